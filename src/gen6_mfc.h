@@ -286,6 +286,29 @@ struct gen6_mfc_context {
     //"buffered_QMatrix" will be used to buffer the QMatrix if the app sends one.
     // Or else, we will load a default QMatrix from the driver for JPEG encode.
     VAQMatrixBufferJPEG buffered_qmatrix;
+
+    /*
+     * The JPEG tables in the layout of their commands, shared by a batch.
+     * They are kept with the inputs they were computed from and reused
+     * as long as the inputs are the same, e.g. for MJPEG at a fixed quality.
+     */
+    struct {
+        uint32_t qm[2][32];             /* luma, chroma: 1/Q, two per dword */
+        uint8_t load_qm[2];
+        uint32_t dc_table[2][12];
+        uint32_t ac_table[2][162];
+        uint8_t load_huffman_table[2];
+        int num_huffman_tables;
+
+        int qm_valid;
+        unsigned int qm_quality;        /* the normalized quality factor */
+        VAQMatrixBufferJPEG qm_key;     /* the loaded matrices only, rest 0 */
+        int huffman_valid;
+        VAHuffmanTableBufferJPEGBaseline huffman_key;   /* idem */
+
+        unsigned int num_updates;       /* the times they were computed */
+        unsigned int num_reuses;        /* the times they were reused */
+    } jpeg_tables;
     struct i965_gpe_context gpe_context;
     struct i965_buffer_surface mfc_batchbuffer_surface;
     struct intel_batchbuffer *aux_batchbuffer;
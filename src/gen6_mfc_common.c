@@ -39,6 +39,7 @@
 #include "i965_drv_video.h"
 #include "i965_encoder.h"
 #include "i965_encoder_utils.h"
+#include "i965_gpe_walker.h"
 #include "gen6_mfc.h"
 #include "gen6_vme.h"
 #include "gen9_mfc.h"
@@ -862,7 +863,6 @@ static float intel_lambda_qp(int qp)
     return lambdaf;
 }
 
-static
 void intel_h264_calc_mbmvcost_qp(int qp,
                                  int slice_type,
                                  uint8_t *vme_state_message)
@@ -965,6 +965,89 @@ void intel_h264_calc_mbmvcost_qp(int qp,
     return;
 }
 
+/*
+ * The mode and MV costs only depend on the QP and the slice type, so they
+ * are evaluated once for every QP and slice type and then looked up
+ */
+static uint8_t intel_mbmv_cost_lut[SLICE_TYPE_I + 1][QP_MAX + 1][MODE_INTER_MV7 + 1];
+static pthread_once_t intel_mbmv_cost_lut_once = PTHREAD_ONCE_INIT;
+
+static void
+intel_mbmv_cost_lut_init(void)
+{
+    int slice_type, qp;
+
+    for (slice_type = SLICE_TYPE_P; slice_type <= SLICE_TYPE_I; slice_type++) {
+        for (qp = 0; qp <= QP_MAX; qp++)
+            intel_h264_calc_mbmvcost_qp(qp, slice_type, intel_mbmv_cost_lut[slice_type][qp]);
+    }
+}
+
+/* Copies the mode and MV costs that are set for the given slice type */
+static void
+intel_mbmv_cost_copy_modes(uint8_t *vme_state_message,
+                           const uint8_t *cost,
+                           int is_intra)
+{
+    if (is_intra) {
+        memcpy(vme_state_message + MODE_INTRA_NONPRED, cost + MODE_INTRA_NONPRED,
+               MODE_INTRA_4X4 - MODE_INTRA_NONPRED + 1);
+    } else {
+        memcpy(vme_state_message + MODE_INTRA_NONPRED, cost + MODE_INTRA_NONPRED,
+               MODE_INTER_BWD - MODE_INTRA_NONPRED + 1);
+        memcpy(vme_state_message + MODE_INTER_MV0, cost + MODE_INTER_MV0,
+               MODE_INTER_MV7 - MODE_INTER_MV0 + 1);
+    }
+}
+
+void
+intel_h264_get_mbmvcost_qp(int qp,
+                           int slice_type,
+                           uint8_t *vme_state_message)
+{
+    const uint8_t *cost;
+
+    assert(qp >= 0 && qp <= QP_MAX);
+    assert(slice_type >= SLICE_TYPE_P && slice_type <= SLICE_TYPE_I);
+
+    pthread_once(&intel_mbmv_cost_lut_once, intel_mbmv_cost_lut_init);
+    cost = intel_mbmv_cost_lut[slice_type][qp];
+
+    vme_state_message[MODE_CHROMA_INTRA] = cost[MODE_CHROMA_INTRA];
+    vme_state_message[MODE_REFID_COST] = cost[MODE_REFID_COST];
+    intel_mbmv_cost_copy_modes(vme_state_message, cost, slice_type == SLICE_TYPE_I);
+}
+
+/* Same costs as H.264, without the chroma intra and reference id costs */
+void
+intel_hevc_get_mbmvcost_qp(int qp,
+                           int slice_type,
+                           uint8_t *vme_state_message)
+{
+    const uint8_t *cost;
+
+    assert(qp >= 0 && qp <= QP_MAX);
+
+    pthread_once(&intel_mbmv_cost_lut_once, intel_mbmv_cost_lut_init);
+
+    switch (slice_type) {
+    case HEVC_SLICE_I:
+        cost = intel_mbmv_cost_lut[SLICE_TYPE_I][qp];
+        break;
+
+    case HEVC_SLICE_P:
+        cost = intel_mbmv_cost_lut[SLICE_TYPE_P][qp];
+        break;
+
+    default:
+        assert(slice_type == HEVC_SLICE_B);
+        cost = intel_mbmv_cost_lut[SLICE_TYPE_B][qp];
+        break;
+    }
+
+    intel_mbmv_cost_copy_modes(vme_state_message, cost, slice_type == HEVC_SLICE_I);
+}
+
 void intel_vme_update_mbmv_cost(VADriverContextP ctx,
                                 struct encode_state *encode_state,
                                 struct intel_encoder_context *encoder_context)
@@ -986,7 +1069,7 @@ void intel_vme_update_mbmv_cost(VADriverContextP ctx,
     if (vme_state_message == NULL)
         return;
 
-    intel_h264_calc_mbmvcost_qp(qp, slice_type, vme_state_message);
+    intel_h264_get_mbmvcost_qp(qp, slice_type, vme_state_message);
 }
 
 void intel_vme_vp8_update_mbmv_cost(VADriverContextP ctx,
@@ -1103,21 +1186,6 @@ gen7_vme_scoreboard_init(VADriverContextP ctx, struct gen6_vme_context *vme_cont
     return;
 }
 
-/* check whether the mb of (x_index, y_index) is out of bound */
-static inline int loop_in_bounds(int x_index, int y_index, int first_mb, int num_mb, int mb_width, int mb_height)
-{
-    int mb_index;
-    if (x_index < 0 || x_index >= mb_width)
-        return -1;
-    if (y_index < 0 || y_index >= mb_height)
-        return -1;
-
-    mb_index = y_index * mb_width + x_index;
-    if (mb_index < first_mb || mb_index > (first_mb + num_mb))
-        return -1;
-    return 0;
-}
-
 void
 gen7_vme_walker_fill_vme_batchbuffer(VADriverContextP ctx,
                                      struct encode_state *encode_state,
@@ -1151,112 +1219,49 @@ gen7_vme_walker_fill_vme_batchbuffer(VADriverContextP ctx,
         int first_mb = pSliceParameter->macroblock_address;
         int num_mb = pSliceParameter->num_macroblocks;
         unsigned int mb_intra_ub, score_dep;
-        int x_outer, y_outer, x_inner, y_inner;
-        int xtemp_outer = 0;
-
-        x_outer = first_mb % mb_width;
-        y_outer = first_mb / mb_width;
-        mb_row = y_outer;
-
-        for (; x_outer < (mb_width - 2) && !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            x_inner = x_outer;
-            y_inner = y_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != mb_row) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
-                }
+        struct i965_walker_26_iter iter;
+        int x_inner, y_inner;
 
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (9 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = USE_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
-                /* QP occupies one byte */
-                if (vme_context->roi_enabled) {
-                    qp_index = y_inner * mb_width + x_inner;
-                    qp_mb = *(vme_context->qp_per_mb + qp_index);
-                } else
-                    qp_mb = qp;
-                *command_ptr++ = qp_mb;
-                x_inner -= 2;
-                y_inner += 1;
-            }
-            x_outer += 1;
-        }
+        mb_row = first_mb / mb_width;
 
-        xtemp_outer = mb_width - 2;
-        if (xtemp_outer < 0)
-            xtemp_outer = 0;
-        x_outer = xtemp_outer;
-        y_outer = first_mb / mb_width;
-        for (; !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            y_inner = y_outer;
-            x_inner = x_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != mb_row) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
-
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
-                }
+        i965_walker_26_begin(&iter, mb_width, mb_height, first_mb, num_mb);
 
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (9 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = USE_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
-                /* qp occupies one byte */
-                if (vme_context->roi_enabled) {
-                    qp_index = y_inner * mb_width + x_inner;
-                    qp_mb = *(vme_context->qp_per_mb + qp_index);
-                } else
-                    qp_mb = qp;
-                *command_ptr++ = qp_mb;
-
-                x_inner -= 2;
-                y_inner += 1;
+        while (i965_walker_26_next(&iter, &x_inner, &y_inner)) {
+            mb_intra_ub = 0;
+            score_dep = 0;
+            if (x_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
+                score_dep |= MB_SCOREBOARD_A;
             }
-            x_outer++;
-            if (x_outer >= mb_width) {
-                y_outer += 1;
-                x_outer = xtemp_outer;
+            if (y_inner != mb_row) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
+                score_dep |= MB_SCOREBOARD_B;
+                if (x_inner != 0)
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
+                if (x_inner != (mb_width - 1)) {
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
+                    score_dep |= MB_SCOREBOARD_C;
+                }
             }
+
+            *command_ptr++ = (CMD_MEDIA_OBJECT | (9 - 2));
+            *command_ptr++ = kernel;
+            *command_ptr++ = USE_SCOREBOARD;
+            /* Indirect data */
+            *command_ptr++ = 0;
+            /* the (X, Y) term of scoreboard */
+            *command_ptr++ = ((y_inner << 16) | x_inner);
+            *command_ptr++ = score_dep;
+            /*inline data */
+            *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
+            *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
+            /* QP occupies one byte */
+            if (vme_context->roi_enabled) {
+                qp_index = y_inner * mb_width + x_inner;
+                qp_mb = *(vme_context->qp_per_mb + qp_index);
+            } else
+                qp_mb = qp;
+            *command_ptr++ = qp_mb;
         }
     }
 
@@ -1450,103 +1455,45 @@ gen7_vme_mpeg2_walker_fill_vme_batchbuffer(VADriverContextP ctx,
 
     {
         unsigned int mb_intra_ub, score_dep;
-        int x_outer, y_outer, x_inner, y_inner;
-        int xtemp_outer = 0;
+        struct i965_walker_26_iter iter;
+        int x_inner, y_inner;
         int first_mb = 0;
         int num_mb = mb_width * mb_height;
 
-        x_outer = 0;
-        y_outer = 0;
-
-
-        for (; x_outer < (mb_width - 2) && !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            x_inner = x_outer;
-            y_inner = y_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
 
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
-                }
+        i965_walker_26_begin(&iter, mb_width, mb_height, first_mb, num_mb);
 
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = MPEG2_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
-                x_inner -= 2;
-                y_inner += 1;
+        while (i965_walker_26_next(&iter, &x_inner, &y_inner)) {
+            mb_intra_ub = 0;
+            score_dep = 0;
+            if (x_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
+                score_dep |= MB_SCOREBOARD_A;
             }
-            x_outer += 1;
-        }
-
-        xtemp_outer = mb_width - 2;
-        if (xtemp_outer < 0)
-            xtemp_outer = 0;
-        x_outer = xtemp_outer;
-        y_outer = 0;
-        for (; !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            y_inner = y_outer;
-            x_inner = x_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
+            if (y_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
+                score_dep |= MB_SCOREBOARD_B;
 
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
+                if (x_inner != 0)
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
 
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
+                if (x_inner != (mb_width - 1)) {
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
+                    score_dep |= MB_SCOREBOARD_C;
                 }
-
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = MPEG2_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
-
-                x_inner -= 2;
-                y_inner += 1;
-            }
-            x_outer++;
-            if (x_outer >= mb_width) {
-                y_outer += 1;
-                x_outer = xtemp_outer;
             }
+
+            *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
+            *command_ptr++ = kernel;
+            *command_ptr++ = MPEG2_SCOREBOARD;
+            /* Indirect data */
+            *command_ptr++ = 0;
+            /* the (X, Y) term of scoreboard */
+            *command_ptr++ = ((y_inner << 16) | x_inner);
+            *command_ptr++ = score_dep;
+            /*inline data */
+            *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
+            *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
         }
     }
 
@@ -1852,7 +1799,7 @@ intel_h264_initialize_mbmv_cost(VADriverContextP ctx,
     assert(bo->virtual);
     cost_table = (uint8_t *)(bo->virtual);
     for (qp = 0; qp < QP_MAX; qp++) {
-        intel_h264_calc_mbmvcost_qp(qp, slice_type, cost_table);
+        intel_h264_get_mbmvcost_qp(qp, slice_type, cost_table);
         cost_table += 32;
     }
 
@@ -1961,8 +1908,9 @@ intel_h264_enc_roi_cbr(VADriverContextP ctx,
     bool quickfill = 0;
 
     ROIRegionParam param_regions[I965_MAX_NUM_ROI_REGIONS];
+    struct i965_encoder_roi_rect rects[I965_MAX_NUM_ROI_REGIONS];
     int num_roi = 0;
-    int i, j;
+    int i;
 
     float temp;
     float qstep_nonroi, qstep_base;
@@ -2052,17 +2000,27 @@ intel_h264_enc_roi_cbr(VADriverContextP ctx,
     BRC_CLIP(nonroi_qp, min_qp, 51);
 
 qp_fill:
-    memset(vme_context->qp_per_mb, nonroi_qp, mbs_in_picture);
-    if (!quickfill) {
-        char *qp_ptr;
-
-        for (i = 0; i < num_roi; i++) {
-            for (j = param_regions[i].row_start_in_mb; j < param_regions[i].row_end_in_mb; j++) {
-                qp_ptr = vme_context->qp_per_mb + (j * width_in_mbs) + param_regions[i].col_start_in_mb;
-                memset(qp_ptr, param_regions[i].roi_qp, param_regions[i].width_mbs);
-            }
-        }
+    if (quickfill)
+        num_roi = 0;
+
+    for (i = 0; i < num_roi; i++) {
+        rects[i].left = MAX(param_regions[i].col_start_in_mb, 0);
+        rects[i].right = MAX(param_regions[i].col_end_in_mb, 0);
+        rects[i].top = MAX(param_regions[i].row_start_in_mb, 0);
+        rects[i].bottom = MAX(param_regions[i].row_end_in_mb, 0);
+        rects[i].value = param_regions[i].roi_qp;
     }
+
+    i965_encoder_roi_map_paint(&vme_context->qp_roi_map,
+                               (uint8_t *)vme_context->qp_per_mb,
+                               width_in_mbs,
+                               1,
+                               width_in_mbs,
+                               height_in_mbs,
+                               nonroi_qp,
+                               rects,
+                               num_roi);
+
     return vaStatus;
 }
 
@@ -2071,8 +2029,8 @@ intel_h264_enc_roi_config(VADriverContextP ctx,
                           struct encode_state *encode_state,
                           struct intel_encoder_context *encoder_context)
 {
-    char *qp_ptr;
-    int i, j;
+    struct i965_encoder_roi_rect rects[I965_MAX_NUM_ROI_REGIONS];
+    int j;
     struct i965_driver_data *i965 = i965_driver_data(ctx);
     struct gen6_vme_context *vme_context = encoder_context->vme_context;
     struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
@@ -2103,6 +2061,8 @@ intel_h264_enc_roi_config(VADriverContextP ctx,
         vme_context->saved_width_mbs = width_in_mbs;
         vme_context->saved_height_mbs = height_in_mbs;
         assert(vme_context->qp_per_mb);
+
+        i965_encoder_roi_map_reset(&vme_context->qp_roi_map);
     }
     if (encoder_context->rate_control_mode == VA_RC_CBR) {
         /*
@@ -2123,9 +2083,8 @@ intel_h264_enc_roi_config(VADriverContextP ctx,
         int min_qp = MAX(1, encoder_context->brc.min_qp);
 
         qp = pic_param->pic_init_qp + slice_param->slice_qp_delta;
-        memset(vme_context->qp_per_mb, qp, width_in_mbs * height_in_mbs);
-
 
+        /* the first ROI has the highest priority, paint it last */
         for (j = num_roi - 1; j >= 0; j--) {
             int qp_delta, qp_clip;
 
@@ -2144,11 +2103,22 @@ intel_h264_enc_roi_config(VADriverContextP ctx,
 
             BRC_CLIP(qp_clip, min_qp, 51);
 
-            for (i = row_start; i < row_end; i++) {
-                qp_ptr = vme_context->qp_per_mb + (i * width_in_mbs) + col_start;
-                memset(qp_ptr, qp_clip, (col_end - col_start));
-            }
+            rects[num_roi - 1 - j].left = MAX(col_start, 0);
+            rects[num_roi - 1 - j].right = MAX(col_end, 0);
+            rects[num_roi - 1 - j].top = MAX(row_start, 0);
+            rects[num_roi - 1 - j].bottom = MAX(row_end, 0);
+            rects[num_roi - 1 - j].value = qp_clip;
         }
+
+        i965_encoder_roi_map_paint(&vme_context->qp_roi_map,
+                                   (uint8_t *)vme_context->qp_per_mb,
+                                   width_in_mbs,
+                                   1,
+                                   width_in_mbs,
+                                   height_in_mbs,
+                                   qp,
+                                   rects,
+                                   num_roi);
     } else {
         /*
          * TODO: Disable it for non CBR-CQP.
@@ -2293,9 +2263,8 @@ void intel_vme_hevc_update_mbmv_cost(VADriverContextP ctx,
     VAEncPictureParameterBufferHEVC *pic_param = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
     VAEncSliceParameterBufferHEVC *slice_param = (VAEncSliceParameterBufferHEVC *)encode_state->slice_params_ext[0]->buffer;
     VAEncSequenceParameterBufferHEVC *pSequenceParameter = (VAEncSequenceParameterBufferHEVC *)encode_state->seq_param_ext->buffer;
-    int qp, m_cost, j, mv_count;
+    int qp;
     uint8_t *vme_state_message = (uint8_t *)(vme_context->vme_state_message);
-    float   lambda, m_costf;
 
     /* here no SI SP slice for HEVC, do not need slice fixup */
     int slice_type = slice_param->slice_type;
@@ -2321,91 +2290,5 @@ void intel_vme_hevc_update_mbmv_cost(VADriverContextP ctx,
     if (vme_state_message == NULL)
         return;
 
-    assert(qp <= QP_MAX);
-    lambda = intel_lambda_qp(qp);
-    if (slice_type == HEVC_SLICE_I) {
-        vme_state_message[MODE_INTRA_16X16] = 0;
-        m_cost = lambda * 4;
-        vme_state_message[MODE_INTRA_8X8] = intel_format_lutvalue(m_cost, 0x8f);
-        m_cost = lambda * 16;
-        vme_state_message[MODE_INTRA_4X4] = intel_format_lutvalue(m_cost, 0x8f);
-        m_cost = lambda * 3;
-        vme_state_message[MODE_INTRA_NONPRED] = intel_format_lutvalue(m_cost, 0x6f);
-    } else {
-        m_cost = 0;
-        vme_state_message[MODE_INTER_MV0] = intel_format_lutvalue(m_cost, 0x6f);
-        for (j = 1; j < 3; j++) {
-            m_costf = (log2f((float)(j + 1)) + 1.718f) * lambda;
-            m_cost = (int)m_costf;
-            vme_state_message[MODE_INTER_MV0 + j] = intel_format_lutvalue(m_cost, 0x6f);
-        }
-        mv_count = 3;
-        for (j = 4; j <= 64; j *= 2) {
-            m_costf = (log2f((float)(j + 1)) + 1.718f) * lambda;
-            m_cost = (int)m_costf;
-            vme_state_message[MODE_INTER_MV0 + mv_count] = intel_format_lutvalue(m_cost, 0x6f);
-            mv_count++;
-        }
-
-        if (qp <= 25) {
-            vme_state_message[MODE_INTRA_16X16] = 0x4a;
-            vme_state_message[MODE_INTRA_8X8] = 0x4a;
-            vme_state_message[MODE_INTRA_4X4] = 0x4a;
-            vme_state_message[MODE_INTRA_NONPRED] = 0x4a;
-            vme_state_message[MODE_INTER_16X16] = 0x4a;
-            vme_state_message[MODE_INTER_16X8] = 0x4a;
-            vme_state_message[MODE_INTER_8X8] = 0x4a;
-            vme_state_message[MODE_INTER_8X4] = 0x4a;
-            vme_state_message[MODE_INTER_4X4] = 0x4a;
-            vme_state_message[MODE_INTER_BWD] = 0x2a;
-            return;
-        }
-        m_costf = lambda * 10;
-        vme_state_message[MODE_INTRA_16X16] = intel_format_lutvalue(m_cost, 0x8f);
-        m_cost = lambda * 14;
-        vme_state_message[MODE_INTRA_8X8] = intel_format_lutvalue(m_cost, 0x8f);
-        m_cost = lambda * 24;
-        vme_state_message[MODE_INTRA_4X4] = intel_format_lutvalue(m_cost, 0x8f);
-        m_costf = lambda * 3.5;
-        m_cost = m_costf;
-        vme_state_message[MODE_INTRA_NONPRED] = intel_format_lutvalue(m_cost, 0x6f);
-        if (slice_type == HEVC_SLICE_P) {
-            m_costf = lambda * 2.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_16X16] = intel_format_lutvalue(m_cost, 0x8f);
-            m_costf = lambda * 4;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_16X8] = intel_format_lutvalue(m_cost, 0x8f);
-            m_costf = lambda * 1.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_8X8] = intel_format_lutvalue(m_cost, 0x6f);
-            m_costf = lambda * 3;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_8X4] = intel_format_lutvalue(m_cost, 0x6f);
-            m_costf = lambda * 5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_4X4] = intel_format_lutvalue(m_cost, 0x6f);
-            /* BWD is not used in P-frame */
-            vme_state_message[MODE_INTER_BWD] = 0;
-        } else {
-            m_costf = lambda * 2.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_16X16] = intel_format_lutvalue(m_cost, 0x8f);
-            m_costf = lambda * 5.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_16X8] = intel_format_lutvalue(m_cost, 0x8f);
-            m_costf = lambda * 3.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_8X8] = intel_format_lutvalue(m_cost, 0x6f);
-            m_costf = lambda * 5.0;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_8X4] = intel_format_lutvalue(m_cost, 0x6f);
-            m_costf = lambda * 6.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_4X4] = intel_format_lutvalue(m_cost, 0x6f);
-            m_costf = lambda * 1.5;
-            m_cost = m_costf;
-            vme_state_message[MODE_INTER_BWD] = intel_format_lutvalue(m_cost, 0x6f);
-        }
-    }
+    intel_hevc_get_mbmvcost_qp(qp, slice_type, vme_state_message);
 }
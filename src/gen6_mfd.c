@@ -67,22 +67,20 @@ gen6_mfd_init_avc_surface(VADriverContextP ctx,
         obj_surface->private_data = gen6_avc_surface;
     }
 
+    gen6_avc_surface->dmv_pool = &i965->dmv_pools[I965_DMV_POOL_AVC];
+
     gen6_avc_surface->dmv_bottom_flag = (pic_param->pic_fields.bits.field_pic_flag &&
                                          !pic_param->seq_fields.bits.direct_8x8_inference_flag);
 
     if (gen6_avc_surface->dmv_top == NULL) {
-        gen6_avc_surface->dmv_top = dri_bo_alloc(i965->intel.bufmgr,
-                                                 "direct mv w/r buffer",
-                                                 128 * height_in_mbs * 64,      /* scalable with frame height */
-                                                 0x1000);
+        gen6_avc_surface->dmv_top = i965_dmv_pool_get(gen6_avc_surface->dmv_pool,
+                                                      128 * height_in_mbs * 64);    /* scalable with frame height */
     }
 
     if (gen6_avc_surface->dmv_bottom_flag &&
         gen6_avc_surface->dmv_bottom == NULL) {
-        gen6_avc_surface->dmv_bottom = dri_bo_alloc(i965->intel.bufmgr,
-                                                    "direct mv w/r buffer",
-                                                    128 * height_in_mbs * 64,   /* scalable with frame height */
-                                                    0x1000);
+        gen6_avc_surface->dmv_bottom = i965_dmv_pool_get(gen6_avc_surface->dmv_pool,
+                                                         128 * height_in_mbs * 64);    /* scalable with frame height */
     }
 }
 
@@ -1214,7 +1212,7 @@ gen6_mfd_init_vc1_surface(VADriverContextP ctx,
     }
 }
 
-static void
+static VAStatus
 gen6_mfd_vc1_decode_init(VADriverContextP ctx,
                          struct decode_state *decode_state,
                          struct gen6_mfd_context *gen6_mfd_context)
@@ -1306,69 +1304,36 @@ gen6_mfd_vc1_decode_init(VADriverContextP ctx,
         gen6_mfd_context->bitplane_read_buffer.valid = 1;
     else
         gen6_mfd_context->bitplane_read_buffer.valid = !!(pic_param->bitplane_present.value & 0x7f);
-    dri_bo_unreference(gen6_mfd_context->bitplane_read_buffer.bo);
 
     if (gen6_mfd_context->bitplane_read_buffer.valid) {
         int width_in_mbs = ALIGN(pic_param->coded_width, 16) / 16;
         int height_in_mbs = ALIGN(pic_param->coded_height, 16) / 16;
         int bitplane_width = ALIGN(width_in_mbs, 2) / 2;
-        int src_w, src_h;
-        uint8_t *src = NULL, *dst = NULL;
 
-        bo = dri_bo_alloc(i965->intel.bufmgr,
-                          "VC-1 Bitplane",
-                          bitplane_width * height_in_mbs,
-                          0x1000);
-        assert(bo);
-        gen6_mfd_context->bitplane_read_buffer.bo = bo;
+        if (!intel_ensure_vc1_bitplane_buffer(ctx, &gen6_mfd_context->bitplane_read_buffer,
+                                              &gen6_mfd_context->bitplane_spare_bo,
+                                              bitplane_width * height_in_mbs)) {
+            gen6_mfd_context->bitplane_read_buffer.valid = 0;
+            return VA_STATUS_ERROR_ALLOCATION_FAILED;
+        }
 
+        bo = gen6_mfd_context->bitplane_read_buffer.bo;
         dri_bo_map(bo, True);
         assert(bo->virtual);
-        dst = bo->virtual;
 
         if (picture_type == GEN6_VC1_SKIPPED_PICTURE) {
-            for (src_h = 0; src_h < height_in_mbs; src_h++) {
-                for (src_w = 0; src_w < width_in_mbs; src_w++) {
-                    int dst_index;
-                    uint8_t src_value = 0x2;
-
-                    dst_index = src_w / 2;
-                    dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-                }
-
-                if (src_w & 1)
-                    dst[src_w / 2] >>= 4;
-
-                dst += bitplane_width;
-            }
+            intel_vc1_pack_bitplane(bo->virtual, bitplane_width, NULL,
+                                    width_in_mbs, height_in_mbs);
         } else {
             assert(decode_state->bit_plane->buffer);
-            src = decode_state->bit_plane->buffer;
-
-            for (src_h = 0; src_h < height_in_mbs; src_h++) {
-                for (src_w = 0; src_w < width_in_mbs; src_w++) {
-                    int src_index, dst_index;
-                    int src_shift;
-                    uint8_t src_value;
-
-                    src_index = (src_h * width_in_mbs + src_w) / 2;
-                    src_shift = !((src_h * width_in_mbs + src_w) & 1) * 4;
-                    src_value = ((src[src_index] >> src_shift) & 0xf);
-
-                    dst_index = src_w / 2;
-                    dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-                }
-
-                if (src_w & 1)
-                    dst[src_w / 2] >>= 4;
-
-                dst += bitplane_width;
-            }
+            intel_vc1_pack_bitplane(bo->virtual, bitplane_width,
+                                    decode_state->bit_plane->buffer,
+                                    width_in_mbs, height_in_mbs);
         }
 
         dri_bo_unmap(bo);
-    } else
-        gen6_mfd_context->bitplane_read_buffer.bo = NULL;
+    }
+    return VA_STATUS_SUCCESS;
 }
 
 static void
@@ -1809,7 +1774,7 @@ gen6_mfd_vc1_bsd_object(VADriverContextP ctx,
     ADVANCE_BCS_BATCH(batch);
 }
 
-static void
+static VAStatus
 gen6_mfd_vc1_decode_picture(VADriverContextP ctx,
                             struct decode_state *decode_state,
                             struct gen6_mfd_context *gen6_mfd_context)
@@ -1819,11 +1784,16 @@ gen6_mfd_vc1_decode_picture(VADriverContextP ctx,
     VASliceParameterBufferVC1 *slice_param, *next_slice_param, *next_slice_group_param;
     dri_bo *slice_data_bo;
     int i, j;
+    VAStatus vaStatus;
 
     assert(decode_state->pic_param && decode_state->pic_param->buffer);
     pic_param = (VAPictureParameterBufferVC1 *)decode_state->pic_param->buffer;
 
-    gen6_mfd_vc1_decode_init(ctx, decode_state, gen6_mfd_context);
+    vaStatus = gen6_mfd_vc1_decode_init(ctx, decode_state, gen6_mfd_context);
+
+    if (vaStatus != VA_STATUS_SUCCESS)
+        return vaStatus;
+
     intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
     intel_batchbuffer_emit_mi_flush(batch);
     gen6_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_VC1, gen6_mfd_context);
@@ -1860,6 +1830,7 @@ gen6_mfd_vc1_decode_picture(VADriverContextP ctx,
 
     intel_batchbuffer_end_atomic(batch);
     intel_batchbuffer_flush(batch);
+    return VA_STATUS_SUCCESS;
 }
 
 static VAStatus
@@ -1896,7 +1867,7 @@ gen6_mfd_decode_picture(VADriverContextP ctx,
     case VAProfileVC1Simple:
     case VAProfileVC1Main:
     case VAProfileVC1Advanced:
-        gen6_mfd_vc1_decode_picture(ctx, decode_state, gen6_mfd_context);
+        vaStatus = gen6_mfd_vc1_decode_picture(ctx, decode_state, gen6_mfd_context);
         break;
 
     default:
@@ -1904,8 +1875,6 @@ gen6_mfd_decode_picture(VADriverContextP ctx,
         break;
     }
 
-    vaStatus = VA_STATUS_SUCCESS;
-
 out:
     return vaStatus;
 }
@@ -1936,6 +1905,9 @@ gen6_mfd_context_destroy(void *hw_context)
     dri_bo_unreference(gen6_mfd_context->bitplane_read_buffer.bo);
     gen6_mfd_context->bitplane_read_buffer.bo = NULL;
 
+    dri_bo_unreference(gen6_mfd_context->bitplane_spare_bo);
+    gen6_mfd_context->bitplane_spare_bo = NULL;
+
     intel_batchbuffer_free(gen6_mfd_context->base.batch);
     free(gen6_mfd_context);
 }
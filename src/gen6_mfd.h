@@ -72,6 +72,7 @@ struct gen6_mfd_context {
     GenBuffer           bsd_mpc_row_store_scratch_buffer;
     GenBuffer           mpr_row_store_scratch_buffer;
     GenBuffer           bitplane_read_buffer;
+    dri_bo              *bitplane_spare_bo;     /* the other half of the double buffered bitplane */
 
     int                 wa_mpeg2_slice_vertical_position;
 };
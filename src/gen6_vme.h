@@ -35,6 +35,7 @@
 #include <intel_bufmgr.h>
 
 #include "i965_gpe_utils.h"
+#include "i965_encoder_roi_map.h"
 
 #define INTRA_VME_OUTPUT_IN_BYTES       16      /* in bytes */
 #define INTRA_VME_OUTPUT_IN_DWS         (INTRA_VME_OUTPUT_IN_BYTES / 4)
@@ -106,6 +107,7 @@ struct gen6_vme_context {
     bool roi_enabled;
     char *qp_per_mb;
     int saved_width_mbs, saved_height_mbs;
+    struct i965_encoder_roi_map qp_roi_map;     /* what qp_per_mb holds */
 };
 
 #define MPEG2_PIC_WIDTH_HEIGHT  30
@@ -122,6 +124,18 @@ extern void intel_vme_update_mbmv_cost(VADriverContextP ctx,
                                        struct encode_state *encode_state,
                                        struct intel_encoder_context *encoder_context);
 
+void intel_h264_calc_mbmvcost_qp(int qp,
+                                 int slice_type,
+                                 uint8_t *vme_state_message);
+
+void intel_h264_get_mbmvcost_qp(int qp,
+                                int slice_type,
+                                uint8_t *vme_state_message);
+
+void intel_hevc_get_mbmvcost_qp(int qp,
+                                int slice_type,
+                                uint8_t *vme_state_message);
+
 void intel_vme_vp8_update_mbmv_cost(VADriverContextP ctx,
                                     struct encode_state *encode_state,
                                     struct intel_encoder_context *encoder_context);
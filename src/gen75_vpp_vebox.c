@@ -1241,6 +1241,16 @@ gen75_vebox_ensure_surfaces_storage(VADriverContextP ctx,
 
     proc_ctx->is_iecp_enabled = (proc_ctx->filters_mask & VPP_IECP_MASK) != 0;
 
+    /* Grow the scratch surfaces to the largest input seen so far */
+    if (vpp_frame_store_geometry_update(&proc_ctx->frame_store_geometry,
+                                        proc_ctx->width_input,
+                                        proc_ctx->height_input)) {
+        for (i = 0; i < ARRAY_ELEMS(proc_ctx->frame_store); i++) {
+            if (proc_ctx->frame_store[i].is_scratch_surface)
+                frame_store_clear(&proc_ctx->frame_store[i], ctx);
+        }
+    }
+
     /* Create pipeline surfaces */
     for (i = 0; i < ARRAY_ELEMS(proc_ctx->frame_store); i ++) {
         struct object_surface *obj_surface;
@@ -1249,8 +1259,9 @@ gen75_vebox_ensure_surfaces_storage(VADriverContextP ctx,
         if (proc_ctx->frame_store[i].obj_surface)
             continue; // user allocated surface, not VEBOX internal
 
-        status = i965_CreateSurfaces(ctx, proc_ctx->width_input,
-                                     proc_ctx->height_input, VA_RT_FORMAT_YUV420, 1, &new_surface);
+        status = i965_CreateSurfaces(ctx, proc_ctx->frame_store_geometry.width,
+                                     proc_ctx->frame_store_geometry.height,
+                                     VA_RT_FORMAT_YUV420, 1, &new_surface);
         if (status != VA_STATUS_SUCCESS)
             return status;
 
@@ -1275,6 +1286,19 @@ gen75_vebox_ensure_surfaces_storage(VADriverContextP ctx,
         proc_ctx->frame_store[i].is_scratch_surface = 1;
     }
 
+    /* VEBOX accesses the scratch surfaces with the pitch of the input
+       surface, they take the layout of the input in their larger BOs */
+    for (i = 0; i < ARRAY_ELEMS(proc_ctx->frame_store); i++) {
+        if (!proc_ctx->frame_store[i].is_scratch_surface)
+            continue;
+
+        status = i965_resize_surface_bo(ctx, proc_ctx->frame_store[i].obj_surface,
+                                        proc_ctx->width_input,
+                                        proc_ctx->height_input);
+        if (status != VA_STATUS_SUCCESS)
+            return status;
+    }
+
     /* Allocate DNDI state table  */
     drm_intel_bo_unreference(proc_ctx->dndi_state_table.bo);
     bo = drm_intel_bo_alloc(i965->intel.bufmgr, "vebox: dndi state Buffer",
@@ -1801,6 +1825,10 @@ void gen75_vebox_context_destroy(VADriverContextP ctx,
     for (i = 0; i < ARRAY_ELEMS(proc_ctx->frame_store); i++)
         frame_store_clear(&proc_ctx->frame_store[i], ctx);
 
+    if (proc_ctx->frame_store_geometry.num_reallocs)
+        i965_log_info(ctx, "VEBOX: %u frame store reallocations\n",
+                      proc_ctx->frame_store_geometry.num_reallocs);
+
     /* dndi state table  */
     drm_intel_bo_unreference(proc_ctx->dndi_state_table.bo);
     proc_ctx->dndi_state_table.bo = NULL;
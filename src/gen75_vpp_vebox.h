@@ -37,6 +37,7 @@
 #include "i965_drv_video.h"
 
 #include "gen75_vpp_gpe.h"
+#include "i965_post_processing.h"
 
 #define INPUT_SURFACE  0
 #define OUTPUT_SURFACE 1
@@ -125,6 +126,7 @@ struct intel_vebox_context {
     int height_output;
 
     VEBFrameStore frame_store[FRAME_STORE_COUNT];
+    struct vpp_frame_store_geometry frame_store_geometry;
 
     VEBBuffer dndi_state_table;
     VEBBuffer iecp_state_table;
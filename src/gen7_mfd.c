@@ -71,23 +71,21 @@ gen7_mfd_init_avc_surface(VADriverContextP ctx,
         obj_surface->private_data = gen7_avc_surface;
     }
 
+    gen7_avc_surface->dmv_pool = &i965->dmv_pools[I965_DMV_POOL_AVC];
+
     gen7_avc_surface->dmv_bottom_flag = (pic_param->pic_fields.bits.field_pic_flag &&
                                          !pic_param->seq_fields.bits.direct_8x8_inference_flag);
 
     if (gen7_avc_surface->dmv_top == NULL) {
-        gen7_avc_surface->dmv_top = dri_bo_alloc(i965->intel.bufmgr,
-                                                 "direct mv w/r buffer",
-                                                 width_in_mbs * (height_in_mbs + 1) * 64,
-                                                 0x1000);
+        gen7_avc_surface->dmv_top = i965_dmv_pool_get(gen7_avc_surface->dmv_pool,
+                                                      width_in_mbs * (height_in_mbs + 1) * 64);
         assert(gen7_avc_surface->dmv_top);
     }
 
     if (gen7_avc_surface->dmv_bottom_flag &&
         gen7_avc_surface->dmv_bottom == NULL) {
-        gen7_avc_surface->dmv_bottom = dri_bo_alloc(i965->intel.bufmgr,
-                                                    "direct mv w/r buffer",
-                                                    width_in_mbs * (height_in_mbs + 1) * 64,
-                                                    0x1000);
+        gen7_avc_surface->dmv_bottom = i965_dmv_pool_get(gen7_avc_surface->dmv_pool,
+                                                         width_in_mbs * (height_in_mbs + 1) * 64);
         assert(gen7_avc_surface->dmv_bottom);
     }
 }
@@ -1319,7 +1317,7 @@ gen7_mfd_init_vc1_surface(VADriverContextP ctx,
     }
 }
 
-static void
+static VAStatus
 gen7_mfd_vc1_decode_init(VADriverContextP ctx,
                          struct decode_state *decode_state,
                          struct gen7_mfd_context *gen7_mfd_context)
@@ -1531,14 +1529,11 @@ gen7_mfd_vc1_decode_init(VADriverContextP ctx,
         gen7_mfd_context->bitplane_read_buffer.valid = 1;
     else
         gen7_mfd_context->bitplane_read_buffer.valid = !!(pic_param->bitplane_present.value & 0x7f);
-    dri_bo_unreference(gen7_mfd_context->bitplane_read_buffer.bo);
 
     if (gen7_mfd_context->bitplane_read_buffer.valid) {
         int width_in_mbs = ALIGN(pic_param->coded_width, 16) / 16;
         int height_in_mbs;
         int bitplane_width = ALIGN(width_in_mbs, 2) / 2;
-        int src_w, src_h;
-        uint8_t *src = NULL, *dst = NULL;
 
         if (!pic_param->sequence_fields.bits.interlace ||
             (pic_param->picture_fields.bits.frame_coding_mode < 2)) /* Progressive or Frame-Interlace */
@@ -1546,60 +1541,30 @@ gen7_mfd_vc1_decode_init(VADriverContextP ctx,
         else /* Field-Interlace */
             height_in_mbs = ALIGN(pic_param->coded_height, 32) / 32;
 
-        bo = dri_bo_alloc(i965->intel.bufmgr,
-                          "VC-1 Bitplane",
-                          bitplane_width * height_in_mbs,
-                          0x1000);
-        assert(bo);
-        gen7_mfd_context->bitplane_read_buffer.bo = bo;
+        if (!intel_ensure_vc1_bitplane_buffer(ctx, &gen7_mfd_context->bitplane_read_buffer,
+                                              &gen7_mfd_context->bitplane_spare_bo,
+                                              bitplane_width * height_in_mbs)) {
+            gen7_mfd_context->bitplane_read_buffer.valid = 0;
+            return VA_STATUS_ERROR_ALLOCATION_FAILED;
+        }
 
+        bo = gen7_mfd_context->bitplane_read_buffer.bo;
         dri_bo_map(bo, True);
         assert(bo->virtual);
-        dst = bo->virtual;
 
         if (picture_type == GEN7_VC1_SKIPPED_PICTURE) {
-            for (src_h = 0; src_h < height_in_mbs; src_h++) {
-                for (src_w = 0; src_w < width_in_mbs; src_w++) {
-                    int dst_index;
-                    uint8_t src_value = 0x2;
-
-                    dst_index = src_w / 2;
-                    dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-                }
-
-                if (src_w & 1)
-                    dst[src_w / 2] >>= 4;
-
-                dst += bitplane_width;
-            }
+            intel_vc1_pack_bitplane(bo->virtual, bitplane_width, NULL,
+                                    width_in_mbs, height_in_mbs);
         } else {
             assert(decode_state->bit_plane->buffer);
-            src = decode_state->bit_plane->buffer;
-
-            for (src_h = 0; src_h < height_in_mbs; src_h++) {
-                for (src_w = 0; src_w < width_in_mbs; src_w++) {
-                    int src_index, dst_index;
-                    int src_shift;
-                    uint8_t src_value;
-
-                    src_index = (src_h * width_in_mbs + src_w) / 2;
-                    src_shift = !((src_h * width_in_mbs + src_w) & 1) * 4;
-                    src_value = ((src[src_index] >> src_shift) & 0xf);
-
-                    dst_index = src_w / 2;
-                    dst[dst_index] = ((dst[dst_index] >> 4) | (src_value << 4));
-                }
-
-                if (src_w & 1)
-                    dst[src_w / 2] >>= 4;
-
-                dst += bitplane_width;
-            }
+            intel_vc1_pack_bitplane(bo->virtual, bitplane_width,
+                                    decode_state->bit_plane->buffer,
+                                    width_in_mbs, height_in_mbs);
         }
 
         dri_bo_unmap(bo);
-    } else
-        gen7_mfd_context->bitplane_read_buffer.bo = NULL;
+    }
+    return VA_STATUS_SUCCESS;
 }
 
 static void
@@ -2237,7 +2202,7 @@ gen7_mfd_vc1_bsd_object(VADriverContextP ctx,
     ADVANCE_BCS_BATCH(batch);
 }
 
-static void
+static VAStatus
 gen7_mfd_vc1_decode_picture(VADriverContextP ctx,
                             struct decode_state *decode_state,
                             struct gen7_mfd_context *gen7_mfd_context)
@@ -2247,11 +2212,16 @@ gen7_mfd_vc1_decode_picture(VADriverContextP ctx,
     VASliceParameterBufferVC1 *slice_param, *next_slice_param, *next_slice_group_param;
     dri_bo *slice_data_bo;
     int i, j;
+    VAStatus vaStatus;
 
     assert(decode_state->pic_param && decode_state->pic_param->buffer);
     pic_param = (VAPictureParameterBufferVC1 *)decode_state->pic_param->buffer;
 
-    gen7_mfd_vc1_decode_init(ctx, decode_state, gen7_mfd_context);
+    vaStatus = gen7_mfd_vc1_decode_init(ctx, decode_state, gen7_mfd_context);
+
+    if (vaStatus != VA_STATUS_SUCCESS)
+        return vaStatus;
+
     intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
     intel_batchbuffer_emit_mi_flush(batch);
     gen7_mfd_pipe_mode_select(ctx, decode_state, MFX_FORMAT_VC1, gen7_mfd_context);
@@ -2288,6 +2258,7 @@ gen7_mfd_vc1_decode_picture(VADriverContextP ctx,
 
     intel_batchbuffer_end_atomic(batch);
     intel_batchbuffer_flush(batch);
+    return VA_STATUS_SUCCESS;
 }
 
 static void
@@ -2365,6 +2336,7 @@ gen7_mfd_jpeg_decode_init(VADriverContextP ctx,
 
     gen7_mfd_context->bitplane_read_buffer.bo = NULL;
     gen7_mfd_context->bitplane_read_buffer.valid = 0;
+    gen7_mfd_context->bitplane_spare_bo = NULL;
 }
 
 static const int va_to_gen7_jpeg_rotation[4] = {
@@ -3104,7 +3076,7 @@ gen7_mfd_decode_picture(VADriverContextP ctx,
     case VAProfileVC1Simple:
     case VAProfileVC1Main:
     case VAProfileVC1Advanced:
-        gen7_mfd_vc1_decode_picture(ctx, decode_state, gen7_mfd_context);
+        vaStatus = gen7_mfd_vc1_decode_picture(ctx, decode_state, gen7_mfd_context);
         break;
 
     case VAProfileJPEGBaseline:
@@ -3116,8 +3088,6 @@ gen7_mfd_decode_picture(VADriverContextP ctx,
         break;
     }
 
-    vaStatus = VA_STATUS_SUCCESS;
-
 out:
     return vaStatus;
 }
@@ -3151,6 +3121,9 @@ gen7_mfd_context_destroy(void *hw_context)
     dri_bo_unreference(gen7_mfd_context->bitplane_read_buffer.bo);
     gen7_mfd_context->bitplane_read_buffer.bo = NULL;
 
+    dri_bo_unreference(gen7_mfd_context->bitplane_spare_bo);
+    gen7_mfd_context->bitplane_spare_bo = NULL;
+
     dri_bo_unreference(gen7_mfd_context->jpeg_wa_slice_data_bo);
 
     if (gen7_mfd_context->jpeg_wa_surface_id != VA_INVALID_SURFACE) {
@@ -92,6 +92,7 @@ struct gen7_mfd_context {
     GenBuffer           bsd_mpc_row_store_scratch_buffer;
     GenBuffer           mpr_row_store_scratch_buffer;
     GenBuffer           bitplane_read_buffer;
+    dri_bo              *bitplane_spare_bo;     /* the other half of the double buffered bitplane */
     GenBuffer           segmentation_buffer;
 
     VASurfaceID jpeg_wa_surface_id;
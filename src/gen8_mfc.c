@@ -550,10 +550,14 @@ static void gen8_mfc_init(VADriverContextP ctx,
         height_in_mbs = ALIGN(pSequenceParameter->picture_height, 16) / 16;
     } else {
         assert(encoder_context->codec == CODEC_JPEG);
-        VAEncPictureParameterBufferJPEG *pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_param_ext->buffer;
 
-        width_in_mbs = ALIGN(pic_param->picture_width, 16) / 16;
-        height_in_mbs = ALIGN(pic_param->picture_height, 16) / 16;
+        /* the buffers are shared by all the pictures of a batch */
+        for (i = 0; i < encode_state->num_pic_params_ext; i++) {
+            VAEncPictureParameterBufferJPEG *pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_params_ext[i]->buffer;
+
+            width_in_mbs = MAX(width_in_mbs, ALIGN(pic_param->picture_width, 16) / 16);
+            height_in_mbs = MAX(height_in_mbs, ALIGN(pic_param->picture_height, 16) / 16);
+        }
     }
 
     slice_batchbuffer_size = 64 * width_in_mbs * height_in_mbs + 4096 +
@@ -2601,7 +2605,8 @@ gen8_mfc_mpeg2_encode_picture(VADriverContextP ctx,
 static VAStatus
 intel_mfc_jpeg_prepare(VADriverContextP ctx,
                        struct encode_state *encode_state,
-                       struct intel_encoder_context *encoder_context)
+                       struct intel_encoder_context *encoder_context,
+                       int index)
 {
     struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
     struct object_surface *obj_surface;
@@ -2611,13 +2616,15 @@ intel_mfc_jpeg_prepare(VADriverContextP ctx,
     dri_bo *bo;
 
     /* input YUV surface */
-    obj_surface = encode_state->input_yuv_object;
+    obj_surface = encode_state->batch_input_objects[index];
+    dri_bo_unreference(mfc_context->uncompressed_picture_source.bo);
     mfc_context->uncompressed_picture_source.bo = obj_surface->bo;
     dri_bo_reference(mfc_context->uncompressed_picture_source.bo);
 
     /* coded buffer */
-    obj_buffer = encode_state->coded_buf_object;
+    obj_buffer = encode_state->batch_coded_buf_objects[index];
     bo = obj_buffer->buffer_store->bo;
+    dri_bo_unreference(mfc_context->mfc_indirect_pak_bse_object.bo);
     mfc_context->mfc_indirect_pak_bse_object.bo = bo;
     mfc_context->mfc_indirect_pak_bse_object.offset = I965_CODEDBUFFER_HEADER_SIZE;
     mfc_context->mfc_indirect_pak_bse_object.end_offset = ALIGN(obj_buffer->size_element - 0x1000, 0x1000);
@@ -2637,10 +2644,9 @@ intel_mfc_jpeg_prepare(VADriverContextP ctx,
 static void
 gen8_mfc_jpeg_set_surface_state(VADriverContextP ctx,
                                 struct intel_encoder_context *encoder_context,
-                                struct encode_state *encode_state)
+                                struct object_surface *obj_surface)
 {
     struct intel_batchbuffer *batch = encoder_context->base.batch;
-    struct object_surface *obj_surface = encode_state->input_yuv_object;
     unsigned int input_fourcc;
     unsigned int y_cb_offset;
     unsigned int y_cr_offset;
@@ -2709,11 +2715,10 @@ gen8_mfc_jpeg_set_surface_state(VADriverContextP ctx,
 static void
 gen8_mfc_jpeg_pic_state(VADriverContextP ctx,
                         struct intel_encoder_context *encoder_context,
-                        struct encode_state *encode_state)
+                        VAEncPictureParameterBufferJPEG *pic_param,
+                        struct object_surface *obj_surface)
 {
     struct intel_batchbuffer *batch = encoder_context->base.batch;
-    struct object_surface *obj_surface = encode_state->input_yuv_object;
-    VAEncPictureParameterBufferJPEG *pic_param;
     unsigned int  surface_format;
     unsigned int  frame_width_in_blks;
     unsigned int  frame_height_in_blks;
@@ -2724,9 +2729,7 @@ gen8_mfc_jpeg_pic_state(VADriverContextP ctx,
     unsigned int  picture_width;
     unsigned int  picture_height;
 
-    assert(encode_state->pic_param_ext && encode_state->pic_param_ext->buffer);
     assert(obj_surface);
-    pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_param_ext->buffer;
     surface_format = obj_surface->fourcc;
     picture_width = pic_param->picture_width;
     picture_height = pic_param->picture_height;
@@ -2843,20 +2846,52 @@ get_reciprocal_dword_qm(unsigned char *raster_qm, uint32_t *dword_qm)
 }
 
 
+/*
+ * Scales a quantization matrix by the quality factor and converts it to
+ * the 1/Q column raster of MFX_FQM_STATE.
+ */
 static void
-gen8_mfc_jpeg_fqm_state(VADriverContextP ctx,
-                        struct intel_encoder_context *encoder_context,
-                        struct encode_state *encode_state)
+gen8_mfc_jpeg_scale_qm(const unsigned char *zigzag_qm, unsigned int quality, uint32_t *dword_qm)
+{
+    unsigned char raster_qm[64], column_raster_qm[64];
+    uint32_t temp, i, j;
+
+    for (i = 0; i < 64; i++) {
+        //apply quality to the quantiser matrix and clamp to range [1,255]
+        temp = (zigzag_qm[i] * quality) / 100;
+        temp = (temp > 255) ? 255 : temp;
+        temp = (temp < 1) ? 1 : temp;
+
+        //For VAAPI, the VAQMatrixBuffer needs to be in zigzag order.
+        //The App should send it in zigzag. Now, the driver has to extract the raster from it.
+        raster_qm[zigzag_direct[i]] = (unsigned char)temp;
+    }
+
+    //Convert the raster order(row-ordered) to the column-raster (column by column).
+    //To be consistent with the other encoders, send it in column order.
+    //Need to double check if our HW expects col or row raster.
+    for (j = 0; j < 64; j++) {
+        int row = j / 8, col = j % 8;
+        column_raster_qm[col * 8 + row] = raster_qm[j];
+    }
+
+    //Convert to raster QM to reciprocal. HW expects values in reciprocal.
+    get_reciprocal_dword_qm(column_raster_qm, dword_qm);
+}
+
+/* Returns 0 if the tables of the previous frame are still valid */
+static int
+gen8_mfc_jpeg_compute_qm(VADriverContextP ctx,
+                         struct intel_encoder_context *encoder_context,
+                         struct encode_state *encode_state)
 {
     unsigned int quality = 0;
-    uint32_t temp, i = 0, j = 0, dword_qm[32];
     VAEncPictureParameterBufferJPEG *pic_param;
-    VAQMatrixBufferJPEG *qmatrix;
-    unsigned char raster_qm[64], column_raster_qm[64];
+    VAQMatrixBufferJPEG *qmatrix, key;
     struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
 
-    assert(encode_state->pic_param_ext && encode_state->pic_param_ext->buffer);
-    pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_param_ext->buffer;
+    assert(encode_state->num_pic_params_ext > 0 && encode_state->pic_params_ext[0]->buffer);
+    pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_params_ext[0]->buffer;
     quality = pic_param->quality;
 
     //If the app sends the qmatrix, use it, buffer it for using it with the next frames
@@ -2896,73 +2931,52 @@ gen8_mfc_jpeg_fqm_state(VADriverContextP ctx,
     if (quality == 0)  quality = 1;
     quality = (quality < 50) ? (5000 / quality) : (200 - (quality * 2));
 
-    //Step 1. Apply Quality factor and clip to range [1, 255] for luma and chroma Quantization matrices
-    //Step 2. HW expects the 1/Q[i] values in the qm sent, so get reciprocals
-    //Step 3. HW also expects 32 dwords, hence combine 2 (1/Q) values into 1 dword
-    //Step 4. Send the Quantization matrix to the HW, use gen8_mfc_fqm_state
+    memset(&key, 0, sizeof(key));
+    key.load_lum_quantiser_matrix = qmatrix->load_lum_quantiser_matrix;
+    key.load_chroma_quantiser_matrix = qmatrix->load_chroma_quantiser_matrix;
 
-    //For luma (Y or R)
-    if (qmatrix->load_lum_quantiser_matrix) {
-        //apply quality to lum_quantiser_matrix
-        for (i = 0; i < 64; i++) {
-            temp = (qmatrix->lum_quantiser_matrix[i] * quality) / 100;
-            //clamp to range [1,255]
-            temp = (temp > 255) ? 255 : temp;
-            temp = (temp < 1) ? 1 : temp;
-            qmatrix->lum_quantiser_matrix[i] = (unsigned char)temp;
-        }
+    if (qmatrix->load_lum_quantiser_matrix)
+        memcpy(key.lum_quantiser_matrix, qmatrix->lum_quantiser_matrix, 64);
 
-        //For VAAPI, the VAQMatrixBuffer needs to be in zigzag order.
-        //The App should send it in zigzag. Now, the driver has to extract the raster from it.
-        for (j = 0; j < 64; j++)
-            raster_qm[zigzag_direct[j]] = qmatrix->lum_quantiser_matrix[j];
-
-        //Convert the raster order(row-ordered) to the column-raster (column by column).
-        //To be consistent with the other encoders, send it in column order.
-        //Need to double check if our HW expects col or row raster.
-        for (j = 0; j < 64; j++) {
-            int row = j / 8, col = j % 8;
-            column_raster_qm[col * 8 + row] = raster_qm[j];
-        }
+    if (qmatrix->load_chroma_quantiser_matrix)
+        memcpy(key.chroma_quantiser_matrix, qmatrix->chroma_quantiser_matrix, 64);
 
-        //Convert to raster QM to reciprocal. HW expects values in reciprocal.
-        get_reciprocal_dword_qm(column_raster_qm, dword_qm);
+    if (mfc_context->jpeg_tables.qm_valid &&
+        mfc_context->jpeg_tables.qm_quality == quality &&
+        !memcmp(&mfc_context->jpeg_tables.qm_key, &key, sizeof(key)))
+        return 0;
 
-        //send the luma qm to the command buffer
-        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_LUMA_Y_QUANTIZER_MATRIX, dword_qm, 32, encoder_context);
-    }
+    mfc_context->jpeg_tables.qm_valid = 1;
+    mfc_context->jpeg_tables.qm_quality = quality;
+    mfc_context->jpeg_tables.qm_key = key;
+
+    //For luma (Y or R)
+    mfc_context->jpeg_tables.load_qm[0] = qmatrix->load_lum_quantiser_matrix;
+    if (qmatrix->load_lum_quantiser_matrix)
+        gen8_mfc_jpeg_scale_qm(qmatrix->lum_quantiser_matrix, quality, mfc_context->jpeg_tables.qm[0]);
 
     //For Chroma, if chroma exists (Cb, Cr or G, B)
-    if (qmatrix->load_chroma_quantiser_matrix) {
-        //apply quality to chroma_quantiser_matrix
-        for (i = 0; i < 64; i++) {
-            temp = (qmatrix->chroma_quantiser_matrix[i] * quality) / 100;
-            //clamp to range [1,255]
-            temp = (temp > 255) ? 255 : temp;
-            temp = (temp < 1) ? 1 : temp;
-            qmatrix->chroma_quantiser_matrix[i] = (unsigned char)temp;
-        }
+    mfc_context->jpeg_tables.load_qm[1] = qmatrix->load_chroma_quantiser_matrix;
+    if (qmatrix->load_chroma_quantiser_matrix)
+        gen8_mfc_jpeg_scale_qm(qmatrix->chroma_quantiser_matrix, quality, mfc_context->jpeg_tables.qm[1]);
 
-        //For VAAPI, the VAQMatrixBuffer needs to be in zigzag order.
-        //The App should send it in zigzag. Now, the driver has to extract the raster from it.
-        for (j = 0; j < 64; j++)
-            raster_qm[zigzag_direct[j]] = qmatrix->chroma_quantiser_matrix[j];
-
-        //Convert the raster order(row-ordered) to the column-raster (column by column).
-        //To be consistent with the other encoders, send it in column order.
-        //Need to double check if our HW expects col or row raster.
-        for (j = 0; j < 64; j++) {
-            int row = j / 8, col = j % 8;
-            column_raster_qm[col * 8 + row] = raster_qm[j];
-        }
+    return 1;
+}
 
+static void
+gen8_mfc_jpeg_fqm_state(VADriverContextP ctx,
+                        struct intel_encoder_context *encoder_context)
+{
+    struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
 
-        //Convert to raster QM to reciprocal. HW expects values in reciprocal.
-        get_reciprocal_dword_qm(column_raster_qm, dword_qm);
+    //send the luma qm to the command buffer
+    if (mfc_context->jpeg_tables.load_qm[0])
+        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_LUMA_Y_QUANTIZER_MATRIX, mfc_context->jpeg_tables.qm[0], 32, encoder_context);
 
-        //send the same chroma qm to the command buffer (for both U,V or G,B)
-        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_CHROMA_CB_QUANTIZER_MATRIX, dword_qm, 32, encoder_context);
-        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_CHROMA_CR_QUANTIZER_MATRIX, dword_qm, 32, encoder_context);
+    //send the same chroma qm to the command buffer (for both U,V or G,B)
+    if (mfc_context->jpeg_tables.load_qm[1]) {
+        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_CHROMA_CB_QUANTIZER_MATRIX, mfc_context->jpeg_tables.qm[1], 32, encoder_context);
+        gen8_mfc_fqm_state(ctx, MFX_QM_JPEG_CHROMA_CR_QUANTIZER_MATRIX, mfc_context->jpeg_tables.qm[1], 32, encoder_context);
     }
 }
 
@@ -3094,45 +3108,106 @@ convert_hufftable_to_codes(VAHuffmanTableBufferJPEGBaseline *huff_buffer, uint32
 
 }
 
-//send the huffman table using MFC_JPEG_HUFF_TABLE_STATE
-static void
-gen8_mfc_jpeg_huff_table_state(VADriverContextP ctx,
-                               struct encode_state *encode_state,
-                               struct intel_encoder_context *encoder_context,
-                               int num_tables)
+//convert the huffman tables to the code words of MFC_JPEG_HUFF_TABLE_STATE
+//Returns 0 if the tables of the previous frame are still valid
+static int
+gen8_mfc_jpeg_compute_huff_tables(VADriverContextP ctx,
+                                  struct encode_state *encode_state,
+                                  struct intel_encoder_context *encoder_context)
 {
-    VAHuffmanTableBufferJPEGBaseline *huff_buffer;
-    struct intel_batchbuffer *batch = encoder_context->base.batch;
+    struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+    VAHuffmanTableBufferJPEGBaseline *huff_buffer, key;
+    VAEncSliceParameterBufferJPEG *slice_param;
+    int i, j, component, max_selector = 0;
     uint8_t index;
-    uint32_t dc_table[12], ac_table[162];
 
     assert(encode_state->huffman_table && encode_state->huffman_table->buffer);
     huff_buffer = (VAHuffmanTableBufferJPEGBaseline *)encode_state->huffman_table->buffer;
 
-    memset(dc_table, 0, sizeof(dc_table));
-    memset(ac_table, 0, sizeof(ac_table));
+    //I dont think I need this for loop. Just to be consistent with other encoding logic...
+    for (i = 0; i < encode_state->num_slice_params_ext; i++) {
+        assert(encode_state->slice_params_ext && encode_state->slice_params_ext[i]->buffer);
+        slice_param = (VAEncSliceParameterBufferJPEG *)encode_state->slice_params_ext[i]->buffer;
+
+        for (j = 0; j < encode_state->slice_params_ext[i]->num_elements; j++) {
 
-    for (index = 0; index < num_tables; index++) {
-        int id = va_to_gen7_jpeg_hufftable[index];
+            for (component = 0; component < slice_param->num_components; component++) {
+                if (max_selector < slice_param->components[component].dc_table_selector)
+                    max_selector = slice_param->components[component].dc_table_selector;
+
+                if (max_selector < slice_param->components[component].ac_table_selector)
+                    max_selector = slice_param->components[component].ac_table_selector;
+            }
+
+            slice_param++;
+        }
+    }
+
+    assert(max_selector < 2);
+
+    memset(&key, 0, sizeof(key));
+
+    for (index = 0; index < max_selector + 1; index++) {
+        key.load_huffman_table[index] = huff_buffer->load_huffman_table[index];
+
+        if (!huff_buffer->load_huffman_table[index])
+            continue;
+
+        memcpy(key.huffman_table[index].num_dc_codes, huff_buffer->huffman_table[index].num_dc_codes, 16);
+        memcpy(key.huffman_table[index].dc_values, huff_buffer->huffman_table[index].dc_values, 12);
+        memcpy(key.huffman_table[index].num_ac_codes, huff_buffer->huffman_table[index].num_ac_codes, 16);
+        memcpy(key.huffman_table[index].ac_values, huff_buffer->huffman_table[index].ac_values, 162);
+    }
+
+    if (mfc_context->jpeg_tables.huffman_valid &&
+        mfc_context->jpeg_tables.num_huffman_tables == max_selector + 1 &&
+        !memcmp(&mfc_context->jpeg_tables.huffman_key, &key, sizeof(key)))
+        return 0;
+
+    mfc_context->jpeg_tables.huffman_valid = 1;
+    mfc_context->jpeg_tables.huffman_key = key;
+    mfc_context->jpeg_tables.num_huffman_tables = max_selector + 1;
+
+    for (index = 0; index < mfc_context->jpeg_tables.num_huffman_tables; index++) {
+        mfc_context->jpeg_tables.load_huffman_table[index] = huff_buffer->load_huffman_table[index];
 
         if (!huff_buffer->load_huffman_table[index])
             continue;
 
         //load DC table with 12 DWords
-        convert_hufftable_to_codes(huff_buffer, dc_table, 0, index);  //0 for Dc
+        convert_hufftable_to_codes(huff_buffer, mfc_context->jpeg_tables.dc_table[index], 0, index);  //0 for Dc
 
         //load AC table with 162 DWords
-        convert_hufftable_to_codes(huff_buffer, ac_table, 1, index);  //1 for AC
+        convert_hufftable_to_codes(huff_buffer, mfc_context->jpeg_tables.ac_table[index], 1, index);  //1 for AC
+    }
+
+    return 1;
+}
+
+//send the huffman table using MFC_JPEG_HUFF_TABLE_STATE
+static void
+gen8_mfc_jpeg_huff_table_state(VADriverContextP ctx,
+                               struct intel_encoder_context *encoder_context)
+{
+    struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+    struct intel_batchbuffer *batch = encoder_context->base.batch;
+    uint8_t index;
+
+    for (index = 0; index < mfc_context->jpeg_tables.num_huffman_tables; index++) {
+        int id = va_to_gen7_jpeg_hufftable[index];
+
+        if (!mfc_context->jpeg_tables.load_huffman_table[index])
+            continue;
 
         BEGIN_BCS_BATCH(batch, 176);
         OUT_BCS_BATCH(batch, MFC_JPEG_HUFF_TABLE_STATE | (176 - 2));
         OUT_BCS_BATCH(batch, id); //Huff table id
 
         //DWord 2 - 13 has DC_TABLE
-        intel_batchbuffer_data(batch, dc_table, 12 * 4);
+        intel_batchbuffer_data(batch, mfc_context->jpeg_tables.dc_table[index], 12 * 4);
 
         //Dword 14 -175 has AC_TABLE
-        intel_batchbuffer_data(batch, ac_table, 162 * 4);
+        intel_batchbuffer_data(batch, mfc_context->jpeg_tables.ac_table[index], 162 * 4);
         ADVANCE_BCS_BATCH(batch);
     }
 }
@@ -3179,25 +3254,19 @@ static void get_Y_sampling_factors(uint32_t surface_format, uint8_t *h_factor, u
 //set MFC_JPEG_SCAN_OBJECT
 static void
 gen8_mfc_jpeg_scan_object(VADriverContextP ctx,
-                          struct encode_state *encode_state,
-                          struct intel_encoder_context *encoder_context)
+                          struct intel_encoder_context *encoder_context,
+                          VAEncPictureParameterBufferJPEG *pic_param,
+                          VAEncSliceParameterBufferJPEG *slice_param,
+                          struct object_surface *obj_surface)
 {
     uint32_t mcu_count, surface_format, Mx, My;
     uint8_t i, horizontal_sampling_factor, vertical_sampling_factor, huff_ac_table = 0, huff_dc_table = 0;
     uint8_t is_last_scan = 1;    //Jpeg has only 1 scan per frame. When last scan, HW inserts EOI code.
     uint8_t head_present_flag = 1; //Header has tables and app data
     uint16_t num_components, restart_interval;   //Specifies number of MCUs in an ECS.
-    VAEncSliceParameterBufferJPEG *slice_param;
-    VAEncPictureParameterBufferJPEG *pic_param;
-
     struct intel_batchbuffer *batch = encoder_context->base.batch;
-    struct object_surface *obj_surface = encode_state->input_yuv_object;
 
-    assert(encode_state->slice_params_ext[0] && encode_state->slice_params_ext[0]->buffer);
-    assert(encode_state->pic_param_ext && encode_state->pic_param_ext->buffer);
     assert(obj_surface);
-    pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_param_ext->buffer;
-    slice_param = (VAEncSliceParameterBufferJPEG *)encode_state->slice_params_ext[0]->buffer;
     surface_format = obj_surface->fourcc;
 
     get_Y_sampling_factors(surface_format, &horizontal_sampling_factor, &vertical_sampling_factor);
@@ -3268,14 +3337,18 @@ gen8_mfc_jpeg_pak_insert_object(struct intel_encoder_context *encoder_context, u
 static void
 gen8_mfc_jpeg_add_headers(VADriverContextP ctx,
                           struct encode_state *encode_state,
-                          struct intel_encoder_context *encoder_context)
+                          struct intel_encoder_context *encoder_context,
+                          int index)
 {
     if (encode_state->packed_header_data_ext) {
         VAEncPackedHeaderParameterBuffer *param = NULL;
-        unsigned int *header_data = (unsigned int *)(*encode_state->packed_header_data_ext)->buffer;
+        unsigned int *header_data;
         unsigned int length_in_bits;
 
-        param = (VAEncPackedHeaderParameterBuffer *)(*encode_state->packed_header_params_ext)->buffer;
+        /* a picture without its own header reuses the last one */
+        index = MIN(index, encode_state->num_packed_header_data_ext - 1);
+        header_data = (unsigned int *)encode_state->packed_header_data_ext[index]->buffer;
+        param = (VAEncPackedHeaderParameterBuffer *)encode_state->packed_header_params_ext[index]->buffer;
         length_in_bits = param->bit_length;
 
         gen8_mfc_jpeg_pak_insert_object(encoder_context,
@@ -3307,67 +3380,95 @@ jpeg_init_default_qmatrix(VADriverContextP ctx, struct intel_encoder_context *en
 static void
 gen8_mfc_jpeg_pipeline_picture_programing(VADriverContextP ctx,
                                           struct encode_state *encode_state,
-                                          struct intel_encoder_context *encoder_context)
+                                          struct intel_encoder_context *encoder_context,
+                                          int index)
 {
-    int i, j, component, max_selector = 0;
+    struct object_surface *obj_surface = encode_state->batch_input_objects[index];
+    VAEncPictureParameterBufferJPEG *pic_param;
     VAEncSliceParameterBufferJPEG *slice_param;
+    int slice_index = MIN(index, encode_state->num_slice_params_ext - 1);
+
+    assert(encode_state->pic_params_ext[index] && encode_state->pic_params_ext[index]->buffer);
+    assert(encode_state->slice_params_ext[slice_index] && encode_state->slice_params_ext[slice_index]->buffer);
+    pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_params_ext[index]->buffer;
+    slice_param = (VAEncSliceParameterBufferJPEG *)encode_state->slice_params_ext[slice_index]->buffer;
+
+    intel_mfc_jpeg_prepare(ctx, encode_state, encoder_context, index);
 
-    gen8_mfc_pipe_mode_select(ctx, MFX_FORMAT_JPEG, encoder_context);
-    gen8_mfc_jpeg_set_surface_state(ctx, encoder_context, encode_state);
+    gen8_mfc_jpeg_set_surface_state(ctx, encoder_context, obj_surface);
     gen8_mfc_pipe_buf_addr_state(ctx, encoder_context);
     gen8_mfc_ind_obj_base_addr_state(ctx, encoder_context);
     gen8_mfc_bsp_buf_base_addr_state(ctx, encoder_context);
-    gen8_mfc_jpeg_pic_state(ctx, encoder_context, encode_state);
-
-    //do the slice level encoding here
-    gen8_mfc_jpeg_fqm_state(ctx, encoder_context, encode_state);
-
-    //I dont think I need this for loop. Just to be consistent with other encoding logic...
-    for (i = 0; i < encode_state->num_slice_params_ext; i++) {
-        assert(encode_state->slice_params_ext && encode_state->slice_params_ext[i]->buffer);
-        slice_param = (VAEncSliceParameterBufferJPEG *)encode_state->slice_params_ext[i]->buffer;
+    gen8_mfc_jpeg_pic_state(ctx, encoder_context, pic_param, obj_surface);
 
-        for (j = 0; j < encode_state->slice_params_ext[i]->num_elements; j++) {
+    //set MFC_JPEG_SCAN_OBJECT
+    gen8_mfc_jpeg_scan_object(ctx, encoder_context, pic_param, slice_param, obj_surface);
+    //add headers using MFX_PAK_INSERT_OBJECT (it is refered as MFX_INSERT_OBJECT in this driver code)
+    gen8_mfc_jpeg_add_headers(ctx, encode_state, encoder_context, index);
+}
 
-            for (component = 0; component < slice_param->num_components; component++) {
-                if (max_selector < slice_param->components[component].dc_table_selector)
-                    max_selector = slice_param->components[component].dc_table_selector;
+/* The batch space taken by a picture, the insert object carries its header */
+static int
+gen8_mfc_jpeg_picture_batch_size(struct encode_state *encode_state, int index)
+{
+    int size = 0x800;
 
-                if (max_selector < slice_param->components[component].ac_table_selector)
-                    max_selector = slice_param->components[component].ac_table_selector;
-            }
+    if (encode_state->packed_header_params_ext) {
+        VAEncPackedHeaderParameterBuffer *param;
 
-            slice_param++;
-        }
+        index = MIN(index, encode_state->num_packed_header_params_ext - 1);
+        param = (VAEncPackedHeaderParameterBuffer *)encode_state->packed_header_params_ext[index]->buffer;
+        size += ALIGN(param->bit_length, 32) >> 3;
     }
 
-    assert(max_selector < 2);
-    //send the huffman table using MFC_JPEG_HUFF_TABLE
-    gen8_mfc_jpeg_huff_table_state(ctx, encode_state, encoder_context, max_selector + 1);
-    //set MFC_JPEG_SCAN_OBJECT
-    gen8_mfc_jpeg_scan_object(ctx, encode_state, encoder_context);
-    //add headers using MFX_PAK_INSERT_OBJECT (it is refered as MFX_INSERT_OBJECT in this driver code)
-    gen8_mfc_jpeg_add_headers(ctx, encode_state, encoder_context);
-
+    return size;
 }
 
+/*
+ * The pictures of a batch share the pipe mode, quantization and Huffman
+ * states, which are sent once for as many pictures as fit into an atomic
+ * section of the batch buffer.
+ */
 static void
 gen8_mfc_jpeg_pipeline_programing(VADriverContextP ctx,
                                   struct encode_state *encode_state,
                                   struct intel_encoder_context *encoder_context)
 {
     struct intel_batchbuffer *batch = encoder_context->base.batch;
+    int first, last, i, size;
 
-    // begin programing
-    intel_batchbuffer_start_atomic_bcs(batch, 0x4000);
-    intel_batchbuffer_emit_mi_flush(batch);
+    for (first = 0; first < encode_state->num_pic_params_ext; first = last) {
+        size = 0x1000 + gen8_mfc_jpeg_picture_batch_size(encode_state, first);
 
-    // picture level programing
-    gen8_mfc_jpeg_pipeline_picture_programing(ctx, encode_state, encoder_context);
+        for (last = first + 1; last < encode_state->num_pic_params_ext; last++) {
+            int picture_size = gen8_mfc_jpeg_picture_batch_size(encode_state, last);
 
-    // end programing
-    intel_batchbuffer_end_atomic(batch);
+            if (size + picture_size > BATCH_SIZE / 2)
+                break;
+
+            size += picture_size;
+        }
+
+        // begin programing
+        intel_batchbuffer_start_atomic_bcs(batch, size);
+        intel_batchbuffer_emit_mi_flush(batch);
+
+        gen8_mfc_pipe_mode_select(ctx, MFX_FORMAT_JPEG, encoder_context);
+        gen8_mfc_jpeg_fqm_state(ctx, encoder_context);
+        //send the huffman table using MFC_JPEG_HUFF_TABLE
+        gen8_mfc_jpeg_huff_table_state(ctx, encoder_context);
 
+        // picture level programing
+        for (i = first; i < last; i++) {
+            if (i > first)
+                intel_batchbuffer_emit_mi_flush(batch);
+
+            gen8_mfc_jpeg_pipeline_picture_programing(ctx, encode_state, encoder_context, i);
+        }
+
+        // end programing
+        intel_batchbuffer_end_atomic(batch);
+    }
 }
 
 
@@ -3376,8 +3477,20 @@ gen8_mfc_jpeg_encode_picture(VADriverContextP ctx,
                              struct encode_state *encode_state,
                              struct intel_encoder_context *encoder_context)
 {
+    struct gen6_mfc_context *mfc_context = encoder_context->mfc_context;
+    int updated;
+
     gen8_mfc_init(ctx, encode_state, encoder_context);
-    intel_mfc_jpeg_prepare(ctx, encode_state, encoder_context);
+
+    /* the tables are shared by all the pictures of the batch */
+    updated = gen8_mfc_jpeg_compute_qm(ctx, encoder_context, encode_state);
+    updated |= gen8_mfc_jpeg_compute_huff_tables(ctx, encode_state, encoder_context);
+
+    if (updated)
+        mfc_context->jpeg_tables.num_updates++;
+    else
+        mfc_context->jpeg_tables.num_reuses++;
+
     /*Programing bcs pipeline*/
     gen8_mfc_jpeg_pipeline_programing(ctx, encode_state, encoder_context);
     gen8_mfc_run(ctx, encode_state, encoder_context);
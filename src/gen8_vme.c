@@ -39,6 +39,7 @@
 #include "i965_drv_video.h"
 #include "i965_encoder.h"
 #include "i965_encoder_api.h"
+#include "i965_gpe_walker.h"
 #include "gen6_vme.h"
 #include "gen6_mfc.h"
 
@@ -410,21 +411,6 @@ static VAStatus gen8_vme_constant_setup(VADriverContextP ctx,
 #define     MB_SCOREBOARD_B     (1 << 1)
 #define     MB_SCOREBOARD_C     (1 << 2)
 
-/* check whether the mb of (x_index, y_index) is out of bound */
-static inline int loop_in_bounds(int x_index, int y_index, int first_mb, int num_mb, int mb_width, int mb_height)
-{
-    int mb_index;
-    if (x_index < 0 || x_index >= mb_width)
-        return -1;
-    if (y_index < 0 || y_index >= mb_height)
-        return -1;
-
-    mb_index = y_index * mb_width + x_index;
-    if (mb_index < first_mb || mb_index > (first_mb + num_mb))
-        return -1;
-    return 0;
-}
-
 static void
 gen8wa_vme_walker_fill_vme_batchbuffer(VADriverContextP ctx,
                                        struct encode_state *encode_state,
@@ -448,103 +434,44 @@ gen8wa_vme_walker_fill_vme_batchbuffer(VADriverContextP ctx,
         int first_mb = pSliceParameter->macroblock_address;
         int num_mb = pSliceParameter->num_macroblocks;
         unsigned int mb_intra_ub, score_dep;
-        int x_outer, y_outer, x_inner, y_inner;
-        int xtemp_outer = 0;
+        struct i965_walker_26_iter iter;
+        int x_inner, y_inner;
 
-        x_outer = first_mb % mb_width;
-        y_outer = first_mb / mb_width;
-        mb_row = y_outer;
+        mb_row = first_mb / mb_width;
 
-        for (; x_outer < (mb_width - 2) && !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            x_inner = x_outer;
-            y_inner = y_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != mb_row) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
-                }
+        i965_walker_26_begin(&iter, mb_width, mb_height, first_mb, num_mb);
 
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = USE_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
-                *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
-                *command_ptr++ = 0;
-
-                x_inner -= 2;
-                y_inner += 1;
+        while (i965_walker_26_next(&iter, &x_inner, &y_inner)) {
+            mb_intra_ub = 0;
+            score_dep = 0;
+            if (x_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
+                score_dep |= MB_SCOREBOARD_A;
             }
-            x_outer += 1;
-        }
-
-        xtemp_outer = mb_width - 2;
-        if (xtemp_outer < 0)
-            xtemp_outer = 0;
-        x_outer = xtemp_outer;
-        y_outer = first_mb / mb_width;
-        for (; !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            y_inner = y_outer;
-            x_inner = x_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != mb_row) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
-
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
+            if (y_inner != mb_row) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
+                score_dep |= MB_SCOREBOARD_B;
+                if (x_inner != 0)
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
+                if (x_inner != (mb_width - 1)) {
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
+                    score_dep |= MB_SCOREBOARD_C;
                 }
-
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = USE_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
-
-                *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
-                *command_ptr++ = 0;
-                x_inner -= 2;
-                y_inner += 1;
-            }
-            x_outer++;
-            if (x_outer >= mb_width) {
-                y_outer += 1;
-                x_outer = xtemp_outer;
             }
+
+            *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
+            *command_ptr++ = kernel;
+            *command_ptr++ = USE_SCOREBOARD;
+            /* Indirect data */
+            *command_ptr++ = 0;
+            /* the (X, Y) term of scoreboard */
+            *command_ptr++ = ((y_inner << 16) | x_inner);
+            *command_ptr++ = score_dep;
+            /*inline data */
+            *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
+            *command_ptr++ = ((1 << 18) | (1 << 16) | transform_8x8_mode_flag | (mb_intra_ub << 8));
+            *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
+            *command_ptr++ = 0;
         }
     }
 
@@ -872,108 +799,47 @@ gen8wa_vme_mpeg2_walker_fill_vme_batchbuffer(VADriverContextP ctx,
 
     {
         unsigned int mb_intra_ub, score_dep;
-        int x_outer, y_outer, x_inner, y_inner;
-        int xtemp_outer = 0;
+        struct i965_walker_26_iter iter;
+        int x_inner, y_inner;
         int first_mb = 0;
         int num_mb = mb_width * mb_height;
 
-        x_outer = 0;
-        y_outer = 0;
 
+        i965_walker_26_begin(&iter, mb_width, mb_height, first_mb, num_mb);
 
-        for (; x_outer < (mb_width - 2) && !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            x_inner = x_outer;
-            y_inner = y_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
-
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
-
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
-                }
-
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = MPEG2_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
-                *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
-                *command_ptr++ = 0;
-
-                x_inner -= 2;
-                y_inner += 1;
+        while (i965_walker_26_next(&iter, &x_inner, &y_inner)) {
+            mb_intra_ub = 0;
+            score_dep = 0;
+            if (x_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
+                score_dep |= MB_SCOREBOARD_A;
             }
-            x_outer += 1;
-        }
-
-        xtemp_outer = mb_width - 2;
-        if (xtemp_outer < 0)
-            xtemp_outer = 0;
-        x_outer = xtemp_outer;
-        y_outer = 0;
-        for (; !loop_in_bounds(x_outer, y_outer, first_mb, num_mb, mb_width, mb_height);) {
-            y_inner = y_outer;
-            x_inner = x_outer;
-            for (; !loop_in_bounds(x_inner, y_inner, first_mb, num_mb, mb_width, mb_height);) {
-                mb_intra_ub = 0;
-                score_dep = 0;
-                if (x_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_AE;
-                    score_dep |= MB_SCOREBOARD_A;
-                }
-                if (y_inner != 0) {
-                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
-                    score_dep |= MB_SCOREBOARD_B;
+            if (y_inner != 0) {
+                mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_B;
+                score_dep |= MB_SCOREBOARD_B;
 
-                    if (x_inner != 0)
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
+                if (x_inner != 0)
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_D;
 
-                    if (x_inner != (mb_width - 1)) {
-                        mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
-                        score_dep |= MB_SCOREBOARD_C;
-                    }
+                if (x_inner != (mb_width - 1)) {
+                    mb_intra_ub |= INTRA_PRED_AVAIL_FLAG_C;
+                    score_dep |= MB_SCOREBOARD_C;
                 }
-
-                *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
-                *command_ptr++ = kernel;
-                *command_ptr++ = MPEG2_SCOREBOARD;
-                /* Indirect data */
-                *command_ptr++ = 0;
-                /* the (X, Y) term of scoreboard */
-                *command_ptr++ = ((y_inner << 16) | x_inner);
-                *command_ptr++ = score_dep;
-                /*inline data */
-                *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
-                *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
-
-                *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
-                *command_ptr++ = 0;
-                x_inner -= 2;
-                y_inner += 1;
-            }
-            x_outer++;
-            if (x_outer >= mb_width) {
-                y_outer += 1;
-                x_outer = xtemp_outer;
             }
+
+            *command_ptr++ = (CMD_MEDIA_OBJECT | (8 - 2));
+            *command_ptr++ = kernel;
+            *command_ptr++ = MPEG2_SCOREBOARD;
+            /* Indirect data */
+            *command_ptr++ = 0;
+            /* the (X, Y) term of scoreboard */
+            *command_ptr++ = ((y_inner << 16) | x_inner);
+            *command_ptr++ = score_dep;
+            /*inline data */
+            *command_ptr++ = (mb_width << 16 | y_inner << 8 | x_inner);
+            *command_ptr++ = ((1 << 18) | (1 << 16) | (mb_intra_ub << 8));
+            *command_ptr++ = CMD_MEDIA_STATE_FLUSH;
+            *command_ptr++ = 0;
         }
     }
 
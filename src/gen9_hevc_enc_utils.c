@@ -26,6 +26,8 @@
  *
  */
 
+#include <string.h>
+
 #include "intel_driver.h"
 #include "gen9_hevc_enc_utils.h"
 
@@ -119,3 +121,168 @@ gen9_hevc_get_profile_level_max_frame(VAEncSequenceParameterBufferHEVC *seq_para
     return MIN(profile_level_max_frame,
                seq_param->pic_width_in_luma_samples * seq_param->pic_height_in_luma_samples);
 }
+
+static void
+hevc_tile_layout_reset(struct gen9_hevc_tile_layout *layout,
+                       unsigned int width_in_lcu,
+                       unsigned int height_in_lcu)
+{
+    memset(layout, 0, sizeof(*layout));
+
+    layout->width_in_lcu = width_in_lcu;
+    layout->height_in_lcu = height_in_lcu;
+    layout->num_columns = 1;
+    layout->num_rows = 1;
+    layout->column_start[1] = width_in_lcu;
+    layout->row_start[1] = height_in_lcu;
+}
+
+/*
+ * Set up the tiles of the picture from the PPS. Like column_width_minus1 and
+ * row_height_minus1 in the PPS, the parameters give every tile but the
+ * last one of a row or column, which takes the rest of the picture.
+ */
+bool
+gen9_hevc_tile_layout_init(struct gen9_hevc_tile_layout *layout,
+                           unsigned int width_in_lcu,
+                           unsigned int height_in_lcu,
+                           VAEncPictureParameterBufferHEVC *pic_param)
+{
+    unsigned int i;
+
+    hevc_tile_layout_reset(layout, width_in_lcu, height_in_lcu);
+
+    if (!pic_param->pic_fields.bits.tiles_enabled_flag)
+        return true;
+
+    if (pic_param->num_tile_columns_minus1 + 1 > GEN9_HEVC_MAX_TILE_COLUMNS ||
+        pic_param->num_tile_rows_minus1 + 1 > GEN9_HEVC_MAX_TILE_ROWS ||
+        pic_param->num_tile_columns_minus1 + 1 > width_in_lcu ||
+        pic_param->num_tile_rows_minus1 + 1 > height_in_lcu)
+        return false;
+
+    layout->num_columns = pic_param->num_tile_columns_minus1 + 1;
+    layout->num_rows = pic_param->num_tile_rows_minus1 + 1;
+
+    for (i = 0; i < layout->num_columns - 1; i++) {
+        layout->column_start[i + 1] = layout->column_start[i] +
+                                      pic_param->column_width_minus1[i] + 1;
+
+        if (layout->column_start[i + 1] >= width_in_lcu)
+            return false;
+    }
+
+    for (i = 0; i < layout->num_rows - 1; i++) {
+        layout->row_start[i + 1] = layout->row_start[i] +
+                                   pic_param->row_height_minus1[i] + 1;
+
+        if (layout->row_start[i + 1] >= height_in_lcu)
+            return false;
+    }
+
+    layout->column_start[layout->num_columns] = width_in_lcu;
+    layout->row_start[layout->num_rows] = height_in_lcu;
+
+    return true;
+}
+
+static unsigned int
+hevc_tile_find(const unsigned int *start, unsigned int num, unsigned int pos)
+{
+    unsigned int i = 0;
+
+    while (i < num - 1 && pos >= start[i + 1])
+        i++;
+
+    return i;
+}
+
+/* CtbAddrRsToTs[] of the spec (6-5) */
+unsigned int
+gen9_hevc_tile_ctb_addr_rs_to_ts(const struct gen9_hevc_tile_layout *layout,
+                                 unsigned int ctb_addr_rs)
+{
+    unsigned int x = ctb_addr_rs % layout->width_in_lcu;
+    unsigned int y = ctb_addr_rs / layout->width_in_lcu;
+    unsigned int col = hevc_tile_find(layout->column_start, layout->num_columns, x);
+    unsigned int row = hevc_tile_find(layout->row_start, layout->num_rows, y);
+    unsigned int tile_width = layout->column_start[col + 1] - layout->column_start[col];
+    unsigned int tile_height = layout->row_start[row + 1] - layout->row_start[row];
+
+    return layout->row_start[row] * layout->width_in_lcu +
+           layout->column_start[col] * tile_height +
+           (y - layout->row_start[row]) * tile_width +
+           x - layout->column_start[col];
+}
+
+/*
+ * A slice segment of num_ctu LCUs from first_ctb_addr_ts, in tile scan,
+ * must stay within a tile. Every tile is walked as a new slice, so a
+ * dependent slice segment can't start a tile but the first one: it would
+ * carry on the slice of the tile before.
+ */
+bool
+gen9_hevc_tile_slice_is_valid(const struct gen9_hevc_tile_layout *layout,
+                              unsigned int first_ctb_addr_ts,
+                              unsigned int num_ctu,
+                              bool dependent)
+{
+    unsigned int last_ctb_addr_ts = first_ctb_addr_ts + num_ctu - 1;
+    unsigned int tile, tile_start_rs;
+
+    if (!num_ctu ||
+        last_ctb_addr_ts >= layout->width_in_lcu * layout->height_in_lcu)
+        return false;
+
+    tile = gen9_hevc_tile_id(layout, gen9_hevc_tile_ctb_addr_ts_to_rs(layout, first_ctb_addr_ts));
+
+    if (tile != gen9_hevc_tile_id(layout, gen9_hevc_tile_ctb_addr_ts_to_rs(layout, last_ctb_addr_ts)))
+        return false;
+
+    tile_start_rs = layout->row_start[tile / layout->num_columns] * layout->width_in_lcu +
+                    layout->column_start[tile % layout->num_columns];
+
+    if (dependent && tile &&
+        first_ctb_addr_ts == gen9_hevc_tile_ctb_addr_rs_to_ts(layout, tile_start_rs))
+        return false;
+
+    return true;
+}
+
+/* CtbAddrTsToRs[] of the spec, the inverse of the above */
+unsigned int
+gen9_hevc_tile_ctb_addr_ts_to_rs(const struct gen9_hevc_tile_layout *layout,
+                                 unsigned int ctb_addr_ts)
+{
+    unsigned int row = 0, col = 0;
+    unsigned int tile_width, tile_height, offset;
+
+    while (row < layout->num_rows - 1 &&
+           ctb_addr_ts >= layout->row_start[row + 1] * layout->width_in_lcu)
+        row++;
+
+    offset = ctb_addr_ts - layout->row_start[row] * layout->width_in_lcu;
+    tile_height = layout->row_start[row + 1] - layout->row_start[row];
+
+    while (col < layout->num_columns - 1 &&
+           offset >= layout->column_start[col + 1] * tile_height)
+        col++;
+
+    offset -= layout->column_start[col] * tile_height;
+    tile_width = layout->column_start[col + 1] - layout->column_start[col];
+
+    return (layout->row_start[row] + offset / tile_width) * layout->width_in_lcu +
+           layout->column_start[col] + offset % tile_width;
+}
+
+/* TileId[] of the spec, indexed by the raster scan address */
+unsigned int
+gen9_hevc_tile_id(const struct gen9_hevc_tile_layout *layout,
+                  unsigned int ctb_addr_rs)
+{
+    unsigned int x = ctb_addr_rs % layout->width_in_lcu;
+    unsigned int y = ctb_addr_rs / layout->width_in_lcu;
+
+    return hevc_tile_find(layout->row_start, layout->num_rows, y) * layout->num_columns +
+           hevc_tile_find(layout->column_start, layout->num_columns, x);
+}
@@ -29,15 +29,58 @@
 #ifndef GEN9_HEVC_ENCODER_UTILS_H
 #define GEN9_HEVC_ENCODER_UTILS_H
 
+#include <stdbool.h>
+
 #include <drm.h>
 #include <i915_drm.h>
 #include <intel_bufmgr.h>
 
 #include <va/va.h>
 
+#define GEN9_HEVC_MAX_TILE_COLUMNS      20
+#define GEN9_HEVC_MAX_TILE_ROWS         22
+
+/*
+ * The tile partitioning of a picture, in LCUs. Tile i spans the LCU
+ * columns column_start[i] .. column_start[i + 1] - 1, and likewise for
+ * the rows; column_start[num_columns] is the picture width.
+ */
+struct gen9_hevc_tile_layout {
+    unsigned int width_in_lcu;
+    unsigned int height_in_lcu;
+    unsigned int num_columns;
+    unsigned int num_rows;
+    unsigned int column_start[GEN9_HEVC_MAX_TILE_COLUMNS + 1];
+    unsigned int row_start[GEN9_HEVC_MAX_TILE_ROWS + 1];
+};
+
 extern unsigned int
 gen9_hevc_get_profile_level_max_frame(VAEncSequenceParameterBufferHEVC *seq_param,
                                       unsigned int user_max_frame_size,
                                       unsigned int frame_rate);
 
+extern bool
+gen9_hevc_tile_layout_init(struct gen9_hevc_tile_layout *layout,
+                           unsigned int width_in_lcu,
+                           unsigned int height_in_lcu,
+                           VAEncPictureParameterBufferHEVC *pic_param);
+
+extern unsigned int
+gen9_hevc_tile_ctb_addr_rs_to_ts(const struct gen9_hevc_tile_layout *layout,
+                                 unsigned int ctb_addr_rs);
+
+extern unsigned int
+gen9_hevc_tile_ctb_addr_ts_to_rs(const struct gen9_hevc_tile_layout *layout,
+                                 unsigned int ctb_addr_ts);
+
+extern unsigned int
+gen9_hevc_tile_id(const struct gen9_hevc_tile_layout *layout,
+                  unsigned int ctb_addr_rs);
+
+extern bool
+gen9_hevc_tile_slice_is_valid(const struct gen9_hevc_tile_layout *layout,
+                              unsigned int first_ctb_addr_ts,
+                              unsigned int num_ctu,
+                              bool dependent);
+
 #endif
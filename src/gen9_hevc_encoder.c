@@ -43,6 +43,7 @@
 #include "i965_encoder_common.h"
 #include "i965_encoder_utils.h"
 #include "i965_encoder_api.h"
+#include "i965_gpe_walker.h"
 #include "gen9_hevc_enc_kernels.h"
 #include "gen9_hevc_enc_kernels_binary.h"
 #include "gen9_hevc_enc_utils.h"
@@ -1003,11 +1004,31 @@ gen9_hevc_enc_check_parameters(VADriverContextP ctx,
     VAEncSequenceParameterBufferHEVC *seq_param = NULL;
     VAEncPictureParameterBufferHEVC *pic_param = NULL;
     VAEncSliceParameterBufferHEVC *slice_param = NULL;
+    struct gen9_hevc_tile_layout tiles;
+    unsigned int cu_size, lcu_size;
     int i = 0, j = 0;
 
     seq_param = (VAEncSequenceParameterBufferHEVC *)encode_state->seq_param_ext->buffer;
     pic_param = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
 
+    cu_size = 1 << (seq_param->log2_min_luma_coding_block_size_minus3 + 3);
+    lcu_size = 1 << (seq_param->log2_diff_max_min_luma_coding_block_size +
+                     seq_param->log2_min_luma_coding_block_size_minus3 + 3);
+
+    if (!gen9_hevc_tile_layout_init(&tiles,
+                                    ALIGN(seq_param->pic_width_in_luma_samples / cu_size * cu_size, lcu_size) / lcu_size,
+                                    ALIGN(seq_param->pic_height_in_luma_samples / cu_size * cu_size, lcu_size) / lcu_size,
+                                    pic_param))
+        return VA_STATUS_ERROR_INVALID_PARAMETER;
+
+    /*
+     * The HCP cannot encode tile columns, so a tile is a band of LCU rows,
+     * and every slice must stay within one of them: the slices then need no
+     * entry points, and the tiles are walked as independent slices.
+     */
+    if (tiles.num_columns > 1)
+        return VA_STATUS_ERROR_ATTR_NOT_SUPPORTED;
+
     for (i = 0; i < encode_state->num_slice_params_ext; i++) {
         slice_param = (VAEncSliceParameterBufferHEVC *)encode_state->slice_params_ext[i]->buffer;
 
@@ -1020,6 +1041,13 @@ gen9_hevc_enc_check_parameters(VADriverContextP ctx,
         if (slice_param->num_ref_idx_l0_active_minus1 > GEN9_HEVC_NUM_MAX_REF_L0 - 1 ||
             slice_param->num_ref_idx_l1_active_minus1 > GEN9_HEVC_NUM_MAX_REF_L1 - 1)
             return VA_STATUS_ERROR_ATTR_NOT_SUPPORTED;
+
+        if (tiles.num_rows > 1 &&
+            !gen9_hevc_tile_slice_is_valid(&tiles,
+                                           slice_param->slice_segment_address,
+                                           slice_param->num_ctu_in_slice,
+                                           slice_param->slice_fields.bits.dependent_slice_segment_flag))
+            return VA_STATUS_ERROR_INVALID_PARAMETER;
     }
 
     i = 1 << (seq_param->log2_diff_max_min_luma_coding_block_size +
@@ -1053,9 +1081,14 @@ gen9_hevc_enc_init_seq_parameters(struct gen9_hevc_encoder_context *priv_ctx,
                                   VAEncSequenceParameterBufferHEVC *seq_param)
 {
     int new = 0, m = 0, n = 0;
-
-    if (priv_state->picture_width != seq_param->pic_width_in_luma_samples ||
-        priv_state->picture_height != seq_param->pic_height_in_luma_samples ||
+    unsigned int cu_size = 1 << (seq_param->log2_min_luma_coding_block_size_minus3 + 3);
+    unsigned int lcu_size = cu_size << seq_param->log2_diff_max_min_luma_coding_block_size;
+
+    /* the picture size is kept in whole CUs */
+    if (priv_state->picture_width != seq_param->pic_width_in_luma_samples / cu_size * cu_size ||
+        priv_state->picture_height != seq_param->pic_height_in_luma_samples / cu_size * cu_size ||
+        priv_state->cu_size != cu_size ||
+        priv_state->lcu_size != lcu_size ||
         priv_state->bit_depth_luma_minus8 != seq_param->seq_fields.bits.bit_depth_luma_minus8 ||
         priv_state->bit_depth_chroma_minus8 != seq_param->seq_fields.bits.bit_depth_chroma_minus8)
         new = 1;
@@ -1174,6 +1207,11 @@ gen9_hevc_enc_init_pic_parameters(struct generic_enc_codec_state *generic_state,
 
     priv_state->picture_coding_type = slice_param->slice_type;
 
+    gen9_hevc_tile_layout_init(&priv_state->tiles,
+                               priv_state->width_in_lcu,
+                               priv_state->height_in_lcu,
+                               pic_param);
+
     priv_state->ctu_max_bitsize_allowed = pic_param->ctu_max_bitsize_allowed;
     log2_max_coding_block_size  = seq_param->log2_min_luma_coding_block_size_minus3 + 3 +
                                   seq_param->log2_diff_max_min_luma_coding_block_size;
@@ -1258,7 +1296,12 @@ gen9_hevc_enc_init_parameters(VADriverContextP ctx,
     if (va_status != VA_STATUS_SUCCESS)
         return va_status;
 
-    gen9_hevc_enc_init_seq_parameters(priv_ctx, generic_state, priv_state, seq_param);
+    /* the same sequence parameters as the previous frame, nothing to derive */
+    if (I965_ENCODER_PARAMS_CHANGED(&encoder_context->params, I965_ENCODER_PARAMS_SEQ))
+        gen9_hevc_enc_init_seq_parameters(priv_ctx, generic_state, priv_state, seq_param);
+    else
+        i965_encoder_params_skip(&encoder_context->params, I965_ENCODER_PARAMS_SEQ);
+
     gen9_hevc_enc_init_pic_parameters(generic_state, priv_state, seq_param, pic_param, slice_param);
     gen9_hevc_enc_init_slice_parameters(ctx, encode_state, encoder_context);
 
@@ -1406,64 +1449,6 @@ gen9_hevc_vme_init_scoreboard(struct i965_gpe_context *gpe_context,
     gpe_context->vfe_desc7.scoreboard2.delta_y7 = -2;
 }
 
-static void
-gen9_hevc_vme_set_scoreboard_26z(struct i965_gpe_context *gpe_context,
-                                 unsigned int mask,
-                                 unsigned int enable,
-                                 unsigned int type)
-{
-    gpe_context->vfe_desc5.scoreboard0.mask = mask;
-    gpe_context->vfe_desc5.scoreboard0.type = type;
-    gpe_context->vfe_desc5.scoreboard0.enable = enable;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x0 = -1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y0 = 3;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x1 = -1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y1 = 1;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x2 = -1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y2 = -1;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x3 = 0;
-    gpe_context->vfe_desc6.scoreboard1.delta_y3 = -1;
-
-    gpe_context->vfe_desc7.scoreboard2.delta_x4 = 0;
-    gpe_context->vfe_desc7.scoreboard2.delta_y4 = -2;
-
-    gpe_context->vfe_desc7.scoreboard2.delta_x5 = 0;
-    gpe_context->vfe_desc7.scoreboard2.delta_y5 = -3;
-
-    gpe_context->vfe_desc7.scoreboard2.delta_x6 = 1;
-    gpe_context->vfe_desc7.scoreboard2.delta_y6 = -2;
-
-    gpe_context->vfe_desc7.scoreboard2.delta_x7 = 1;
-    gpe_context->vfe_desc7.scoreboard2.delta_y7 = -3;
-}
-
-static void
-gen9_hevc_vme_set_scoreboard_26(struct i965_gpe_context *gpe_context,
-                                unsigned int mask,
-                                unsigned int enable,
-                                unsigned int type)
-{
-    gpe_context->vfe_desc5.scoreboard0.mask = mask;
-    gpe_context->vfe_desc5.scoreboard0.type = type;
-    gpe_context->vfe_desc5.scoreboard0.enable = enable;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x0 = -1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y0 = 0;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x1 = -1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y1 = -1;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x2 = 0;
-    gpe_context->vfe_desc6.scoreboard1.delta_y2 = -1;
-
-    gpe_context->vfe_desc6.scoreboard1.delta_x3 = 1;
-    gpe_context->vfe_desc6.scoreboard1.delta_y3 = -1;
-}
-
 static void
 gen9_hevc_init_object_walker(struct hevc_enc_kernel_walker_parameter *hevc_walker_param,
                              struct gpe_media_object_walker_parameter *gpe_param)
@@ -1494,101 +1479,6 @@ gen9_hevc_init_object_walker(struct hevc_enc_kernel_walker_parameter *hevc_walke
     }
 }
 
-static void
-gen9_hevc_init_object_walker_26z(struct gen9_hevc_encoder_state *priv_state,
-                                 struct i965_gpe_context *gpe_context,
-                                 struct gpe_media_object_walker_parameter *gpe_param,
-                                 int split_count,
-                                 unsigned int max_slight_height,
-                                 int use_hw_scoreboard,
-                                 int scoreboard_type)
-{
-    int width = priv_state->width_in_mb;
-    int height = max_slight_height * 2;
-    int ts_width = ((width + 3) & 0xfffc) >> 1;
-    int lcu_width = (width + 1) >> 1;
-    int lcu_height = (height + 1) >> 1;
-    int tmp1 = ((lcu_width + 1) >> 1) + ((lcu_width + ((lcu_height - 1) << 1)) + (2 * split_count - 1)) /
-               (2 * split_count);
-
-    gpe_param->use_scoreboard  = use_hw_scoreboard;
-    gpe_param->scoreboard_mask = 0xFF;
-    gpe_param->global_resolution.x = ts_width;
-    gpe_param->global_resolution.y = 4 * tmp1;
-    gpe_param->global_start.x = 0;
-    gpe_param->global_start.y = 0;
-    gpe_param->global_outer_loop_stride.x = ts_width;
-    gpe_param->global_outer_loop_stride.y = 0;
-    gpe_param->global_inner_loop_unit.x = 0;
-    gpe_param->global_inner_loop_unit.y = 4 * tmp1;
-    gpe_param->block_resolution.x = ts_width;
-    gpe_param->block_resolution.y = 4 * tmp1;
-    gpe_param->local_start.x = ts_width;
-    gpe_param->local_start.y = 0;
-    gpe_param->local_end.x = 0;
-    gpe_param->local_end.y = 0;
-    gpe_param->local_outer_loop_stride.x = 1;
-    gpe_param->local_outer_loop_stride.y = 0;
-    gpe_param->local_inner_loop_unit.x = -2;
-    gpe_param->local_inner_loop_unit.y = 4;
-    gpe_param->middle_loop_extra_steps = 3;
-    gpe_param->mid_loop_unit_x = 0;
-    gpe_param->mid_loop_unit_y = 1;
-    gpe_param->global_loop_exec_count = 0;
-    gpe_param->local_loop_exec_count = ((lcu_width + (lcu_height - 1) * 2 + 2 * split_count - 1) /
-                                        (2 * split_count)) * 2 -
-                                       1;
-
-    gen9_hevc_vme_set_scoreboard_26z(gpe_context, 0xff, use_hw_scoreboard, scoreboard_type);
-}
-
-static void
-gen9_hevc_init_object_walker_26(struct gen9_hevc_encoder_state *priv_state,
-                                struct i965_gpe_context *gpe_context,
-                                struct gpe_media_object_walker_parameter *gpe_param,
-                                int split_count,
-                                unsigned int max_slight_height,
-                                int use_hw_scoreboard,
-                                int scoreboard_type)
-{
-    int width = priv_state->width_in_mb;
-    int height = max_slight_height;
-    int ts_width = (width + 1) & 0xfffe;
-    int ts_height = (height + 1) & 0xfffe;
-    int tmp1 = ((ts_width + 1) >> 1) +
-               ((ts_width + ((ts_height - 1) << 1)) +
-                (2 * split_count - 1)) / (2 * split_count);
-
-    gpe_param->use_scoreboard = use_hw_scoreboard;
-    gpe_param->scoreboard_mask = 0x0f;
-    gpe_param->global_resolution.x = ts_width;
-    gpe_param->global_resolution.y = tmp1;
-    gpe_param->global_start.x = 0;
-    gpe_param->global_start.y = 0;
-    gpe_param->global_outer_loop_stride.x = ts_width;
-    gpe_param->global_outer_loop_stride.y = 0;
-    gpe_param->global_inner_loop_unit.x = 0;
-    gpe_param->global_inner_loop_unit.y = tmp1;
-    gpe_param->block_resolution.x = ts_width;
-    gpe_param->block_resolution.y = tmp1;
-    gpe_param->local_start.x = ts_width;
-    gpe_param->local_start.y = 0;
-    gpe_param->local_end.x = 0;
-    gpe_param->local_end.y = 0;
-    gpe_param->local_outer_loop_stride.x = 1;
-    gpe_param->local_outer_loop_stride.y = 0;
-    gpe_param->local_inner_loop_unit.x = -2;
-    gpe_param->local_inner_loop_unit.y = 1;
-    gpe_param->middle_loop_extra_steps = 0;
-    gpe_param->mid_loop_unit_x = 0;
-    gpe_param->mid_loop_unit_y = 0;
-    gpe_param->global_loop_exec_count = 0;
-    gpe_param->local_loop_exec_count = (width + (height - 1) * 2 + split_count - 1) /
-                                       split_count;
-
-    gen9_hevc_vme_set_scoreboard_26(gpe_context, 0xff, use_hw_scoreboard, scoreboard_type);
-}
-
 static void
 gen9_hevc_run_object_walker(VADriverContextP ctx,
                             struct intel_encoder_context *encoder_context,
@@ -1707,6 +1597,8 @@ gen9_hevc_brc_prepare(struct encode_state *encode_state,
     enum HEVC_BRC_METHOD brc_method = HEVC_BRC_CQP;
     int internal_tu_mode = encoder_context->quality_level;
     int brc_reset = 0;
+    /* the kernel BRC runs at the rate of the whole stream, the layers get their budgets in layer_brc */
+    int top_layer = encoder_context->layer.num_layers > 1 ? encoder_context->layer.num_layers - 1 : 0;
 
     vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
     generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
@@ -1752,38 +1644,38 @@ gen9_hevc_brc_prepare(struct encode_state *encode_state,
             generic_state->num_pak_passes = 4;
 
             if (brc_method == HEVC_BRC_VCM ||
-                encoder_context->brc.mb_rate_control[0] == 0)
+                encoder_context->brc.mb_rate_control[top_layer] == 0)
                 priv_state->lcu_brc_enabled = (priv_state->tu_mode == HEVC_TU_BEST_QUALITY);
             else if (brc_method == HEVC_BRC_ICQ ||
-                     encoder_context->brc.mb_rate_control[0] == 1)
+                     encoder_context->brc.mb_rate_control[top_layer] == 1)
                 priv_state->lcu_brc_enabled = 1;
             else
                 priv_state->lcu_brc_enabled = 0;
 
             priv_state->max_bit_rate_in_kbs =
-                ALIGN(encoder_context->brc.bits_per_second[0], HEVC_BRC_KBPS) /
+                ALIGN(encoder_context->brc.bits_per_second[top_layer], HEVC_BRC_KBPS) /
                 HEVC_BRC_KBPS;
 
             if (brc_method == HEVC_BRC_CBR) {
                 priv_state->target_bit_rate_in_kbs = priv_state->max_bit_rate_in_kbs;
                 priv_state->min_bit_rate_in_kbs = priv_state->max_bit_rate_in_kbs;
             } else {
-                if (encoder_context->brc.target_percentage[0] > HEVC_BRC_MIN_TARGET_PERCENTAGE)
+                if (encoder_context->brc.target_percentage[top_layer] > HEVC_BRC_MIN_TARGET_PERCENTAGE)
                     priv_state->min_bit_rate_in_kbs = priv_state->max_bit_rate_in_kbs *
-                                                      (2 * encoder_context->brc.target_percentage[0] - 100) /
+                                                      (2 * encoder_context->brc.target_percentage[top_layer] - 100) /
                                                       100;
                 else
                     priv_state->min_bit_rate_in_kbs = 0;
 
                 priv_state->target_bit_rate_in_kbs = priv_state->max_bit_rate_in_kbs *
-                                                     encoder_context->brc.target_percentage[0] / 100;
+                                                     encoder_context->brc.target_percentage[top_layer] / 100;
 
                 brc_reset = 1;
             }
 
-            if (encoder_context->brc.framerate[0].den)
-                priv_state->frames_per_100s = encoder_context->brc.framerate[0].num * 100 /
-                                              encoder_context->brc.framerate[0].den;
+            if (encoder_context->brc.framerate[top_layer].den)
+                priv_state->frames_per_100s = encoder_context->brc.framerate[top_layer].num * 100 /
+                                              encoder_context->brc.framerate[top_layer].den;
 
             priv_state->init_vbv_buffer_fullness_in_bit =
                 encoder_context->brc.hrd_initial_buffer_fullness;
@@ -2710,6 +2602,11 @@ gen9_hevc_brc_update_set_curbe(VADriverContextP ctx,
     memcpy((void *)cmd, GEN9_HEVC_BRCUPDATE_CURBE_DATA,
            sizeof(GEN9_HEVC_BRCUPDATE_CURBE_DATA));
 
+    /* a temporal layer frame is aimed at the budget of its layer rather than the average frame */
+    if (encoder_context->layer_brc.num_layers)
+        priv_state->brc_init_current_target_buf_full_in_bits += encoder_context->layer_brc.budget -
+                                                                priv_state->brc_init_reset_input_bits_per_frame;
+
     cmd->dw5.target_size_flag = 0;
     if (priv_state->brc_init_current_target_buf_full_in_bits >
         (double)priv_state->brc_init_reset_buf_size_in_bits) {
@@ -3955,6 +3852,7 @@ gen9_hevc_set_control_region(VADriverContextP ctx,
     struct encoder_vme_mfc_context *vme_context = NULL;
     struct gen9_hevc_encoder_context *priv_ctx = NULL;
     struct gen9_hevc_encoder_state *priv_state = NULL;
+    VAEncPictureParameterBufferHEVC *pic_param = NULL;
     VAEncSliceParameterBufferHEVC *slice_param = NULL;
     gen9_hevc_mbenc_control_region *p_region = NULL;
     unsigned int slice, num_regions, height, num_slices, num_units_in_region;
@@ -3965,6 +3863,7 @@ gen9_hevc_set_control_region(VADriverContextP ctx,
     int is_arbitrary_slices = 0;
     int slice_start_y[I965_MAX_NUM_SLICE + 1];
     int max_height;
+    unsigned int walker_degree;
     int k = 0, i = 0;
 
     vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
@@ -3990,10 +3889,29 @@ gen9_hevc_set_control_region(VADriverContextP ctx,
         frame_height_in_units = ALIGN(priv_state->picture_height, 32) / 32;
     }
 
+    pic_param = (VAEncPictureParameterBufferHEVC *)encode_state->pic_param_ext->buffer;
+
     for (slice = 0; slice < encode_state->num_slice_params_ext; slice++) {
         slice_param = (VAEncSliceParameterBufferHEVC *)encode_state->slice_params_ext[slice]->buffer;
-        if (slice_param->slice_segment_address %
-            ALIGN(priv_state->picture_width, 32)) {
+
+        /*
+         * The slices of a tiled picture are made of whole LCU rows, each
+         * tile is walked as regions of its own, started at once.
+         */
+        if (pic_param->pic_fields.bits.tiles_enabled_flag) {
+            if (priv_state->lcu_size != 32 ||
+                slice_param->slice_segment_address % priv_state->width_in_lcu) {
+                is_arbitrary_slices = 1;
+            } else {
+                slice_start_y[slice] = slice_param->slice_segment_address /
+                                       priv_state->width_in_lcu;
+
+                if (priv_state->walking_pattern_26) {
+                    slice_start_y[slice] *= 2;
+                }
+            }
+        } else if (slice_param->slice_segment_address %
+                   ALIGN(priv_state->picture_width, 32)) {
             is_arbitrary_slices = 1;
         } else {
             slice_start_y[slice] = slice_param->slice_segment_address /
@@ -4193,16 +4111,15 @@ gen9_hevc_set_control_region(VADriverContextP ctx,
         }
     }
 
-    if (priv_state->walking_pattern_26)
-        gen9_hevc_init_object_walker_26(priv_state, gpe_context, &param->gpe_param,
-                                        priv_state->num_regions_in_slice, max_height,
-                                        priv_state->use_hw_scoreboard,
-                                        priv_state->use_hw_non_stalling_scoreborad);
-    else
-        gen9_hevc_init_object_walker_26z(priv_state, gpe_context, &param->gpe_param,
-                                         priv_state->num_regions_in_slice, max_height,
-                                         priv_state->use_hw_scoreboard,
-                                         priv_state->use_hw_non_stalling_scoreborad);
+    walker_degree = priv_state->walking_pattern_26 ? WALKER_26_DEGREE : WALKER_26Z_DEGREE;
+
+    param->gpe_param.use_scoreboard = priv_state->use_hw_scoreboard;
+    i965_walker_init_regions(walker_degree, priv_state->width_in_mb,
+                             priv_state->walking_pattern_26 ? max_height : max_height * 2,
+                             priv_state->num_regions_in_slice, &param->gpe_param);
+    i965_walker_set_scoreboard(gpe_context, walker_degree, 0xff,
+                               priv_state->use_hw_scoreboard,
+                               priv_state->use_hw_non_stalling_scoreborad);
 
     p_region = (gen9_hevc_mbenc_control_region *)i965_map_gpe_resource(&priv_ctx->res_con_corrent_thread_buffer);
     if (!p_region)
@@ -6178,10 +6095,26 @@ static void
 gen9_hevc_vme_kernels_context_init(VADriverContextP ctx,
                                    struct intel_encoder_context *encoder_context)
 {
+    struct encoder_vme_mfc_context *vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct gen9_hevc_encoder_context *priv_ctx = (struct gen9_hevc_encoder_context *)vme_context->private_enc_ctx;
+    struct i965_gpe_state_heap *heap = &encoder_context->gpe_state_heap;
+    int i;
+
     gen9_hevc_vme_scaling_context_init(ctx, encoder_context);
     gen9_hevc_vme_me_context_init(ctx, encoder_context);
     gen9_hevc_vme_mbenc_context_init(ctx, encoder_context);
     gen9_hevc_vme_brc_context_init(ctx, encoder_context);
+
+    /* all the kernels recycle their state BOs from the same heap */
+    i965_gpe_context_set_state_heap(priv_ctx->scaling_context.gpe_contexts,
+                                    NUM_HEVC_ENC_SCALING, heap);
+    for (i = 0; i < NUM_HEVC_ENC_ME_TYPES; i++)
+        i965_gpe_context_set_state_heap(priv_ctx->me_context.gpe_context[i],
+                                        NUM_HEVC_ENC_ME, heap);
+    i965_gpe_context_set_state_heap(priv_ctx->mbenc_context.gpe_contexts,
+                                    GEN8_HEVC_ENC_MBENC_TOTAL_NUM, heap);
+    i965_gpe_context_set_state_heap(priv_ctx->brc_context.gpe_contexts,
+                                    GEN9_HEVC_ENC_BRC_NUM, heap);
 }
 
 static void
@@ -6626,6 +6559,8 @@ gen9_hevc_pak_add_slice_state(VADriverContextP ctx,
     int slice_hor_pos, slice_ver_pos, next_slice_hor_pos, next_slice_ver_pos;
     int slice_type = 0, slice_end = 0, last_slice = 0;
     int collocated_ref_idx = 0;
+    int slice_start_rs = 0, slice_end_rs = 0, tile_row = 0;
+    int loop_filter_across_slices = 0;
 
     pak_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
     priv_state = (struct gen9_hevc_encoder_state *)pak_context->private_enc_state;
@@ -6634,15 +6569,38 @@ gen9_hevc_pak_add_slice_state(VADriverContextP ctx,
 
     slice_type = slice_param->slice_type;
     slice_end = slice_param->slice_segment_address + slice_param->num_ctu_in_slice;
-    slice_hor_pos = slice_param->slice_segment_address % priv_state->width_in_lcu;
-    slice_ver_pos = slice_param->slice_segment_address / priv_state->width_in_lcu;
-    next_slice_hor_pos = slice_end % priv_state->width_in_lcu;
-    next_slice_ver_pos = slice_end / priv_state->width_in_lcu;
 
     if (slice_end >= priv_state->width_in_lcu * priv_state->height_in_lcu ||
         slice_idx == encode_state->num_slice_params_ext - 1)
         last_slice = 1;
 
+    /*
+     * The slice addresses are in tile scan. With the tiles of whole LCU
+     * rows accepted here it is the raster scan, the mapping only matters
+     * once tile columns are.
+     */
+    slice_start_rs = gen9_hevc_tile_ctb_addr_ts_to_rs(&priv_state->tiles,
+                                                      slice_param->slice_segment_address);
+    slice_end_rs = last_slice ? slice_end :
+                   gen9_hevc_tile_ctb_addr_ts_to_rs(&priv_state->tiles, slice_end);
+
+    slice_hor_pos = slice_start_rs % priv_state->width_in_lcu;
+    slice_ver_pos = slice_start_rs / priv_state->width_in_lcu;
+    next_slice_hor_pos = slice_end_rs % priv_state->width_in_lcu;
+    next_slice_ver_pos = slice_end_rs / priv_state->width_in_lcu;
+
+    /*
+     * A slice starting a tile is filtered against the one above only if the
+     * loop filter also runs across the tiles.
+     */
+    loop_filter_across_slices = slice_param->slice_fields.bits.slice_loop_filter_across_slices_enabled_flag;
+    tile_row = gen9_hevc_tile_id(&priv_state->tiles, slice_start_rs) / priv_state->tiles.num_columns;
+
+    if (pic_param->pic_fields.bits.tiles_enabled_flag &&
+        !pic_param->pic_fields.bits.loop_filter_across_tiles_enabled_flag &&
+        slice_param->slice_segment_address == priv_state->tiles.row_start[tile_row] * priv_state->width_in_lcu)
+        loop_filter_across_slices = 0;
+
     if (priv_state->picture_coding_type != HEVC_SLICE_I &&
         slice_param->slice_fields.bits.slice_temporal_mvp_enabled_flag &&
         slice_param->slice_fields.bits.collocated_from_l0_flag)
@@ -6683,7 +6641,7 @@ gen9_hevc_pak_add_slice_state(VADriverContextP ctx,
                   slice_param->slice_fields.bits.mvd_l1_zero_flag << 13 |
                   slice_param->slice_fields.bits.slice_sao_luma_flag << 12 |
                   slice_param->slice_fields.bits.slice_sao_chroma_flag << 11 |
-                  slice_param->slice_fields.bits.slice_loop_filter_across_slices_enabled_flag << 10 |
+                  loop_filter_across_slices << 10 |
                   (slice_param->slice_beta_offset_div2 & 0xf) << 5 |
                   (slice_param->slice_tc_offset_div2 & 0xf) << 1 |
                   slice_param->slice_fields.bits.slice_deblocking_filter_disabled_flag);
@@ -7173,6 +7131,7 @@ gen9_hevc_pak_read_status(VADriverContextP ctx,
     struct gen9_hevc_encoder_state *priv_state = NULL;
     struct gpe_mi_flush_dw_parameter mi_flush_dw_param;
     struct hevc_encode_status_buffer *status_buffer = NULL;
+    struct i965_encoder_status_regs status_regs;
 
     pak_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
     priv_ctx = (struct gen9_hevc_encoder_context *)pak_context->private_enc_ctx;
@@ -7209,6 +7168,14 @@ gen9_hevc_pak_read_status(VADriverContextP ctx,
     }
 
     gen8_gpe_mi_flush_dw(ctx, batch, &mi_flush_dw_param);
+
+    memset(&status_regs, 0, sizeof(status_regs));
+    status_regs.bs_byte_count_frame = status_buffer->mmio_bs_frame_offset;
+    status_regs.bs_byte_count_frame_nh = status_buffer->mmio_bs_frame_no_header_offset;
+    status_regs.image_status_mask = status_buffer->mmio_image_mask_offset;
+    status_regs.image_status_ctrl = status_buffer->mmio_image_ctrl_offset;
+    i965_encoder_status_ring_emit(ctx, batch, &encoder_context->status_ring, 0,
+                                  &status_regs, generic_state->curr_pak_pass + 1);
 }
 
 static VAStatus
@@ -7434,5 +7401,9 @@ gen9_hevc_pak_context_init(VADriverContextP ctx,
     encoder_context->mfc_pipeline = gen9_hevc_pak_pipeline;
     encoder_context->mfc_brc_prepare = gen9_hevc_brc_prepare;
     encoder_context->get_status = gen9_hevc_get_coded_status;
+
+    /* not fatal, the coded buffers still carry the status */
+    i965_encoder_status_ring_alloc(ctx, &encoder_context->status_ring, 1);
+
     return true;
 }
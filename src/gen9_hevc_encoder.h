@@ -36,6 +36,7 @@
 #include <va/va.h>
 #include "i965_gpe_utils.h"
 #include "gen9_hevc_enc_kernels.h"
+#include "gen9_hevc_enc_utils.h"
 
 // VME parameters
 struct hevc_enc_kernel_walker_parameter {
@@ -431,6 +432,8 @@ struct gen9_hevc_encoder_state {
     int width_in_mb;
     int height_in_mb;
 
+    struct gen9_hevc_tile_layout tiles;
+
     int mb_data_offset;
     int mb_code_size;
     int pak_obj_size;
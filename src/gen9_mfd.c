@@ -83,6 +83,8 @@ gen9_hcpd_init_hevc_surface(VADriverContextP ctx,
         obj_surface->private_data = gen9_hevc_surface;
     }
 
+    gen9_hevc_surface->dmv_pool = &i965->dmv_pools[I965_DMV_POOL_HEVC];
+
     if (gen9_hevc_surface->motion_vector_temporal_bo == NULL) {
         uint32_t size;
 
@@ -94,10 +96,8 @@ gen9_hcpd_init_hevc_surface(VADriverContextP ctx,
                    ((gen9_hcpd_context->picture_height_in_pixels + 31) >> 5);
 
         size <<= 6; /* in unit of 64bytes */
-        gen9_hevc_surface->motion_vector_temporal_bo = dri_bo_alloc(i965->intel.bufmgr,
-                                                                    "motion vector temporal buffer",
-                                                                    size,
-                                                                    0x1000);
+        gen9_hevc_surface->motion_vector_temporal_bo = i965_dmv_pool_get(gen9_hevc_surface->dmv_pool,
+                                                                         size);
     }
 }
 
@@ -650,31 +650,54 @@ gen9_hcpd_get_reference_picture_frame_id(VAPictureHEVC *ref_pic,
     return 0;
 }
 
+/* Emits a slice level command, unless it is identical to the one
+   previously emitted into the same cache entry for this picture */
+static void
+gen9_hcpd_emit_cached_state(struct intel_batchbuffer *batch,
+                            uint32_t *cmd,
+                            int num_dwords,
+                            uint32_t *cache,
+                            uint8_t *cache_valid,
+                            struct gen9_hcpd_context *gen9_hcpd_context)
+{
+    const unsigned int size = num_dwords * sizeof(uint32_t);
+
+    if (gen9_hcpd_context->slice_state_dedup &&
+        *cache_valid && memcmp(cache, cmd, size) == 0) {
+        gen9_hcpd_context->skipped_slice_state_bytes += size;
+        return;
+    }
+
+    BEGIN_BCS_BATCH(batch, num_dwords);
+    intel_batchbuffer_data(batch, cmd, size);
+    ADVANCE_BCS_BATCH(batch);
+
+    memcpy(cache, cmd, size);
+    *cache_valid = 1;
+}
+
 static void
 gen9_hcpd_ref_idx_state_1(struct intel_batchbuffer *batch,
                           int list,
                           VAPictureParameterBufferHEVC *pic_param,
                           VASliceParameterBufferHEVC *slice_param,
-                          GenFrameStore frame_store[MAX_GEN_HCP_REFERENCE_FRAMES])
+                          struct gen9_hcpd_context *gen9_hcpd_context)
 {
+    GenFrameStore * const frame_store = gen9_hcpd_context->reference_surfaces;
     int i;
     uint8_t num_ref_minus1 = (list ? slice_param->num_ref_idx_l1_active_minus1 : slice_param->num_ref_idx_l0_active_minus1);
     uint8_t *ref_list = slice_param->RefPicList[list];
+    uint32_t cmd[18];
 
-    BEGIN_BCS_BATCH(batch, 18);
-
-    OUT_BCS_BATCH(batch, HCP_REF_IDX_STATE | (18 - 2));
-    OUT_BCS_BATCH(batch,
-                  num_ref_minus1 << 1 |
-                  list);
+    cmd[0] = HCP_REF_IDX_STATE | (18 - 2);
+    cmd[1] = num_ref_minus1 << 1 | list;
 
     for (i = 0; i < 16; i++) {
         if (i < MIN((num_ref_minus1 + 1), 15)) {
             VAPictureHEVC *ref_pic = &pic_param->ReferenceFrames[ref_list[i]];
             VAPictureHEVC *curr_pic = &pic_param->CurrPic;
 
-            OUT_BCS_BATCH(batch,
-                          !(ref_pic->flags & VA_PICTURE_HEVC_BOTTOM_FIELD) << 15 |
+            cmd[2 + i] = (!(ref_pic->flags & VA_PICTURE_HEVC_BOTTOM_FIELD) << 15 |
                           !!(ref_pic->flags & VA_PICTURE_HEVC_FIELD_PIC) << 14 |
                           !!(ref_pic->flags & VA_PICTURE_HEVC_LONG_TERM_REFERENCE) << 13 |
                           0 << 12 |
@@ -682,11 +705,14 @@ gen9_hcpd_ref_idx_state_1(struct intel_batchbuffer *batch,
                           gen9_hcpd_get_reference_picture_frame_id(ref_pic, frame_store) << 8 |
                           (CLAMP(-128, 127, curr_pic->pic_order_cnt - ref_pic->pic_order_cnt) & 0xff));
         } else {
-            OUT_BCS_BATCH(batch, 0);
+            cmd[2 + i] = 0;
         }
     }
 
-    ADVANCE_BCS_BATCH(batch);
+    gen9_hcpd_emit_cached_state(batch, cmd, 18,
+                                gen9_hcpd_context->ref_idx_state_cache[list],
+                                &gen9_hcpd_context->ref_idx_state_cache_valid[list],
+                                gen9_hcpd_context);
 }
 
 static void
@@ -700,18 +726,19 @@ gen9_hcpd_ref_idx_state(VADriverContextP ctx,
     if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_I)
         return;
 
-    gen9_hcpd_ref_idx_state_1(batch, 0, pic_param, slice_param, gen9_hcpd_context->reference_surfaces);
+    gen9_hcpd_ref_idx_state_1(batch, 0, pic_param, slice_param, gen9_hcpd_context);
 
     if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_P)
         return;
 
-    gen9_hcpd_ref_idx_state_1(batch, 1, pic_param, slice_param, gen9_hcpd_context->reference_surfaces);
+    gen9_hcpd_ref_idx_state_1(batch, 1, pic_param, slice_param, gen9_hcpd_context);
 }
 
 static void
 gen9_hcpd_weightoffset_state_1(struct intel_batchbuffer *batch,
                                int list,
-                               VASliceParameterBufferHEVC *slice_param)
+                               VASliceParameterBufferHEVC *slice_param,
+                               struct gen9_hcpd_context *gen9_hcpd_context)
 {
     int i;
     uint8_t num_ref_minus1 = (list == 1) ? slice_param->num_ref_idx_l1_active_minus1 : slice_param->num_ref_idx_l0_active_minus1;
@@ -719,34 +746,34 @@ gen9_hcpd_weightoffset_state_1(struct intel_batchbuffer *batch,
     int8_t *delta_luma_weight = (list == 1) ? slice_param->delta_luma_weight_l1 : slice_param->delta_luma_weight_l0;
     int8_t (* chroma_offset)[2] = (list == 1) ? slice_param->ChromaOffsetL1 : slice_param->ChromaOffsetL0;
     int8_t (* delta_chroma_weight)[2] = (list == 1) ? slice_param->delta_chroma_weight_l1 : slice_param->delta_chroma_weight_l0;
+    uint32_t cmd[34];
 
-    BEGIN_BCS_BATCH(batch, 34);
-
-    OUT_BCS_BATCH(batch, HCP_WEIGHTOFFSET | (34 - 2));
-    OUT_BCS_BATCH(batch, list);
+    cmd[0] = HCP_WEIGHTOFFSET | (34 - 2);
+    cmd[1] = list;
 
     for (i = 0; i < 16; i++) {
         if (i < MIN((num_ref_minus1 + 1), 15)) {
-            OUT_BCS_BATCH(batch,
-                          (luma_offset[i] & 0xff) << 8 |
+            cmd[2 + i] = ((luma_offset[i] & 0xff) << 8 |
                           (delta_luma_weight[i] & 0xff));
         } else {
-            OUT_BCS_BATCH(batch, 0);
+            cmd[2 + i] = 0;
         }
     }
     for (i = 0; i < 16; i++) {
         if (i < MIN((num_ref_minus1 + 1), 15)) {
-            OUT_BCS_BATCH(batch,
-                          (chroma_offset[i][1] & 0xff) << 24 |
-                          (delta_chroma_weight[i][1] & 0xff) << 16 |
-                          (chroma_offset[i][0] & 0xff) << 8 |
-                          (delta_chroma_weight[i][0] & 0xff));
+            cmd[18 + i] = ((chroma_offset[i][1] & 0xff) << 24 |
+                           (delta_chroma_weight[i][1] & 0xff) << 16 |
+                           (chroma_offset[i][0] & 0xff) << 8 |
+                           (delta_chroma_weight[i][0] & 0xff));
         } else {
-            OUT_BCS_BATCH(batch, 0);
+            cmd[18 + i] = 0;
         }
     }
 
-    ADVANCE_BCS_BATCH(batch);
+    gen9_hcpd_emit_cached_state(batch, cmd, 34,
+                                gen9_hcpd_context->weightoffset_state_cache[list],
+                                &gen9_hcpd_context->weightoffset_state_cache_valid[list],
+                                gen9_hcpd_context);
 }
 
 static void
@@ -766,12 +793,12 @@ gen9_hcpd_weightoffset_state(VADriverContextP ctx,
          !pic_param->pic_fields.bits.weighted_bipred_flag))
         return;
 
-    gen9_hcpd_weightoffset_state_1(batch, 0, slice_param);
+    gen9_hcpd_weightoffset_state_1(batch, 0, slice_param, gen9_hcpd_context);
 
     if (slice_param->LongSliceFlags.fields.slice_type == HEVC_SLICE_P)
         return;
 
-    gen9_hcpd_weightoffset_state_1(batch, 1, slice_param);
+    gen9_hcpd_weightoffset_state_1(batch, 1, slice_param, gen9_hcpd_context);
 }
 
 static int
@@ -1002,6 +1029,11 @@ gen9_hcpd_hevc_decode_picture(VADriverContextP ctx,
     if (pic_param->pic_fields.bits.tiles_enabled_flag)
         gen9_hcpd_tile_state(ctx, decode_state, gen9_hcpd_context);
 
+    memset(gen9_hcpd_context->ref_idx_state_cache_valid, 0,
+           sizeof(gen9_hcpd_context->ref_idx_state_cache_valid));
+    memset(gen9_hcpd_context->weightoffset_state_cache_valid, 0,
+           sizeof(gen9_hcpd_context->weightoffset_state_cache_valid));
+
     /* Need to double it works or not if the two slice groups have differenct slice data buffers */
     for (j = 0; j < decode_state->num_slice_params; j++) {
         assert(decode_state->slice_params && decode_state->slice_params[j]->buffer);
@@ -1946,6 +1978,7 @@ gen9_hcpd_hevc_context_init(VADriverContextP ctx,
                             struct gen9_hcpd_context *gen9_hcpd_context)
 {
     hevc_gen_default_iq_matrix(&gen9_hcpd_context->iq_matrix_hevc);
+    gen9_hcpd_context->slice_state_dedup = 1;
 }
 
 static void
@@ -95,6 +95,16 @@ struct gen9_hcpd_context {
     unsigned short first_inter_slice_collocated_from_l0_flag;
     int first_inter_slice_valid;
 
+    /* Last HCP_REF_IDX_STATE and HCP_WEIGHTOFFSET emitted for each list
+       in the current picture. Slices sharing the same reference lists
+       and weight tables don't emit them again */
+    uint32_t ref_idx_state_cache[2][18];
+    uint32_t weightoffset_state_cache[2][34];
+    uint8_t ref_idx_state_cache_valid[2];
+    uint8_t weightoffset_state_cache_valid[2];
+    uint8_t slice_state_dedup;          /* 0 emits them for every slice */
+    uint64_t skipped_slice_state_bytes;
+
     vp9_last_frame_status last_frame;
     FRAME_CONTEXT vp9_frame_ctx[FRAME_CONTEXTS];
     FRAME_CONTEXT vp9_fc_inter_default;
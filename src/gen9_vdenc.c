@@ -961,32 +961,39 @@ gen9_vdenc_update_roi_in_streamin_state(VADriverContextP ctx,
 {
     struct gen9_vdenc_context *vdenc_context = encoder_context->mfc_context;
     struct gen9_vdenc_streamin_state *streamin_state;
-    int row, col, i;
+    struct i965_encoder_roi_rect rects[3];
+    int i;
 
     if (!vdenc_context->num_roi)
         return;
 
+    /* The last one has higher priority */
+    for (i = 0; i < vdenc_context->num_roi; i++) {
+        rects[i].left = MAX(vdenc_context->roi[i].left, 0);
+        rects[i].right = MAX(vdenc_context->roi[i].right + 1, 0);
+        rects[i].top = MAX(vdenc_context->roi[i].top, 0);
+        rects[i].bottom = MAX(vdenc_context->roi[i].bottom + 1, 0);
+        rects[i].value = i + 1;
+    }
+
     streamin_state = (struct gen9_vdenc_streamin_state *)i965_map_gpe_resource(&vdenc_context->vdenc_streamin_res);
 
-    if (!streamin_state)
+    if (!streamin_state) {
+        i965_encoder_roi_map_reset(&vdenc_context->streamin_roi_map);
         return;
-
-    for (col = 0;  col < vdenc_context->frame_width_in_mbs; col++) {
-        for (row = 0; row < vdenc_context->frame_height_in_mbs; row++) {
-            streamin_state[row * vdenc_context->frame_width_in_mbs + col].dw0.roi_selection = 0; /* non-ROI region */
-
-            /* The last one has higher priority */
-            for (i = vdenc_context->num_roi - 1; i >= 0; i--) {
-                if ((col >= vdenc_context->roi[i].left && col <= vdenc_context->roi[i].right) &&
-                    (row >= vdenc_context->roi[i].top && row <= vdenc_context->roi[i].bottom)) {
-                    streamin_state[row * vdenc_context->frame_width_in_mbs + col].dw0.roi_selection = i + 1;
-
-                    break;
-                }
-            }
-        }
     }
 
+    /* roi_selection is the low byte of dw0, 0 for a non-ROI MB */
+    i965_encoder_roi_map_paint(&vdenc_context->streamin_roi_map,
+                               (uint8_t *)streamin_state,
+                               vdenc_context->frame_width_in_mbs * sizeof(*streamin_state),
+                               sizeof(*streamin_state),
+                               vdenc_context->frame_width_in_mbs,
+                               vdenc_context->frame_height_in_mbs,
+                               0,
+                               rects,
+                               vdenc_context->num_roi);
+
     i965_unmap_gpe_resource(&vdenc_context->vdenc_streamin_res);
 }
 
@@ -1004,6 +1011,9 @@ gen9_vdenc_avc_prepare(VADriverContextP ctx,
     VAEncPictureParameterBufferH264 *pic_param;
     VAEncSliceParameterBufferH264 *slice_param;
     VDEncAvcSurface *vdenc_avc_surface;
+    struct i965_gpe_resource streamin_res;
+    struct i965_encoder_roi_map streamin_roi_map;
+    unsigned int streamin_size;
     dri_bo *bo;
     int i, j, enable_avc_ildb = 0;
     int qp;
@@ -1171,12 +1181,33 @@ gen9_vdenc_avc_prepare(VADriverContextP ctx,
                                 "VDENC row store scratch buffer");
 
     assert(sizeof(struct gen9_vdenc_streamin_state) == 64);
-    i965_free_gpe_resource(&vdenc_context->vdenc_streamin_res);
-    ALLOC_VDENC_BUFFER_RESOURCE(vdenc_context->vdenc_streamin_res,
-                                vdenc_context->frame_width_in_mbs *
-                                vdenc_context->frame_height_in_mbs *
-                                sizeof(struct gen9_vdenc_streamin_state),
-                                "VDENC StreamIn buffer");
+
+    /*
+     * Two stream-in buffers in turn, the ROI of a buffer is repainted from
+     * what it held two frames ago. A buffer still used by the GPU is
+     * replaced rather than waited on.
+     */
+    streamin_res = vdenc_context->vdenc_streamin_res;
+    vdenc_context->vdenc_streamin_res = vdenc_context->vdenc_streamin_spare_res;
+    vdenc_context->vdenc_streamin_spare_res = streamin_res;
+
+    streamin_roi_map = vdenc_context->streamin_roi_map;
+    vdenc_context->streamin_roi_map = vdenc_context->streamin_spare_roi_map;
+    vdenc_context->streamin_spare_roi_map = streamin_roi_map;
+
+    streamin_size = vdenc_context->frame_width_in_mbs *
+                    vdenc_context->frame_height_in_mbs *
+                    sizeof(struct gen9_vdenc_streamin_state);
+
+    if (!vdenc_context->vdenc_streamin_res.bo ||
+        vdenc_context->vdenc_streamin_res.size != streamin_size ||
+        drm_intel_bo_busy(vdenc_context->vdenc_streamin_res.bo)) {
+        i965_free_gpe_resource(&vdenc_context->vdenc_streamin_res);
+        ALLOC_VDENC_BUFFER_RESOURCE(vdenc_context->vdenc_streamin_res,
+                                    streamin_size,
+                                    "VDENC StreamIn buffer");
+        i965_encoder_roi_map_reset(&vdenc_context->streamin_roi_map);
+    }
 
     /*
      * Calculate the index for each reference surface in list0 for the first slice
@@ -3905,6 +3936,7 @@ gen9_vdenc_free_resources(struct gen9_vdenc_context *vdenc_context)
     i965_free_gpe_resource(&vdenc_context->vdenc_row_store_scratch_res);
 
     i965_free_gpe_resource(&vdenc_context->vdenc_streamin_res);
+    i965_free_gpe_resource(&vdenc_context->vdenc_streamin_spare_res);
 }
 
 static void
@@ -35,6 +35,7 @@
 
 #include "i965_gpe_utils.h"
 #include "i965_encoder.h"
+#include "i965_encoder_roi_map.h"
 
 struct encode_state;
 
@@ -809,6 +810,9 @@ struct gen9_vdenc_context {
     struct i965_gpe_resource vdenc_row_store_scratch_res;                       // VDENC internal buffer
 
     struct i965_gpe_resource vdenc_streamin_res;
+    struct i965_gpe_resource vdenc_streamin_spare_res;                          // the previous frame's, used in turn
+    struct i965_encoder_roi_map streamin_roi_map;                               // what vdenc_streamin_res holds
+    struct i965_encoder_roi_map streamin_spare_roi_map;
 
     uint32_t    num_refs[2];
     uint32_t    list_ref_idx[2][32];
@@ -824,87 +824,23 @@ gen9_vp9_free_resources(struct gen9_encoder_context_vp9 *vme_context)
     return;
 }
 
+/* The walks of the VP9 kernels are the shared ones, only the degrees are numbered apart */
 static void
 gen9_init_media_object_walker_parameter(struct intel_encoder_context *encoder_context,
                                         struct gpe_encoder_kernel_walker_parameter *kernel_walker_param,
                                         struct gpe_media_object_walker_parameter *walker_param)
 {
-    memset(walker_param, 0, sizeof(*walker_param));
+    struct gpe_encoder_kernel_walker_parameter param = *kernel_walker_param;
 
-    walker_param->use_scoreboard = kernel_walker_param->use_scoreboard;
-
-    walker_param->block_resolution.x = kernel_walker_param->resolution_x;
-    walker_param->block_resolution.y = kernel_walker_param->resolution_y;
-
-    walker_param->global_resolution.x = kernel_walker_param->resolution_x;
-    walker_param->global_resolution.y = kernel_walker_param->resolution_y;
-
-    walker_param->global_outer_loop_stride.x = kernel_walker_param->resolution_x;
-    walker_param->global_outer_loop_stride.y = 0;
-
-    walker_param->global_inner_loop_unit.x = 0;
-    walker_param->global_inner_loop_unit.y = kernel_walker_param->resolution_y;
-
-    walker_param->local_loop_exec_count = 0xFFFF;  //MAX VALUE
-    walker_param->global_loop_exec_count = 0xFFFF;  //MAX VALUE
-
-    if (kernel_walker_param->no_dependency) {
-        walker_param->scoreboard_mask = 0;
-        walker_param->use_scoreboard = 0;
-        // Raster scan walking pattern
-        walker_param->local_outer_loop_stride.x = 0;
-        walker_param->local_outer_loop_stride.y = 1;
-        walker_param->local_inner_loop_unit.x = 1;
-        walker_param->local_inner_loop_unit.y = 0;
-        walker_param->local_end.x = kernel_walker_param->resolution_x - 1;
-        walker_param->local_end.y = 0;
-    } else {
-        walker_param->local_end.x = 0;
-        walker_param->local_end.y = 0;
-
-        if (kernel_walker_param->walker_degree == VP9_45Z_DEGREE) {
-            // 45z degree
-            walker_param->scoreboard_mask = 0x0F;
-
-            walker_param->global_loop_exec_count = 0x3FF;
-            walker_param->local_loop_exec_count = 0x3FF;
-
-            walker_param->global_resolution.x = (unsigned int)(kernel_walker_param->resolution_x / 2.f) + 1;
-            walker_param->global_resolution.y = 2 * kernel_walker_param->resolution_y;
-
-            walker_param->global_start.x = 0;
-            walker_param->global_start.y = 0;
-
-            walker_param->global_outer_loop_stride.x = walker_param->global_resolution.x;
-            walker_param->global_outer_loop_stride.y = 0;
-
-            walker_param->global_inner_loop_unit.x = 0;
-            walker_param->global_inner_loop_unit.y = walker_param->global_resolution.y;
-
-            walker_param->block_resolution.x = walker_param->global_resolution.x;
-            walker_param->block_resolution.y = walker_param->global_resolution.y;
-
-            walker_param->local_start.x = 0;
-            walker_param->local_start.y = 0;
-
-            walker_param->local_outer_loop_stride.x = 1;
-            walker_param->local_outer_loop_stride.y = 0;
+    if (kernel_walker_param->walker_degree == VP9_45Z_DEGREE)
+        param.walker_degree = WALKER_45Z_DEGREE;
+    else
+        param.walker_degree = WALKER_26_DEGREE;
 
-            walker_param->local_inner_loop_unit.x = -1;
-            walker_param->local_inner_loop_unit.y = 4;
+    if (param.no_dependency)
+        param.use_scoreboard = 0;
 
-            walker_param->middle_loop_extra_steps = 3;
-            walker_param->mid_loop_unit_x = 0;
-            walker_param->mid_loop_unit_y = 1;
-        } else {
-            // 26 degree
-            walker_param->scoreboard_mask = 0x0F;
-            walker_param->local_outer_loop_stride.x = 1;
-            walker_param->local_outer_loop_stride.y = 0;
-            walker_param->local_inner_loop_unit.x = -2;
-            walker_param->local_inner_loop_unit.y = 1;
-        }
-    }
+    i965_init_media_object_walker_parameter(&param, walker_param);
 }
 
 static void
@@ -4507,12 +4443,24 @@ gen9_vme_kernels_context_init_vp9(VADriverContextP ctx,
                                   struct intel_encoder_context *encoder_context,
                                   struct gen9_encoder_context_vp9 *vme_context)
 {
+    struct i965_gpe_state_heap *heap = &encoder_context->gpe_state_heap;
+
     gen9_vme_scaling_context_init_vp9(ctx, vme_context, &vme_context->scaling_context);
     gen9_vme_me_context_init_vp9(ctx, vme_context, &vme_context->me_context);
     gen9_vme_mbenc_context_init_vp9(ctx, vme_context, &vme_context->mbenc_context);
     gen9_vme_dys_context_init_vp9(ctx, vme_context, &vme_context->dys_context);
     gen9_vme_brc_context_init_vp9(ctx, vme_context, &vme_context->brc_context);
 
+    /* all the kernels recycle their state BOs from the same heap */
+    i965_gpe_context_set_state_heap(vme_context->scaling_context.gpe_contexts,
+                                    NUM_VP9_SCALING, heap);
+    i965_gpe_context_set_state_heap(&vme_context->me_context.gpe_context, 1, heap);
+    i965_gpe_context_set_state_heap(vme_context->mbenc_context.gpe_contexts,
+                                    NUM_VP9_MBENC, heap);
+    i965_gpe_context_set_state_heap(&vme_context->dys_context.gpe_context, 1, heap);
+    i965_gpe_context_set_state_heap(vme_context->brc_context.gpe_contexts,
+                                    NUM_VP9_BRC, heap);
+
     vme_context->pfn_set_curbe_brc = gen9_vp9_set_curbe_brc;
     vme_context->pfn_set_curbe_me = gen9_vp9_set_curbe_me;
     vme_context->pfn_send_me_surface = gen9_vp9_send_me_surface;
@@ -5341,6 +5289,7 @@ gen9_vp9_read_mfc_status(VADriverContextP ctx, struct intel_encoder_context *enc
     //struct gpe_mi_copy_mem_parameter mi_copy_mem_param;
     struct vp9_encode_status_buffer_internal *status_buffer;
     struct gen9_vp9_state *vp9_state;
+    struct i965_encoder_status_regs status_regs;
 
     vp9_state = (struct gen9_vp9_state *)(encoder_context->enc_priv_state);
     if (!vp9_state || !pak_context || !batch)
@@ -5383,6 +5332,13 @@ gen9_vp9_read_mfc_status(VADriverContextP ctx, struct intel_encoder_context *enc
 
     gen8_gpe_mi_flush_dw(ctx, batch, &mi_flush_dw_param);
 
+    memset(&status_regs, 0, sizeof(status_regs));
+    status_regs.bs_byte_count_frame = status_buffer->vp9_bs_frame_reg_offset;
+    status_regs.image_status_mask = status_buffer->vp9_image_mask_reg_offset;
+    status_regs.image_status_ctrl = status_buffer->vp9_image_ctrl_reg_offset;
+    i965_encoder_status_ring_emit(ctx, batch, &encoder_context->status_ring, 0,
+                                  &status_regs, vp9_state->curr_pak_pass + 1);
+
     return;
 }
 
@@ -5679,5 +5635,9 @@ gen9_vp9_pak_context_init(VADriverContextP ctx, struct intel_encoder_context *en
     encoder_context->mfc_pipeline = gen9_vp9_pak_pipeline;
     encoder_context->mfc_brc_prepare = gen9_vp9_pak_brc_prepare;
     encoder_context->get_status = gen9_vp9_get_coded_status;
+
+    /* not fatal, the coded buffers still carry the status */
+    i965_encoder_status_ring_alloc(ctx, &encoder_context->status_ring, 1);
+
     return true;
 }
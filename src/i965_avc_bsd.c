@@ -57,22 +57,20 @@ i965_avc_bsd_init_avc_bsd_surface(VADriverContextP ctx,
         obj_surface->private_data = avc_bsd_surface;
     }
 
+    avc_bsd_surface->dmv_pool = &i965->dmv_pools[I965_DMV_POOL_AVC];
+
     avc_bsd_surface->dmv_bottom_flag = (pic_param->pic_fields.bits.field_pic_flag &&
                                         !pic_param->seq_fields.bits.direct_8x8_inference_flag);
 
     if (avc_bsd_surface->dmv_top == NULL) {
-        avc_bsd_surface->dmv_top = dri_bo_alloc(i965->intel.bufmgr,
-                                                "direct mv w/r buffer",
-                                                DMV_SIZE,
-                                                0x1000);
+        avc_bsd_surface->dmv_top = i965_dmv_pool_get(avc_bsd_surface->dmv_pool,
+                                                     DMV_SIZE);
     }
 
     if (avc_bsd_surface->dmv_bottom_flag &&
         avc_bsd_surface->dmv_bottom == NULL) {
-        avc_bsd_surface->dmv_bottom = dri_bo_alloc(i965->intel.bufmgr,
-                                                   "direct mv w/r buffer",
-                                                   DMV_SIZE,
-                                                   0x1000);
+        avc_bsd_surface->dmv_bottom = i965_dmv_pool_get(avc_bsd_surface->dmv_pool,
+                                                        DMV_SIZE);
     }
 }
 
@@ -601,32 +601,34 @@ gen9_avc_update_misc_parameters(VADriverContextP ctx,
     struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
     struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
     int i;
+    /* the kernel BRC runs at the rate of the whole stream, the layers get their budgets in layer_brc */
+    int top_layer = encoder_context->layer.num_layers > 1 ? encoder_context->layer.num_layers - 1 : 0;
 
     /* brc */
-    generic_state->max_bit_rate = (encoder_context->brc.bits_per_second[0] + 1000 - 1) / 1000;
+    generic_state->max_bit_rate = (encoder_context->brc.bits_per_second[top_layer] + 1000 - 1) / 1000;
 
     if (generic_state->internal_rate_mode == VA_RC_CBR) {
         generic_state->min_bit_rate = generic_state->max_bit_rate;
-        generic_state->mb_brc_enabled = encoder_context->brc.mb_rate_control[0] == 1;
+        generic_state->mb_brc_enabled = encoder_context->brc.mb_rate_control[top_layer] == 1;
 
         if (generic_state->target_bit_rate != generic_state->max_bit_rate) {
             generic_state->target_bit_rate = generic_state->max_bit_rate;
             generic_state->brc_need_reset = 1;
         }
     } else if (generic_state->internal_rate_mode == VA_RC_VBR) {
-        generic_state->min_bit_rate = generic_state->max_bit_rate * (2 * encoder_context->brc.target_percentage[0] - 100) / 100;
-        generic_state->mb_brc_enabled = encoder_context->brc.mb_rate_control[0] == 1;
+        generic_state->min_bit_rate = generic_state->max_bit_rate * (2 * encoder_context->brc.target_percentage[top_layer] - 100) / 100;
+        generic_state->mb_brc_enabled = encoder_context->brc.mb_rate_control[top_layer] == 1;
 
-        if (generic_state->target_bit_rate != generic_state->max_bit_rate * encoder_context->brc.target_percentage[0] / 100) {
-            generic_state->target_bit_rate = generic_state->max_bit_rate * encoder_context->brc.target_percentage[0] / 100;
+        if (generic_state->target_bit_rate != generic_state->max_bit_rate * encoder_context->brc.target_percentage[top_layer] / 100) {
+            generic_state->target_bit_rate = generic_state->max_bit_rate * encoder_context->brc.target_percentage[top_layer] / 100;
             generic_state->brc_need_reset = 1;
         }
     }
 
     /*  frame rate */
     if (generic_state->internal_rate_mode != VA_RC_CQP) {
-        generic_state->frames_per_100s = encoder_context->brc.framerate[0].num * 100 / encoder_context->brc.framerate[0].den ;
-        generic_state->frame_rate = encoder_context->brc.framerate[0].num / encoder_context->brc.framerate[0].den ;
+        generic_state->frames_per_100s = encoder_context->brc.framerate[top_layer].num * 100 / encoder_context->brc.framerate[top_layer].den ;
+        generic_state->frame_rate = encoder_context->brc.framerate[top_layer].num / encoder_context->brc.framerate[top_layer].den ;
         generic_state->frames_per_window_size = (int)(encoder_context->brc.window_size * generic_state->frame_rate / 1000); // brc.windows size in ms as the unit
     } else {
         generic_state->frames_per_100s = 30 * 100;
@@ -1431,6 +1433,9 @@ gen9_avc_free_resources(struct encoder_vme_mfc_context * vme_context)
     i965_free_gpe_resource(&avc_ctx->res_brc_image_state_read_buffer);
     i965_free_gpe_resource(&avc_ctx->res_brc_image_state_write_buffer);
     i965_free_gpe_resource(&avc_ctx->res_brc_const_data_buffer);
+    free(avc_ctx->brc_const_data_cache.data);
+    avc_ctx->brc_const_data_cache.data = NULL;
+    avc_ctx->brc_const_data_cache.size = 0;
     i965_free_gpe_resource(&avc_ctx->res_brc_dist_data_surface);
     i965_free_gpe_resource(&avc_ctx->res_mbbrc_roi_surface);
     i965_free_gpe_resource(&avc_ctx->res_mbbrc_mb_qp_data_surface);
@@ -1512,7 +1517,8 @@ gen9_avc_run_kernel_media_object(VADriverContextP ctx,
 
     intel_batchbuffer_end_atomic(batch);
 
-    intel_batchbuffer_flush(batch);
+    if (!avc_ctx->defer_kernel_flush)
+        intel_batchbuffer_flush(batch);
 }
 
 static void
@@ -1553,7 +1559,24 @@ gen9_avc_run_kernel_media_object_walker(VADriverContextP ctx,
 
     intel_batchbuffer_end_atomic(batch);
 
-    intel_batchbuffer_flush(batch);
+    if (!avc_ctx->defer_kernel_flush)
+        intel_batchbuffer_flush(batch);
+}
+
+/*
+ * While the kernels of the VME stage are queued into a single batch, the
+ * kernels already queued must be submitted before the CPU rewrites a
+ * buffer they use. Mapping the buffer then waits for them as usual.
+ */
+static void
+gen9_avc_sync_gpe_resource(struct intel_encoder_context *encoder_context,
+                           struct i965_gpe_resource *gpe_resource)
+{
+    struct intel_batchbuffer *batch = encoder_context->base.batch;
+
+    if (batch && gpe_resource->bo &&
+        drm_intel_bo_references(batch->buffer, gpe_resource->bo))
+        intel_batchbuffer_flush(batch);
 }
 
 static void
@@ -1947,6 +1970,7 @@ gen9_avc_kernel_scaling(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_scaling.gpe_contexts[kernel_idx]);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     if (surface_param.use_32x_scaling) {
@@ -1977,6 +2001,7 @@ gen9_avc_kernel_scaling(VADriverContextP ctx,
     }
 
     generic_ctx->pfn_send_scaling_surface(ctx, encode_state, gpe_context, encoder_context, &surface_param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     /* setup the interface data */
     gpe->setup_interface_data(ctx, gpe_context);
@@ -2354,38 +2379,23 @@ gen95_avc_calc_lambda_table(VADriverContextP ctx,
     }
 }
 
+/* Builds everything in the BRC constant data except the reference list QPs */
 static void
-gen9_avc_init_brc_const_data(VADriverContextP ctx,
-                             struct encode_state *encode_state,
-                             struct intel_encoder_context *encoder_context)
+gen9_avc_build_brc_const_data(VADriverContextP ctx,
+                              struct generic_enc_codec_state *generic_state,
+                              struct avc_enc_state *avc_state,
+                              unsigned char *data)
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
-    struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
-    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
-    struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
-    struct avc_enc_state * avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
 
-    struct i965_gpe_resource *gpe_resource = NULL;
-    unsigned char * data = NULL;
     unsigned char * data_tmp = NULL;
     unsigned int size = 0;
     unsigned int table_idx = 0;
     unsigned int block_based_skip_enable = avc_state->block_based_skip_enable;
     int i = 0;
 
-    struct object_surface *obj_surface;
-    VAEncSliceParameterBufferH264 * slice_param = avc_state->slice_param[0];
-    VASurfaceID surface_id;
     unsigned int transform_8x8_mode_flag = avc_state->transform_8x8_mode_enable;
 
-    gpe_resource = &(avc_ctx->res_brc_const_data_buffer);
-    assert(gpe_resource);
-
-    i965_zero_gpe_resource(gpe_resource);
-
-    data = i965_map_gpe_resource(gpe_resource);
-    assert(data);
-
     table_idx = slice_type_kernel[generic_state->frame_type];
 
     /* Fill surface with QP Adjustment table, Distortion threshold table, MaxFrame threshold table, Distortion QP Adjustment Table*/
@@ -2415,46 +2425,10 @@ gen9_avc_init_brc_const_data(VADriverContextP ctx,
     }
     data += size;
 
-    /*fill the qp for ref list*/
+    /*the qp for ref list, filled per frame*/
     size = 32 + 32 + 32 + 160;
     memset(data, 0xff, 32);
     memset(data + 32 + 32, 0xff, 32);
-    switch (generic_state->frame_type) {
-    case SLICE_TYPE_P: {
-        for (i = 0 ; i <  slice_param->num_ref_idx_l0_active_minus1 + 1; i++) {
-            surface_id = slice_param->RefPicList0[i].picture_id;
-            obj_surface = SURFACE(surface_id);
-            if (!obj_surface)
-                break;
-            *(data + i) = avc_state->list_ref_idx[0][i];//?
-        }
-    }
-    break;
-    case SLICE_TYPE_B: {
-        data = data + 32 + 32;
-        for (i = 0 ; i <  slice_param->num_ref_idx_l1_active_minus1 + 1; i++) {
-            surface_id = slice_param->RefPicList1[i].picture_id;
-            obj_surface = SURFACE(surface_id);
-            if (!obj_surface)
-                break;
-            *(data + i) = avc_state->list_ref_idx[1][i];//?
-        }
-
-        data = data - 32 - 32;
-
-        for (i = 0 ; i <  slice_param->num_ref_idx_l0_active_minus1 + 1; i++) {
-            surface_id = slice_param->RefPicList0[i].picture_id;
-            obj_surface = SURFACE(surface_id);
-            if (!obj_surface)
-                break;
-            *(data + i) = avc_state->list_ref_idx[0][i];//?
-        }
-    }
-    break;
-    default:
-        /*SLICE_TYPE_I,no change */
-        break;
-    }
     data += size;
 
     /*mv cost and mode cost*/
@@ -2508,6 +2482,114 @@ gen9_avc_init_brc_const_data(VADriverContextP ctx,
         size = 64;
         memcpy(data, (unsigned char *)gen95_avc_ftq25, size * sizeof(unsigned char));
     }
+}
+
+static void
+gen9_avc_init_brc_const_data(VADriverContextP ctx,
+                             struct encode_state *encode_state,
+                             struct intel_encoder_context *encoder_context)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
+    struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
+    struct avc_enc_state * avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
+
+    struct i965_gpe_resource *gpe_resource = NULL;
+    struct i965_avc_brc_const_data_key key;
+    unsigned char * data = NULL;
+    int i = 0;
+
+    struct object_surface *obj_surface;
+    VAEncSliceParameterBufferH264 * slice_param = avc_state->slice_param[0];
+    VASurfaceID surface_id;
+
+    gpe_resource = &(avc_ctx->res_brc_const_data_buffer);
+    assert(gpe_resource);
+
+    memset(&key, 0, sizeof(key));
+    key.frame_type = generic_state->frame_type;
+    key.block_based_skip_enable = avc_state->block_based_skip_enable;
+    key.transform_8x8_mode_enable = avc_state->transform_8x8_mode_enable;
+    key.non_ftq_skip_threshold_lut_input_enable = avc_state->non_ftq_skip_threshold_lut_input_enable;
+    key.ftq_skip_threshold_lut_input_enable = avc_state->ftq_skip_threshold_lut_input_enable;
+    key.old_mode_cost_enable = avc_state->old_mode_cost_enable;
+    key.adaptive_intra_scaling_enable = avc_state->adaptive_intra_scaling_enable;
+    memcpy(key.non_ftq_skip_threshold_lut, avc_state->non_ftq_skip_threshold_lut, sizeof(key.non_ftq_skip_threshold_lut));
+    memcpy(key.ftq_skip_threshold_lut, avc_state->ftq_skip_threshold_lut, sizeof(key.ftq_skip_threshold_lut));
+
+    /* The tables only change with the frame type and the encoding options */
+    if (!avc_ctx->brc_const_data_cache.data ||
+        avc_ctx->brc_const_data_cache.size != gpe_resource->size ||
+        memcmp(&avc_ctx->brc_const_data_cache.key, &key, sizeof(key))) {
+        free(avc_ctx->brc_const_data_cache.data);
+        avc_ctx->brc_const_data_cache.data = calloc(1, gpe_resource->size);
+        assert(avc_ctx->brc_const_data_cache.data);
+        avc_ctx->brc_const_data_cache.size = gpe_resource->size;
+        avc_ctx->brc_const_data_cache.key = key;
+
+        gen9_avc_build_brc_const_data(ctx, generic_state, avc_state, avc_ctx->brc_const_data_cache.data);
+    }
+
+    /* Don't wait for the BRC kernel of the previous frame, use a new BO instead */
+    if (drm_intel_bo_busy(gpe_resource->bo)) {
+        unsigned int width = gpe_resource->width;
+        unsigned int height = gpe_resource->height;
+        unsigned int pitch = gpe_resource->pitch;
+
+        i965_free_gpe_resource(gpe_resource);
+        i965_gpe_allocate_2d_resource(i965->intel.bufmgr,
+                                      gpe_resource,
+                                      width, height,
+                                      pitch,
+                                      "brc const data buffer");
+        assert(gpe_resource->bo);
+    }
+
+    data = i965_map_gpe_resource(gpe_resource);
+    assert(data);
+
+    memcpy(data, avc_ctx->brc_const_data_cache.data, avc_ctx->brc_const_data_cache.size);
+
+    /*fill the qp for ref list*/
+    data += I965_AVC_BRC_CONST_DATA_REF_QP_OFFSET;
+
+    switch (generic_state->frame_type) {
+    case SLICE_TYPE_P: {
+        for (i = 0 ; i <  slice_param->num_ref_idx_l0_active_minus1 + 1; i++) {
+            surface_id = slice_param->RefPicList0[i].picture_id;
+            obj_surface = SURFACE(surface_id);
+            if (!obj_surface)
+                break;
+            *(data + i) = avc_state->list_ref_idx[0][i];//?
+        }
+    }
+    break;
+    case SLICE_TYPE_B: {
+        data = data + 32 + 32;
+        for (i = 0 ; i <  slice_param->num_ref_idx_l1_active_minus1 + 1; i++) {
+            surface_id = slice_param->RefPicList1[i].picture_id;
+            obj_surface = SURFACE(surface_id);
+            if (!obj_surface)
+                break;
+            *(data + i) = avc_state->list_ref_idx[1][i];//?
+        }
+
+        data = data - 32 - 32;
+
+        for (i = 0 ; i <  slice_param->num_ref_idx_l0_active_minus1 + 1; i++) {
+            surface_id = slice_param->RefPicList0[i].picture_id;
+            obj_surface = SURFACE(surface_id);
+            if (!obj_surface)
+                break;
+            *(data + i) = avc_state->list_ref_idx[0][i];//?
+        }
+    }
+    break;
+    default:
+        /*SLICE_TYPE_I,no change */
+        break;
+    }
 
     i965_unmap_gpe_resource(gpe_resource);
 }
@@ -2800,11 +2882,13 @@ gen9_avc_kernel_brc_init_reset(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_brc.gpe_contexts[kernel_idx]);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     generic_ctx->pfn_set_curbe_brc_init_reset(ctx, encode_state, gpe_context, encoder_context, NULL);
 
     generic_ctx->pfn_send_brc_init_reset_surface(ctx, encode_state, gpe_context, encoder_context, NULL);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -2850,6 +2934,11 @@ gen9_avc_set_curbe_brc_frame_update(VADriverContextP ctx,
 
     memcpy(cmd, &gen9_avc_frame_brc_update_curbe_init_data, sizeof(gen9_avc_frame_brc_update_curbe_data));
 
+    /* a temporal layer frame is aimed at the budget of its layer rather than the average frame */
+    if (encoder_context->layer_brc.num_layers)
+        generic_state->brc_init_current_target_buf_full_in_bits += encoder_context->layer_brc.budget -
+                                                                   generic_state->brc_init_reset_input_bits_per_frame;
+
     cmd->dw5.target_size_flag = 0 ;
     if (generic_state->brc_init_current_target_buf_full_in_bits > (double)generic_state->brc_init_reset_buf_size_in_bits) {
         /*overflow*/
@@ -2926,6 +3015,11 @@ gen9_avc_set_curbe_brc_frame_update(VADriverContextP ctx,
     common_param.target_bit_rate = generic_state->target_bit_rate;
 
     cmd->dw19.user_max_frame = i965_avc_get_profile_level_max_frame(&common_param, seq_param->level_idc);
+
+    /* a temporal layer frame is capped to what the HRD buffers of its sub-streams hold */
+    if (encoder_context->layer_brc.num_layers)
+        cmd->dw19.user_max_frame = MIN(cmd->dw19.user_max_frame,
+                                       MAX((unsigned int)(encoder_context->layer_brc.max_bits / 8), 1));
     i965_gpe_context_unmap_curbe(gpe_context);
 
     return;
@@ -3142,12 +3236,16 @@ gen9_avc_kernel_brc_frame_update(VADriverContextP ctx,
     curbe_brc_param.gpe_context_brc_frame_update = gpe_context;
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
     /*brc copy ignored*/
 
     /* set curbe frame update*/
     generic_ctx->pfn_set_curbe_brc_frame_update(ctx, encode_state, gpe_context, encoder_context, &curbe_brc_param);
 
+    gen9_avc_sync_gpe_resource(encoder_context, &avc_ctx->res_brc_const_data_buffer);
+    gen9_avc_sync_gpe_resource(encoder_context, &avc_ctx->res_brc_image_state_read_buffer);
+
     /* load brc constant data, is it same as mbenc mb brc constant data? no.*/
     if (avc_state->multi_pre_enable) {
         gen9_avc_init_brc_const_data(ctx, encode_state, encoder_context);
@@ -3162,6 +3260,7 @@ gen9_avc_kernel_brc_frame_update(VADriverContextP ctx,
     }
     /* set surface frame mbenc*/
     generic_ctx->pfn_send_brc_frame_update_surface(ctx, encode_state, gpe_context, encoder_context, &curbe_brc_param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
 
     gpe->setup_interface_data(ctx, gpe_context);
@@ -3288,6 +3387,7 @@ gen9_avc_kernel_brc_mb_update(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_brc.gpe_contexts[kernel_idx]);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     /* set curbe brc mb update*/
@@ -3296,6 +3396,7 @@ gen9_avc_kernel_brc_mb_update(VADriverContextP ctx,
 
     /* set surface brc mb update*/
     generic_ctx->pfn_send_brc_mb_update_surface(ctx, encode_state, gpe_context, encoder_context, NULL);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
 
     gpe->setup_interface_data(ctx, gpe_context);
@@ -4792,6 +4893,7 @@ gen9_avc_send_surface_mbenc(VADriverContextP ctx,
                                     size / 4,
                                     0,
                                     GEN9_AVC_MBENC_MAD_DATA_INDEX);
+        gen9_avc_sync_gpe_resource(encoder_context, gpe_resource);
         i965_zero_gpe_resource(gpe_resource);
     }
 
@@ -5302,6 +5404,7 @@ gen9_avc_kernel_mbenc(VADriverContextP ctx,
         gpe->context_init(ctx, gpe_context);
     }
 
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     if (!avc_state->mbenc_curbe_set_in_brc_update) {
@@ -5315,15 +5418,18 @@ gen9_avc_kernel_mbenc(VADriverContextP ctx,
         if (avc_state->lambda_table_enable)
             gen95_avc_calc_lambda_table(ctx, encode_state, encoder_context);
 
+        gen9_avc_sync_gpe_resource(encoder_context, &avc_ctx->res_mbbrc_const_data_buffer);
         gen9_avc_load_mb_brc_const_data(ctx, encode_state, encoder_context);
     }
 
     /*clear the mad buffer*/
     if (mad_enable) {
+        gen9_avc_sync_gpe_resource(encoder_context, &avc_ctx->res_mad_data_buffer);
         i965_zero_gpe_resource(&(avc_ctx->res_mad_data_buffer));
     }
     /*send surface*/
     generic_ctx->pfn_send_mbenc_surface(ctx, encode_state, gpe_context, encoder_context, &param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -5757,6 +5863,7 @@ gen9_avc_kernel_me(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_me.gpe_contexts[kernel_idx]);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     /*set curbe*/
@@ -5766,6 +5873,7 @@ gen9_avc_kernel_me(VADriverContextP ctx,
 
     /*send surface*/
     generic_ctx->pfn_send_me_surface(ctx, encode_state, gpe_context, encoder_context, &param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -5889,6 +5997,7 @@ gen9_avc_kernel_wp(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_wp.gpe_contexts);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     memset(&param, 0, sizeof(param));
@@ -5898,6 +6007,7 @@ gen9_avc_kernel_wp(VADriverContextP ctx,
 
     /*send surface*/
     generic_ctx->pfn_send_wp_surface(ctx, encode_state, gpe_context, encoder_context, &param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -6037,6 +6147,7 @@ gen9_avc_kernel_sfd(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_sfd.gpe_contexts);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     /*set curbe*/
@@ -6044,6 +6155,7 @@ gen9_avc_kernel_sfd(VADriverContextP ctx,
 
     /*send surface*/
     generic_ctx->pfn_send_sfd_surface(ctx, encode_state, gpe_context, encoder_context, NULL);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -6171,6 +6283,7 @@ gen9_avc_preenc_kernel_scaling(VADriverContextP ctx,
     gpe_context = &(avc_ctx->context_scaling.gpe_contexts[kernel_idx]);
 
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     generic_ctx->pfn_set_curbe_scaling4x(ctx, encode_state, gpe_context, encoder_context, &surface_param);
@@ -6182,6 +6295,7 @@ gen9_avc_preenc_kernel_scaling(VADriverContextP ctx,
      * VAStatsStatisticsH264 will be used to store the output.  */
     surface_param.enable_mb_flatness_check = 0;
     generic_ctx->pfn_send_scaling_surface(ctx, encode_state, gpe_context, encoder_context, &surface_param);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     /* setup the interface data */
     gpe->setup_interface_data(ctx, gpe_context);
@@ -6803,6 +6917,7 @@ gen9_avc_preenc_kernel_preproc(VADriverContextP ctx,
 
     gpe_context = &(avc_ctx->context_preproc.gpe_contexts);
     gpe->context_init(ctx, gpe_context);
+    i965_gpe_context_map_surface_state(gpe_context);
     gpe->reset_binding_table(ctx, gpe_context);
 
     /*set curbe*/
@@ -6810,6 +6925,7 @@ gen9_avc_preenc_kernel_preproc(VADriverContextP ctx,
 
     /*send surface*/
     generic_ctx->pfn_send_preproc_surface(ctx, encode_state, gpe_context, encoder_context, NULL);
+    i965_gpe_context_unmap_surface_state(gpe_context);
 
     gpe->setup_interface_data(ctx, gpe_context);
 
@@ -7393,6 +7509,11 @@ gen8_avc_set_curbe_brc_frame_update(VADriverContextP ctx,
 
     memcpy(cmd, &gen8_avc_frame_brc_update_curbe_init_data, sizeof(gen8_avc_frame_brc_update_curbe_data));
 
+    /* a temporal layer frame is aimed at the budget of its layer rather than the average frame */
+    if (encoder_context->layer_brc.num_layers)
+        generic_state->brc_init_current_target_buf_full_in_bits += encoder_context->layer_brc.budget -
+                                                                   generic_state->brc_init_reset_input_bits_per_frame;
+
     cmd->dw5.target_size_flag = 0 ;
     if (generic_state->brc_init_current_target_buf_full_in_bits > (double)generic_state->brc_init_reset_buf_size_in_bits) {
         /*overflow*/
@@ -7470,6 +7591,11 @@ gen8_avc_set_curbe_brc_frame_update(VADriverContextP ctx,
 
     cmd->dw19.user_max_frame = i965_avc_get_profile_level_max_frame(&common_param, seq_param->level_idc);
 
+    /* a temporal layer frame is capped to what the HRD buffers of its sub-streams hold */
+    if (encoder_context->layer_brc.num_layers)
+        cmd->dw19.user_max_frame = MIN(cmd->dw19.user_max_frame,
+                                       MAX((unsigned int)(encoder_context->layer_brc.max_bits / 8), 1));
+
     i965_gpe_context_unmap_curbe(gpe_context);
 
     return;
@@ -7947,6 +8073,74 @@ gen9_avc_kernel_destroy(struct encoder_vme_mfc_context * vme_context)
 /*
 vme pipeline
 */
+
+/*
+ * The frame sizes and the HME levels, they only depend on the sequence
+ * parameters and the preset.
+ */
+static void
+gen9_avc_update_frame_sizes(struct generic_enc_codec_state *generic_state,
+                            VAEncSequenceParameterBufferH264 *seq_param,
+                            unsigned int preset)
+{
+    generic_state->b16xme_supported = gen9_avc_super_hme[preset];
+    generic_state->b32xme_supported = gen9_avc_ultra_hme[preset];
+
+    generic_state->frame_width_in_mbs = seq_param->picture_width_in_mbs;
+    generic_state->frame_height_in_mbs = seq_param->picture_height_in_mbs;
+    generic_state->frame_width_in_pixel = generic_state->frame_width_in_mbs * 16;
+    generic_state->frame_height_in_pixel = generic_state->frame_height_in_mbs * 16;
+
+    generic_state->frame_width_4x  = ALIGN(generic_state->frame_width_in_pixel / 4, 16);
+    generic_state->frame_height_4x = ALIGN(generic_state->frame_height_in_pixel / 4, 16);
+    generic_state->downscaled_width_4x_in_mb  = generic_state->frame_width_4x / 16 ;
+    generic_state->downscaled_height_4x_in_mb = generic_state->frame_height_4x / 16;
+
+    generic_state->frame_width_16x  =  ALIGN(generic_state->frame_width_in_pixel / 16, 16);
+    generic_state->frame_height_16x =  ALIGN(generic_state->frame_height_in_pixel / 16, 16);
+    generic_state->downscaled_width_16x_in_mb  = generic_state->frame_width_16x / 16 ;
+    generic_state->downscaled_height_16x_in_mb = generic_state->frame_height_16x / 16;
+
+    generic_state->frame_width_32x  = ALIGN(generic_state->frame_width_in_pixel / 32, 16);
+    generic_state->frame_height_32x = ALIGN(generic_state->frame_height_in_pixel / 32, 16);
+    generic_state->downscaled_width_32x_in_mb  = generic_state->frame_width_32x / 16 ;
+    generic_state->downscaled_height_32x_in_mb = generic_state->frame_height_32x / 16;
+
+    /* disable HME/16xME if the size is too small */
+    if (generic_state->frame_width_4x <= INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->b32xme_supported = 0;
+        generic_state->b16xme_supported = 0;
+        generic_state->frame_width_4x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_width_4x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+    if (generic_state->frame_height_4x <= INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->b32xme_supported = 0;
+        generic_state->b16xme_supported = 0;
+        generic_state->frame_height_4x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_height_4x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+
+    if (generic_state->frame_width_16x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->b32xme_supported = 0;
+        generic_state->frame_width_16x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_width_16x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+    if (generic_state->frame_height_16x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->b32xme_supported = 0;
+        generic_state->frame_height_16x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_height_16x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+
+    if (generic_state->frame_width_32x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->frame_width_32x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_width_32x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+    if (generic_state->frame_height_32x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
+        generic_state->frame_height_32x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
+        generic_state->downscaled_height_32x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+    }
+}
+
 static void
 gen9_avc_update_parameters(VADriverContextP ctx,
                            VAProfile profile,
@@ -7964,9 +8158,6 @@ gen9_avc_update_parameters(VADriverContextP ctx,
     unsigned int fei_enabled = encoder_context->fei_enabled;
 
     /* seq/pic/slice parameter setting */
-    generic_state->b16xme_supported = gen9_avc_super_hme[preset];
-    generic_state->b32xme_supported = gen9_avc_ultra_hme[preset];
-
     avc_state->seq_param = (VAEncSequenceParameterBufferH264 *)encode_state->seq_param_ext->buffer;
     avc_state->pic_param = (VAEncPictureParameterBufferH264 *)encode_state->pic_param_ext->buffer;
 
@@ -8076,83 +8267,17 @@ gen9_avc_update_parameters(VADriverContextP ctx,
     }
 
 
-    generic_state->frame_width_in_mbs = seq_param->picture_width_in_mbs;
-    generic_state->frame_height_in_mbs = seq_param->picture_height_in_mbs;
-    generic_state->frame_width_in_pixel = generic_state->frame_width_in_mbs * 16;
-    generic_state->frame_height_in_pixel = generic_state->frame_height_in_mbs * 16;
-
-    generic_state->frame_width_4x  = ALIGN(generic_state->frame_width_in_pixel / 4, 16);
-    generic_state->frame_height_4x = ALIGN(generic_state->frame_height_in_pixel / 4, 16);
-    generic_state->downscaled_width_4x_in_mb  = generic_state->frame_width_4x / 16 ;
-    generic_state->downscaled_height_4x_in_mb = generic_state->frame_height_4x / 16;
-
-    generic_state->frame_width_16x  =  ALIGN(generic_state->frame_width_in_pixel / 16, 16);
-    generic_state->frame_height_16x =  ALIGN(generic_state->frame_height_in_pixel / 16, 16);
-    generic_state->downscaled_width_16x_in_mb  = generic_state->frame_width_16x / 16 ;
-    generic_state->downscaled_height_16x_in_mb = generic_state->frame_height_16x / 16;
-
-    generic_state->frame_width_32x  = ALIGN(generic_state->frame_width_in_pixel / 32, 16);
-    generic_state->frame_height_32x = ALIGN(generic_state->frame_height_in_pixel / 32, 16);
-    generic_state->downscaled_width_32x_in_mb  = generic_state->frame_width_32x / 16 ;
-    generic_state->downscaled_height_32x_in_mb = generic_state->frame_height_32x / 16;
-
-    if (generic_state->hme_supported) {
-        generic_state->hme_enabled = 1;
-    } else {
-        generic_state->hme_enabled = 0;
-    }
-
-    if (generic_state->b16xme_supported) {
-        generic_state->b16xme_enabled = 1;
-    } else {
-        generic_state->b16xme_enabled = 0;
-    }
-
-    if (generic_state->b32xme_supported) {
-        generic_state->b32xme_enabled = 1;
+    if (!I965_ENCODER_PARAMS_CHANGED(&encoder_context->params, I965_ENCODER_PARAMS_SEQ) &&
+        avc_state->seq_preset == preset) {
+        i965_encoder_params_skip(&encoder_context->params, I965_ENCODER_PARAMS_SEQ);
     } else {
-        generic_state->b32xme_enabled = 0;
-    }
-    /* disable HME/16xME if the size is too small */
-    if (generic_state->frame_width_4x <= INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->b32xme_supported = 0;
-        generic_state->b32xme_enabled = 0;
-        generic_state->b16xme_supported = 0;
-        generic_state->b16xme_enabled = 0;
-        generic_state->frame_width_4x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_width_4x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
-    }
-    if (generic_state->frame_height_4x <= INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->b32xme_supported = 0;
-        generic_state->b32xme_enabled = 0;
-        generic_state->b16xme_supported = 0;
-        generic_state->b16xme_enabled = 0;
-        generic_state->frame_height_4x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_height_4x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
-    }
-
-    if (generic_state->frame_width_16x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->b32xme_supported = 0;
-        generic_state->b32xme_enabled = 0;
-        generic_state->frame_width_16x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_width_16x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
-    }
-    if (generic_state->frame_height_16x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->b32xme_supported = 0;
-        generic_state->b32xme_enabled = 0;
-        generic_state->frame_height_16x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_height_16x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
-    }
-
-    if (generic_state->frame_width_32x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->frame_width_32x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_width_32x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
-    }
-    if (generic_state->frame_height_32x < INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT) {
-        generic_state->frame_height_32x = INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT;
-        generic_state->downscaled_height_32x_in_mb = WIDTH_IN_MACROBLOCKS(INTEL_VME_MIN_ALLOWED_WIDTH_HEIGHT);
+        gen9_avc_update_frame_sizes(generic_state, seq_param, preset);
+        avc_state->seq_preset = preset;
     }
 
+    generic_state->hme_enabled = generic_state->hme_supported;
+    generic_state->b16xme_enabled = generic_state->b16xme_supported;
+    generic_state->b32xme_enabled = generic_state->b32xme_supported;
 }
 
 static VAStatus
@@ -8161,6 +8286,7 @@ gen9_avc_encode_check_parameter(VADriverContextP ctx,
                                 struct intel_encoder_context *encoder_context)
 {
     struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
     struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
     struct avc_enc_state * avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
     unsigned int rate_control_mode = encoder_context->rate_control_mode;
@@ -8299,6 +8425,12 @@ gen9_avc_encode_check_parameter(VADriverContextP ctx,
     avc_state->skip_bias_adjustment_enable = avc_state->skip_bias_adjustment_supported && (generic_state->frame_type == SLICE_TYPE_P)
                                              && (generic_state->gop_ref_distance == 1) && (avc_state->pic_param->pic_init_qp + avc_state->slice_param[0]->slice_qp_delta >= 22) && !generic_state->brc_enabled;
 
+    /* A static scene is coded skip heavy whatever the QP and rate control */
+    if (avc_state->scene_adaptive_enable &&
+        (avc_ctx->scene_detector.hints & I965_ENCODER_STATUS_HINT_STATIC_SCENE))
+        avc_state->skip_bias_adjustment_enable = avc_state->skip_bias_adjustment_supported && (generic_state->frame_type == SLICE_TYPE_P)
+                                                 && (generic_state->gop_ref_distance == 1);
+
     if (generic_state->kernel_mode == INTEL_ENC_KERNEL_QUALITY) {
         avc_state->tq_enable = 1;
         avc_state->tq_rounding = 6;
@@ -8577,6 +8709,7 @@ gen9_avc_vme_gpe_kernel_run(VADriverContextP ctx,
                             struct intel_encoder_context *encoder_context)
 {
     struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
     struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
     struct avc_enc_state * avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
     int fei_enabled = encoder_context->fei_enabled;
@@ -8585,6 +8718,9 @@ gen9_avc_vme_gpe_kernel_run(VADriverContextP ctx,
     VAEncSliceParameterBufferH264 *slice_param = avc_state->slice_param[0];
     int sfd_in_use = 0;
 
+    /* Queue all the kernels below into one batch and submit it at the end */
+    avc_ctx->defer_kernel_flush = 1;
+
     /* BRC init/reset needs to be called before HME since it will reset the Brc Distortion surface*/
     if (!fei_enabled && generic_state->brc_enabled && (!generic_state->brc_inited || generic_state->brc_need_reset)) {
         gen9_avc_kernel_brc_init_reset(ctx, encode_state, encoder_context);
@@ -8660,9 +8796,73 @@ gen9_avc_vme_gpe_kernel_run(VADriverContextP ctx,
 
     /*ignore the reset vertical line kernel*/
 
+    avc_ctx->defer_kernel_flush = 0;
+
+    if (encoder_context->base.batch)
+        intel_batchbuffer_flush(encoder_context->base.batch);
+
     return VA_STATUS_SUCCESS;
 }
 
+/*
+ * Runs the scene detector on the 4x HME distortion of the pending frame,
+ * the first rows of the buffer hold a 16 bit distortion against the first
+ * reference for every MB. It is read when the next frame is submitted,
+ * before its VME stage writes the buffer again (frame_id 0), or when the
+ * coded buffer of the frame is mapped, possibly from another thread.
+ *
+ * The buffer is only mapped once the GPU is done with it. A mapped coded
+ * buffer leaves a busy buffer pending for a later call, the next frame
+ * can't wait for it and runs the detector without a distortion: the frame
+ * gets no hints and the detector keeps its state, as for an I frame.
+ */
+static void
+gen9_avc_scene_analysis_flush(struct intel_encoder_context *encoder_context,
+                              uint32_t frame_id)
+{
+    struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
+    struct i965_gpe_resource *gpe_resource = &avc_ctx->s4x_memv_distortion_buffer;
+    unsigned int num_mbs = 0;
+    unsigned int x, y;
+    uint64_t total_dist = 0;
+    uint32_t hints;
+    uint16_t *row;
+    uint8_t *data;
+
+    _i965LockMutex(&avc_ctx->scene_mutex);
+
+    if (!avc_ctx->scene_pending ||
+        (frame_id && frame_id != avc_ctx->scene_frame_id) ||
+        (frame_id && drm_intel_bo_busy(gpe_resource->bo))) {
+        _i965UnlockMutex(&avc_ctx->scene_mutex);
+        return;
+    }
+
+    avc_ctx->scene_pending = 0;
+    data = NULL;
+
+    if (!drm_intel_bo_busy(gpe_resource->bo))
+        data = i965_map_gpe_resource(gpe_resource);
+
+    if (data) {
+        for (y = 0; y < avc_ctx->scene_height_in_mbs; y++) {
+            row = (uint16_t *)(data + y * gpe_resource->pitch);
+
+            for (x = 0; x < avc_ctx->scene_width_in_mbs; x++)
+                total_dist += row[x];
+        }
+
+        num_mbs = avc_ctx->scene_width_in_mbs * avc_ctx->scene_height_in_mbs;
+        i965_unmap_gpe_resource(gpe_resource);
+    }
+
+    hints = i965_avc_scene_detector_update(&avc_ctx->scene_detector, total_dist, num_mbs);
+    i965_encoder_status_ring_set_hints(&encoder_context->status_ring, avc_ctx->scene_frame_id, hints);
+
+    _i965UnlockMutex(&avc_ctx->scene_mutex);
+}
+
 static VAStatus
 gen9_avc_vme_pipeline(VADriverContextP ctx,
                       VAProfile profile,
@@ -8671,6 +8871,10 @@ gen9_avc_vme_pipeline(VADriverContextP ctx,
 {
     VAStatus va_status;
 
+    /* the hints of the last frame steer this one, and its VME stage
+     * overwrites the distortion */
+    gen9_avc_scene_analysis_flush(encoder_context, 0);
+
     gen9_avc_update_parameters(ctx, profile, encode_state, encoder_context);
 
     va_status = gen9_avc_encode_check_parameter(ctx, encode_state, encoder_context);
@@ -9103,6 +9307,7 @@ gen9_avc_vme_context_destroy(void * context)
     avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
 
     gen9_avc_kernel_destroy(vme_context);
+    _i965DestroyMutex(&avc_ctx->scene_mutex);
 
     free(generic_ctx);
     free(avc_ctx);
@@ -9224,6 +9429,26 @@ gen9_avc_kernel_init(VADriverContextP ctx,
         generic_ctx->pfn_send_me_surface = gen9_avc_preenc_send_surface_me;
         generic_ctx->pfn_send_preproc_surface = gen9_avc_preenc_send_surface_preproc;
     }
+
+    /* all the kernels recycle their state BOs from the same heap */
+    i965_gpe_context_set_state_heap(avc_ctx->context_scaling.gpe_contexts,
+                                    ARRAY_ELEMS(avc_ctx->context_scaling.gpe_contexts),
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(avc_ctx->context_me.gpe_contexts,
+                                    ARRAY_ELEMS(avc_ctx->context_me.gpe_contexts),
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(avc_ctx->context_brc.gpe_contexts,
+                                    ARRAY_ELEMS(avc_ctx->context_brc.gpe_contexts),
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(avc_ctx->context_mbenc.gpe_contexts,
+                                    ARRAY_ELEMS(avc_ctx->context_mbenc.gpe_contexts),
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(&avc_ctx->context_wp.gpe_contexts, 1,
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(&avc_ctx->context_sfd.gpe_contexts, 1,
+                                    &encoder_context->gpe_state_heap);
+    i965_gpe_context_set_state_heap(&avc_ctx->context_preproc.gpe_contexts, 1,
+                                    &encoder_context->gpe_state_heap);
 }
 
 /*
@@ -9376,10 +9601,10 @@ gen9_mfc_avc_pipe_buf_addr_state(VADriverContextP ctx, struct intel_encoder_cont
     OUT_BUFFER_3DW(batch, avc_ctx->res_pak_mb_status_buffer.bo, 1, 0, i965->intel.mocs_state);//?
 
     /* the DW13-15 is for the intra_row_store_scratch */
-    OUT_BUFFER_3DW(batch, avc_ctx->res_intra_row_store_scratch_buffer.bo, 1, 0, i965->intel.mocs_state);
+    OUT_BUFFER_3DW(batch, avc_ctx->res_intra_row_store_scratch_buffer[avc_ctx->pak_pipe].bo, 1, 0, i965->intel.mocs_state);
 
     /* the DW16-18 is for the deblocking filter */
-    OUT_BUFFER_3DW(batch, avc_ctx->res_deblocking_filter_row_store_scratch_buffer.bo, 1, 0, i965->intel.mocs_state);
+    OUT_BUFFER_3DW(batch, avc_ctx->res_deblocking_filter_row_store_scratch_buffer[avc_ctx->pak_pipe].bo, 1, 0, i965->intel.mocs_state);
 
     /* the DW 19-50 is for Reference pictures*/
     for (i = 0; i < ARRAY_ELEMS(avc_ctx->list_reference_res); i++) {
@@ -9492,7 +9717,7 @@ gen9_mfc_avc_bsp_buf_base_addr_state(VADriverContextP ctx, struct intel_encoder_
     OUT_BCS_BATCH(batch, MFX_BSP_BUF_BASE_ADDR_STATE | (10 - 2));
 
     /* The DW1-3 is for bsd/mpc row store scratch buffer */
-    OUT_BUFFER_3DW(batch, avc_ctx->res_bsd_mpc_row_store_scratch_buffer.bo, 1, 0, i965->intel.mocs_state);
+    OUT_BUFFER_3DW(batch, avc_ctx->res_bsd_mpc_row_store_scratch_buffer[avc_ctx->pak_pipe].bo, 1, 0, i965->intel.mocs_state);
 
     /* The DW4-6 is for MPR Row Store Scratch Buffer Base Address, ignore for encoder */
     OUT_BUFFER_3DW(batch, NULL, 0, 0, 0);
@@ -10470,6 +10695,7 @@ gen9_avc_read_mfc_status(VADriverContextP ctx, struct intel_encoder_context *enc
     struct gpe_mi_store_data_imm_parameter mi_store_data_imm_param;
     struct gpe_mi_flush_dw_parameter mi_flush_dw_param;
     struct encoder_status_buffer_internal *status_buffer;
+    struct i965_encoder_status_regs status_regs;
 
     status_buffer = &(avc_ctx->status_buffer);
 
@@ -10488,31 +10714,44 @@ gen9_avc_read_mfc_status(VADriverContextP ctx, struct intel_encoder_context *enc
     mi_store_reg_mem_param.mmio_offset = status_buffer->image_status_mask_reg_offset;
     gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
 
-    /*update the status in the pak_statistic_surface */
-    mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
-    mi_store_reg_mem_param.offset = 0;
-    mi_store_reg_mem_param.mmio_offset = status_buffer->bs_byte_count_frame_reg_offset;
-    gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+    /* Only BRC reads the PAK statistics, leave them alone when the frames
+     * may run on both VDBoxes */
+    if (generic_state->brc_enabled || avc_ctx->pak_scheduler.num_pipes == 1) {
+        /*update the status in the pak_statistic_surface */
+        mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
+        mi_store_reg_mem_param.offset = 0;
+        mi_store_reg_mem_param.mmio_offset = status_buffer->bs_byte_count_frame_reg_offset;
+        gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
 
-    mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
-    mi_store_reg_mem_param.offset = 4;
-    mi_store_reg_mem_param.mmio_offset = status_buffer->bs_byte_count_frame_nh_reg_offset;
-    gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+        mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
+        mi_store_reg_mem_param.offset = 4;
+        mi_store_reg_mem_param.mmio_offset = status_buffer->bs_byte_count_frame_nh_reg_offset;
+        gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
 
-    memset(&mi_store_data_imm_param, 0, sizeof(mi_store_data_imm_param));
-    mi_store_data_imm_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
-    mi_store_data_imm_param.offset = sizeof(unsigned int) * 2;
-    mi_store_data_imm_param.dw0 = (generic_state->curr_pak_pass + 1);
-    gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
+        memset(&mi_store_data_imm_param, 0, sizeof(mi_store_data_imm_param));
+        mi_store_data_imm_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
+        mi_store_data_imm_param.offset = sizeof(unsigned int) * 2;
+        mi_store_data_imm_param.dw0 = (generic_state->curr_pak_pass + 1);
+        gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
 
-    mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
-    mi_store_reg_mem_param.offset = sizeof(unsigned int) * (4 + generic_state->curr_pak_pass) ;
-    mi_store_reg_mem_param.mmio_offset = status_buffer->image_status_ctrl_reg_offset;
-    gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+        mi_store_reg_mem_param.bo = avc_ctx->res_brc_pre_pak_statistics_output_buffer.bo;
+        mi_store_reg_mem_param.offset = sizeof(unsigned int) * (4 + generic_state->curr_pak_pass) ;
+        mi_store_reg_mem_param.mmio_offset = status_buffer->image_status_ctrl_reg_offset;
+        gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+    }
 
     memset(&mi_flush_dw_param, 0, sizeof(mi_flush_dw_param));
     gpe->mi_flush_dw(ctx, batch, &mi_flush_dw_param);
 
+    memset(&status_regs, 0, sizeof(status_regs));
+    status_regs.bs_byte_count_frame = status_buffer->bs_byte_count_frame_reg_offset;
+    status_regs.bs_byte_count_frame_nh = status_buffer->bs_byte_count_frame_nh_reg_offset;
+    status_regs.image_status_mask = status_buffer->image_status_mask_reg_offset;
+    status_regs.image_status_ctrl = status_buffer->image_status_ctrl_reg_offset;
+    status_regs.qp_status_reg = status_buffer->mfc_qp_status_count_reg_offset;
+    i965_encoder_status_ring_emit(ctx, batch, &encoder_context->status_ring, avc_ctx->pak_pipe,
+                                  &status_regs, generic_state->curr_pak_pass + 1);
+
     return;
 }
 
@@ -10728,6 +10967,24 @@ gen9_avc_fei_pak_pipeline_prepare(VADriverContextP ctx,
 
 }
 
+/*
+ * The row stores are scratch space of the VDBox running the frame, they
+ * are only reallocated when the width of the frames changes.
+ */
+static unsigned int
+gen9_avc_pak_alloc_row_store(struct i965_driver_data *i965,
+                             struct i965_gpe_resource *res,
+                             unsigned int size,
+                             const char *name)
+{
+    if (res->bo && res->size == size)
+        return 1;
+
+    i965_free_gpe_resource(res);
+
+    return i965_allocate_gpe_resource(i965->intel.bufmgr, res, size, name);
+}
+
 static VAStatus
 gen9_avc_pak_pipeline_prepare(VADriverContextP ctx,
                               VAProfile profile,
@@ -10884,30 +11141,25 @@ gen9_avc_pak_pipeline_prepare(VADriverContextP ctx,
     }
 
 
-    size = w_mb * 64;
-    i965_free_gpe_resource(&avc_ctx->res_intra_row_store_scratch_buffer);
-    allocate_flag = i965_allocate_gpe_resource(i965->intel.bufmgr,
-                                               &avc_ctx->res_intra_row_store_scratch_buffer,
-                                               size,
-                                               "PAK Intra row store scratch buffer");
+    /* the row stores of the pipe picked for the frame */
+    allocate_flag = gen9_avc_pak_alloc_row_store(i965,
+                                                 &avc_ctx->res_intra_row_store_scratch_buffer[avc_ctx->pak_pipe],
+                                                 w_mb * 64,
+                                                 "PAK Intra row store scratch buffer");
     if (!allocate_flag)
         goto failed_allocation;
 
-    size = w_mb * 4 * 64;
-    i965_free_gpe_resource(&avc_ctx->res_deblocking_filter_row_store_scratch_buffer);
-    allocate_flag = i965_allocate_gpe_resource(i965->intel.bufmgr,
-                                               &avc_ctx->res_deblocking_filter_row_store_scratch_buffer,
-                                               size,
-                                               "PAK Deblocking filter row store scratch buffer");
+    allocate_flag = gen9_avc_pak_alloc_row_store(i965,
+                                                 &avc_ctx->res_deblocking_filter_row_store_scratch_buffer[avc_ctx->pak_pipe],
+                                                 w_mb * 4 * 64,
+                                                 "PAK Deblocking filter row store scratch buffer");
     if (!allocate_flag)
         goto failed_allocation;
 
-    size = w_mb * 2 * 64;
-    i965_free_gpe_resource(&avc_ctx->res_bsd_mpc_row_store_scratch_buffer);
-    allocate_flag = i965_allocate_gpe_resource(i965->intel.bufmgr,
-                                               &avc_ctx->res_bsd_mpc_row_store_scratch_buffer,
-                                               size,
-                                               "PAK BSD/MPC row store scratch buffer");
+    allocate_flag = gen9_avc_pak_alloc_row_store(i965,
+                                                 &avc_ctx->res_bsd_mpc_row_store_scratch_buffer[avc_ctx->pak_pipe],
+                                                 w_mb * 2 * 64,
+                                                 "PAK BSD/MPC row store scratch buffer");
     if (!allocate_flag)
         goto failed_allocation;
 
@@ -10926,6 +11178,83 @@ failed_allocation:
     return VA_STATUS_ERROR_ALLOCATION_FAILED;
 }
 
+static void
+gen9_avc_pak_select_pipe(struct encode_state *encode_state,
+                         struct intel_encoder_context *encoder_context)
+{
+    struct encoder_vme_mfc_context * pak_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)pak_context->private_enc_ctx;
+    struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)pak_context->generic_enc_state;
+    struct encoder_status_buffer_internal *status_buffer = &avc_ctx->status_buffer;
+    VASurfaceID refs[ARRAY_ELEMS(encode_state->reference_objects)];
+    int i;
+
+    for (i = 0; i < ARRAY_ELEMS(refs); i++) {
+        if (encode_state->reference_objects[i])
+            refs[i] = encode_state->reference_objects[i]->base.id;
+        else
+            refs[i] = VA_INVALID_SURFACE;
+    }
+
+    avc_ctx->pak_pipe = i965_avc_pak_scheduler_select(&avc_ctx->pak_scheduler,
+                                                      refs,
+                                                      ARRAY_ELEMS(refs),
+                                                      generic_state->brc_enabled);
+
+    if (avc_ctx->pak_pipe) {
+        avc_ctx->vdbox_idc = BSD_RING1;
+        avc_ctx->vdbox_mmio_base = VDBOX1_MMIO_BASE;
+    } else {
+        avc_ctx->vdbox_idc = BSD_RING0;
+        avc_ctx->vdbox_mmio_base = VDBOX0_MMIO_BASE;
+    }
+
+    /* the MFC status registers of the VDBox running the frame */
+    status_buffer->bs_byte_count_frame_reg_offset = avc_ctx->vdbox_mmio_base + (MFC_BITSTREAM_BYTECOUNT_FRAME_REG - VDBOX0_MMIO_BASE);
+    status_buffer->bs_byte_count_frame_nh_reg_offset = avc_ctx->vdbox_mmio_base + (MFC_BITSTREAM_BYTECOUNT_SLICE_REG - VDBOX0_MMIO_BASE);
+    status_buffer->image_status_mask_reg_offset = avc_ctx->vdbox_mmio_base + (MFC_IMAGE_STATUS_MASK_REG - VDBOX0_MMIO_BASE);
+    status_buffer->image_status_ctrl_reg_offset = avc_ctx->vdbox_mmio_base + (MFC_IMAGE_STATUS_CTRL_REG - VDBOX0_MMIO_BASE);
+    status_buffer->mfc_qp_status_count_reg_offset = avc_ctx->vdbox_mmio_base + (MFC_QP_STATUS_COUNT_REG - VDBOX0_MMIO_BASE);
+}
+
+/* Leaves the distortion of the frame to gen9_avc_scene_analysis_flush() */
+static void
+gen9_avc_scene_analysis(VADriverContextP ctx,
+                        struct encode_state *encode_state,
+                        struct intel_encoder_context *encoder_context)
+{
+    struct encoder_vme_mfc_context * vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
+    struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
+    struct avc_enc_state * avc_state = (struct avc_enc_state *)vme_context->private_enc_state;
+    uint32_t frame_id;
+    uint32_t hints;
+
+    if (!avc_state->scene_analysis_enable)
+        return;
+
+    /* in frame order */
+    gen9_avc_scene_analysis_flush(encoder_context, 0);
+
+    frame_id = i965_encoder_status_ring_last_frame_id(&encoder_context->status_ring);
+
+    /* the coded buffer of the previous frame may be mapped meanwhile */
+    _i965LockMutex(&avc_ctx->scene_mutex);
+
+    if (generic_state->frame_type == SLICE_TYPE_I || !generic_state->hme_enabled) {
+        /* no ME, the detector keeps its state */
+        hints = i965_avc_scene_detector_update(&avc_ctx->scene_detector, 0, 0);
+        i965_encoder_status_ring_set_hints(&encoder_context->status_ring, frame_id, hints);
+    } else {
+        avc_ctx->scene_pending = 1;
+        avc_ctx->scene_frame_id = frame_id;
+        avc_ctx->scene_width_in_mbs = MIN(generic_state->frame_width_in_mbs, generic_state->downscaled_width_4x_in_mb * 4);
+        avc_ctx->scene_height_in_mbs = MIN(generic_state->frame_height_in_mbs, generic_state->downscaled_height_4x_in_mb * 4);
+    }
+
+    _i965UnlockMutex(&avc_ctx->scene_mutex);
+}
+
 static VAStatus
 gen9_avc_encode_picture(VADriverContextP ctx,
                         VAProfile profile,
@@ -10940,13 +11269,21 @@ gen9_avc_encode_picture(VADriverContextP ctx,
     struct generic_enc_codec_state * generic_state = (struct generic_enc_codec_state *)vme_context->generic_enc_state;
     struct intel_batchbuffer *batch = encoder_context->base.batch;
 
+    /* before the PAK resources, some of them are per pipe */
+    gen9_avc_pak_select_pipe(encode_state, encoder_context);
+
     va_status = gen9_avc_pak_pipeline_prepare(ctx, profile, encode_state, encoder_context);
 
     if (va_status != VA_STATUS_SUCCESS)
         return va_status;
 
+    /* the frame runs, the next one is scheduled after it */
+    i965_avc_pak_scheduler_commit(&avc_ctx->pak_scheduler,
+                                  avc_ctx->pak_pipe,
+                                  encode_state->reconstructed_object->base.id);
+
     if (i965->intel.has_bsd2)
-        intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, BSD_RING0);
+        intel_batchbuffer_start_atomic_bcs_override(batch, 0x1000, avc_ctx->vdbox_idc);
     else
         intel_batchbuffer_start_atomic_bcs(batch, 0x1000);
     intel_batchbuffer_emit_mi_flush(batch);
@@ -10978,6 +11315,8 @@ gen9_avc_encode_picture(VADriverContextP ctx,
     intel_batchbuffer_end_atomic(batch);
     intel_batchbuffer_flush(batch);
 
+    gen9_avc_scene_analysis(ctx, encode_state, encoder_context);
+
     generic_state->seq_frame_number++;
     generic_state->total_frame_number++;
     generic_state->first_frame = 0;
@@ -11030,9 +11369,11 @@ gen9_avc_pak_context_destroy(void * context)
     i965_free_gpe_resource(&generic_ctx->res_uncompressed_input_surface);
 
     i965_free_gpe_resource(&generic_ctx->compressed_bitstream.res);
-    i965_free_gpe_resource(&avc_ctx->res_intra_row_store_scratch_buffer);
-    i965_free_gpe_resource(&avc_ctx->res_deblocking_filter_row_store_scratch_buffer);
-    i965_free_gpe_resource(&avc_ctx->res_bsd_mpc_row_store_scratch_buffer);
+    for (i = 0; i < I965_AVC_MAX_PAK_PIPES; i++) {
+        i965_free_gpe_resource(&avc_ctx->res_intra_row_store_scratch_buffer[i]);
+        i965_free_gpe_resource(&avc_ctx->res_deblocking_filter_row_store_scratch_buffer[i]);
+        i965_free_gpe_resource(&avc_ctx->res_bsd_mpc_row_store_scratch_buffer[i]);
+    }
     i965_free_gpe_resource(&avc_ctx->res_pak_mb_status_buffer);
 
     for (i = 0 ; i < MAX_MFC_AVC_REFERENCE_SURFACES; i++) {
@@ -11055,11 +11396,20 @@ gen9_avc_get_coded_status(VADriverContextP ctx,
                           struct intel_encoder_context *encoder_context,
                           struct i965_coded_buffer_segment *coded_buf_seg)
 {
+    struct encoder_vme_mfc_context * vme_context;
+    struct i965_avc_encoder_context * avc_ctx;
     struct encoder_status *avc_encode_status;
 
     if (!encoder_context || !coded_buf_seg)
         return VA_STATUS_ERROR_INVALID_BUFFER;
 
+    /* the frame is done, its hints go with the statistics of the buffer */
+    vme_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    avc_ctx = (struct i965_avc_encoder_context *)vme_context->private_enc_ctx;
+
+    if (coded_buf_seg->brc_stats.frame_id)
+        gen9_avc_scene_analysis_flush(encoder_context, coded_buf_seg->brc_stats.frame_id);
+
     avc_encode_status = (struct encoder_status *)coded_buf_seg->codec_private_data;
     coded_buf_seg->base.size = avc_encode_status->bs_byte_count_frame;
 
@@ -11315,6 +11665,11 @@ gen9_avc_vme_context_init(VADriverContextP ctx, struct intel_encoder_context *en
 
     avc_state->lambda_table_enable = 0;
 
+    avc_state->scene_analysis_enable = i965->intel.enc_scene_analysis > 0;
+    avc_state->scene_adaptive_enable = i965->intel.enc_scene_analysis > 1;
+    i965_avc_scene_detector_init(&avc_ctx->scene_detector);
+    _i965InitMutex(&avc_ctx->scene_mutex);
+
     if (IS_GEN8(i965->intel.device_info)) {
         avc_state->brc_const_data_surface_width = 64;
         avc_state->brc_const_data_surface_height = 44;
@@ -11400,15 +11755,26 @@ Bool
 gen9_avc_pak_context_init(VADriverContextP ctx, struct intel_encoder_context *encoder_context)
 {
     /* VME & PAK share the same context */
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
     struct encoder_vme_mfc_context * pak_context = (struct encoder_vme_mfc_context *)encoder_context->vme_context;
+    struct i965_avc_encoder_context * avc_ctx;
+    int num_pak_pipes;
 
     if (!pak_context)
         return false;
 
+    avc_ctx = (struct i965_avc_encoder_context *)pak_context->private_enc_ctx;
+    num_pak_pipes = i965->intel.has_bsd2 ? 2 : 1;
+    i965_avc_pak_scheduler_init(&avc_ctx->pak_scheduler, num_pak_pipes);
+
     encoder_context->mfc_context = pak_context;
     encoder_context->mfc_context_destroy = gen9_avc_pak_context_destroy;
     encoder_context->mfc_pipeline = gen9_avc_pak_pipeline;
     encoder_context->mfc_brc_prepare = gen9_avc_pak_brc_prepare;
     encoder_context->get_status = gen9_avc_get_coded_status;
+
+    /* not fatal, the coded buffers still carry the status */
+    i965_encoder_status_ring_alloc(ctx, &encoder_context->status_ring, num_pak_pipes);
+
     return true;
 }
@@ -167,3 +167,137 @@ i965_avc_calc_skip_value(unsigned int enc_block_based_sip_en, unsigned int trans
 
     return skip_value;
 }
+
+void
+i965_avc_pak_scheduler_init(struct i965_avc_pak_scheduler *scheduler, int num_pipes)
+{
+    int i;
+
+    assert(num_pipes > 0 && num_pipes <= I965_AVC_MAX_PAK_PIPES);
+
+    scheduler->num_pipes = num_pipes;
+    scheduler->last_pipe = num_pipes - 1;
+
+    for (i = 0; i < I965_AVC_MAX_PAK_PIPES; i++)
+        scheduler->last_recon[i] = VA_INVALID_SURFACE;
+}
+
+/*
+ * A frame follows the pipe still writing one of its references, on the
+ * other ring it would only wait for that frame. A frame without such a
+ * reference (an I frame or a frame after a non reference B frame) goes to
+ * the other pipe and runs next to the previous frame. The kernel orders
+ * the rings through the BOs shared by the frames.
+ *
+ * BRC feeds the PAK statistics of a frame to the next one, so every frame
+ * depends on the previous one and they all stay on the first pipe.
+ *
+ * The scheduler is left as it is until i965_avc_pak_scheduler_commit(),
+ * once the frame is sure to run.
+ */
+int
+i965_avc_pak_scheduler_select(const struct i965_avc_pak_scheduler *scheduler,
+                              const VASurfaceID *refs,
+                              int num_refs,
+                              int brc_enabled)
+{
+    int pipe = -1;
+    int i, j;
+
+    if (scheduler->num_pipes == 1 || brc_enabled) {
+        pipe = 0;
+    } else {
+        /* the most recent frame wins if both pipes write a reference */
+        for (i = 0; i < num_refs; i++) {
+            if (refs[i] == VA_INVALID_SURFACE)
+                continue;
+
+            for (j = 0; j < scheduler->num_pipes; j++) {
+                if (refs[i] == scheduler->last_recon[j] &&
+                    (pipe < 0 || j == scheduler->last_pipe))
+                    pipe = j;
+            }
+        }
+
+        if (pipe < 0)
+            pipe = (scheduler->last_pipe + 1) % scheduler->num_pipes;
+    }
+
+    return pipe;
+}
+
+/* The frame reconstructed into recon runs on pipe */
+void
+i965_avc_pak_scheduler_commit(struct i965_avc_pak_scheduler *scheduler,
+                              int pipe,
+                              VASurfaceID recon)
+{
+    assert(pipe >= 0 && pipe < scheduler->num_pipes);
+
+    scheduler->last_recon[pipe] = recon;
+    scheduler->last_pipe = pipe;
+}
+
+void
+i965_avc_scene_detector_init(struct i965_avc_scene_detector *detector)
+{
+    detector->avg_dist = 0;
+    detector->num_frames = 0;
+    detector->num_static = 0;
+    detector->hints = 0;
+}
+
+/*
+ * A frame is a scene cut when its distortion jumps well above the average
+ * of the previous frames, the average then starts over with the frames
+ * after the cut.
+ * A scene is static after a few frames with a low distortion and stays so
+ * until the distortion clearly rises again.
+ *
+ * total_dist is the sum of the ME distortion over num_mbs MBs. A frame
+ * without ME (an I frame) has num_mbs 0, it keeps the state of the
+ * previous frames.
+ */
+uint32_t
+i965_avc_scene_detector_update(struct i965_avc_scene_detector *detector,
+                               uint64_t total_dist,
+                               unsigned int num_mbs)
+{
+    uint32_t dist;
+    uint32_t hints = 0;
+
+    if (num_mbs) {
+        dist = total_dist / num_mbs;
+
+        if (detector->num_frames >= I965_AVC_SCENE_MIN_FRAMES &&
+            dist >= I965_AVC_SCENE_CUT_MIN_DIST &&
+            ((uint64_t)dist << 4) >= (uint64_t)detector->avg_dist * I965_AVC_SCENE_CUT_RATIO) {
+            hints |= I965_ENCODER_STATUS_HINT_SCENE_CUT;
+            detector->num_frames = 0;
+        } else {
+            if (detector->num_frames == 0)
+                detector->avg_dist = dist << 4;
+            else
+                detector->avg_dist = (detector->avg_dist * 7 + (dist << 4) + 4) / 8;
+
+            if (detector->num_frames < I965_AVC_SCENE_MIN_FRAMES)
+                detector->num_frames++;
+        }
+
+        if (dist <= I965_AVC_SCENE_STATIC_DIST) {
+            if (detector->num_static < I965_AVC_SCENE_STATIC_FRAMES)
+                detector->num_static++;
+        } else if (detector->num_static < I965_AVC_SCENE_STATIC_FRAMES ||
+                   dist > I965_AVC_SCENE_STATIC_EXIT_DIST ||
+                   (hints & I965_ENCODER_STATUS_HINT_SCENE_CUT)) {
+            detector->num_static = 0;
+        }
+    }
+
+    if (detector->num_static >= I965_AVC_SCENE_STATIC_FRAMES)
+        hints |= I965_ENCODER_STATUS_HINT_STATIC_SCENE;
+
+    detector->hints = hints;
+
+    return hints;
+}
@@ -36,6 +36,7 @@
 #include <assert.h>
 #include "intel_driver.h"
 #include "i965_avc_encoder.h"
+#include "i965_avc_const_def.h"
 
 // SubMbPartMask defined in CURBE for AVC ENC
 #define INTEL_AVC_DISABLE_4X4_SUB_MB_PARTITION    0x40
@@ -104,6 +105,50 @@ typedef enum {
 /*
 common structure and define
 */
+/* Inputs of the BRC constant data besides the per frame reference lists */
+struct i965_avc_brc_const_data_key {
+    uint32_t frame_type;
+    uint32_t block_based_skip_enable;
+    uint32_t transform_8x8_mode_enable;
+    uint32_t non_ftq_skip_threshold_lut_input_enable;
+    uint32_t ftq_skip_threshold_lut_input_enable;
+    uint32_t old_mode_cost_enable;
+    uint32_t adaptive_intra_scaling_enable;
+    uint8_t  non_ftq_skip_threshold_lut[52];
+    uint8_t  ftq_skip_threshold_lut[52];
+};
+
+/* The reference list QPs follow the QP adjustment and the skip tables */
+#define I965_AVC_BRC_CONST_DATA_REF_QP_OFFSET                                   \
+    (sizeof(gen9_avc_qp_adjustment_dist_threshold_max_frame_threshold_dist_qp_adjustment_ipb) + \
+     sizeof(gen9_avc_skip_value_p[0][0]))
+#define I965_AVC_BRC_CONST_DATA_REF_QP_SIZE     256
+
+#define I965_AVC_MAX_PAK_PIPES 2
+
+/* Picks the VDBox running the PAK of every frame on parts with two of them */
+struct i965_avc_pak_scheduler {
+    int num_pipes;
+    int last_pipe;
+    VASurfaceID last_recon[I965_AVC_MAX_PAK_PIPES]; /* the last frame written by each pipe */
+};
+
+/* thresholds on the 4x HME distortion per MB */
+#define I965_AVC_SCENE_CUT_RATIO        4       /* against the running average */
+#define I965_AVC_SCENE_CUT_MIN_DIST     256
+#define I965_AVC_SCENE_MIN_FRAMES       2       /* in the average before a cut is reported */
+#define I965_AVC_SCENE_STATIC_DIST      16
+#define I965_AVC_SCENE_STATIC_EXIT_DIST 32
+#define I965_AVC_SCENE_STATIC_FRAMES    3
+
+/* Detects scene cuts and static scenes from the ME distortion of the frames */
+struct i965_avc_scene_detector {
+    uint32_t avg_dist;      /* running average of the distortion per MB, 4 fractional bits */
+    int num_frames;         /* frames in the average */
+    int num_static;         /* consecutive frames below the static threshold */
+    uint32_t hints;         /* I965_ENCODER_STATUS_HINT_* of the last frame */
+};
+
 struct i965_avc_encoder_context {
 
     VADriverContextP ctx;
@@ -119,6 +164,11 @@ struct i965_avc_encoder_context {
     struct i965_gpe_resource res_brc_mbenc_curbe_read_buffer;
     struct i965_gpe_resource res_brc_mbenc_curbe_write_buffer;
     struct i965_gpe_resource res_brc_const_data_buffer;
+    struct {
+        unsigned char *data;
+        unsigned int size;
+        struct i965_avc_brc_const_data_key key;
+    } brc_const_data_cache;
     //brc and mbbrc
     struct i965_gpe_resource res_mb_status_buffer;
     //mbbrc
@@ -164,10 +214,11 @@ struct i965_avc_encoder_context {
 
     /* PAK resource */
     //internal
-    struct i965_gpe_resource res_intra_row_store_scratch_buffer;
-    struct i965_gpe_resource res_deblocking_filter_row_store_scratch_buffer;
+    //one per pipe, the frames on the two VDBoxes run at the same time
+    struct i965_gpe_resource res_intra_row_store_scratch_buffer[I965_AVC_MAX_PAK_PIPES];
+    struct i965_gpe_resource res_deblocking_filter_row_store_scratch_buffer[I965_AVC_MAX_PAK_PIPES];
     struct i965_gpe_resource res_deblocking_filter_tile_col_buffer;
-    struct i965_gpe_resource res_bsd_mpc_row_store_scratch_buffer;
+    struct i965_gpe_resource res_bsd_mpc_row_store_scratch_buffer[I965_AVC_MAX_PAK_PIPES];
     struct i965_gpe_resource res_mfc_indirect_bse_object;
     struct i965_gpe_resource res_pak_mb_status_buffer;
     struct i965_gpe_resource res_direct_mv_buffersr[NUM_MFC_AVC_DMV_BUFFERS];//INTERNAL: 0-31 as input,32 and 33 as output
@@ -206,6 +257,21 @@ struct i965_avc_encoder_context {
 
     struct encoder_status_buffer_internal status_buffer;
 
+    /* the kernels are queued and submitted by the caller */
+    int defer_kernel_flush;
+
+    struct i965_avc_pak_scheduler pak_scheduler;
+    int pak_pipe;
+    int vdbox_idc;
+    uint32_t vdbox_mmio_base;
+
+    struct i965_avc_scene_detector scene_detector;
+    /* the frame whose 4x HME distortion is still to be read */
+    int scene_pending;
+    uint32_t scene_frame_id;            /* status ring frame id */
+    unsigned int scene_width_in_mbs;
+    unsigned int scene_height_in_mbs;
+    _I965Mutex scene_mutex;             /* the scene state, also used by the coded buffer map */
 };
 
 #define MAX_AVC_SLICE_NUM 256
@@ -315,6 +381,7 @@ struct avc_enc_state {
     uint32_t hme_mv_cost_scaling_factor;
     uint32_t slice_height;//default 1
     uint32_t slice_num;//default 1
+    uint32_t seq_preset;    /* the preset of the frame sizes in generic_state */
     uint32_t dist_scale_factor_list0[32];
     uint32_t bi_weight;
     uint32_t brc_const_data_surface_width;
@@ -335,7 +402,9 @@ struct avc_enc_state {
     uint32_t decouple_mbenc_curbe_from_brc_enable : 1;
     uint32_t extended_mv_cost_range_enable : 1;
     uint32_t lambda_table_enable : 1;
-    uint32_t reserved_g95 : 30;
+    uint32_t scene_analysis_enable : 1;
+    uint32_t scene_adaptive_enable : 1;
+    uint32_t reserved_g95 : 28;
     uint32_t mbenc_brc_buffer_size;
 
 };
@@ -347,4 +416,9 @@ extern unsigned int i965_avc_get_profile_level_max_frame(struct avc_param * para
 extern int i965_avc_get_max_mv_len(int level_idc);
 extern int i965_avc_get_max_mv_per_2mb(int level_idc);
 extern unsigned short i965_avc_calc_skip_value(unsigned int enc_block_based_sip_en, unsigned int transform_8x8_flag, unsigned short skip_value);
+extern void i965_avc_pak_scheduler_init(struct i965_avc_pak_scheduler *scheduler, int num_pipes);
+extern int i965_avc_pak_scheduler_select(const struct i965_avc_pak_scheduler *scheduler, const VASurfaceID *refs, int num_refs, int brc_enabled);
+extern void i965_avc_pak_scheduler_commit(struct i965_avc_pak_scheduler *scheduler, int pipe, VASurfaceID recon);
+extern void i965_avc_scene_detector_init(struct i965_avc_scene_detector *detector);
+extern uint32_t i965_avc_scene_detector_update(struct i965_avc_scene_detector *detector, uint64_t total_dist, unsigned int num_mbs);
 #endif // _I965_AVC_ENCODER_COMMON_H
@@ -185,19 +185,22 @@ mpeg2_set_reference_surfaces(
     }
 }
 
-/* Ensure the supplied VA surface has valid storage for decoding the
-   current picture */
-VAStatus
-avc_ensure_surface_bo(
-    VADriverContextP                    ctx,
+/* Derive the surface formats of the current H.264 sequence, unless they
+   are already known from a previous picture */
+static VAStatus
+avc_check_surface_format(
     struct decode_state                *decode_state,
-    struct object_surface              *obj_surface,
     const VAPictureParameterBufferH264 *pic_param
 )
 {
-    VAStatus va_status;
+    struct decode_check_cache * const cache = &decode_state->check_cache;
+    const uint32_t seq_key = DECODE_CHECK_KEY_AVC |
+                             pic_param->seq_fields.bits.chroma_format_idc;
     uint32_t hw_fourcc, fourcc, subsample, chroma_format;
 
+    if (cache->seq_key == seq_key)
+        return VA_STATUS_SUCCESS;
+
     /* Validate chroma format */
     switch (pic_param->seq_fields.bits.chroma_format_idc) {
     case 0: // Grayscale
@@ -231,26 +234,73 @@ avc_ensure_surface_bo(
     if (!hw_fourcc)
         return VA_STATUS_ERROR_UNSUPPORTED_RT_FORMAT;
 
+    cache->seq_key = seq_key;
+    cache->fourcc = fourcc;
+    cache->hw_fourcc = hw_fourcc;
+    cache->subsample = subsample;
+    return VA_STATUS_SUCCESS;
+}
+
+/* Ensure the supplied VA surface has valid storage for decoding the
+   current picture */
+VAStatus
+avc_ensure_surface_bo(
+    VADriverContextP                    ctx,
+    struct decode_state                *decode_state,
+    struct object_surface              *obj_surface,
+    const VAPictureParameterBufferH264 *pic_param
+)
+{
+    struct decode_check_cache * const cache = &decode_state->check_cache;
+    VAStatus va_status;
+    uint32_t hw_fourcc, fourcc;
+    bool fake_chroma;
+
+    va_status = avc_check_surface_format(decode_state, pic_param);
+    if (va_status != VA_STATUS_SUCCESS)
+        return va_status;
+
+    fourcc = cache->fourcc;
+    hw_fourcc = cache->hw_fourcc;
+    fake_chroma = (fourcc == VA_FOURCC_Y800 && hw_fourcc == VA_FOURCC_NV12);
+
+    /* A reference frame already validated for this sequence */
+    if (obj_surface->bo && obj_surface->fourcc == hw_fourcc &&
+        obj_surface->fake_chroma_filled == fake_chroma &&
+        obj_surface != decode_state->render_object) {
+        cache->num_hits++;
+        return VA_STATUS_SUCCESS;
+    }
+    cache->num_misses++;
+
     /* (Re-)allocate the underlying surface buffer store, if necessary */
     if (!obj_surface->bo || obj_surface->fourcc != hw_fourcc) {
         struct i965_driver_data * const i965 = i965_driver_data(ctx);
 
         i965_destroy_surface_storage(obj_surface);
         va_status = i965_check_alloc_surface_bo(ctx, obj_surface,
-                                                i965->codec_info->has_tiled_surface, hw_fourcc, subsample);
+                                                i965->codec_info->has_tiled_surface, hw_fourcc, cache->subsample);
         if (va_status != VA_STATUS_SUCCESS)
             return va_status;
     }
 
-    /* Fake chroma components if grayscale is implemented on top of NV12 */
-    if (fourcc == VA_FOURCC_Y800 && hw_fourcc == VA_FOURCC_NV12) {
-        const uint32_t uv_offset = obj_surface->width * obj_surface->height;
-        const uint32_t uv_size   = obj_surface->width * obj_surface->height / 2;
-
-        drm_intel_gem_bo_map_gtt(obj_surface->bo);
-        memset(obj_surface->bo->virtual + uv_offset, 0x80, uv_size);
-        drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
-    }
+    /* Fake chroma components if grayscale is implemented on top of NV12.
+       The decoder leaves the chroma planes untouched, so a reference
+       frame still holds what was written when it was decoded and only
+       the picture being decoded needs to be filled again */
+    if (fake_chroma) {
+        if (!obj_surface->fake_chroma_filled ||
+            obj_surface == decode_state->render_object) {
+            const uint32_t uv_offset = obj_surface->width * obj_surface->height;
+            const uint32_t uv_size   = obj_surface->width * obj_surface->height / 2;
+
+            drm_intel_gem_bo_map_gtt(obj_surface->bo);
+            memset(obj_surface->bo->virtual + uv_offset, 0x80, uv_size);
+            drm_intel_gem_bo_unmap_gtt(obj_surface->bo);
+            obj_surface->fake_chroma_filled = true;
+        }
+    } else
+        obj_surface->fake_chroma_filled = false;
     return VA_STATUS_SUCCESS;
 }
 
@@ -578,16 +628,6 @@ gen6_mfd_avc_phantom_slice(VADriverContextP ctx,
     gen6_mfd_avc_phantom_slice_bsd_object(ctx, pic_param, batch);
 }
 
-/* Comparison function for sorting out the array of free frame store entries */
-static int
-compare_avc_ref_store_func(const void *p1, const void *p2)
-{
-    const GenFrameStore * const fs1 = *((GenFrameStore **)p1);
-    const GenFrameStore * const fs2 = *((GenFrameStore **)p2);
-
-    return fs1->ref_age - fs2->ref_age;
-}
-
 static void
 intel_update_codec_frame_store_index(
     VADriverContextP              ctx,
@@ -598,13 +638,12 @@ intel_update_codec_frame_store_index(
     GenFrameStoreContext         *fs_ctx
 )
 {
-    GenFrameStore **free_refs = calloc(num_elements, sizeof(GenFrameStore *));
+    GenFrameStore *free_refs[MAX_GEN_REFERENCE_FRAMES];
     uint32_t used_refs = 0, add_refs = 0;
     uint64_t age;
-    int i, n, num_free_refs;
+    int i, j, n, num_free_refs;
 
-    if (!free_refs)
-        return;
+    assert(num_elements <= MAX_GEN_REFERENCE_FRAMES);
 
     /* Detect changes of access unit */
     if (fs_ctx->age == 0 || fs_ctx->prev_poc != poc)
@@ -636,16 +675,20 @@ intel_update_codec_frame_store_index(
     }
 
     /* Build and sort out the list of retired candidates. The resulting
-       list is ordered by increasing age when they were last used */
+       list is ordered by increasing age when they were last used, and
+       by increasing index for entries of the same age, so that the slot
+       assignment only depends on the sequence of reference lists */
     for (i = 0, n = 0; i < num_elements; i++) {
         if (!(used_refs & (1 << i))) {
             GenFrameStore * const fs = &frame_store[i];
             fs->obj_surface = NULL;
-            free_refs[n++] = fs;
+
+            for (j = n++; j > 0 && free_refs[j - 1]->ref_age > fs->ref_age; j--)
+                free_refs[j] = free_refs[j - 1];
+            free_refs[j] = fs;
         }
     }
     num_free_refs = n;
-    qsort(&free_refs[0], n, sizeof(free_refs[0]), compare_avc_ref_store_func);
 
     /* Append the new reference frames */
     for (i = 0, n = 0; i < ARRAY_ELEMS(decode_state->reference_objects); i++) {
@@ -668,8 +711,6 @@ intel_update_codec_frame_store_index(
         }
         WARN_ONCE("No free slot found for DPB reference list!!!\n");
     }
-
-    free(free_refs);
 }
 
 void
@@ -1210,33 +1251,43 @@ hevc_ensure_surface_bo(
     const VAPictureParameterBufferHEVC *pic_param
 )
 {
+    struct i965_driver_data * const i965 = i965_driver_data(ctx);
+    struct decode_check_cache * const cache = &decode_state->check_cache;
+    const uint32_t seq_key = DECODE_CHECK_KEY_HEVC |
+                             (pic_param->bit_depth_luma_minus8 << 4) |
+                             pic_param->bit_depth_chroma_minus8;
     VAStatus va_status = VA_STATUS_SUCCESS;
-    int update = 0;
-    unsigned int fourcc = VA_FOURCC_NV12;
+    unsigned int fourcc;
 
-    if ((pic_param->bit_depth_luma_minus8 > 0)
-        || (pic_param->bit_depth_chroma_minus8 > 0)) {
-        if (obj_surface->fourcc != VA_FOURCC_P010) {
-            update = 1;
+    if (cache->seq_key != seq_key) {
+        if ((pic_param->bit_depth_luma_minus8 > 0)
+            || (pic_param->bit_depth_chroma_minus8 > 0))
             fourcc = VA_FOURCC_P010;
-        }
-    } else if (obj_surface->fourcc != VA_FOURCC_NV12) {
-        update = 1;
-        fourcc = VA_FOURCC_NV12;
+        else
+            fourcc = VA_FOURCC_NV12;
+
+        cache->seq_key = seq_key;
+        cache->fourcc = fourcc;
+        cache->hw_fourcc = fourcc;
+        cache->subsample = SUBSAMPLE_YUV420;
     }
+    fourcc = cache->hw_fourcc;
 
-    /* (Re-)allocate the underlying surface buffer store, if necessary */
-    if (!obj_surface->bo || update) {
-        struct i965_driver_data * const i965 = i965_driver_data(ctx);
+    /* A surface already validated for this sequence */
+    if (obj_surface->bo && obj_surface->fourcc == fourcc) {
+        cache->num_hits++;
+        return VA_STATUS_SUCCESS;
+    }
+    cache->num_misses++;
 
-        i965_destroy_surface_storage(obj_surface);
+    /* (Re-)allocate the underlying surface buffer store */
+    i965_destroy_surface_storage(obj_surface);
 
-        va_status = i965_check_alloc_surface_bo(ctx,
-                                                obj_surface,
-                                                i965->codec_info->has_tiled_surface,
-                                                fourcc,
-                                                SUBSAMPLE_YUV420);
-    }
+    va_status = i965_check_alloc_surface_bo(ctx,
+                                            obj_surface,
+                                            i965->codec_info->has_tiled_surface,
+                                            fourcc,
+                                            SUBSAMPLE_YUV420);
 
     return va_status;
 }
@@ -1540,6 +1591,82 @@ intel_ensure_vp8_segmentation_buffer(VADriverContextP ctx, GenBuffer *buf,
     return buf->valid;
 }
 
+bool
+intel_ensure_vc1_bitplane_buffer(VADriverContextP ctx, GenBuffer *buf,
+                                 dri_bo **spare_bo, unsigned int buf_size)
+{
+    struct i965_driver_data * const i965 = i965_driver_data(ctx);
+    dri_bo *bo;
+
+    /* The bitplane is double buffered: while the GPU still reads the
+       buffer of the previous picture, the one of the picture before it is
+       usually done, so pipelined pictures alternate between the two
+       without stalling on the map or allocating a new buffer */
+    if (buf->bo && buf->bo->size >= buf_size && !drm_intel_bo_busy(buf->bo))
+        return true;
+
+    if (*spare_bo && (*spare_bo)->size >= buf_size && !drm_intel_bo_busy(*spare_bo)) {
+        bo = buf->bo;
+        buf->bo = *spare_bo;
+        *spare_bo = bo;
+        return true;
+    }
+
+    /* Both are busy or too small, the busy one of the previous picture
+       becomes the spare */
+    drm_intel_bo_unreference(*spare_bo);
+    *spare_bo = NULL;
+
+    if (buf->bo && buf->bo->size >= buf_size)
+        *spare_bo = buf->bo;
+    else
+        drm_intel_bo_unreference(buf->bo);
+
+    buf->bo = drm_intel_bo_alloc(i965->intel.bufmgr, "VC-1 Bitplane",
+                                 buf_size, 0x1000);
+    return buf->bo != NULL;
+}
+
+/* Converts the VA bitplane (one nibble per MB, continuous over the whole
+   picture, first MB in the high nibble) into the MFX layout (one row of
+   dst_pitch bytes per MB row, first MB in the low nibble). A NULL src
+   fills the bitplane for a skipped picture */
+void
+intel_vc1_pack_bitplane(uint8_t *dst, unsigned int dst_pitch,
+                        const uint8_t *src,
+                        unsigned int width_in_mbs, unsigned int height_in_mbs)
+{
+    const unsigned int num_pairs = width_in_mbs / 2;
+    unsigned int x, y, n;
+
+    for (y = 0, n = 0; y < height_in_mbs; y++, n += width_in_mbs) {
+        const uint8_t *s;
+
+        if (!src) {
+            memset(dst, 0x22, num_pairs);
+            if (width_in_mbs & 1)
+                dst[num_pairs] = 0x02;
+            dst += dst_pitch;
+            continue;
+        }
+
+        /* n is the index of the first MB of the row in the VA bitplane */
+        s = src + n / 2;
+        if (!(n & 1)) {
+            for (x = 0; x < num_pairs; x++)
+                dst[x] = (uint8_t)((s[x] >> 4) | (s[x] << 4));
+            if (width_in_mbs & 1)
+                dst[x] = s[x] >> 4;
+        } else {
+            for (x = 0; x < num_pairs; x++)
+                dst[x] = (s[x] & 0x0f) | (s[x + 1] & 0xf0);
+            if (width_in_mbs & 1)
+                dst[x] = s[x] & 0x0f;
+        }
+        dst += dst_pitch;
+    }
+}
+
 void
 hevc_gen_default_iq_matrix(VAIQMatrixBufferHEVC *iq_matrix)
 {
@@ -175,6 +175,15 @@ bool
 intel_ensure_vp8_segmentation_buffer(VADriverContextP ctx, GenBuffer *buf,
                                      unsigned int mb_width, unsigned int mb_height);
 
+bool
+intel_ensure_vc1_bitplane_buffer(VADriverContextP ctx, GenBuffer *buf,
+                                 dri_bo **spare_bo, unsigned int buf_size);
+
+void
+intel_vc1_pack_bitplane(uint8_t *dst, unsigned int dst_pitch,
+                        const uint8_t *src,
+                        unsigned int width_in_mbs, unsigned int height_in_mbs);
+
 void
 hevc_gen_default_iq_matrix(VAIQMatrixBufferHEVC *iq_matrix);
 
@@ -984,6 +984,9 @@
 #define MFC_IMAGE_STATUS_CTRL_REG               0x128B8
 #define MFC_QP_STATUS_COUNT_REG                 0x128bc
 
+#define VDBOX0_MMIO_BASE                        0x12000
+#define VDBOX1_MMIO_BASE                        0x1c000
+
 #define HCP_VP9_BITSTREAM_BYTECOUNT_FRAME_REG           0x1E9E0
 #define HCP_VP9_BITSTREAM_BYTECOUNT_FRAME_NO_HEADER_REG 0x1E9E4
 
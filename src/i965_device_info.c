@@ -29,8 +29,6 @@
 
 #include <string.h>
 #include <strings.h>
-#include <errno.h>
-#include <cpuid.h>
 
 /* Extra set of chroma formats supported for H.264 decoding (beyond YUV 4:2:0) */
 #define EXTRA_H264_DEC_CHROMA_FORMATS \
@@ -896,42 +894,6 @@ i965_get_device_info(int devid)
     }
 }
 
-static void cpuid(unsigned int op,
-                  uint32_t *eax, uint32_t *ebx,
-                  uint32_t *ecx, uint32_t *edx)
-{
-    __cpuid_count(op, 0, *eax, *ebx, *ecx, *edx);
-}
-
-/*
- * This function doesn't check the length. And the caller should
- * assure that the length of input string should be greater than 48.
- */
-static int intel_driver_detect_cpustring(char *model_id)
-{
-    uint32_t *rdata;
-
-    if (model_id == NULL)
-        return -EINVAL;
-
-    rdata = (uint32_t *)model_id;
-
-    /* obtain the max supported extended CPUID info */
-    cpuid(0x80000000, &rdata[0], &rdata[1], &rdata[2], &rdata[3]);
-
-    /* If the max extended CPUID info is less than 0x80000004, fail */
-    if (rdata[0] < 0x80000004)
-        return -EINVAL;
-
-    /* obtain the CPUID string */
-    cpuid(0x80000002, &rdata[0], &rdata[1], &rdata[2], &rdata[3]);
-    cpuid(0x80000003, &rdata[4], &rdata[5], &rdata[6], &rdata[7]);
-    cpuid(0x80000004, &rdata[8], &rdata[9], &rdata[10], &rdata[11]);
-
-    *(model_id + 48) = '\0';
-    return 0;
-}
-
 /*
  * the hook_list for HSW.
  * It is captured by /proc/cpuinfo and the space character is stripped.
@@ -947,17 +909,19 @@ const static char *hsw_cpu_hook_list[] =  {
 
 static void hsw_hw_codec_preinit(VADriverContextP ctx, struct hw_codec_info *codec_info)
 {
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
     char model_string[64];
     char *model_ptr, *tmp_ptr;
     int i, model_len, list_len;
     bool found;
 
-    memset(model_string, 0, sizeof(model_string));
-
     /* If it can't detect cpu model_string, leave it alone */
-    if (intel_driver_detect_cpustring(model_string))
+    if (i965->intel.cpu_model[0] == '\0')
         return;
 
+    memset(model_string, 0, sizeof(model_string));
+    memcpy(model_string, i965->intel.cpu_model, sizeof(i965->intel.cpu_model));
+
     /* strip the cpufreq info */
     model_ptr = model_string;
     tmp_ptr = strstr(model_ptr, "@");
@@ -1010,17 +974,19 @@ const static char *gen6_cpu_hook_list[] =  {
 
 static void gen6_hw_codec_preinit(VADriverContextP ctx, struct hw_codec_info *codec_info)
 {
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
     char model_string[64];
     char *model_ptr, *tmp_ptr;
     int i, model_len, list_len;
     bool found;
 
-    memset(model_string, 0, sizeof(model_string));
-
     /* If it can't detect cpu model_string, leave it alone */
-    if (intel_driver_detect_cpustring(model_string))
+    if (i965->intel.cpu_model[0] == '\0')
         return;
 
+    memset(model_string, 0, sizeof(model_string));
+    memcpy(model_string, i965->intel.cpu_model, sizeof(i965->intel.cpu_model));
+
     /* strip the cpufreq info */
     model_ptr = model_string;
     tmp_ptr = strstr(model_ptr, "@");
@@ -1100,17 +1066,19 @@ const static char *gen7_cpu_hook_list[] =  {
 
 static void gen7_hw_codec_preinit(VADriverContextP ctx, struct hw_codec_info *codec_info)
 {
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
     char model_string[64];
     char *model_ptr, *tmp_ptr;
     int i, model_len, list_len;
     bool found;
 
-    memset(model_string, 0, sizeof(model_string));
-
     /* If it can't detect cpu model_string, leave it alone */
-    if (intel_driver_detect_cpustring(model_string))
+    if (i965->intel.cpu_model[0] == '\0')
         return;
 
+    memset(model_string, 0, sizeof(model_string));
+    memcpy(model_string, i965->intel.cpu_model, sizeof(i965->intel.cpu_model));
+
     /* strip the cpufreq info */
     model_ptr = model_string;
     tmp_ptr = strstr(model_ptr, "@");
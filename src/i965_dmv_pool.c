@@ -0,0 +1,218 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "intel_driver.h"
+#include "i965_dmv_pool.h"
+
+/*
+ * The buffer manager may round the sizes up, a BO is good for any size
+ * it holds and up to a quarter less.
+ */
+static int
+i965_dmv_pool_bucket_fits(unsigned long bucket_size, unsigned long size)
+{
+    return bucket_size >= size && bucket_size - size <= size / 4 + 4096;
+}
+
+void
+i965_dmv_pool_init(struct i965_dmv_pool *pool, dri_bufmgr *bufmgr, const char *name)
+{
+    memset(pool, 0, sizeof(*pool));
+    pool->bufmgr = bufmgr;
+    pool->name = name;
+    pool->max_bytes = I965_DMV_POOL_MAX_BYTES;
+    _i965InitMutex(&pool->mutex);
+}
+
+void
+i965_dmv_pool_fini(struct i965_dmv_pool *pool)
+{
+    int i, j;
+
+    for (i = 0; i < I965_DMV_POOL_BUCKETS; i++) {
+        for (j = 0; j < pool->buckets[i].num_bos; j++) {
+            dri_bo_unreference(pool->buckets[i].bos[j]);
+            pool->buckets[i].bos[j] = NULL;
+        }
+
+        pool->buckets[i].num_bos = 0;
+        pool->buckets[i].size = 0;
+    }
+
+    pool->stats.num_bytes = 0;
+    _i965DestroyMutex(&pool->mutex);
+}
+
+/* Takes the last BO of bucket i, the bucket is free once empty */
+static dri_bo *
+i965_dmv_pool_take(struct i965_dmv_pool *pool, int i)
+{
+    dri_bo *bo;
+
+    assert(pool->buckets[i].num_bos);
+
+    bo = pool->buckets[i].bos[--pool->buckets[i].num_bos];
+    pool->buckets[i].bos[pool->buckets[i].num_bos] = NULL;
+    pool->stats.num_bytes -= bo->size;
+
+    if (!pool->buckets[i].num_bos)
+        pool->buckets[i].size = 0;
+
+    return bo;
+}
+
+/* The least recently used bucket holding BOs, but for bucket skip */
+static int
+i965_dmv_pool_lru_bucket(struct i965_dmv_pool *pool, int skip)
+{
+    int i, lru = -1;
+
+    for (i = 0; i < I965_DMV_POOL_BUCKETS; i++) {
+        if (i == skip || !pool->buckets[i].num_bos)
+            continue;
+
+        if (lru < 0 ||
+            (int32_t)(pool->buckets[i].last_use - pool->buckets[lru].last_use) < 0)
+            lru = i;
+    }
+
+    return lru;
+}
+
+dri_bo *
+i965_dmv_pool_get(struct i965_dmv_pool *pool, unsigned long size)
+{
+    dri_bo *bo = NULL;
+    int i;
+
+    _i965LockMutex(&pool->mutex);
+
+    for (i = 0; i < I965_DMV_POOL_BUCKETS; i++) {
+        if (pool->buckets[i].num_bos &&
+            i965_dmv_pool_bucket_fits(pool->buckets[i].size, size)) {
+            pool->buckets[i].last_use = ++pool->clock;
+            bo = i965_dmv_pool_take(pool, i);
+            pool->stats.num_reuses++;
+            break;
+        }
+    }
+
+    _i965UnlockMutex(&pool->mutex);
+
+    if (bo)
+        return bo;
+
+    bo = dri_bo_alloc(pool->bufmgr, pool->name, size, 0x1000);
+
+    if (bo) {
+        _i965LockMutex(&pool->mutex);
+        pool->stats.num_allocs++;
+        _i965UnlockMutex(&pool->mutex);
+    }
+
+    return bo;
+}
+
+/* Takes over the reference of the caller on bo */
+void
+i965_dmv_pool_put(struct i965_dmv_pool *pool, dri_bo *bo)
+{
+    dri_bo *evicted[I965_DMV_POOL_BUCKETS * I965_DMV_POOL_SLOTS];
+    int num_evicted = 0;
+    int i, bucket = -1;
+
+    if (!bo)
+        return;
+
+    if (!pool) {
+        dri_bo_unreference(bo);
+        return;
+    }
+
+    _i965LockMutex(&pool->mutex);
+
+    if (bo->size <= pool->max_bytes) {
+        for (i = 0; i < I965_DMV_POOL_BUCKETS; i++) {
+            if (pool->buckets[i].num_bos && pool->buckets[i].size == bo->size) {
+                bucket = i;
+                break;
+            }
+
+            if (!pool->buckets[i].num_bos && bucket < 0)
+                bucket = i;
+        }
+
+        /* a new size with every bucket taken, the least recently used goes */
+        if (bucket < 0) {
+            bucket = i965_dmv_pool_lru_bucket(pool, -1);
+
+            while (pool->buckets[bucket].num_bos)
+                evicted[num_evicted++] = i965_dmv_pool_take(pool, bucket);
+        }
+
+        if (pool->buckets[bucket].num_bos == I965_DMV_POOL_SLOTS)
+            bucket = -1;
+    }
+
+    if (bucket >= 0) {
+        /* the other sizes first, from the least recently used */
+        while (pool->stats.num_bytes + bo->size > pool->max_bytes) {
+            i = i965_dmv_pool_lru_bucket(pool, bucket);
+
+            if (i < 0)
+                i = bucket;
+
+            evicted[num_evicted++] = i965_dmv_pool_take(pool, i);
+        }
+
+        pool->buckets[bucket].size = bo->size;
+        pool->buckets[bucket].bos[pool->buckets[bucket].num_bos++] = bo;
+        pool->buckets[bucket].last_use = ++pool->clock;
+        pool->stats.num_bytes += bo->size;
+        pool->stats.num_returns++;
+    } else {
+        pool->stats.num_drops++;
+    }
+
+    pool->stats.num_evictions += num_evicted;
+    _i965UnlockMutex(&pool->mutex);
+
+    while (num_evicted)
+        dri_bo_unreference(evicted[--num_evicted]);
+
+    if (bucket < 0)
+        dri_bo_unreference(bo);
+}
+
+void
+i965_dmv_pool_get_stats(struct i965_dmv_pool *pool, struct i965_dmv_pool_stats *stats)
+{
+    _i965LockMutex(&pool->mutex);
+    *stats = pool->stats;
+    _i965UnlockMutex(&pool->mutex);
+}
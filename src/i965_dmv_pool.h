@@ -0,0 +1,95 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_DMV_POOL_H_
+#define _I965_DMV_POOL_H_
+
+#include <stdint.h>
+#include <intel_bufmgr.h>
+
+#include "i965_mutext.h"
+
+#define I965_DMV_POOL_BUCKETS           4
+#define I965_DMV_POOL_SLOTS             17      /* a full DPB and the current picture */
+#define I965_DMV_POOL_MAX_BYTES         (64 << 20)      /* default cap on the pooled BOs */
+
+enum {
+    I965_DMV_POOL_AVC = 0,
+    I965_DMV_POOL_HEVC,
+    I965_DMV_POOL_NUM,
+};
+
+struct i965_dmv_pool_stats {
+    uint32_t num_allocs;                /* new BOs */
+    uint32_t num_reuses;                /* BOs taken from the pool */
+    uint32_t num_returns;               /* BOs given back to the pool */
+    uint32_t num_drops;                 /* BOs released, the pool being full */
+    uint32_t num_evictions;             /* pooled BOs released for newer ones */
+    unsigned long num_bytes;            /* the size of the pooled BOs */
+};
+
+/*
+ * The direct MV / temporal MV buffers of the decoded surfaces, kept when
+ * the surfaces are destroyed for the next ones of the same size. Sessions
+ * created and torn down over and over take their buffers from here.
+ *
+ * A bucket holds the BOs of one size and is free again once emptied. A
+ * size coming back with every bucket taken empties the least recently
+ * used one, and the BOs of the least recently used buckets go first when
+ * the pool would hold more than max_bytes.
+ */
+struct i965_dmv_pool {
+    dri_bufmgr *bufmgr;
+    const char *name;
+    unsigned long max_bytes;
+
+    _I965Mutex mutex;
+    uint32_t clock;                     /* ticks on every get / put */
+
+    struct {
+        unsigned long size;             /* the size of the BOs, 0 if free */
+        unsigned int num_bos;
+        uint32_t last_use;              /* clock of the last get / put */
+        dri_bo *bos[I965_DMV_POOL_SLOTS];
+    } buckets[I965_DMV_POOL_BUCKETS];
+
+    struct i965_dmv_pool_stats stats;
+};
+
+void
+i965_dmv_pool_init(struct i965_dmv_pool *pool, dri_bufmgr *bufmgr, const char *name);
+
+void
+i965_dmv_pool_fini(struct i965_dmv_pool *pool);
+
+dri_bo *
+i965_dmv_pool_get(struct i965_dmv_pool *pool, unsigned long size);
+
+void
+i965_dmv_pool_put(struct i965_dmv_pool *pool, dri_bo *bo);
+
+void
+i965_dmv_pool_get_stats(struct i965_dmv_pool *pool, struct i965_dmv_pool_stats *stats);
+
+#endif /* _I965_DMV_POOL_H_ */
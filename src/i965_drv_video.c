@@ -1237,20 +1237,17 @@ i965_GetConfigAttributes(VADriverContextP ctx,
             break;
 
         case VAConfigAttribEncRateControlExt:
-            if ((profile == VAProfileH264ConstrainedBaseline ||
-                 profile == VAProfileH264Main ||
-                 profile == VAProfileH264High) &&
+            if (((profile == VAProfileH264ConstrainedBaseline ||
+                  profile == VAProfileH264Main ||
+                  profile == VAProfileH264High) ||
+                 ((profile == VAProfileHEVCMain ||
+                   profile == VAProfileHEVCMain10) &&
+                  IS_GEN9(i965->intel.device_info))) &&
                 entrypoint == VAEntrypointEncSlice) {
-                if (IS_GEN9(i965->intel.device_info))
-                    attrib_list[i].value = VA_ATTRIB_NOT_SUPPORTED;
-                else if (IS_GEN10(i965->intel.device_info))
-                    attrib_list[i].value = VA_ATTRIB_NOT_SUPPORTED;
-                else {
-                    VAConfigAttribValEncRateControlExt *val_config = (VAConfigAttribValEncRateControlExt *) & (attrib_list[i].value);
+                VAConfigAttribValEncRateControlExt *val_config = (VAConfigAttribValEncRateControlExt *) & (attrib_list[i].value);
 
-                    val_config->bits.max_num_temporal_layers_minus1 = MAX_TEMPORAL_LAYERS - 1;
-                    val_config->bits.temporal_layer_bitrate_control_flag = 1;
-                }
+                val_config->bits.max_num_temporal_layers_minus1 = MAX_TEMPORAL_LAYERS - 1;
+                val_config->bits.temporal_layer_bitrate_control_flag = 1;
             } else {
                 attrib_list[i].value = VA_ATTRIB_NOT_SUPPORTED;
             }
@@ -1612,6 +1609,7 @@ i965_destroy_surface_storage(struct object_surface *obj_surface)
 
     dri_bo_unreference(obj_surface->bo);
     obj_surface->bo = NULL;
+    obj_surface->fake_chroma_filled = false;
 
     if (obj_surface->free_private_data != NULL) {
         obj_surface->free_private_data(&obj_surface->private_data);
@@ -1994,6 +1992,7 @@ i965_CreateSurfaces2(
         obj_surface->user_h_stride_set = false;
         obj_surface->user_v_stride_set = false;
         obj_surface->border_cleared = false;
+        obj_surface->fake_chroma_filled = false;
 
         obj_surface->subpic_render_idx = 0;
         for (j = 0; j < I965_MAX_SUBPIC_SUM; j++) {
@@ -2518,6 +2517,9 @@ i965_destroy_context(struct object_heap *heap, struct object_base *obj)
             i965_release_buffer_store(&obj_context->codec_state.encode.packed_header_data_ext[i]);
         free(obj_context->codec_state.encode.packed_header_data_ext);
 
+        for (i = 0; i < obj_context->codec_state.encode.num_pic_params_ext; i++)
+            i965_release_buffer_store(&obj_context->codec_state.encode.pic_params_ext[i]);
+
         i965_release_buffer_store(&obj_context->codec_state.encode.encmb_map);
     } else if (obj_context->codec_type == CODEC_PREENC) {
         /* using the same encode codec_state for preenc too,
@@ -2959,6 +2961,7 @@ i965_create_buffer_internal(VADriverContextP ctx,
                 coded_buffer_segment->mapped = 0;
                 coded_buffer_segment->codec = 0;
                 coded_buffer_segment->status_support = 0;
+                coded_buffer_segment->brc_stats.frame_id = 0;
                 dri_bo_unmap(buffer_store->bo);
             } else if (data) {
                 dri_bo_subdata(buffer_store->bo, 0, size * num_elements, data);
@@ -2984,6 +2987,8 @@ i965_create_buffer_internal(VADriverContextP ctx,
                 memcpy(buffer_store->buffer, data, size * num_elements);
             else
                 memset(buffer_store->buffer, 0, size * num_elements);
+
+            buffer_store->size = size * num_elements;
         }
     }
 
@@ -3044,6 +3049,92 @@ i965_BufferSetNumElements(VADriverContextP ctx,
     return vaStatus;
 }
 
+/* The status ring of the encoder writing to a coded buffer, NULL if none */
+static struct i965_encoder_status_ring *
+i965_coded_buffer_status_ring(VADriverContextP ctx, struct object_buffer *obj_buffer)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct object_context *obj_context = CONTEXT(obj_buffer->context_id);
+
+    if (obj_buffer->type != VAEncCodedBufferType ||
+        !obj_context ||
+        obj_context->codec_type != CODEC_ENC ||
+        !obj_context->hw_context)
+        return NULL;
+
+    return &((struct intel_encoder_context *)obj_context->hw_context)->status_ring;
+}
+
+/*
+ * Hands out up to max_records statuses of the frames completed by an
+ * encoder context, in encoding order, without waiting on the GPU. It is
+ * meant for applications polling many frames at once instead of mapping
+ * every coded buffer.
+ */
+VAStatus DLL_EXPORT
+i965_HarvestEncoderStatus(VADriverContextP ctx,
+                          VAContextID context,
+                          struct i965_encoder_status_record *records,
+                          unsigned int max_records,
+                          unsigned int *num_records)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct object_context *obj_context = CONTEXT(context);
+    struct i965_encoder_status_ring *status_ring;
+
+    ASSERT_RET(obj_context, VA_STATUS_ERROR_INVALID_CONTEXT);
+    ASSERT_RET(num_records, VA_STATUS_ERROR_INVALID_PARAMETER);
+    ASSERT_RET(records || !max_records, VA_STATUS_ERROR_INVALID_PARAMETER);
+
+    *num_records = 0;
+
+    if (obj_context->codec_type != CODEC_ENC || !obj_context->hw_context)
+        return VA_STATUS_ERROR_INVALID_CONTEXT;
+
+    status_ring = &((struct intel_encoder_context *)obj_context->hw_context)->status_ring;
+
+    if (!status_ring->records[0])
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+
+    *num_records = i965_encoder_status_ring_harvest(status_ring, records, max_records);
+
+    return VA_STATUS_SUCCESS;
+}
+
+/*
+ * The statistics go last, an application not looking for them still finds
+ * the coded data in the first segments. The hints of the driver come from
+ * the status ring, the frame is done once its coded buffer is mapped.
+ */
+static void
+i965_link_coded_buffer_brc_stats(struct i965_encoder_status_ring *status_ring,
+                                 struct i965_coded_buffer_segment *coded_buffer_segment)
+{
+    VACodedBufferSegment *segment = &coded_buffer_segment->base;
+    struct i965_encoder_status_record record;
+
+    while (segment->next && segment->next != &coded_buffer_segment->brc_stats_base)
+        segment = segment->next;
+
+    segment->next = NULL;
+
+    if (!coded_buffer_segment->brc_stats.frame_id)
+        return;
+
+    if (status_ring &&
+        i965_encoder_status_ring_query(status_ring,
+                                       coded_buffer_segment->brc_stats.frame_id,
+                                       &record) == VA_STATUS_SUCCESS)
+        coded_buffer_segment->brc_stats.hints = record.hints;
+
+    memset(&coded_buffer_segment->brc_stats_base, 0, sizeof(coded_buffer_segment->brc_stats_base));
+    coded_buffer_segment->brc_stats_base.size = MIN(coded_buffer_segment->brc_stats.size,
+                                                    sizeof(coded_buffer_segment->brc_stats));
+    coded_buffer_segment->brc_stats_base.status = I965_CODED_BUF_STATUS_BRC_STATS;
+    coded_buffer_segment->brc_stats_base.buf = &coded_buffer_segment->brc_stats;
+    segment->next = &coded_buffer_segment->brc_stats_base;
+}
+
 VAStatus
 i965_MapBuffer(VADriverContextP ctx,
                VABufferID buf_id,       /* in */
@@ -3166,6 +3257,10 @@ i965_MapBuffer(VADriverContextP ctx,
                     vaStatus = VA_STATUS_SUCCESS;
                 }
 
+                if (i965->intel.enc_brc_stats)
+                    i965_link_coded_buffer_brc_stats(i965_coded_buffer_status_ring(ctx, obj_buffer),
+                                                     coded_buffer_segment);
+
                 coded_buffer_segment->mapped = 1;
             } else {
                 assert(coded_buffer_segment->base.buf);
@@ -3230,6 +3325,7 @@ i965_DestroyBuffer(VADriverContextP ctx, VABufferID buffer_id)
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
     struct object_buffer *obj_buffer = BUFFER(buffer_id);
+    struct i965_encoder_status_ring *status_ring;
     VAStatus va_status = VA_STATUS_SUCCESS;
 
     ASSERT_RET(obj_buffer, VA_STATUS_ERROR_INVALID_BUFFER);
@@ -3242,6 +3338,11 @@ i965_DestroyBuffer(VADriverContextP ctx, VABufferID buffer_id)
         obj_buffer->wrapper_buffer = VA_INVALID_ID;
     }
 
+    status_ring = i965_coded_buffer_status_ring(ctx, obj_buffer);
+
+    if (status_ring && obj_buffer->buffer_store)
+        i965_encoder_status_ring_forget_coded_bo(status_ring, obj_buffer->buffer_store->bo);
+
     i965_destroy_buffer(&i965->buffer_heap, (struct object_base *)obj_buffer);
 
     return va_status;
@@ -3273,6 +3374,11 @@ i965_BeginPicture(VADriverContextP ctx,
         /* ext */
         i965_release_buffer_store(&obj_context->codec_state.encode.pic_param_ext);
 
+        for (i = 0; i < obj_context->codec_state.encode.num_pic_params_ext; i++)
+            i965_release_buffer_store(&obj_context->codec_state.encode.pic_params_ext[i]);
+
+        obj_context->codec_state.encode.num_pic_params_ext = 0;
+
         for (i = 0; i < ARRAY_ELEMS(obj_context->codec_state.encode.packed_header_param); i++)
             i965_release_buffer_store(&obj_context->codec_state.encode.packed_header_param[i]);
 
@@ -3709,7 +3815,20 @@ i965_encoder_render_picture(VADriverContextP ctx,
             break;
 
         case VAEncPictureParameterBufferType:
+            /* the batch is full, nothing of the picture may be kept */
+            if (obj_config->profile == VAProfileJPEGBaseline &&
+                encode->num_pic_params_ext == I965_MAX_JPEG_BATCH) {
+                vaStatus = VA_STATUS_ERROR_MAX_NUM_EXCEEDED;
+                return vaStatus;
+            }
+
             vaStatus = I965_RENDER_ENCODE_BUFFER(picture_parameter_ext);
+
+            if (vaStatus == VA_STATUS_SUCCESS &&
+                obj_config->profile == VAProfileJPEGBaseline) {
+                i965_reference_buffer_store(&encode->pic_params_ext[encode->num_pic_params_ext++],
+                                            obj_buffer->buffer_store);
+            }
             break;
 
         case VAHuffmanTableBufferType:
@@ -4498,23 +4617,19 @@ error:
     return va_status;
 }
 
-VAStatus
-i965_check_alloc_surface_bo(VADriverContextP ctx,
-                            struct object_surface *obj_surface,
-                            int tiled,
-                            unsigned int fourcc,
-                            unsigned int subsampling)
+/* Lays out the planes of obj_surface for its orig_width x orig_height */
+static VAStatus
+i965_surface_layout(VADriverContextP ctx,
+                    struct object_surface *obj_surface,
+                    int tiled,
+                    unsigned int fourcc,
+                    unsigned int subsampling,
+                    int *region_width_ptr,
+                    int *region_height_ptr)
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
     int region_width, region_height;
 
-    if (obj_surface->bo) {
-        ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
-        ASSERT_RET(obj_surface->fourcc == fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
-        ASSERT_RET(obj_surface->subsampling == subsampling, VA_STATUS_ERROR_INVALID_SURFACE);
-        return VA_STATUS_SUCCESS;
-    }
-
     obj_surface->x_cb_offset = 0; /* X offset is always 0 */
     obj_surface->x_cr_offset = 0;
 
@@ -4759,6 +4874,36 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
 
     obj_surface->size = ALIGN(region_width * region_height, 0x1000);
 
+    *region_width_ptr = region_width;
+    *region_height_ptr = region_height;
+
+    return VA_STATUS_SUCCESS;
+}
+
+VAStatus
+i965_check_alloc_surface_bo(VADriverContextP ctx,
+                            struct object_surface *obj_surface,
+                            int tiled,
+                            unsigned int fourcc,
+                            unsigned int subsampling)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    int region_width, region_height;
+    VAStatus va_status;
+
+    if (obj_surface->bo) {
+        ASSERT_RET(obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
+        ASSERT_RET(obj_surface->fourcc == fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
+        ASSERT_RET(obj_surface->subsampling == subsampling, VA_STATUS_ERROR_INVALID_SURFACE);
+        return VA_STATUS_SUCCESS;
+    }
+
+    va_status = i965_surface_layout(ctx, obj_surface, tiled, fourcc, subsampling,
+                                    &region_width, &region_height);
+
+    if (va_status != VA_STATUS_SUCCESS)
+        return va_status;
+
     if ((tiled && !obj_surface->user_disable_tiling)) {
         uint32_t tiling_mode = I915_TILING_Y; /* always uses Y-tiled format */
         unsigned long pitch;
@@ -4786,6 +4931,47 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
     return VA_STATUS_SUCCESS;
 }
 
+/*
+ * Lays out an internal surface for a new size in the BO it already has,
+ * the BO must have been allocated for a size at least as large. The BO
+ * keeps the pitch it was allocated with for the CPU, only the GPU may
+ * access the surface afterwards.
+ */
+VAStatus
+i965_resize_surface_bo(VADriverContextP ctx,
+                       struct object_surface *obj_surface,
+                       int width,
+                       int height)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    int region_width, region_height;
+    unsigned int tiling, swizzle;
+    VAStatus va_status;
+
+    ASSERT_RET(obj_surface->bo && obj_surface->fourcc, VA_STATUS_ERROR_INVALID_SURFACE);
+
+    if (obj_surface->orig_width == width && obj_surface->orig_height == height)
+        return VA_STATUS_SUCCESS;
+
+    dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+
+    /* as i965_CreateSurfaces() does, for the linear layouts */
+    obj_surface->orig_width = width;
+    obj_surface->orig_height = height;
+    obj_surface->width = ALIGN(width, i965->codec_info->min_linear_wpitch);
+    obj_surface->height = ALIGN(height, i965->codec_info->min_linear_hpitch);
+    va_status = i965_surface_layout(ctx, obj_surface, tiling != I915_TILING_NONE,
+                                    obj_surface->fourcc, obj_surface->subsampling,
+                                    &region_width, &region_height);
+
+    if (va_status != VA_STATUS_SUCCESS)
+        return va_status;
+
+    ASSERT_RET(obj_surface->size <= obj_surface->bo->size, VA_STATUS_ERROR_INVALID_SURFACE);
+
+    return VA_STATUS_SUCCESS;
+}
+
 VAStatus i965_DeriveImage(VADriverContextP ctx,
                           VASurfaceID surface,
                           VAImage *out_image)        /* out */
@@ -7274,6 +7460,9 @@ i965_driver_data_init(VADriverContextP ctx)
     _i965InitMutex(&i965->render_mutex);
     _i965InitMutex(&i965->pp_mutex);
 
+    i965_dmv_pool_init(&i965->dmv_pools[I965_DMV_POOL_AVC], i965->intel.bufmgr, "direct mv w/r buffer");
+    i965_dmv_pool_init(&i965->dmv_pools[I965_DMV_POOL_HEVC], i965->intel.bufmgr, "motion vector temporal buffer");
+
     return true;
 
 err_subpic_heap:
@@ -7295,6 +7484,7 @@ static void
 i965_driver_data_terminate(VADriverContextP ctx)
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
+    int i;
 
     _i965DestroyMutex(&i965->pp_mutex);
     _i965DestroyMutex(&i965->render_mutex);
@@ -7311,6 +7501,10 @@ i965_driver_data_terminate(VADriverContextP ctx)
     i965_destroy_heap(&i965->surface_heap, i965_destroy_surface);
     i965_destroy_heap(&i965->context_heap, i965_destroy_context);
     i965_destroy_heap(&i965->config_heap, i965_destroy_config);
+
+    /* after the surfaces, they give their buffers back */
+    for (i = 0; i < I965_DMV_POOL_NUM; i++)
+        i965_dmv_pool_fini(&i965->dmv_pools[i]);
 }
 
 struct {
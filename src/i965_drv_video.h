@@ -86,6 +86,7 @@
 #define I965_MIN_CODEC_ENC_RESOLUTION_WIDTH_HEIGHT   32
 #define I965_MAX_NUM_ROI_REGIONS                     8
 #define I965_MAX_NUM_SLICE                           32
+#define I965_MAX_JPEG_BATCH                          16
 
 #define ENCODER_LP_QUALITY_RANGE  8
 
@@ -198,6 +199,7 @@ struct buffer_store {
     dri_bo *bo;
     int ref_count;
     int num_elements;
+    unsigned int size;                  /* of buffer in bytes */
 };
 
 struct object_config {
@@ -216,6 +218,23 @@ struct codec_state_base {
     uint32_t chroma_formats;
 };
 
+/* Sequence level results of the decoder parameter checks. They are kept
+ * across pictures and only derived again when the sequence changes, so
+ * that a reference surface already validated for the sequence is not
+ * checked again on every picture */
+#define DECODE_CHECK_KEY_AVC    (1 << 30)
+#define DECODE_CHECK_KEY_HEVC   (2 << 30)
+
+struct decode_check_cache {
+    uint32_t seq_key;           /* DECODE_CHECK_KEY_* | sequence fields, 0 if unset */
+    uint32_t fourcc;            /* the format of the decoded pictures */
+    uint32_t hw_fourcc;         /* the format of the surface storage */
+    uint32_t subsample;
+
+    unsigned int num_hits;      /* references that skipped the checks */
+    unsigned int num_misses;
+};
+
 struct decode_state {
     struct codec_state_base base;
     struct buffer_store *pic_param;
@@ -233,6 +252,8 @@ struct decode_state {
 
     struct object_surface *render_object;
     struct object_surface *reference_objects[16]; /* Up to 2 reference surfaces are valid for MPEG-2,*/
+
+    struct decode_check_cache check_cache;
 };
 
 #define SLICE_PACKED_DATA_INDEX_TYPE    0x80000000
@@ -301,6 +322,17 @@ struct encode_state {
     struct object_surface *reconstructed_object;
     struct object_buffer *coded_buf_object;
     struct object_surface *reference_objects[16]; /* Up to 2 reference surfaces are valid for MPEG-2,*/
+
+    /*
+     * JPEG: the pictures encoded by one vaEndPicture(), one picture
+     * parameter buffer each. The first picture is read from the render
+     * target, the others from their reconstructed_picture, all of them
+     * share the quantization and Huffman tables.
+     */
+    struct buffer_store *pic_params_ext[I965_MAX_JPEG_BATCH];
+    int num_pic_params_ext;
+    struct object_surface *batch_input_objects[I965_MAX_JPEG_BATCH];
+    struct object_buffer *batch_coded_buf_objects[I965_MAX_JPEG_BATCH];
 };
 
 struct proc_state {
@@ -390,6 +422,9 @@ struct object_surface {
     /* we need clear right and bottom border for NV12.
      * to avoid encode run to run issue*/
     uint32_t border_cleared      : 1;
+    /* the chroma planes of an NV12 surface holding a grayscale picture
+     * were already filled with the neutral value */
+    uint32_t fake_chroma_filled  : 1;
 
     VAGenericID wrapper_surface;
 
@@ -519,6 +554,7 @@ struct hw_codec_info {
 
 #include "i965_render.h"
 #include "i965_gpe_utils.h"
+#include "i965_dmv_pool.h"
 
 struct i965_driver_data {
     struct intel_driver_data intel;
@@ -556,6 +592,9 @@ struct i965_driver_data {
     VADriverContextP wrapper_pdrvctx;
 
     struct i965_gpe_table gpe_table;
+
+    /* the DMV buffers of the decoded surfaces, per codec */
+    struct i965_dmv_pool dmv_pools[I965_DMV_POOL_NUM];
 };
 
 #define NEW_CONFIG_ID() object_heap_allocate(&i965->config_heap);
@@ -591,6 +630,12 @@ i965_check_alloc_surface_bo(VADriverContextP ctx,
                             unsigned int fourcc,
                             unsigned int subsampling);
 
+VAStatus
+i965_resize_surface_bo(VADriverContextP ctx,
+                       struct object_surface *obj_surface,
+                       int width,
+                       int height);
+
 int
 va_enc_packed_type_to_idx(int packed_type);
 
@@ -621,6 +666,48 @@ va_enc_packed_type_to_idx(int packed_type);
 #define HEVC_DELIMITER3 0x00
 #define HEVC_DELIMITER4 0x00
 
+/* The status of the coded buffer segment holding i965_coded_buffer_brc_stats */
+#define I965_CODED_BUF_STATUS_BRC_STATS         0x40000000
+
+#define I965_CODED_BUFFER_BRC_STATS_VERSION     1
+
+/*
+ * The rate control statistics of one frame, in a layout that does not
+ * change across releases: new fields only go at the end, in place of the
+ * reserved ones, and size tells which fields are there.
+ *
+ * The driver writes its own fields when the frame starts and the PAK
+ * writes the others with the coded data, frame_id last. It is 0 if the
+ * PAK of the codec does not write the statistics. Only the PAKs of the
+ * gen8+ AVC and the gen9 HEVC and VP9 encoders do. The legacy gen6/7/7.5
+ * MFC encoders do not: their batches have no register stores to build
+ * on, and their BRC already reads the frame size back on the CPU to
+ * repack. The HRD model of that BRC (gen6_mfc_context.hrd) is not
+ * exported.
+ *
+ * target_bits and the hrd_* fields come from the driver's own model of
+ * the rate control buffer, updated with the sizes of the previous frames
+ * on the CPU. They are not read back from the BRC history of the kernels,
+ * so they follow the budget the application asked for rather than the
+ * exact state of the kernel BRC.
+ */
+struct i965_coded_buffer_brc_stats {
+    uint32_t version;                   /* I965_CODED_BUFFER_BRC_STATS_VERSION */
+    uint32_t size;                      /* sizeof(struct i965_coded_buffer_brc_stats) */
+    uint32_t frame_id;                  /* the id of the frame in the status ring */
+    uint32_t target_bits;               /* the budget of the frame, 0 without BRC */
+    uint32_t actual_bytes;              /* from the PAK */
+    uint32_t actual_bytes_nh;           /* from the PAK, without the headers */
+    uint32_t qp_status_reg;             /* raw MFC_QP_STATUS_COUNT of the PAK, not a QP, 0 if not available */
+    uint32_t image_status_ctrl;         /* from the PAK, frame size / HRD conformance of the last pass */
+    uint32_t num_passes;                /* from the PAK */
+    uint32_t hrd_buffer_size;           /* in bits, 0 without BRC */
+    uint32_t hrd_buffer_fullness;       /* in bits, before the frame */
+    uint32_t hrd_num_underflows;        /* so far in the sequence */
+    uint32_t hints;                     /* I965_ENCODER_STATUS_HINT_*, from the status ring */
+    uint32_t reserved[3];
+};
+
 struct i965_coded_buffer_segment {
     union {
         VACodedBufferSegment base;
@@ -633,6 +720,14 @@ struct i965_coded_buffer_segment {
     unsigned int pad1;
 
     unsigned int codec_private_data[512];       /* Store codec private data, must be 16-bytes aligned */
+
+    /* VA_INTEL_ENC_BRC_STATS: linked after the segments of the coded data */
+    union {
+        VACodedBufferSegment brc_stats_base;
+        unsigned char pad2[64];
+    };
+
+    struct i965_coded_buffer_brc_stats brc_stats;
 };
 
 #define I965_CODEDBUFFER_HEADER_SIZE   ALIGN(sizeof(struct i965_coded_buffer_segment), 0x1000)
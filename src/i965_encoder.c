@@ -28,6 +28,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <string.h>
 #include <assert.h>
 
@@ -669,11 +670,11 @@ intel_encoder_check_roi_parameter(VADriverContextP ctx,
         encoder_context->brc.roi_value_is_qp_delta = misc->roi_flags.bits.roi_value_is_qp_delta;
 
     for (i = 0; i <  encoder_context->brc.num_roi; i++) {
-        encoder_context->brc.roi[i].left = misc->roi->roi_rectangle.x;
-        encoder_context->brc.roi[i].right = encoder_context->brc.roi[i].left + misc->roi->roi_rectangle.width;
-        encoder_context->brc.roi[i].top = misc->roi->roi_rectangle.y;
-        encoder_context->brc.roi[i].bottom = encoder_context->brc.roi[i].top + misc->roi->roi_rectangle.height;
-        encoder_context->brc.roi[i].value = misc->roi->roi_value;
+        encoder_context->brc.roi[i].left = misc->roi[i].roi_rectangle.x;
+        encoder_context->brc.roi[i].right = encoder_context->brc.roi[i].left + misc->roi[i].roi_rectangle.width;
+        encoder_context->brc.roi[i].top = misc->roi[i].roi_rectangle.y;
+        encoder_context->brc.roi[i].bottom = encoder_context->brc.roi[i].top + misc->roi[i].roi_rectangle.height;
+        encoder_context->brc.roi[i].value = misc->roi[i].roi_value;
     }
 }
 
@@ -1103,18 +1104,57 @@ intel_encoder_check_jpeg_parameter(VADriverContextP ctx,
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
     struct object_buffer *obj_buffer;
-    VAEncPictureParameterBufferJPEG *pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_param_ext->buffer;
+    struct object_surface *obj_surface;
+    VAEncPictureParameterBufferJPEG *pic_param, *first_pic_param;
+    unsigned int tiling, swizzle;
+    int i;
 
+    assert(encode_state->num_pic_params_ext > 0);
+    first_pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_params_ext[0]->buffer;
 
-    assert(!(pic_param->pic_flags.bits.profile)); //Baseline profile is 0.
+    for (i = 0; i < encode_state->num_pic_params_ext; i++) {
+        pic_param = (VAEncPictureParameterBufferJPEG *)encode_state->pic_params_ext[i]->buffer;
 
-    obj_buffer = BUFFER(pic_param->coded_buf);
-    assert(obj_buffer && obj_buffer->buffer_store && obj_buffer->buffer_store->bo);
+        assert(!(pic_param->pic_flags.bits.profile)); //Baseline profile is 0.
 
-    if (!obj_buffer || !obj_buffer->buffer_store || !obj_buffer->buffer_store->bo)
-        goto error;
+        obj_buffer = BUFFER(pic_param->coded_buf);
+        assert(obj_buffer && obj_buffer->buffer_store && obj_buffer->buffer_store->bo);
 
-    encode_state->coded_buf_object = obj_buffer;
+        if (!obj_buffer || !obj_buffer->buffer_store || !obj_buffer->buffer_store->bo)
+            goto error;
+
+        encode_state->batch_coded_buf_objects[i] = obj_buffer;
+
+        /* the first picture is the render target, see intel_encoder_check_jpeg_yuv_surface() */
+        if (i == 0)
+            continue;
+
+        /* the pictures of a batch share the quantization tables */
+        if (pic_param->quality != first_pic_param->quality ||
+            pic_param->num_components != first_pic_param->num_components)
+            goto error;
+
+        /* and are read as they are, without a copy to a tiled surface */
+        obj_surface = SURFACE(pic_param->reconstructed_picture);
+
+        if (!obj_surface || !obj_surface->bo)
+            goto error;
+
+        dri_bo_get_tiling(obj_surface->bo, &tiling, &swizzle);
+
+        if (tiling != I915_TILING_Y)
+            goto error;
+
+        if ((obj_surface->fourcc != VA_FOURCC_NV12) && (obj_surface->fourcc != VA_FOURCC_UYVY) &&
+            (obj_surface->fourcc != VA_FOURCC_YUY2) && (obj_surface->fourcc != VA_FOURCC_Y800) &&
+            (obj_surface->fourcc != VA_FOURCC_RGBA) && (obj_surface->fourcc != VA_FOURCC_444P))
+            goto error;
+
+        encode_state->batch_input_objects[i] = obj_surface;
+    }
+
+    pic_param = first_pic_param;
+    encode_state->coded_buf_object = encode_state->batch_coded_buf_objects[0];
 
     encoder_context->frame_width_in_pixel = pic_param->picture_width;
     encoder_context->frame_height_in_pixel = pic_param->picture_height;
@@ -1419,6 +1459,7 @@ intel_encoder_sanity_check_input(VADriverContextP ctx,
         if (vaStatus != VA_STATUS_SUCCESS)
             goto out;
         vaStatus = intel_encoder_check_jpeg_yuv_surface(ctx, profile, encode_state, encoder_context);
+        encode_state->batch_input_objects[0] = encode_state->input_yuv_object;
         break;
     }
 
@@ -1458,6 +1499,163 @@ out:
     return vaStatus;
 }
 
+/* Corrects the HRD with the sizes of the frames completed so far, in encoding order */
+static void
+intel_encoder_layer_brc_end_frames(struct i965_encoder_layer_brc *layer_brc,
+                                   struct i965_encoder_status_ring *status_ring)
+{
+    struct i965_encoder_status_record record;
+    uint32_t frame_id;
+    VAStatus va_status;
+
+    while (i965_encoder_layer_brc_oldest_pending(layer_brc, &frame_id)) {
+        va_status = VA_STATUS_ERROR_INVALID_PARAMETER;
+
+        if (frame_id)
+            va_status = i965_encoder_status_ring_query(status_ring, frame_id, &record);
+
+        if (va_status == VA_STATUS_ERROR_SURFACE_BUSY)
+            break;
+
+        /* not tracked by the ring or already harvested, keep the budget */
+        i965_encoder_layer_brc_end_frame(layer_brc,
+                                         va_status == VA_STATUS_SUCCESS ?
+                                         record.bs_byte_count_frame * 8.0 : -1);
+    }
+}
+
+/*
+ * Writes the driver side of the rate control statistics of the frame to
+ * the header of its coded buffer, the PAK adds its own side. Without
+ * temporal layers the HRD is followed on its own, the BRC kernels keep
+ * theirs in the BRC history buffers.
+ */
+static void
+intel_encoder_brc_stats_begin_frame(VADriverContextP ctx,
+                                    struct intel_encoder_context *encoder_context,
+                                    dri_bo *coded_bo,
+                                    uint32_t frame_id)
+{
+    struct intel_driver_data *intel = intel_driver_data(ctx);
+    struct i965_encoder_layer_brc *hrd = NULL;
+    struct i965_coded_buffer_brc_stats brc_stats;
+    double bits_per_second, frames_per_second;
+    unsigned int top;
+
+    if (!intel->enc_brc_stats)
+        return;
+
+    if (encoder_context->layer_brc.num_layers) {
+        hrd = &encoder_context->layer_brc;
+    } else if ((encoder_context->rate_control_mode & (VA_RC_CBR | VA_RC_VBR)) &&
+               encoder_context->brc.framerate[0].num &&
+               encoder_context->brc.framerate[0].den) {
+        hrd = &encoder_context->brc_stats_hrd;
+
+        if (encoder_context->brc.need_reset || !hrd->num_layers) {
+            bits_per_second = encoder_context->brc.bits_per_second[0];
+
+            if (encoder_context->rate_control_mode == VA_RC_VBR)
+                bits_per_second = bits_per_second * encoder_context->brc.target_percentage[0] / 100;
+
+            frames_per_second = (double)encoder_context->brc.framerate[0].num /
+                                encoder_context->brc.framerate[0].den;
+
+            i965_encoder_layer_brc_init(hrd,
+                                        1,
+                                        &bits_per_second,
+                                        &frames_per_second,
+                                        encoder_context->brc.hrd_buffer_size,
+                                        encoder_context->brc.hrd_initial_buffer_fullness);
+        }
+
+        intel_encoder_layer_brc_end_frames(hrd, &encoder_context->status_ring);
+        i965_encoder_layer_brc_begin_frame(hrd, 0);
+        i965_encoder_layer_brc_set_frame_id(hrd, frame_id);
+    } else {
+        encoder_context->brc_stats_hrd.num_layers = 0;
+    }
+
+    memset(&brc_stats, 0, sizeof(brc_stats));
+    brc_stats.version = I965_CODED_BUFFER_BRC_STATS_VERSION;
+    brc_stats.size = sizeof(brc_stats);
+
+    if (hrd) {
+        top = hrd->num_layers - 1;
+
+        /* the budget of the frame is already taken out */
+        brc_stats.target_bits = hrd->budget;
+        brc_stats.hrd_buffer_size = hrd->buffer_size[top];
+        brc_stats.hrd_buffer_fullness = hrd->fullness[top] + hrd->budget;
+        brc_stats.hrd_num_underflows = hrd->num_underflows[top];
+    }
+
+    dri_bo_subdata(coded_bo,
+                   offsetof(struct i965_coded_buffer_segment, brc_stats),
+                   sizeof(brc_stats),
+                   &brc_stats);
+}
+
+static void
+intel_encoder_status_begin_frame(VADriverContextP ctx,
+                                 struct encode_state *encode_state,
+                                 struct intel_encoder_context *encoder_context)
+{
+    struct object_buffer *obj_buffer = encode_state->coded_buf_object;
+    uint32_t frame_id;
+
+    if (!obj_buffer || !obj_buffer->buffer_store)
+        return;
+
+    frame_id = i965_encoder_status_ring_begin_frame(&encoder_context->status_ring,
+                                                    obj_buffer->base.id,
+                                                    obj_buffer->buffer_store->bo);
+    i965_encoder_layer_brc_set_frame_id(&encoder_context->layer_brc, frame_id);
+    intel_encoder_brc_stats_begin_frame(ctx, encoder_context, obj_buffer->buffer_store->bo, frame_id);
+}
+
+/*
+ * Sets the budget of the current frame from its temporal layer, the BRC
+ * prepare / curbe setup of the codecs reads it from layer_brc.budget.
+ */
+static void
+intel_encoder_layer_brc_begin_frame(struct intel_encoder_context *encoder_context)
+{
+    struct i965_encoder_layer_brc *layer_brc = &encoder_context->layer_brc;
+    double bits_per_second[MAX_TEMPORAL_LAYERS];
+    double frames_per_second[MAX_TEMPORAL_LAYERS];
+    unsigned int num_layers = encoder_context->layer.num_layers;
+    unsigned int i;
+
+    if (num_layers < 2 ||
+        !(encoder_context->rate_control_mode & (VA_RC_CBR | VA_RC_VBR))) {
+        layer_brc->num_layers = 0;
+        return;
+    }
+
+    if (encoder_context->brc.need_reset || layer_brc->num_layers != num_layers) {
+        for (i = 0; i < num_layers; i++) {
+            bits_per_second[i] = encoder_context->brc.bits_per_second[i];
+
+            if (encoder_context->rate_control_mode == VA_RC_VBR)
+                bits_per_second[i] = bits_per_second[i] * encoder_context->brc.target_percentage[i] / 100;
+
+            frames_per_second[i] = (double)encoder_context->brc.framerate[i].num /
+                                   encoder_context->brc.framerate[i].den;
+        }
+
+        i965_encoder_layer_brc_init(layer_brc,
+                                    num_layers,
+                                    bits_per_second,
+                                    frames_per_second,
+                                    encoder_context->brc.hrd_buffer_size,
+                                    encoder_context->brc.hrd_initial_buffer_fullness);
+    }
+
+    intel_encoder_layer_brc_end_frames(layer_brc, &encoder_context->status_ring);
+    i965_encoder_layer_brc_begin_frame(layer_brc, encoder_context->layer.curr_frame_layer_id);
+}
+
 static VAStatus
 intel_encoder_end_picture(VADriverContextP ctx,
                           VAProfile profile,
@@ -1473,6 +1671,8 @@ intel_encoder_end_picture(VADriverContextP ctx,
     if (vaStatus != VA_STATUS_SUCCESS)
         return vaStatus;
 
+    i965_encoder_params_update(&encoder_context->params, encode_state);
+    intel_encoder_layer_brc_begin_frame(encoder_context);
     encoder_context->mfc_brc_prepare(encode_state, encoder_context);
 
     /* VME or PAK stages are separately invoked if middleware configured the corresponding
@@ -1482,11 +1682,20 @@ intel_encoder_end_picture(VADriverContextP ctx,
     if (encoder_context->fei_enabled || encoder_context->preenc_enabled) {
         if ((encoder_context->fei_function_mode == VA_FEI_FUNCTION_ENC) ||
             (encoder_context->preenc_enabled)) {
-            if ((encoder_context->vme_context && encoder_context->vme_pipeline))
-                return encoder_context->vme_pipeline(ctx, profile, encode_state, encoder_context);
+            if ((encoder_context->vme_context && encoder_context->vme_pipeline)) {
+                vaStatus = encoder_context->vme_pipeline(ctx, profile, encode_state, encoder_context);
+                if (vaStatus != VA_STATUS_SUCCESS)
+                    i965_encoder_params_invalidate(&encoder_context->params);
+                return vaStatus;
+            }
         } else if (encoder_context->fei_function_mode == VA_FEI_FUNCTION_PAK) {
-            if ((encoder_context->mfc_context && encoder_context->mfc_pipeline))
-                return encoder_context->mfc_pipeline(ctx, profile, encode_state, encoder_context);
+            if ((encoder_context->mfc_context && encoder_context->mfc_pipeline)) {
+                intel_encoder_status_begin_frame(ctx, encode_state, encoder_context);
+                vaStatus = encoder_context->mfc_pipeline(ctx, profile, encode_state, encoder_context);
+                if (vaStatus != VA_STATUS_SUCCESS)
+                    i965_encoder_params_invalidate(&encoder_context->params);
+                return vaStatus;
+            }
         }
         /* Setting ENC and PAK as ENC|PAK is invalid */
         assert(encoder_context->fei_function_mode != (VA_FEI_FUNCTION_ENC | VA_FEI_FUNCTION_PAK));
@@ -1494,12 +1703,17 @@ intel_encoder_end_picture(VADriverContextP ctx,
 
     if ((encoder_context->vme_context && encoder_context->vme_pipeline)) {
         vaStatus = encoder_context->vme_pipeline(ctx, profile, encode_state, encoder_context);
-        if (vaStatus != VA_STATUS_SUCCESS)
+        if (vaStatus != VA_STATUS_SUCCESS) {
+            i965_encoder_params_invalidate(&encoder_context->params);
             return vaStatus;
+        }
     }
 
     assert(encoder_context->mfc_pipeline != NULL);
-    encoder_context->mfc_pipeline(ctx, profile, encode_state, encoder_context);
+    intel_encoder_status_begin_frame(ctx, encode_state, encoder_context);
+    vaStatus = encoder_context->mfc_pipeline(ctx, profile, encode_state, encoder_context);
+    if (vaStatus != VA_STATUS_SUCCESS)
+        i965_encoder_params_invalidate(&encoder_context->params);
     encoder_context->num_frames_in_sequence++;
     encoder_context->brc.need_reset = 0;
     /*
@@ -1532,6 +1746,9 @@ intel_encoder_context_destroy(void *hw_context)
         encoder_context->is_tmp_id = 0;
     }
 
+    i965_encoder_status_ring_free(&encoder_context->status_ring);
+    i965_encoder_params_free(&encoder_context->params);
+    i965_gpe_state_heap_destroy(&encoder_context->gpe_state_heap);
     intel_batchbuffer_free(encoder_context->base.batch);
     free(encoder_context);
 }
@@ -1567,6 +1784,7 @@ intel_enc_hw_context_init(VADriverContextP ctx,
     encoder_context->base.run = intel_encoder_end_picture;
     encoder_context->base.get_status = intel_encoder_get_status;
     encoder_context->base.batch = intel_batchbuffer_new(intel, I915_EXEC_RENDER, 0);
+    i965_gpe_state_heap_init(&encoder_context->gpe_state_heap, encoder_context->base.batch);
     encoder_context->input_yuv_surface = VA_INVALID_SURFACE;
     encoder_context->is_tmp_id = 0;
     encoder_context->low_power_mode = 0;
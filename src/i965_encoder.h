@@ -35,6 +35,10 @@
 
 #include "i965_structs.h"
 #include "i965_drv_video.h"
+#include "i965_gpe_utils.h"
+#include "i965_encoder_status.h"
+#include "i965_encoder_layer_brc.h"
+#include "i965_encoder_params.h"
 
 #define I965_BRC_NONE                   0
 #define I965_BRC_CBR                    1
@@ -134,6 +138,21 @@ struct intel_encoder_context {
     VAStatus(*get_status)(VADriverContextP ctx,
                           struct intel_encoder_context *encoder_context,
                           struct i965_coded_buffer_segment *coded_buffer_segment);
+
+    /* per frame PAK status, only allocated by the codecs writing it */
+    struct i965_encoder_status_ring status_ring;
+
+    /* per temporal layer budgets and HRD, the BRC kernels see one stream */
+    struct i965_encoder_layer_brc layer_brc;
+
+    /* VA_INTEL_ENC_BRC_STATS: the HRD of the statistics when layer_brc is not in use */
+    struct i965_encoder_layer_brc brc_stats_hrd;
+
+    /* the parameter buffers of the previous frame, and what changed since */
+    struct i965_encoder_params params;
+
+    /* the surface and dynamic state BOs recycled by the GPE contexts of the codec */
+    struct i965_gpe_state_heap gpe_state_heap;
 };
 
 extern struct hw_context *
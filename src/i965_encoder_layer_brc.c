@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "i965_encoder_layer_brc.h"
+
+void
+i965_encoder_layer_brc_init(struct i965_encoder_layer_brc *brc,
+                            unsigned int num_layers,
+                            const double *bits_per_second,
+                            const double *frames_per_second,
+                            double buffer_size,
+                            double initial_fullness)
+{
+    double top_bits_per_second, top_frames_per_second;
+    double layer_bits_per_second, layer_frames_per_second;
+    unsigned int i;
+
+    assert(num_layers > 0 && num_layers <= I965_ENCODER_LAYER_BRC_MAX_LAYERS);
+
+    memset(brc, 0, sizeof(*brc));
+    brc->num_layers = num_layers;
+
+    top_bits_per_second = bits_per_second[num_layers - 1];
+    top_frames_per_second = frames_per_second[num_layers - 1];
+
+    if (initial_fullness <= 0 || initial_fullness > buffer_size)
+        initial_fullness = buffer_size / 2;
+
+    for (i = 0; i < num_layers; i++) {
+        layer_bits_per_second = bits_per_second[i];
+        layer_frames_per_second = frames_per_second[i];
+
+        if (i > 0) {
+            layer_bits_per_second -= bits_per_second[i - 1];
+            layer_frames_per_second -= frames_per_second[i - 1];
+        }
+
+        if (layer_frames_per_second > 0)
+            brc->frame_budget[i] = layer_bits_per_second / layer_frames_per_second;
+
+        brc->input_bits[i] = bits_per_second[i] / top_frames_per_second;
+        brc->buffer_size[i] = buffer_size * bits_per_second[i] / top_bits_per_second;
+        brc->fullness[i] = initial_fullness * bits_per_second[i] / top_bits_per_second;
+    }
+}
+
+/*
+ * Starts a frame of the given layer and returns its budget in bits. The
+ * buffers fill for one frame of the whole stream, then the budget is taken
+ * out of the buffers of every sub-stream holding the layer.
+ */
+double
+i965_encoder_layer_brc_begin_frame(struct i965_encoder_layer_brc *brc,
+                                   unsigned int layer)
+{
+    double budget, max_bits;
+    unsigned int i, slot;
+
+    if (!brc->num_layers)
+        return 0;
+
+    if (layer >= brc->num_layers)
+        layer = brc->num_layers - 1;
+
+    for (i = 0; i < brc->num_layers; i++) {
+        brc->fullness[i] += brc->input_bits[i];
+
+        if (brc->fullness[i] > brc->buffer_size[i])
+            brc->fullness[i] = brc->buffer_size[i];
+    }
+
+    max_bits = brc->fullness[layer];
+
+    for (i = layer + 1; i < brc->num_layers; i++) {
+        if (max_bits > brc->fullness[i])
+            max_bits = brc->fullness[i];
+    }
+
+    if (max_bits < 0)
+        max_bits = 0;
+
+    budget = brc->frame_budget[layer];
+
+    if (budget > max_bits)
+        budget = max_bits;
+
+    for (i = layer; i < brc->num_layers; i++)
+        brc->fullness[i] -= budget;
+
+    /* a frame that never completes is taken for its budget */
+    if (brc->num_pending == I965_ENCODER_LAYER_BRC_MAX_PENDING) {
+        brc->first_pending = (brc->first_pending + 1) % I965_ENCODER_LAYER_BRC_MAX_PENDING;
+        brc->num_pending--;
+    }
+
+    slot = (brc->first_pending + brc->num_pending) % I965_ENCODER_LAYER_BRC_MAX_PENDING;
+    brc->pending[slot].frame_id = 0;
+    brc->pending[slot].layer = layer;
+    brc->pending[slot].bits = budget;
+    brc->num_pending++;
+
+    brc->layer = layer;
+    brc->budget = budget;
+    brc->max_bits = max_bits;
+
+    return budget;
+}
+
+/* Ties the last started frame to the id it got in the status ring */
+void
+i965_encoder_layer_brc_set_frame_id(struct i965_encoder_layer_brc *brc,
+                                    uint32_t frame_id)
+{
+    unsigned int slot;
+
+    if (!brc->num_pending)
+        return;
+
+    slot = (brc->first_pending + brc->num_pending - 1) % I965_ENCODER_LAYER_BRC_MAX_PENDING;
+    brc->pending[slot].frame_id = frame_id;
+}
+
+int
+i965_encoder_layer_brc_oldest_pending(struct i965_encoder_layer_brc *brc,
+                                      uint32_t *frame_id)
+{
+    if (!brc->num_pending)
+        return 0;
+
+    *frame_id = brc->pending[brc->first_pending].frame_id;
+
+    return 1;
+}
+
+/*
+ * Completes the oldest pending frame with its actual size, a negative size
+ * keeps the budget it was charged.
+ */
+void
+i965_encoder_layer_brc_end_frame(struct i965_encoder_layer_brc *brc,
+                                 double frame_bits)
+{
+    unsigned int slot, i;
+    double delta;
+
+    if (!brc->num_pending)
+        return;
+
+    slot = brc->first_pending;
+    brc->first_pending = (brc->first_pending + 1) % I965_ENCODER_LAYER_BRC_MAX_PENDING;
+    brc->num_pending--;
+
+    if (frame_bits < 0)
+        return;
+
+    delta = brc->pending[slot].bits - frame_bits;
+
+    for (i = brc->pending[slot].layer; i < brc->num_layers; i++) {
+        brc->fullness[i] += delta;
+
+        if (brc->fullness[i] < 0) {
+            brc->num_underflows[i]++;
+            brc->fullness[i] = 0;
+        } else if (brc->fullness[i] > brc->buffer_size[i]) {
+            brc->fullness[i] = brc->buffer_size[i];
+        }
+    }
+}
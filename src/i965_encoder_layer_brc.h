@@ -0,0 +1,99 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_ENCODER_LAYER_BRC_H_
+#define _I965_ENCODER_LAYER_BRC_H_
+
+#include <stdint.h>
+
+#define I965_ENCODER_LAYER_BRC_MAX_LAYERS       4       /* MAX_TEMPORAL_LAYERS */
+#define I965_ENCODER_LAYER_BRC_MAX_PENDING      64
+
+/*
+ * Per temporal layer rate control on top of the BRC kernels, which see a
+ * single stream.
+ *
+ * Every frame of layer i gets the budget of its layer, the bitrate of the
+ * layer over its frame rate. The bitrates and frame rates of the layers
+ * are cumulative as in VAEncMiscParameterTypeTemporalLayerStructure, layer
+ * i alone has bits_per_second[i] - bits_per_second[i - 1].
+ *
+ * Every sub-stream made of the layers 0 to i has its own HRD buffer, sized
+ * in proportion of its bitrate. A frame of layer i is taken out of the
+ * buffers of the sub-streams i and up, its budget is capped so that none
+ * of them underflows. Dropping the layers above i leaves a conforming
+ * stream.
+ *
+ * The frame sizes come back later than the frames are started, a frame
+ * is charged its budget when it starts and corrected once its size is
+ * known.
+ */
+struct i965_encoder_layer_brc {
+    unsigned int num_layers;            /* 0 if not in use */
+
+    double frame_budget[I965_ENCODER_LAYER_BRC_MAX_LAYERS];
+    double input_bits[I965_ENCODER_LAYER_BRC_MAX_LAYERS];      /* per frame of the whole stream */
+    double buffer_size[I965_ENCODER_LAYER_BRC_MAX_LAYERS];
+    double fullness[I965_ENCODER_LAYER_BRC_MAX_LAYERS];
+    unsigned int num_underflows[I965_ENCODER_LAYER_BRC_MAX_LAYERS];
+
+    /* the current frame */
+    unsigned int layer;
+    double budget;
+    double max_bits;                    /* the most it can take without an underflow */
+
+    struct {
+        uint32_t frame_id;              /* 0 until the frame goes to the PAK */
+        unsigned int layer;
+        double bits;                    /* charged to the buffers */
+    } pending[I965_ENCODER_LAYER_BRC_MAX_PENDING];
+    unsigned int first_pending;
+    unsigned int num_pending;
+};
+
+void
+i965_encoder_layer_brc_init(struct i965_encoder_layer_brc *brc,
+                            unsigned int num_layers,
+                            const double *bits_per_second,
+                            const double *frames_per_second,
+                            double buffer_size,
+                            double initial_fullness);
+
+double
+i965_encoder_layer_brc_begin_frame(struct i965_encoder_layer_brc *brc,
+                                   unsigned int layer);
+
+void
+i965_encoder_layer_brc_set_frame_id(struct i965_encoder_layer_brc *brc,
+                                    uint32_t frame_id);
+
+int
+i965_encoder_layer_brc_oldest_pending(struct i965_encoder_layer_brc *brc,
+                                      uint32_t *frame_id);
+
+void
+i965_encoder_layer_brc_end_frame(struct i965_encoder_layer_brc *brc,
+                                 double frame_bits);
+
+#endif /* _I965_ENCODER_LAYER_BRC_H_ */
@@ -0,0 +1,211 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "i965_drv_video.h"
+#include "i965_encoder_params.h"
+
+#define FNV_OFFSET_BASIS        0xcbf29ce484222325ULL
+#define FNV_PRIME               0x100000001b3ULL
+
+/* FNV-1a */
+uint64_t
+i965_encoder_params_hash(uint64_t hash, const void *data, unsigned int size)
+{
+    const unsigned char *p = data;
+    unsigned int i;
+
+    for (i = 0; i < size; i++) {
+        hash ^= p[i];
+        hash *= FNV_PRIME;
+    }
+
+    return hash;
+}
+
+/*
+ * Compares the buffers with the snapshot and takes them in, returns
+ * whether they changed. No buffer at all is a state of its own.
+ */
+int
+i965_encoder_params_snapshot_update(struct i965_encoder_params_snapshot *snapshot,
+                                    const void * const *data,
+                                    const unsigned int *sizes,
+                                    unsigned int num_buffers)
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    unsigned int size = 0, offset;
+    unsigned char *p;
+    unsigned int i;
+
+    for (i = 0; i < num_buffers; i++) {
+        hash = i965_encoder_params_hash(hash, data[i], sizes[i]);
+        size += sizes[i];
+    }
+
+    if (snapshot->valid && snapshot->hash == hash && snapshot->size == size) {
+        for (i = 0, offset = 0; i < num_buffers; offset += sizes[i], i++) {
+            if (memcmp(snapshot->data + offset, data[i], sizes[i]))
+                break;
+        }
+
+        if (i == num_buffers)
+            return 0;
+    }
+
+    if (size > snapshot->max_size) {
+        p = realloc(snapshot->data, size);
+
+        if (!p) {
+            snapshot->valid = 0;
+            return 1;
+        }
+
+        snapshot->data = p;
+        snapshot->max_size = size;
+    }
+
+    for (i = 0, offset = 0; i < num_buffers; offset += sizes[i], i++)
+        memcpy(snapshot->data + offset, data[i], sizes[i]);
+
+    snapshot->valid = 1;
+    snapshot->hash = hash;
+    snapshot->size = size;
+
+    return 1;
+}
+
+static int
+i965_encoder_params_update_buffer(struct i965_encoder_params_snapshot *snapshot,
+                                  struct buffer_store *buffer_store)
+{
+    const void *data;
+    unsigned int size;
+
+    if (!buffer_store || !buffer_store->buffer)
+        return i965_encoder_params_snapshot_update(snapshot, NULL, NULL, 0);
+
+    data = buffer_store->buffer;
+    size = buffer_store->size;
+
+    return i965_encoder_params_snapshot_update(snapshot, &data, &size, 1);
+}
+
+/* every misc buffer goes with its type and index, the same bytes in another slot are a change */
+static int
+i965_encoder_params_update_misc(struct i965_encoder_params_snapshot *snapshot,
+                                struct encode_state *encode_state)
+{
+    uint32_t keys[ARRAY_ELEMS(encode_state->misc_param) * ARRAY_ELEMS(encode_state->misc_param[0])];
+    const void *data[ARRAY_ELEMS(keys) * 2];
+    unsigned int sizes[ARRAY_ELEMS(keys) * 2];
+    struct buffer_store *buffer_store;
+    unsigned int i, j, n = 0, num_buffers = 0;
+
+    for (i = 0; i < ARRAY_ELEMS(encode_state->misc_param); i++) {
+        for (j = 0; j < ARRAY_ELEMS(encode_state->misc_param[0]); j++) {
+            buffer_store = encode_state->misc_param[i][j];
+
+            if (!buffer_store || !buffer_store->buffer)
+                continue;
+
+            keys[n] = (i << 8) | j;
+            data[num_buffers] = &keys[n];
+            sizes[num_buffers++] = sizeof(keys[n]);
+            data[num_buffers] = buffer_store->buffer;
+            sizes[num_buffers++] = buffer_store->size;
+            n++;
+        }
+    }
+
+    return i965_encoder_params_snapshot_update(snapshot, data, sizes, num_buffers);
+}
+
+/* Returns the I965_ENCODER_PARAMS_* bits of the buffers changed since the previous frame */
+unsigned int
+i965_encoder_params_update(struct i965_encoder_params *params,
+                           struct encode_state *encode_state)
+{
+    unsigned int i;
+
+    params->changed = 0;
+
+    if (params->disabled) {
+        /* the next frame tracked starts from scratch */
+        i965_encoder_params_invalidate(params);
+        params->changed = (1 << I965_ENCODER_PARAMS_NUM) - 1;
+    } else {
+        if (i965_encoder_params_update_buffer(&params->snapshots[I965_ENCODER_PARAMS_SEQ],
+                                              encode_state->seq_param_ext))
+            params->changed |= 1 << I965_ENCODER_PARAMS_SEQ;
+
+        if (i965_encoder_params_update_misc(&params->snapshots[I965_ENCODER_PARAMS_MISC],
+                                            encode_state))
+            params->changed |= 1 << I965_ENCODER_PARAMS_MISC;
+    }
+
+    params->num_frames++;
+
+    for (i = 0; i < I965_ENCODER_PARAMS_NUM; i++) {
+        if (params->changed & (1 << i))
+            params->num_changed[i]++;
+    }
+
+    return params->changed;
+}
+
+void
+i965_encoder_params_skip(struct i965_encoder_params *params,
+                         unsigned int which)
+{
+    params->num_skipped[which]++;
+}
+
+/*
+ * The codec failed before deriving its state from the current buffers,
+ * the next frame sees all of them as changed.
+ */
+void
+i965_encoder_params_invalidate(struct i965_encoder_params *params)
+{
+    unsigned int i;
+
+    for (i = 0; i < I965_ENCODER_PARAMS_NUM; i++)
+        params->snapshots[i].valid = 0;
+}
+
+void
+i965_encoder_params_free(struct i965_encoder_params *params)
+{
+    unsigned int i;
+
+    for (i = 0; i < I965_ENCODER_PARAMS_NUM; i++) {
+        free(params->snapshots[i].data);
+        params->snapshots[i].data = NULL;
+        params->snapshots[i].max_size = 0;
+        params->snapshots[i].valid = 0;
+    }
+}
@@ -0,0 +1,90 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_ENCODER_PARAMS_H_
+#define _I965_ENCODER_PARAMS_H_
+
+#include <stdint.h>
+
+struct encode_state;
+
+#define I965_ENCODER_PARAMS_SEQ                 0
+#define I965_ENCODER_PARAMS_MISC                1
+#define I965_ENCODER_PARAMS_NUM                 2
+
+#define I965_ENCODER_PARAMS_CHANGED(params, which)      ((params)->changed & (1 << (which)))
+
+/* A copy of the parameter buffers of one kind, as they were last seen */
+struct i965_encoder_params_snapshot {
+    int valid;
+    uint64_t hash;
+    unsigned int size;
+    unsigned int max_size;
+    unsigned char *data;
+};
+
+/*
+ * The sequence and misc parameter buffers of the previous frame of an
+ * encoder context, updated once per frame before the codec runs. The
+ * picture parameters change with every frame and are not tracked.
+ *
+ * The applications send the same sequence and misc parameters again and
+ * again, the codecs only derive the state depending on them when they
+ * changed. The buffers are hashed, a snapshot with the same hash is
+ * compared byte by byte, so a change is never missed.
+ */
+struct i965_encoder_params {
+    struct i965_encoder_params_snapshot snapshots[I965_ENCODER_PARAMS_NUM];
+    unsigned int changed;               /* 1 << I965_ENCODER_PARAMS_*, of the current frame */
+    int disabled;                       /* every buffer is seen as changed, nothing is hashed */
+
+    unsigned int num_frames;
+    unsigned int num_changed[I965_ENCODER_PARAMS_NUM];
+    unsigned int num_skipped[I965_ENCODER_PARAMS_NUM];  /* the derivations the codecs skipped */
+};
+
+uint64_t
+i965_encoder_params_hash(uint64_t hash, const void *data, unsigned int size);
+
+int
+i965_encoder_params_snapshot_update(struct i965_encoder_params_snapshot *snapshot,
+                                    const void * const *data,
+                                    const unsigned int *sizes,
+                                    unsigned int num_buffers);
+
+unsigned int
+i965_encoder_params_update(struct i965_encoder_params *params,
+                           struct encode_state *encode_state);
+
+void
+i965_encoder_params_skip(struct i965_encoder_params *params,
+                         unsigned int which);
+
+void
+i965_encoder_params_invalidate(struct i965_encoder_params *params);
+
+void
+i965_encoder_params_free(struct i965_encoder_params *params);
+
+#endif /* _I965_ENCODER_PARAMS_H_ */
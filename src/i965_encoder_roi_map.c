@@ -0,0 +1,180 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <string.h>
+#include <assert.h>
+
+#include "i965_encoder_roi_map.h"
+
+void
+i965_encoder_roi_map_reset(struct i965_encoder_roi_map *map)
+{
+    memset(map, 0, sizeof(*map));
+}
+
+static int
+i965_encoder_roi_rect_is_empty(const struct i965_encoder_roi_rect *rect)
+{
+    return rect->left >= rect->right || rect->top >= rect->bottom;
+}
+
+static int
+i965_encoder_roi_rect_equal(const struct i965_encoder_roi_rect *a,
+                            const struct i965_encoder_roi_rect *b)
+{
+    return a->left == b->left &&
+           a->right == b->right &&
+           a->top == b->top &&
+           a->bottom == b->bottom;
+}
+
+/* Clips rect to area, returns 0 if nothing is left */
+static int
+i965_encoder_roi_rect_clip(struct i965_encoder_roi_rect *rect,
+                           const struct i965_encoder_roi_rect *area)
+{
+    if (rect->left < area->left)
+        rect->left = area->left;
+
+    if (rect->right > area->right)
+        rect->right = area->right;
+
+    if (rect->top < area->top)
+        rect->top = area->top;
+
+    if (rect->bottom > area->bottom)
+        rect->bottom = area->bottom;
+
+    return !i965_encoder_roi_rect_is_empty(rect);
+}
+
+static void
+i965_encoder_roi_map_fill(struct i965_encoder_roi_map *map,
+                          uint8_t *buf,
+                          const struct i965_encoder_roi_rect *rect,
+                          uint8_t value)
+{
+    unsigned int count = rect->right - rect->left;
+    unsigned int row, i;
+    uint8_t *p;
+
+    for (row = rect->top; row < rect->bottom; row++) {
+        p = buf + row * map->pitch + rect->left * map->elem_size;
+
+        if (map->elem_size == 1) {
+            memset(p, value, count);
+        } else {
+            for (i = 0; i < count; i++, p += map->elem_size)
+                *p = value;
+        }
+    }
+}
+
+static void
+i965_encoder_roi_map_add_dirty(struct i965_encoder_roi_map *map,
+                               const struct i965_encoder_roi_rect *rect)
+{
+    if (i965_encoder_roi_rect_is_empty(rect))
+        return;
+
+    assert(map->num_dirty < 2 * I965_ENCODER_ROI_MAP_MAX_RECTS);
+    map->dirty[map->num_dirty++] = *rect;
+}
+
+/*
+ * Paints rects over the background into buf, the later rectangles on
+ * top. buf must hold what the last paint left, the caller resets the map
+ * whenever it does not. Returns the number of repainted areas in map->dirty.
+ */
+unsigned int
+i965_encoder_roi_map_paint(struct i965_encoder_roi_map *map,
+                           uint8_t *buf,
+                           unsigned int pitch,
+                           unsigned int elem_size,
+                           unsigned int width,
+                           unsigned int height,
+                           uint8_t background,
+                           const struct i965_encoder_roi_rect *rects,
+                           unsigned int num_rects)
+{
+    struct i965_encoder_roi_rect frame = { 0, width, 0, height, 0 };
+    struct i965_encoder_roi_rect new_rects[I965_ENCODER_ROI_MAP_MAX_RECTS];
+    struct i965_encoder_roi_rect rect;
+    unsigned int max_rects = num_rects > map->num_rects ? num_rects : map->num_rects;
+    unsigned int i, j;
+
+    assert(num_rects <= I965_ENCODER_ROI_MAP_MAX_RECTS);
+
+    for (i = 0; i < num_rects; i++) {
+        new_rects[i] = rects[i];
+
+        if (!i965_encoder_roi_rect_clip(&new_rects[i], &frame))
+            new_rects[i].right = new_rects[i].left;
+    }
+
+    map->num_dirty = 0;
+
+    if (map->width != width ||
+        map->height != height ||
+        map->pitch != pitch ||
+        map->elem_size != elem_size ||
+        map->background != background) {
+        map->width = width;
+        map->height = height;
+        map->pitch = pitch;
+        map->elem_size = elem_size;
+        map->background = background;
+
+        i965_encoder_roi_map_add_dirty(map, &frame);
+    } else {
+        for (i = 0; i < max_rects; i++) {
+            if (i >= num_rects) {
+                i965_encoder_roi_map_add_dirty(map, &map->rects[i]);
+            } else if (i >= map->num_rects) {
+                i965_encoder_roi_map_add_dirty(map, &new_rects[i]);
+            } else if (!i965_encoder_roi_rect_equal(&map->rects[i], &new_rects[i])) {
+                i965_encoder_roi_map_add_dirty(map, &map->rects[i]);
+                i965_encoder_roi_map_add_dirty(map, &new_rects[i]);
+            } else if (map->rects[i].value != new_rects[i].value) {
+                i965_encoder_roi_map_add_dirty(map, &new_rects[i]);
+            }
+        }
+    }
+
+    for (i = 0; i < map->num_dirty; i++) {
+        i965_encoder_roi_map_fill(map, buf, &map->dirty[i], background);
+
+        for (j = 0; j < num_rects; j++) {
+            rect = new_rects[j];
+
+            if (i965_encoder_roi_rect_clip(&rect, &map->dirty[i]))
+                i965_encoder_roi_map_fill(map, buf, &rect, rect.value);
+        }
+    }
+
+    memcpy(map->rects, new_rects, num_rects * sizeof(new_rects[0]));
+    map->num_rects = num_rects;
+
+    return map->num_dirty;
+}
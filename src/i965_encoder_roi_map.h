@@ -0,0 +1,84 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_ENCODER_ROI_MAP_H_
+#define _I965_ENCODER_ROI_MAP_H_
+
+#include <stdint.h>
+
+#define I965_ENCODER_ROI_MAP_MAX_RECTS          8       /* I965_MAX_NUM_ROI_REGIONS */
+
+/* A rectangle of MBs, right and bottom excluded */
+struct i965_encoder_roi_rect {
+    unsigned short left;
+    unsigned short right;
+    unsigned short top;
+    unsigned short bottom;
+
+    uint8_t value;
+};
+
+/*
+ * Rasterizes ROI rectangles into a per MB map, a QP map or the ROI
+ * selection of a stream-in buffer.
+ *
+ * The map remembers what it painted last, a new set of rectangles only
+ * repaints the areas of the rectangles that changed. Every area is filled
+ * with the background then with the rectangles crossing it, in order, so
+ * the result is the same as painting the whole map again. A new size or
+ * background repaints the whole map.
+ *
+ * Every MB takes elem_size bytes in the buffer, the value goes to the
+ * first one.
+ */
+struct i965_encoder_roi_map {
+    unsigned int width;                 /* in MBs, 0 until the first paint */
+    unsigned int height;
+    unsigned int pitch;
+    unsigned int elem_size;
+    uint8_t background;
+
+    struct i965_encoder_roi_rect rects[I965_ENCODER_ROI_MAP_MAX_RECTS];
+    unsigned int num_rects;
+
+    /* the areas repainted by the last paint, the value is not used */
+    struct i965_encoder_roi_rect dirty[2 * I965_ENCODER_ROI_MAP_MAX_RECTS];
+    unsigned int num_dirty;
+};
+
+void
+i965_encoder_roi_map_reset(struct i965_encoder_roi_map *map);
+
+unsigned int
+i965_encoder_roi_map_paint(struct i965_encoder_roi_map *map,
+                           uint8_t *buf,
+                           unsigned int pitch,
+                           unsigned int elem_size,
+                           unsigned int width,
+                           unsigned int height,
+                           uint8_t background,
+                           const struct i965_encoder_roi_rect *rects,
+                           unsigned int num_rects);
+
+#endif /* _I965_ENCODER_ROI_MAP_H_ */
@@ -0,0 +1,497 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+
+#include "intel_batchbuffer.h"
+#include "intel_driver.h"
+#include "i965_drv_video.h"
+#include "i965_gpe_utils.h"
+#include "i965_encoder_status.h"
+
+void
+i965_encoder_status_ring_init(struct i965_encoder_status_ring *ring,
+                              struct i965_encoder_status_record **records,
+                              unsigned int num_pipes,
+                              unsigned int num_slots)
+{
+    unsigned int i, j;
+
+    assert(num_pipes > 0 && num_pipes <= I965_ENCODER_STATUS_RING_PIPES);
+    assert(num_slots > 0 && num_slots <= I965_ENCODER_STATUS_RING_SLOTS);
+
+    ring->num_pipes = num_pipes;
+    ring->num_slots = num_slots;
+    ring->next_frame_id = 1;
+    ring->oldest_frame_id = 1;
+    ring->harvest_frame_id = 1;
+    ring->num_dropped = 0;
+
+    for (j = 0; j < num_pipes; j++) {
+        ring->records[j] = records[j];
+
+        for (i = 0; i < num_slots; i++)
+            ring->records[j][i].frame_id = 0;
+    }
+
+    for (i = 0; i < num_slots; i++) {
+        ring->slots[i].frame_id = 0;
+        ring->slots[i].pipe = 0;
+        ring->slots[i].coded_bo = NULL;
+        ring->slots[i].hints = 0;
+    }
+
+    _i965InitMutex(&ring->mutex);
+}
+
+Bool
+i965_encoder_status_ring_alloc(VADriverContextP ctx,
+                               struct i965_encoder_status_ring *ring,
+                               unsigned int num_pipes)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct i965_encoder_status_record *records[I965_ENCODER_STATUS_RING_PIPES];
+    dri_bo *bo;
+    unsigned int i;
+
+    if (ring->records[0])
+        return true;
+
+    for (i = 0; i < num_pipes; i++) {
+        bo = dri_bo_alloc(i965->intel.bufmgr,
+                          "encoder status ring",
+                          I965_ENCODER_STATUS_RING_SLOTS * sizeof(struct i965_encoder_status_record),
+                          0x1000);
+
+        if (!bo)
+            goto failed;
+
+        /* The ring stays mapped through the GTT, so the CPU sees the GPU
+         * writes without waiting on the BO */
+        if (drm_intel_gem_bo_map_gtt(bo)) {
+            dri_bo_unreference(bo);
+            goto failed;
+        }
+
+        ring->bo[i] = bo;
+        records[i] = bo->virtual;
+    }
+
+    i965_encoder_status_ring_init(ring, records, num_pipes, I965_ENCODER_STATUS_RING_SLOTS);
+
+    return true;
+
+failed:
+    while (i--) {
+        drm_intel_gem_bo_unmap_gtt(ring->bo[i]);
+        dri_bo_unreference(ring->bo[i]);
+        ring->bo[i] = NULL;
+    }
+
+    return false;
+}
+
+void
+i965_encoder_status_ring_free(struct i965_encoder_status_ring *ring)
+{
+    unsigned int i;
+
+    if (!ring->records[0])
+        return;
+
+    for (i = 0; i < ring->num_slots; i++) {
+        dri_bo_unreference(ring->slots[i].coded_bo);
+        ring->slots[i].coded_bo = NULL;
+    }
+
+    for (i = 0; i < ring->num_pipes; i++) {
+        if (ring->bo[i]) {
+            drm_intel_gem_bo_unmap_gtt(ring->bo[i]);
+            dri_bo_unreference(ring->bo[i]);
+            ring->bo[i] = NULL;
+        }
+
+        ring->records[i] = NULL;
+    }
+
+    _i965DestroyMutex(&ring->mutex);
+}
+
+#define BRC_STATS_OFFSET(field)                                         \
+    (offsetof(struct i965_coded_buffer_segment, brc_stats) +            \
+     offsetof(struct i965_coded_buffer_brc_stats, field))
+
+/*
+ * Writes the PAK side of the rate control statistics to the header of the
+ * coded buffer, the driver side is already there.
+ */
+static void
+i965_encoder_status_emit_brc_stats(VADriverContextP ctx,
+                                   struct intel_batchbuffer *batch,
+                                   dri_bo *coded_bo,
+                                   const struct i965_encoder_status_regs *regs,
+                                   unsigned int num_passes,
+                                   uint32_t frame_id)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct i965_gpe_table *gpe = &i965->gpe_table;
+    struct gpe_mi_store_register_mem_parameter mi_store_reg_mem_param;
+    struct gpe_mi_store_data_imm_parameter mi_store_data_imm_param;
+    struct gpe_mi_flush_dw_parameter mi_flush_dw_param;
+    const struct {
+        uint32_t mmio_offset;
+        uint32_t offset;
+    } reg_list[] = {
+        { regs->bs_byte_count_frame, BRC_STATS_OFFSET(actual_bytes) },
+        { regs->bs_byte_count_frame_nh, BRC_STATS_OFFSET(actual_bytes_nh) },
+        { regs->qp_status_reg, BRC_STATS_OFFSET(qp_status_reg) },
+        { regs->image_status_ctrl, BRC_STATS_OFFSET(image_status_ctrl) },
+    };
+    unsigned int i;
+
+    memset(&mi_store_reg_mem_param, 0, sizeof(mi_store_reg_mem_param));
+    mi_store_reg_mem_param.bo = coded_bo;
+
+    for (i = 0; i < ARRAY_ELEMS(reg_list); i++) {
+        if (!reg_list[i].mmio_offset)
+            continue;
+
+        mi_store_reg_mem_param.offset = reg_list[i].offset;
+        mi_store_reg_mem_param.mmio_offset = reg_list[i].mmio_offset;
+        gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+    }
+
+    memset(&mi_store_data_imm_param, 0, sizeof(mi_store_data_imm_param));
+    mi_store_data_imm_param.bo = coded_bo;
+    mi_store_data_imm_param.offset = BRC_STATS_OFFSET(num_passes);
+    mi_store_data_imm_param.dw0 = num_passes;
+    gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
+
+    memset(&mi_flush_dw_param, 0, sizeof(mi_flush_dw_param));
+    gpe->mi_flush_dw(ctx, batch, &mi_flush_dw_param);
+
+    mi_store_data_imm_param.offset = BRC_STATS_OFFSET(frame_id);
+    mi_store_data_imm_param.dw0 = frame_id;
+    gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
+}
+
+static void
+i965_encoder_status_ring_release(struct i965_encoder_status_ring *ring,
+                                 unsigned int slot)
+{
+    dri_bo_unreference(ring->slots[slot].coded_bo);
+    ring->slots[slot].coded_bo = NULL;
+    ring->slots[slot].frame_id = 0;
+}
+
+/*
+ * With BRC the PAK may run several passes and every pass writes the status,
+ * the record is final once the coded buffer is idle as well. The coded
+ * buffer isn't needed any more then.
+ */
+static Bool
+i965_encoder_status_ring_is_done(struct i965_encoder_status_ring *ring,
+                                 unsigned int slot)
+{
+    if (ring->records[ring->slots[slot].pipe][slot].frame_id != ring->slots[slot].frame_id)
+        return false;
+
+    if (ring->slots[slot].coded_bo) {
+        if (drm_intel_bo_busy(ring->slots[slot].coded_bo))
+            return false;
+
+        dri_bo_unreference(ring->slots[slot].coded_bo);
+        ring->slots[slot].coded_bo = NULL;
+    }
+
+    return true;
+}
+
+uint32_t
+i965_encoder_status_ring_begin_frame(struct i965_encoder_status_ring *ring,
+                                     VABufferID coded_buf,
+                                     dri_bo *coded_bo)
+{
+    struct i965_encoder_status_record *record;
+    uint32_t frame_id;
+    unsigned int slot, i;
+
+    if (!ring->records[0])
+        return 0;
+
+    _i965LockMutex(&ring->mutex);
+
+    /* The ring is full, overwrite the oldest frame */
+    if (ring->next_frame_id - ring->oldest_frame_id == ring->num_slots) {
+        i965_encoder_status_ring_release(ring, ring->oldest_frame_id % ring->num_slots);
+
+        if (ring->harvest_frame_id == ring->oldest_frame_id) {
+            ring->harvest_frame_id++;
+            ring->num_dropped++;
+        }
+
+        ring->oldest_frame_id++;
+    }
+
+    /* Only the frames in flight keep their coded buffer */
+    for (i = ring->oldest_frame_id; i != ring->next_frame_id; i++) {
+        if (ring->slots[i % ring->num_slots].coded_bo)
+            i965_encoder_status_ring_is_done(ring, i % ring->num_slots);
+    }
+
+    frame_id = ring->next_frame_id++;
+    slot = frame_id % ring->num_slots;
+
+    for (i = 0; i < ring->num_pipes; i++) {
+        record = &ring->records[i][slot];
+        memset(record, 0, sizeof(*record));
+        record->frame_id = ~frame_id;
+        record->coded_buf = coded_buf;
+    }
+
+    ring->slots[slot].frame_id = frame_id;
+    ring->slots[slot].pipe = 0;
+    ring->slots[slot].coded_bo = coded_bo;
+    ring->slots[slot].hints = 0;
+
+    if (coded_bo)
+        dri_bo_reference(coded_bo);
+
+    _i965UnlockMutex(&ring->mutex);
+
+    return frame_id;
+}
+
+void
+i965_encoder_status_ring_emit(VADriverContextP ctx,
+                              struct intel_batchbuffer *batch,
+                              struct i965_encoder_status_ring *ring,
+                              unsigned int pipe,
+                              const struct i965_encoder_status_regs *regs,
+                              unsigned int num_passes)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct i965_gpe_table *gpe = &i965->gpe_table;
+    struct gpe_mi_store_register_mem_parameter mi_store_reg_mem_param;
+    struct gpe_mi_store_data_imm_parameter mi_store_data_imm_param;
+    struct gpe_mi_flush_dw_parameter mi_flush_dw_param;
+    const struct {
+        uint32_t mmio_offset;
+        uint32_t offset;
+    } reg_list[] = {
+        { regs->bs_byte_count_frame, offsetof(struct i965_encoder_status_record, bs_byte_count_frame) },
+        { regs->bs_byte_count_frame_nh, offsetof(struct i965_encoder_status_record, bs_byte_count_frame_nh) },
+        { regs->image_status_mask, offsetof(struct i965_encoder_status_record, image_status_mask) },
+        { regs->image_status_ctrl, offsetof(struct i965_encoder_status_record, image_status_ctrl) },
+        { regs->qp_status_reg, offsetof(struct i965_encoder_status_record, qp_status_reg) },
+    };
+    uint32_t frame_id, base_offset;
+    unsigned int i;
+    dri_bo *bo, *coded_bo;
+
+    if (!ring->bo[0])
+        return;
+
+    if (pipe >= ring->num_pipes)
+        pipe = 0;
+
+    bo = ring->bo[pipe];
+
+    _i965LockMutex(&ring->mutex);
+    frame_id = ring->next_frame_id - 1;
+
+    /* no frame has been started */
+    if (frame_id + 1 == ring->oldest_frame_id) {
+        _i965UnlockMutex(&ring->mutex);
+        return;
+    }
+
+    ring->slots[frame_id % ring->num_slots].pipe = pipe;
+    coded_bo = ring->slots[frame_id % ring->num_slots].coded_bo;
+    _i965UnlockMutex(&ring->mutex);
+
+    base_offset = (frame_id % ring->num_slots) * sizeof(struct i965_encoder_status_record);
+
+    memset(&mi_flush_dw_param, 0, sizeof(mi_flush_dw_param));
+    gpe->mi_flush_dw(ctx, batch, &mi_flush_dw_param);
+
+    memset(&mi_store_reg_mem_param, 0, sizeof(mi_store_reg_mem_param));
+    mi_store_reg_mem_param.bo = bo;
+
+    for (i = 0; i < ARRAY_ELEMS(reg_list); i++) {
+        if (!reg_list[i].mmio_offset)
+            continue;
+
+        mi_store_reg_mem_param.offset = base_offset + reg_list[i].offset;
+        mi_store_reg_mem_param.mmio_offset = reg_list[i].mmio_offset;
+        gpe->mi_store_register_mem(ctx, batch, &mi_store_reg_mem_param);
+    }
+
+    memset(&mi_store_data_imm_param, 0, sizeof(mi_store_data_imm_param));
+    mi_store_data_imm_param.bo = bo;
+    mi_store_data_imm_param.offset = base_offset + offsetof(struct i965_encoder_status_record, num_passes);
+    mi_store_data_imm_param.dw0 = num_passes;
+    gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
+
+    /* the frame id goes last, once the registers have landed */
+    gpe->mi_flush_dw(ctx, batch, &mi_flush_dw_param);
+
+    mi_store_data_imm_param.offset = base_offset + offsetof(struct i965_encoder_status_record, frame_id);
+    mi_store_data_imm_param.dw0 = frame_id;
+    gpe->mi_store_data_imm(ctx, batch, &mi_store_data_imm_param);
+
+    if (i965->intel.enc_brc_stats && coded_bo)
+        i965_encoder_status_emit_brc_stats(ctx, batch, coded_bo, regs, num_passes, frame_id);
+}
+
+/* The id of the last frame begun, 0 if none */
+uint32_t
+i965_encoder_status_ring_last_frame_id(struct i965_encoder_status_ring *ring)
+{
+    uint32_t frame_id = 0;
+
+    if (!ring->records[0])
+        return 0;
+
+    _i965LockMutex(&ring->mutex);
+
+    if (ring->next_frame_id != ring->oldest_frame_id)
+        frame_id = ring->next_frame_id - 1;
+
+    _i965UnlockMutex(&ring->mutex);
+
+    return frame_id;
+}
+
+/*
+ * The hints of a frame may come after later frames are begun, they are
+ * dropped once the frame has left the ring.
+ */
+void
+i965_encoder_status_ring_set_hints(struct i965_encoder_status_ring *ring,
+                                   uint32_t frame_id,
+                                   uint32_t hints)
+{
+    if (!ring->records[0] || !frame_id)
+        return;
+
+    _i965LockMutex(&ring->mutex);
+
+    if (frame_id - ring->oldest_frame_id < ring->next_frame_id - ring->oldest_frame_id)
+        ring->slots[frame_id % ring->num_slots].hints = hints;
+
+    _i965UnlockMutex(&ring->mutex);
+}
+
+VAStatus
+i965_encoder_status_ring_query(struct i965_encoder_status_ring *ring,
+                               uint32_t frame_id,
+                               struct i965_encoder_status_record *record)
+{
+    VAStatus va_status = VA_STATUS_ERROR_SURFACE_BUSY;
+    unsigned int slot;
+
+    if (!ring->records[0])
+        return VA_STATUS_ERROR_UNIMPLEMENTED;
+
+    _i965LockMutex(&ring->mutex);
+
+    if (frame_id - ring->oldest_frame_id >= ring->next_frame_id - ring->oldest_frame_id) {
+        va_status = VA_STATUS_ERROR_INVALID_PARAMETER;
+    } else {
+        slot = frame_id % ring->num_slots;
+
+        if (i965_encoder_status_ring_is_done(ring, slot)) {
+            *record = ring->records[ring->slots[slot].pipe][slot];
+            record->hints = ring->slots[slot].hints;
+            va_status = VA_STATUS_SUCCESS;
+        }
+    }
+
+    _i965UnlockMutex(&ring->mutex);
+
+    return va_status;
+}
+
+/*
+ * The coded buffer is destroyed, its frames no longer hold it: such a frame
+ * is done once its record is written.
+ */
+void
+i965_encoder_status_ring_forget_coded_bo(struct i965_encoder_status_ring *ring,
+                                         dri_bo *coded_bo)
+{
+    unsigned int i;
+
+    if (!ring->records[0] || !coded_bo)
+        return;
+
+    _i965LockMutex(&ring->mutex);
+
+    for (i = 0; i < ring->num_slots; i++) {
+        if (ring->slots[i].coded_bo == coded_bo) {
+            dri_bo_unreference(coded_bo);
+            ring->slots[i].coded_bo = NULL;
+        }
+    }
+
+    _i965UnlockMutex(&ring->mutex);
+}
+
+/*
+ * Hands out the completed frames in encoding order, it stops at the first
+ * frame still in flight even if later frames have already completed. The
+ * frames handed out stay in the ring and can still be queried.
+ */
+unsigned int
+i965_encoder_status_ring_harvest(struct i965_encoder_status_ring *ring,
+                                 struct i965_encoder_status_record *records,
+                                 unsigned int max_records)
+{
+    unsigned int num_records = 0;
+    unsigned int slot;
+
+    if (!ring->records[0])
+        return 0;
+
+    _i965LockMutex(&ring->mutex);
+
+    while (num_records < max_records &&
+           ring->harvest_frame_id != ring->next_frame_id) {
+        slot = ring->harvest_frame_id % ring->num_slots;
+
+        if (!i965_encoder_status_ring_is_done(ring, slot))
+            break;
+
+        records[num_records] = ring->records[ring->slots[slot].pipe][slot];
+        records[num_records++].hints = ring->slots[slot].hints;
+        ring->harvest_frame_id++;
+    }
+
+    _i965UnlockMutex(&ring->mutex);
+
+    return num_records;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_ENCODER_STATUS_H_
+#define _I965_ENCODER_STATUS_H_
+
+#include <stdint.h>
+
+#include "i965_drv_video.h"
+
+#define I965_ENCODER_STATUS_RING_SLOTS          64
+#define I965_ENCODER_STATUS_RING_PIPES          2
+
+#define I965_ENCODER_STATUS_HINT_SCENE_CUT      (1 << 0)
+#define I965_ENCODER_STATUS_HINT_STATIC_SCENE   (1 << 1)
+
+/*
+ * The status of one encoded frame. The PAK writes every field but
+ * coded_buf and hints, and writes frame_id last so that a slot whose
+ * frame_id matches the frame it was handed out for holds the whole status.
+ */
+struct i965_encoder_status_record {
+    uint32_t frame_id;
+    uint32_t coded_buf;                 /* VABufferID of the coded buffer */
+    uint32_t bs_byte_count_frame;
+    uint32_t bs_byte_count_frame_nh;
+    uint32_t image_status_mask;
+    uint32_t image_status_ctrl;         /* frame size / HRD conformance of the last pass */
+    uint32_t qp_status_reg;             /* raw QP status count register, not a QP */
+    uint32_t num_passes;
+    uint32_t hints;                     /* I965_ENCODER_STATUS_HINT_*, from the driver */
+};
+
+/* The MMIO registers of the PAK engine, 0 if not available */
+struct i965_encoder_status_regs {
+    uint32_t bs_byte_count_frame;
+    uint32_t bs_byte_count_frame_nh;
+    uint32_t image_status_mask;
+    uint32_t image_status_ctrl;
+    uint32_t qp_status_reg;
+};
+
+/*
+ * A ring of per frame status records, filled by the GPU as the frames
+ * complete. It can be queried and harvested from any thread without
+ * waiting on the coded buffers, the application gets the status of a
+ * frame with the segments of its coded buffer too. The oldest frame is
+ * overwritten once the ring is full.
+ *
+ * A slot holds a reference on the coded buffer of its frame while the
+ * frame is in flight only.
+ *
+ * Every PAK pipe writes its own copy of the records, a BO written from
+ * two rings would serialize the frames running on them.
+ */
+struct i965_encoder_status_ring {
+    dri_bo *bo[I965_ENCODER_STATUS_RING_PIPES];
+    struct i965_encoder_status_record *records[I965_ENCODER_STATUS_RING_PIPES];
+    unsigned int num_pipes;
+    unsigned int num_slots;
+
+    struct {
+        uint32_t frame_id;
+        unsigned int pipe;              /* the pipe writing the record */
+        dri_bo *coded_bo;               /* NULL once the frame is done */
+        uint32_t hints;
+    } slots[I965_ENCODER_STATUS_RING_SLOTS];
+
+    uint32_t next_frame_id;             /* the id handed to the next frame */
+    uint32_t oldest_frame_id;           /* the oldest frame still in the ring */
+    uint32_t harvest_frame_id;          /* the oldest frame not harvested yet */
+    uint32_t num_dropped;               /* overwritten before being harvested */
+
+    _I965Mutex mutex;
+};
+
+void
+i965_encoder_status_ring_init(struct i965_encoder_status_ring *ring,
+                              struct i965_encoder_status_record **records,
+                              unsigned int num_pipes,
+                              unsigned int num_slots);
+
+Bool
+i965_encoder_status_ring_alloc(VADriverContextP ctx,
+                               struct i965_encoder_status_ring *ring,
+                               unsigned int num_pipes);
+
+void
+i965_encoder_status_ring_free(struct i965_encoder_status_ring *ring);
+
+uint32_t
+i965_encoder_status_ring_begin_frame(struct i965_encoder_status_ring *ring,
+                                     VABufferID coded_buf,
+                                     dri_bo *coded_bo);
+
+void
+i965_encoder_status_ring_emit(VADriverContextP ctx,
+                              struct intel_batchbuffer *batch,
+                              struct i965_encoder_status_ring *ring,
+                              unsigned int pipe,
+                              const struct i965_encoder_status_regs *regs,
+                              unsigned int num_passes);
+
+uint32_t
+i965_encoder_status_ring_last_frame_id(struct i965_encoder_status_ring *ring);
+
+void
+i965_encoder_status_ring_set_hints(struct i965_encoder_status_ring *ring,
+                                   uint32_t frame_id,
+                                   uint32_t hints);
+
+VAStatus
+i965_encoder_status_ring_query(struct i965_encoder_status_ring *ring,
+                               uint32_t frame_id,
+                               struct i965_encoder_status_record *record);
+
+unsigned int
+i965_encoder_status_ring_harvest(struct i965_encoder_status_ring *ring,
+                                 struct i965_encoder_status_record *records,
+                                 unsigned int max_records);
+
+void
+i965_encoder_status_ring_forget_coded_bo(struct i965_encoder_status_ring *ring,
+                                         dri_bo *coded_bo);
+
+/* Exported for the applications, see i965_drv_video.c */
+VAStatus
+i965_HarvestEncoderStatus(VADriverContextP ctx,
+                          VAContextID context,
+                          struct i965_encoder_status_record *records,
+                          unsigned int max_records,
+                          unsigned int *num_records);
+
+#endif /* _I965_ENCODER_STATUS_H_ */
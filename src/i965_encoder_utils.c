@@ -1078,11 +1078,16 @@ static void slice_rbsp(avc_bitstream *bs,
         */
     }
 
-    if (pic_param->pic_fields.bits.tiles_enabled_flag ||
-        pic_param->pic_fields.bits.entropy_coding_sync_enabled_flag) {
+    if (pic_param->pic_fields.bits.entropy_coding_sync_enabled_flag) {
         /* TBD.
-        * Add the Entry-points && tile definition.
+        * Add the Entry-points of the wavefront substreams.
         */
+    } else if (pic_param->pic_fields.bits.tiles_enabled_flag) {
+        /*
+        * Only slices within a single tile are supported, they have no
+        * entry points.
+        */
+        avc_bitstream_put_ue(bs, 0);    /* num_entry_point_offsets */
     }
 
     /* slice_segment_header_extension_present_flag. Not present */
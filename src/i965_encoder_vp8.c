@@ -2156,6 +2156,17 @@ i965_encoder_vp8_get_misc_parameters(VADriverContextP ctx,
 {
     struct i965_encoder_vp8_context *vp8_context = encoder_context->vme_context;
 
+    /*
+     * The GOP follows the sequence and the rate control settings come with
+     * a BRC reset, the misc buffers of the previous frame leave them as is
+     */
+    if (!encoder_context->is_new_sequence &&
+        !encoder_context->brc.need_reset &&
+        !I965_ENCODER_PARAMS_CHANGED(&encoder_context->params, I965_ENCODER_PARAMS_MISC)) {
+        i965_encoder_params_skip(&encoder_context->params, I965_ENCODER_PARAMS_MISC);
+        return;
+    }
+
     if (vp8_context->internal_rate_mode == I965_BRC_CQP) {
         vp8_context->init_vbv_buffer_fullness_in_bit = 0;
         vp8_context->vbv_buffer_size_in_bit = 0;
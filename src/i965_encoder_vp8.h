@@ -71,9 +71,6 @@
 #define VP8_PICTURE_STATE_SIZE             (VP8_PICTURE_STATE_CMD_SIZE + VP8_HEADER_METADATA_SIZE + (16 * sizeof(unsigned int)))
 #define VP8_HEADER_METADATA_OFFSET         (VP8_PICTURE_STATE_CMD_SIZE + (3 * sizeof(unsigned int)))
 
-#define VDBOX0_MMIO_BASE                                        0x12000
-#define VDBOX1_MMIO_BASE                                        0x1c000
-
 #define VP8_MFC_IMAGE_STATUS_MASK_REG_OFFSET                    0x900
 #define VP8_MFC_IMAGE_STATUS_CTRL_REG_OFFSET                    0x904
 #define VP8_MFC_BITSTREAM_BYTECOUNT_FRAME_REG_OFFSET            0x908
@@ -1120,32 +1120,158 @@ gen8_gpe_pipeline_setup(VADriverContextP ctx,
     gen8_gpe_idrt(ctx, gpe_context, batch);
 }
 
+/* Removes slots[index], the retired BOs stay ordered from the oldest */
+static void
+gen8_gpe_state_heap_remove(dri_bo *slots[GPE_STATE_HEAP_SLOTS], int index)
+{
+    memmove(&slots[index], &slots[index + 1],
+            (GPE_STATE_HEAP_SLOTS - 1 - index) * sizeof(slots[0]));
+    slots[GPE_STATE_HEAP_SLOTS - 1] = NULL;
+}
+
+static void
+gen8_gpe_state_heap_put(dri_bo *slots[GPE_STATE_HEAP_SLOTS],
+                        dri_bo *bo)
+{
+    int i;
+
+    if (!bo)
+        return;
+
+    /* All slots are taken, drop the oldest retired BO */
+    if (slots[GPE_STATE_HEAP_SLOTS - 1]) {
+        dri_bo_unreference(slots[0]);
+        gen8_gpe_state_heap_remove(slots, 0);
+    }
+
+    for (i = 0; i < GPE_STATE_HEAP_SLOTS; i++) {
+        if (!slots[i]) {
+            slots[i] = bo;
+            return;
+        }
+    }
+}
+
+/* A submitted batch keeps its BOs busy, only the batch being built has
+   to be checked */
+static dri_bo *
+gen8_gpe_state_heap_get(VADriverContextP ctx,
+                        struct i965_gpe_state_heap *heap,
+                        dri_bo *slots[GPE_STATE_HEAP_SLOTS],
+                        const char *name,
+                        unsigned int size)
+{
+    struct i965_driver_data *i965 = i965_driver_data(ctx);
+    dri_bo *bo;
+    int i;
+
+    for (i = 0; i < GPE_STATE_HEAP_SLOTS; i++) {
+        bo = slots[i];
+
+        if (!bo || bo->size < size)
+            continue;
+
+        if (heap->batch && drm_intel_bo_references(heap->batch->buffer, bo))
+            continue;
+
+        if (drm_intel_bo_busy(bo))
+            continue;
+
+        gen8_gpe_state_heap_remove(slots, i);
+        heap->num_bo_reuses++;
+
+        return bo;
+    }
+
+    bo = dri_bo_alloc(i965->intel.bufmgr, name, size, 4096);
+    assert(bo);
+    heap->num_bo_allocs++;
+
+    return bo;
+}
+
+void
+i965_gpe_state_heap_init(struct i965_gpe_state_heap *heap,
+                         struct intel_batchbuffer *batch)
+{
+    memset(heap, 0, sizeof(*heap));
+    heap->batch = batch;
+}
+
+void
+i965_gpe_state_heap_destroy(struct i965_gpe_state_heap *heap)
+{
+    int i;
+
+    for (i = 0; i < GPE_STATE_HEAP_SLOTS; i++) {
+        dri_bo_unreference(heap->surface_state_bo[i]);
+        heap->surface_state_bo[i] = NULL;
+
+        dri_bo_unreference(heap->dynamic_state_bo[i]);
+        heap->dynamic_state_bo[i] = NULL;
+    }
+
+    heap->batch = NULL;
+}
+
+void
+i965_gpe_context_set_state_heap(struct i965_gpe_context *gpe_contexts,
+                                int num_contexts,
+                                struct i965_gpe_state_heap *heap)
+{
+    int i;
+
+    for (i = 0; i < num_contexts; i++)
+        gpe_contexts[i].state_heap = heap;
+}
+
 void
 gen8_gpe_context_init(VADriverContextP ctx,
                       struct i965_gpe_context *gpe_context)
 {
     struct i965_driver_data *i965 = i965_driver_data(ctx);
+    struct i965_gpe_state_heap *heap = gpe_context->state_heap;
     dri_bo *bo;
     int bo_size;
     unsigned int start_offset, end_offset;
 
-    dri_bo_unreference(gpe_context->surface_state_binding_table.bo);
-    bo = dri_bo_alloc(i965->intel.bufmgr,
-                      "surface state & binding table",
-                      gpe_context->surface_state_binding_table.length,
-                      4096);
-    assert(bo);
+    if (heap) {
+        gen8_gpe_state_heap_put(heap->surface_state_bo,
+                                gpe_context->surface_state_binding_table.bo);
+        bo = gen8_gpe_state_heap_get(ctx,
+                                     heap,
+                                     heap->surface_state_bo,
+                                     "surface state & binding table",
+                                     gpe_context->surface_state_binding_table.length);
+    } else {
+        dri_bo_unreference(gpe_context->surface_state_binding_table.bo);
+        bo = dri_bo_alloc(i965->intel.bufmgr,
+                          "surface state & binding table",
+                          gpe_context->surface_state_binding_table.length,
+                          4096);
+        assert(bo);
+    }
     gpe_context->surface_state_binding_table.bo = bo;
 
     bo_size = gpe_context->idrt.max_entries * ALIGN(gpe_context->idrt.entry_size, 64) +
               ALIGN(gpe_context->curbe.length, 64) +
               gpe_context->sampler.max_entries * ALIGN(gpe_context->sampler.entry_size, 64);
-    dri_bo_unreference(gpe_context->dynamic_state.bo);
-    bo = dri_bo_alloc(i965->intel.bufmgr,
-                      "surface state & binding table",
-                      bo_size,
-                      4096);
-    assert(bo);
+    if (heap) {
+        gen8_gpe_state_heap_put(heap->dynamic_state_bo,
+                                gpe_context->dynamic_state.bo);
+        bo = gen8_gpe_state_heap_get(ctx,
+                                     heap,
+                                     heap->dynamic_state_bo,
+                                     "surface state & binding table",
+                                     bo_size);
+    } else {
+        dri_bo_unreference(gpe_context->dynamic_state.bo);
+        bo = dri_bo_alloc(i965->intel.bufmgr,
+                          "surface state & binding table",
+                          bo_size,
+                          4096);
+        assert(bo);
+    }
     gpe_context->dynamic_state.bo = bo;
     gpe_context->dynamic_state.bo_size = bo_size;
 
@@ -1181,9 +1307,48 @@ gen8_gpe_context_init(VADriverContextP ctx,
 }
 
 
+/*
+ * Keeps the surface state & binding table BO mapped until
+ * i965_gpe_context_unmap_surface_state(), so that resetting the binding
+ * table and adding all the surfaces of a kernel only maps it once
+ */
+void
+i965_gpe_context_map_surface_state(struct i965_gpe_context *gpe_context)
+{
+    assert(!gpe_context->surface_state_binding_table.mapped);
+
+    dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+    gpe_context->surface_state_binding_table.mapped = 1;
+}
+
+void
+i965_gpe_context_unmap_surface_state(struct i965_gpe_context *gpe_context)
+{
+    assert(gpe_context->surface_state_binding_table.mapped);
+
+    dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+    gpe_context->surface_state_binding_table.mapped = 0;
+}
+
+static void
+i965_gpe_surface_state_begin(struct i965_gpe_context *gpe_context)
+{
+    if (!gpe_context->surface_state_binding_table.mapped)
+        dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+}
+
+static void
+i965_gpe_surface_state_end(struct i965_gpe_context *gpe_context)
+{
+    if (!gpe_context->surface_state_binding_table.mapped)
+        dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+}
+
 void
 gen8_gpe_context_destroy(struct i965_gpe_context *gpe_context)
 {
+    gpe_context->state_heap = NULL;
+
     dri_bo_unreference(gpe_context->surface_state_binding_table.bo);
     gpe_context->surface_state_binding_table.bo = NULL;
 
@@ -1386,6 +1551,9 @@ i965_allocate_gpe_resource(dri_bufmgr *bufmgr,
     res->size = size;
     res->bo = dri_bo_alloc(bufmgr, name, res->size, 4096);
     res->map = NULL;
+    res->tiling = I915_TILING_NONE;
+    res->swizzle = I915_BIT_6_SWIZZLE_NONE;
+    res->tiling_valid = 1;
 
     return (res->bo != NULL);
 }
@@ -1395,8 +1563,6 @@ i965_object_surface_to_2d_gpe_resource_with_align(struct i965_gpe_resource *res,
                                                   struct object_surface *obj_surface,
                                                   unsigned int alignment)
 {
-    unsigned int swizzle;
-
     res->type = I965_GPE_RESOURCE_2D;
     res->width = ALIGN(obj_surface->orig_width, (1 << alignment));
     res->height = ALIGN(obj_surface->orig_height, (1 << alignment));
@@ -1409,7 +1575,8 @@ i965_object_surface_to_2d_gpe_resource_with_align(struct i965_gpe_resource *res,
     res->map = NULL;
 
     dri_bo_reference(res->bo);
-    dri_bo_get_tiling(obj_surface->bo, &res->tiling, &swizzle);
+    dri_bo_get_tiling(obj_surface->bo, &res->tiling, &res->swizzle);
+    res->tiling_valid = 1;
 }
 
 void
@@ -1423,8 +1590,6 @@ void
 i965_dri_object_to_buffer_gpe_resource(struct i965_gpe_resource *res,
                                        dri_bo *bo)
 {
-    unsigned int swizzle;
-
     res->type = I965_GPE_RESOURCE_BUFFER;
     res->width = bo->size;
     res->height = 1;
@@ -1434,7 +1599,8 @@ i965_dri_object_to_buffer_gpe_resource(struct i965_gpe_resource *res,
     res->map = NULL;
 
     dri_bo_reference(res->bo);
-    dri_bo_get_tiling(res->bo, &res->tiling, &swizzle);
+    dri_bo_get_tiling(res->bo, &res->tiling, &res->swizzle);
+    res->tiling_valid = 1;
 }
 
 void
@@ -1444,8 +1610,6 @@ i965_dri_object_to_2d_gpe_resource(struct i965_gpe_resource *res,
                                    unsigned int height,
                                    unsigned int pitch)
 {
-    unsigned int swizzle;
-
     res->type = I965_GPE_RESOURCE_2D;
     res->width = width;
     res->height = height;
@@ -1455,7 +1619,20 @@ i965_dri_object_to_2d_gpe_resource(struct i965_gpe_resource *res,
     res->map = NULL;
 
     dri_bo_reference(res->bo);
-    dri_bo_get_tiling(res->bo, &res->tiling, &swizzle);
+    dri_bo_get_tiling(res->bo, &res->tiling, &res->swizzle);
+    res->tiling_valid = 1;
+}
+
+/* Resources filled in by hand don't have their tiling cached yet */
+static unsigned int
+i965_gpe_resource_get_tiling(struct i965_gpe_resource *res)
+{
+    if (!res->tiling_valid) {
+        dri_bo_get_tiling(res->bo, &res->tiling, &res->swizzle);
+        res->tiling_valid = 1;
+    }
+
+    return res->tiling;
 }
 
 void
@@ -1474,6 +1651,7 @@ i965_free_gpe_resource(struct i965_gpe_resource *res)
     dri_bo_unreference(res->bo);
     res->bo = NULL;
     res->map = NULL;
+    res->tiling_valid = 0;
 }
 
 void *
@@ -1706,14 +1884,14 @@ gen9_gpe_reset_binding_table(VADriverContextP ctx,
     unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset;
     int i;
 
-    dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+    i965_gpe_surface_state_begin(gpe_context);
     binding_table = (unsigned int*)((char *)gpe_context->surface_state_binding_table.bo->virtual + binding_table_offset);
 
     for (i = 0; i < gpe_context->surface_state_binding_table.max_entries; i++) {
         *(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset + i * SURFACE_STATE_PADDED_SIZE_GEN9;
     }
 
-    dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+    i965_gpe_surface_state_end(gpe_context);
 }
 
 void
@@ -1900,16 +2078,16 @@ gen9_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
                              int index)
 {
     char *buf;
-    unsigned int tiling, swizzle, width, height, pitch, tile_alignment, y_offset = 0;
+    unsigned int tiling, width, height, pitch, tile_alignment, y_offset = 0;
     unsigned int surface_state_offset = gpe_context->surface_state_binding_table.surface_state_offset +
                                         index * SURFACE_STATE_PADDED_SIZE_GEN9;
     unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset +
                                         index * 4;
     struct i965_gpe_resource *gpe_resource = gpe_surface->gpe_resource;
 
-    dri_bo_get_tiling(gpe_resource->bo, &tiling, &swizzle);
+    tiling = i965_gpe_resource_get_tiling(gpe_resource);
 
-    dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+    i965_gpe_surface_state_begin(gpe_context);
     buf = (char *)gpe_context->surface_state_binding_table.bo->virtual;
     *((unsigned int *)(buf + binding_table_offset)) = surface_state_offset;
 
@@ -2055,7 +2233,7 @@ gen9_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
                           gpe_resource->bo);
     }
 
-    dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+    i965_gpe_surface_state_end(gpe_context);
 }
 
 bool
@@ -2081,6 +2259,9 @@ i965_gpe_allocate_2d_resource(dri_bufmgr *bufmgr,
 
     res->bo = dri_bo_alloc(bufmgr, name, res->size, 4096);
     res->map = NULL;
+    res->tiling = I915_TILING_NONE;
+    res->swizzle = I915_BIT_6_SWIZZLE_NONE;
+    res->tiling_valid = 1;
 
     return true;
 }
@@ -2223,14 +2404,14 @@ gen8_gpe_reset_binding_table(VADriverContextP ctx, struct i965_gpe_context *gpe_
     unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset;
     int i;
 
-    dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+    i965_gpe_surface_state_begin(gpe_context);
     binding_table = (unsigned int*)((char *)gpe_context->surface_state_binding_table.bo->virtual + binding_table_offset);
 
     for (i = 0; i < gpe_context->surface_state_binding_table.max_entries; i++) {
         *(binding_table + i) = gpe_context->surface_state_binding_table.surface_state_offset + i * SURFACE_STATE_PADDED_SIZE_GEN8;
     }
 
-    dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+    i965_gpe_surface_state_end(gpe_context);
 }
 
 static void
@@ -2338,16 +2519,16 @@ gen8_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
                              int index)
 {
     char *buf;
-    unsigned int tiling, swizzle, width, height, pitch, tile_alignment, y_offset = 0;
+    unsigned int tiling, width, height, pitch, tile_alignment, y_offset = 0;
     unsigned int surface_state_offset = gpe_context->surface_state_binding_table.surface_state_offset +
                                         index * SURFACE_STATE_PADDED_SIZE_GEN8;
     unsigned int binding_table_offset = gpe_context->surface_state_binding_table.binding_table_offset +
                                         index * 4;
     struct i965_gpe_resource *gpe_resource = gpe_surface->gpe_resource;
 
-    dri_bo_get_tiling(gpe_resource->bo, &tiling, &swizzle);
+    tiling = i965_gpe_resource_get_tiling(gpe_resource);
 
-    dri_bo_map(gpe_context->surface_state_binding_table.bo, 1);
+    i965_gpe_surface_state_begin(gpe_context);
     buf = (char *)gpe_context->surface_state_binding_table.bo->virtual;
     *((unsigned int *)(buf + binding_table_offset)) = surface_state_offset;
 
@@ -2447,7 +2628,7 @@ gen8_gpe_context_add_surface(struct i965_gpe_context *gpe_context,
                           gpe_resource->bo);
     }
 
-    dri_bo_unmap(gpe_context->surface_state_binding_table.bo);
+    i965_gpe_surface_state_end(gpe_context);
 }
 
 void
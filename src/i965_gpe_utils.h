@@ -35,6 +35,8 @@
 
 #define MAX_GPE_KERNELS    32
 
+#define GPE_STATE_HEAP_SLOTS    32
+
 struct i965_buffer_surface {
     dri_bo *bo;
     unsigned int num_blocks;
@@ -42,6 +44,20 @@ struct i965_buffer_surface {
     unsigned int pitch;
 };
 
+/*
+ * Retired surface state and dynamic state BOs, oldest first, shared by the
+ * GPE contexts of an encoder. gen8_gpe_context_init() recycles one once
+ * the GPU and the batch the contexts are emitted into no longer reference
+ * it, the batch belongs to the encoder and outlives the heap
+ */
+struct i965_gpe_state_heap {
+    dri_bo *surface_state_bo[GPE_STATE_HEAP_SLOTS];
+    dri_bo *dynamic_state_bo[GPE_STATE_HEAP_SLOTS];
+    struct intel_batchbuffer *batch;
+    unsigned int num_bo_allocs;
+    unsigned int num_bo_reuses;
+};
+
 enum {
     I965_GPE_RESOURCE_BUFFER = 0,
     I965_GPE_RESOURCE_2D
@@ -56,6 +72,8 @@ struct i965_gpe_resource {
     uint32_t pitch;
     uint32_t size;
     uint32_t tiling;
+    uint32_t swizzle;
+    uint32_t tiling_valid;      /* tiling and swizzle match bo */
     uint32_t cb_cr_pitch;
     uint32_t x_cb_offset;
     uint32_t y_cb_offset;
@@ -89,6 +107,7 @@ struct i965_gpe_context {
         unsigned int max_entries;
         unsigned int binding_table_offset;
         unsigned int surface_state_offset;
+        unsigned int mapped;            /* kept mapped across surface setup */
     } surface_state_binding_table;
 
     struct {
@@ -179,6 +198,9 @@ struct i965_gpe_context {
         int bo_size;
         unsigned int end_offset;
     } dynamic_state;
+
+    /* NULL allocates new state BOs on every gen8_gpe_context_init() */
+    struct i965_gpe_state_heap *state_heap;
 };
 
 struct gpe_mi_flush_dw_parameter {
@@ -327,6 +349,14 @@ gen8_gpe_context_set_dynamic_buffer(VADriverContextP ctx,
 
 
 void gen8_gpe_context_destroy(struct i965_gpe_context *gpe_context);
+void i965_gpe_state_heap_init(struct i965_gpe_state_heap *heap,
+                              struct intel_batchbuffer *batch);
+void i965_gpe_state_heap_destroy(struct i965_gpe_state_heap *heap);
+void i965_gpe_context_set_state_heap(struct i965_gpe_context *gpe_contexts,
+                                     int num_contexts,
+                                     struct i965_gpe_state_heap *heap);
+void i965_gpe_context_map_surface_state(struct i965_gpe_context *gpe_context);
+void i965_gpe_context_unmap_surface_state(struct i965_gpe_context *gpe_context);
 void gen8_gpe_context_init(VADriverContextP ctx,
                            struct i965_gpe_context *gpe_context);
 
@@ -0,0 +1,421 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "i965_gpe_walker.h"
+
+void
+i965_walker_init_regions(unsigned int walker_degree,
+                         int width,
+                         int height,
+                         int num_regions,
+                         struct gpe_media_object_walker_parameter *walker_param)
+{
+    if (walker_degree == WALKER_26Z_DEGREE) {
+        /* 32x32 blocks, four 16x16 blocks in Z order each */
+        int ts_width = ((width + 3) & 0xfffc) >> 1;
+        int lcu_width = (width + 1) >> 1;
+        int lcu_height = (height + 1) >> 1;
+        int tmp1 = ((lcu_width + 1) >> 1) +
+                   ((lcu_width + ((lcu_height - 1) << 1)) + (2 * num_regions - 1)) /
+                   (2 * num_regions);
+
+        walker_param->scoreboard_mask = 0xFF;
+        walker_param->global_resolution.x = ts_width;
+        walker_param->global_resolution.y = 4 * tmp1;
+        walker_param->global_start.x = 0;
+        walker_param->global_start.y = 0;
+        walker_param->global_outer_loop_stride.x = ts_width;
+        walker_param->global_outer_loop_stride.y = 0;
+        walker_param->global_inner_loop_unit.x = 0;
+        walker_param->global_inner_loop_unit.y = 4 * tmp1;
+        walker_param->block_resolution.x = ts_width;
+        walker_param->block_resolution.y = 4 * tmp1;
+        walker_param->local_start.x = ts_width;
+        walker_param->local_start.y = 0;
+        walker_param->local_end.x = 0;
+        walker_param->local_end.y = 0;
+        walker_param->local_outer_loop_stride.x = 1;
+        walker_param->local_outer_loop_stride.y = 0;
+        walker_param->local_inner_loop_unit.x = -2;
+        walker_param->local_inner_loop_unit.y = 4;
+        walker_param->middle_loop_extra_steps = 3;
+        walker_param->mid_loop_unit_x = 0;
+        walker_param->mid_loop_unit_y = 1;
+        walker_param->global_loop_exec_count = 0;
+        walker_param->local_loop_exec_count = ((lcu_width + (lcu_height - 1) * 2 + 2 * num_regions - 1) /
+                                               (2 * num_regions)) * 2 -
+                                              1;
+    } else {
+        int ts_width = (width + 1) & 0xfffe;
+        int ts_height = (height + 1) & 0xfffe;
+        int tmp1 = ((ts_width + 1) >> 1) +
+                   ((ts_width + ((ts_height - 1) << 1)) +
+                    (2 * num_regions - 1)) / (2 * num_regions);
+
+        walker_param->scoreboard_mask = 0x0f;
+        walker_param->global_resolution.x = ts_width;
+        walker_param->global_resolution.y = tmp1;
+        walker_param->global_start.x = 0;
+        walker_param->global_start.y = 0;
+        walker_param->global_outer_loop_stride.x = ts_width;
+        walker_param->global_outer_loop_stride.y = 0;
+        walker_param->global_inner_loop_unit.x = 0;
+        walker_param->global_inner_loop_unit.y = tmp1;
+        walker_param->block_resolution.x = ts_width;
+        walker_param->block_resolution.y = tmp1;
+        walker_param->local_start.x = ts_width;
+        walker_param->local_start.y = 0;
+        walker_param->local_end.x = 0;
+        walker_param->local_end.y = 0;
+        walker_param->local_outer_loop_stride.x = 1;
+        walker_param->local_outer_loop_stride.y = 0;
+        walker_param->local_inner_loop_unit.x = -2;
+        walker_param->local_inner_loop_unit.y = 1;
+        walker_param->middle_loop_extra_steps = 0;
+        walker_param->mid_loop_unit_x = 0;
+        walker_param->mid_loop_unit_y = 0;
+        walker_param->global_loop_exec_count = 0;
+        walker_param->local_loop_exec_count = (width + (height - 1) * 2 + num_regions - 1) /
+                                              num_regions;
+    }
+}
+
+void
+i965_walker_set_scoreboard(struct i965_gpe_context *gpe_context,
+                           unsigned int walker_degree,
+                           unsigned int mask,
+                           unsigned int enable,
+                           unsigned int type)
+{
+    gpe_context->vfe_desc5.scoreboard0.mask = mask;
+    gpe_context->vfe_desc5.scoreboard0.type = type;
+    gpe_context->vfe_desc5.scoreboard0.enable = enable;
+
+    if (walker_degree == WALKER_26Z_DEGREE) {
+        gpe_context->vfe_desc6.scoreboard1.delta_x0 = -1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y0 = 3;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x1 = -1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y1 = 1;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x2 = -1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y2 = -1;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x3 = 0;
+        gpe_context->vfe_desc6.scoreboard1.delta_y3 = -1;
+
+        gpe_context->vfe_desc7.scoreboard2.delta_x4 = 0;
+        gpe_context->vfe_desc7.scoreboard2.delta_y4 = -2;
+
+        gpe_context->vfe_desc7.scoreboard2.delta_x5 = 0;
+        gpe_context->vfe_desc7.scoreboard2.delta_y5 = -3;
+
+        gpe_context->vfe_desc7.scoreboard2.delta_x6 = 1;
+        gpe_context->vfe_desc7.scoreboard2.delta_y6 = -2;
+
+        gpe_context->vfe_desc7.scoreboard2.delta_x7 = 1;
+        gpe_context->vfe_desc7.scoreboard2.delta_y7 = -3;
+    } else {
+        gpe_context->vfe_desc6.scoreboard1.delta_x0 = -1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y0 = 0;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x1 = -1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y1 = -1;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x2 = 0;
+        gpe_context->vfe_desc6.scoreboard1.delta_y2 = -1;
+
+        gpe_context->vfe_desc6.scoreboard1.delta_x3 = 1;
+        gpe_context->vfe_desc6.scoreboard1.delta_y3 = -1;
+    }
+}
+
+static int
+walker_26_in_slice(struct i965_walker_26_iter *iter, int x, int y)
+{
+    int index;
+
+    if (x < 0 || x >= iter->width)
+        return 0;
+    if (y < 0 || y >= iter->height)
+        return 0;
+
+    index = y * iter->width + x;
+
+    return index >= iter->first && index <= iter->first + iter->num;
+}
+
+enum {
+    WALKER_26_LEFT,                     /* the wavefronts starting on the first row */
+    WALKER_26_RIGHT,                    /* then on the last two columns */
+    WALKER_26_DONE,
+};
+
+static void
+walker_26_right(struct i965_walker_26_iter *iter)
+{
+    iter->state = WALKER_26_RIGHT;
+    iter->x_outer = iter->x_restart;
+    iter->y_outer = iter->first / iter->width;
+
+    if (!walker_26_in_slice(iter, iter->x_outer, iter->y_outer))
+        iter->state = WALKER_26_DONE;
+}
+
+void
+i965_walker_26_begin(struct i965_walker_26_iter *iter,
+                     int width, int height,
+                     int first, int num)
+{
+    iter->width = width;
+    iter->height = height;
+    iter->first = first;
+    iter->num = num;
+    iter->x_outer = first % width;
+    iter->y_outer = first / width;
+    iter->x_restart = MAX(width - 2, 0);
+    iter->state = WALKER_26_LEFT;
+
+    if (iter->x_outer >= width - 2 ||
+        !walker_26_in_slice(iter, iter->x_outer, iter->y_outer))
+        walker_26_right(iter);
+
+    iter->x = iter->x_outer;
+    iter->y = iter->y_outer;
+}
+
+bool
+i965_walker_26_next(struct i965_walker_26_iter *iter, int *x, int *y)
+{
+    while (iter->state != WALKER_26_DONE) {
+        if (walker_26_in_slice(iter, iter->x, iter->y)) {
+            *x = iter->x;
+            *y = iter->y;
+            iter->x -= 2;
+            iter->y += 1;
+
+            return true;
+        }
+
+        /* the wavefront is done, start the next one */
+        iter->x_outer++;
+
+        if (iter->state == WALKER_26_LEFT) {
+            if (iter->x_outer >= iter->width - 2 ||
+                !walker_26_in_slice(iter, iter->x_outer, iter->y_outer))
+                walker_26_right(iter);
+        } else {
+            if (iter->x_outer >= iter->width) {
+                iter->y_outer++;
+                iter->x_outer = iter->x_restart;
+            }
+
+            if (!walker_26_in_slice(iter, iter->x_outer, iter->y_outer))
+                iter->state = WALKER_26_DONE;
+        }
+
+        iter->x = iter->x_outer;
+        iter->y = iter->y_outer;
+    }
+
+    return false;
+}
+
+struct walker_dep {
+    int x, y;
+};
+
+static const struct walker_dep walker_deps_45[] = {
+    { -1, 0 }, { 0, -1 },
+};
+
+static const struct walker_dep walker_deps_26[] = {
+    { -1, 0 }, { -1, -1 }, { 0, -1 }, { 1, -1 },
+};
+
+/*
+ * The Z patterns code the 2x2 groups in raster order and the blocks of a
+ * group in Z order, a block only waits on the neighbours coded before it.
+ */
+static int
+walker_is_z(unsigned int walker_degree)
+{
+    return (walker_degree == WALKER_26Z_DEGREE ||
+            walker_degree == WALKER_45Z_DEGREE);
+}
+
+static int
+walker_rank(unsigned int walker_degree, int width, int x, int y)
+{
+    if (walker_is_z(walker_degree))
+        return ((y >> 1) * ((width + 1) >> 1) + (x >> 1)) * 4 + (y & 1) * 2 + (x & 1);
+
+    return y * width + x;
+}
+
+struct walker_sim {
+    unsigned int walker_degree;
+    int width;
+    int height;
+    int region_height;
+    const struct walker_dep *deps;
+    int num_deps;
+    unsigned int *steps;                /* the step of every block run so far */
+    unsigned int *widths;               /* the blocks of every step */
+};
+
+static void
+walker_sim_block(struct walker_sim *sim, int x, int y)
+{
+    unsigned int step = 0;
+    int i, dx, dy;
+
+    if (x >= sim->width || y >= sim->height)
+        return;
+
+    for (i = 0; i < sim->num_deps; i++) {
+        dx = x + sim->deps[i].x;
+        dy = y + sim->deps[i].y;
+
+        if (dx < 0 || dx >= sim->width || dy < 0 || dy >= sim->height)
+            continue;
+
+        if (dy / sim->region_height != y / sim->region_height)
+            continue;
+
+        if (walker_rank(sim->walker_degree, sim->width, dx, dy) >
+            walker_rank(sim->walker_degree, sim->width, x, y))
+            continue;
+
+        step = MAX(step, sim->steps[dy * sim->width + dx]);
+    }
+
+    sim->steps[y * sim->width + x] = step + 1;
+    sim->widths[step + 1]++;
+}
+
+bool
+i965_walker_simulate(unsigned int walker_degree,
+                     int width,
+                     int height,
+                     int num_regions,
+                     struct i965_walker_stats *stats)
+{
+    struct walker_sim sim;
+    int i, x, y;
+
+    memset(stats, 0, sizeof(*stats));
+
+    if (width <= 0 || height <= 0 || num_regions <= 0)
+        return false;
+
+    sim.walker_degree = walker_degree;
+    sim.width = width;
+    sim.height = height;
+    sim.region_height = (height + num_regions - 1) / num_regions;
+
+    if (walker_is_z(walker_degree))
+        sim.region_height = ALIGN(sim.region_height, 2);
+
+    if (walker_degree == WALKER_45_DEGREE ||
+        walker_degree == WALKER_45Z_DEGREE) {
+        sim.deps = walker_deps_45;
+        sim.num_deps = ARRAY_ELEMS(walker_deps_45);
+    } else {
+        sim.deps = walker_deps_26;
+        sim.num_deps = ARRAY_ELEMS(walker_deps_26);
+    }
+
+    sim.steps = calloc(width * height, sizeof(*sim.steps));
+    sim.widths = calloc(width * height + 1, sizeof(*sim.widths));
+
+    if (!sim.steps || !sim.widths) {
+        free(sim.steps);
+        free(sim.widths);
+        return false;
+    }
+
+    /* in coding order, every block comes after the blocks it waits on */
+    if (walker_is_z(walker_degree)) {
+        for (y = 0; y < height; y += 2) {
+            for (x = 0; x < width; x += 2) {
+                for (i = 0; i < 4; i++)
+                    walker_sim_block(&sim, x + (i & 1), y + (i >> 1));
+            }
+        }
+    } else {
+        for (y = 0; y < height; y++) {
+            for (x = 0; x < width; x++)
+                walker_sim_block(&sim, x, y);
+        }
+    }
+
+    stats->num_blocks = width * height;
+
+    for (i = 1; i <= width * height && sim.widths[i]; i++) {
+        stats->critical_path = i;
+        stats->max_parallel = MAX(stats->max_parallel, sim.widths[i]);
+    }
+
+    free(sim.steps);
+    free(sim.widths);
+
+    return true;
+}
+
+/*
+ * The fewest regions whose widest step fills max_threads, or else the
+ * count with the shortest critical path. Every region costs the blocks
+ * on its first row their dependencies on the region above.
+ */
+int
+i965_walker_best_num_regions(unsigned int walker_degree,
+                             int width,
+                             int height,
+                             unsigned int max_threads,
+                             int max_regions)
+{
+    struct i965_walker_stats stats;
+    unsigned int best_path = ~0u;
+    int best = 1;
+    int n;
+
+    for (n = 1; n <= max_regions && n <= height; n++) {
+        if (!i965_walker_simulate(walker_degree, width, height, n, &stats))
+            break;
+
+        if (stats.critical_path < best_path) {
+            best_path = stats.critical_path;
+            best = n;
+        }
+
+        if (stats.max_parallel >= max_threads)
+            break;
+    }
+
+    return best;
+}
@@ -0,0 +1,111 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _I965_GPE_WALKER_H_
+#define _I965_GPE_WALKER_H_
+
+#include <stdbool.h>
+
+#include "i965_drv_video.h"
+#include "i965_gpe_utils.h"
+
+/*
+ * The dependency patterns of the kernels that walk a frame in wavefronts,
+ * in enum walker_degree, and what the walker and the scoreboard are set to
+ * for them.
+ *
+ * A frame can also be walked as several regions at once, every region
+ * starting its own wavefront. The kernel is given the region starts and
+ * no block waits on a block of another region.
+ */
+
+/*
+ * The MEDIA_OBJECT_WALKER of a 26 or 26Z degree walk of a frame of
+ * width x height 16x16 blocks split into num_regions regions. Only the
+ * walk itself is set, not the kernel or its inline data.
+ */
+void
+i965_walker_init_regions(unsigned int walker_degree,
+                         int width,
+                         int height,
+                         int num_regions,
+                         struct gpe_media_object_walker_parameter *walker_param);
+
+/* The scoreboard deltas of a 26 or 26Z degree walk */
+void
+i965_walker_set_scoreboard(struct i965_gpe_context *gpe_context,
+                           unsigned int walker_degree,
+                           unsigned int mask,
+                           unsigned int enable,
+                           unsigned int type);
+
+/*
+ * The 26 degree order of the blocks of a slice, for the kernels that are
+ * fed one MEDIA_OBJECT per block instead of a walker: the blocks of a
+ * wavefront go from the top right to the bottom left.
+ */
+struct i965_walker_26_iter {
+    int width;
+    int height;
+    int first;                          /* the first block of the slice */
+    int num;
+    int x_outer, y_outer;               /* the start of the wavefront */
+    int x, y;                           /* the next block of the wavefront */
+    int x_restart;
+    int state;
+};
+
+void
+i965_walker_26_begin(struct i965_walker_26_iter *iter,
+                     int width, int height,
+                     int first, int num);
+
+bool
+i965_walker_26_next(struct i965_walker_26_iter *iter, int *x, int *y);
+
+/*
+ * A walk simulated on the CPU, every block running one step after the
+ * last block it waits on, with as many threads as blocks.
+ */
+struct i965_walker_stats {
+    unsigned int num_blocks;
+    unsigned int critical_path;         /* steps to the last block */
+    unsigned int max_parallel;          /* the blocks of the widest step */
+};
+
+bool
+i965_walker_simulate(unsigned int walker_degree,
+                     int width,
+                     int height,
+                     int num_regions,
+                     struct i965_walker_stats *stats);
+
+int
+i965_walker_best_num_regions(unsigned int walker_degree,
+                             int width,
+                             int height,
+                             unsigned int max_threads,
+                             int max_regions);
+
+#endif /* _I965_GPE_WALKER_H_ */
@@ -1169,6 +1169,31 @@ pp_dndi_frame_store_clear(DNDIFrameStore *fs, VADriverContextP ctx)
     pp_dndi_frame_store_reset(fs);
 }
 
+/* The scratch frame store is kept at the largest resolution seen so far,
+   bounded by VPP_FRAME_STORE_MAX_{WIDTH,HEIGHT}, so that streams switching
+   resolution back and forth don't tear it down on every switch. Returns
+   true when the scratch surfaces need to be (re)allocated with the
+   updated geometry */
+bool
+vpp_frame_store_geometry_update(struct vpp_frame_store_geometry *geometry,
+                                int width, int height)
+{
+    int new_width, new_height;
+
+    new_width = MAX(width, MIN(geometry->width, VPP_FRAME_STORE_MAX_WIDTH));
+    new_height = MAX(height, MIN(geometry->height, VPP_FRAME_STORE_MAX_HEIGHT));
+
+    if (new_width == geometry->width && new_height == geometry->height)
+        return false;
+
+    if (geometry->width > 0 && geometry->height > 0)
+        geometry->num_reallocs++;
+
+    geometry->width = new_width;
+    geometry->height = new_height;
+    return true;
+}
+
 static void
 pp_dndi_context_init(struct pp_dndi_context *dndi_ctx)
 {
@@ -1291,11 +1316,20 @@ pp_dndi_context_ensure_surfaces_storage(VADriverContextP ctx,
             return status;
     }
 
+    /* Grow the scratch surfaces to the largest resolution seen so far */
+    if (vpp_frame_store_geometry_update(&dndi_ctx->frame_store_geometry,
+                                        MAX(src_surface->orig_width, dst_surface->orig_width),
+                                        MAX(src_surface->orig_height, dst_surface->orig_height))) {
+        for (i = 0; i < ARRAY_ELEMS(dndi_ctx->frame_store); i++) {
+            if (dndi_ctx->frame_store[i].is_scratch_surface)
+                pp_dndi_frame_store_clear(&dndi_ctx->frame_store[i], ctx);
+        }
+    }
+
     /* Create pipeline surfaces */
     for (i = 0; i < ARRAY_ELEMS(dndi_ctx->frame_store); i ++) {
         struct object_surface *obj_surface;
         VASurfaceID new_surface;
-        unsigned int width, height;
 
         if (dndi_ctx->frame_store[i].obj_surface &&
             dndi_ctx->frame_store[i].obj_surface->bo)
@@ -1305,16 +1339,10 @@ pp_dndi_context_ensure_surfaces_storage(VADriverContextP ctx,
             obj_surface = dndi_ctx->frame_store[i].obj_surface;
             dndi_ctx->frame_store[i].is_scratch_surface = 0;
         } else {
-            if (i <= DNDI_FRAME_IN_STMM) {
-                width = src_surface->orig_width;
-                height = src_surface->orig_height;
-            } else {
-                width = dst_surface->orig_width;
-                height = dst_surface->orig_height;
-            }
-
-            status = i965_CreateSurfaces(ctx, width, height, VA_RT_FORMAT_YUV420,
-                                         1, &new_surface);
+            status = i965_CreateSurfaces(ctx,
+                                         dndi_ctx->frame_store_geometry.width,
+                                         dndi_ctx->frame_store_geometry.height,
+                                         VA_RT_FORMAT_YUV420, 1, &new_surface);
             if (status != VA_STATUS_SUCCESS)
                 return status;
 
@@ -5623,6 +5651,10 @@ i965_post_processing_context_finalize(VADriverContextP ctx,
         pp_dndi_frame_store_clear(&pp_context->pp_dndi_context.frame_store[i],
                                   ctx);
 
+    if (pp_context->pp_dndi_context.frame_store_geometry.num_reallocs)
+        i965_log_info(ctx, "DNDI: %u frame store reallocations\n",
+                      pp_context->pp_dndi_context.frame_store_geometry.num_reallocs);
+
     dri_bo_unreference(pp_context->pp_dn_context.stmm_bo);
     pp_context->pp_dn_context.stmm_bo = NULL;
 
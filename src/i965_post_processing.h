@@ -106,10 +106,22 @@ typedef struct dndi_frame_store {
     unsigned int is_scratch_surface : 1;
 } DNDIFrameStore;
 
+/* Upper bound of the resolution the scratch frame store is kept at */
+#define VPP_FRAME_STORE_MAX_WIDTH       4096
+#define VPP_FRAME_STORE_MAX_HEIGHT      4096
+
+/* Geometry of the internal (scratch) frame store surfaces */
+struct vpp_frame_store_geometry {
+    int width;
+    int height;
+    unsigned int num_reallocs;
+};
+
 struct pp_dndi_context {
     int dest_w;
     int dest_h;
     DNDIFrameStore frame_store[DNDI_FRAME_STORE_COUNT];
+    struct vpp_frame_store_geometry frame_store_geometry;
 
     /* Temporary flags live until the current picture is processed */
     unsigned int is_di_enabled          : 1;
@@ -646,4 +658,8 @@ i965_proc_picture(VADriverContextP ctx,
 int
 pp_get_surface_fourcc(VADriverContextP ctx, const struct i965_surface *surface);
 
+bool
+vpp_frame_store_geometry_update(struct vpp_frame_store_geometry *geometry,
+                                int width, int height);
+
 #endif /* __I965_POST_PROCESSING_H__ */
@@ -0,0 +1,231 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/utsname.h>
+
+#include "intel_caps_cache.h"
+
+struct intel_caps_file {
+    int version;
+    struct intel_caps_key key;
+    struct intel_caps caps;
+};
+
+#define CAPS_INT(name, member)                                          \
+    { name, offsetof(struct intel_caps_file, member), 0 }
+#define CAPS_STR(name, member)                                          \
+    { name, offsetof(struct intel_caps_file, member),                   \
+      sizeof(((struct intel_caps_file *)0)->member) }
+
+/* One line per field, "name=value" */
+static const struct {
+    const char *name;
+    size_t offset;
+    size_t size;                        /* 0 for an int */
+} caps_fields[] = {
+    CAPS_INT("version", version),
+    CAPS_INT("device_id", key.device_id),
+    CAPS_INT("revision", key.revision),
+    CAPS_STR("kernel", key.kernel),
+    CAPS_STR("boot_id", key.boot_id),
+    CAPS_INT("has_exec2", caps.has_exec2),
+    CAPS_INT("has_bsd", caps.has_bsd),
+    CAPS_INT("has_blt", caps.has_blt),
+    CAPS_INT("has_vebox", caps.has_vebox),
+    CAPS_INT("has_bsd2", caps.has_bsd2),
+    CAPS_INT("has_huc", caps.has_huc),
+    CAPS_INT("eu_total", caps.eu_total),
+    CAPS_STR("cpu_model", caps.cpu_model),
+};
+
+#define NUM_CAPS_FIELDS (sizeof(caps_fields) / sizeof(caps_fields[0]))
+
+void
+intel_caps_cache_get_key(int device_id, int revision,
+                         struct intel_caps_key *key)
+{
+    struct utsname uts;
+    FILE *fp;
+
+    memset(key, 0, sizeof(*key));
+    key->device_id = device_id;
+    key->revision = revision;
+
+    if (uname(&uts) == 0)
+        snprintf(key->kernel, sizeof(key->kernel), "%s %s",
+                 uts.release, uts.version);
+
+    fp = fopen("/proc/sys/kernel/random/boot_id", "r");
+
+    if (fp) {
+        if (fgets(key->boot_id, sizeof(key->boot_id), fp))
+            key->boot_id[strcspn(key->boot_id, "\n")] = '\0';
+        else
+            key->boot_id[0] = '\0';
+
+        fclose(fp);
+    }
+}
+
+static bool
+intel_caps_cache_parse(FILE *fp, struct intel_caps_file *file)
+{
+    uint32_t seen = 0;
+    char line[256];
+    char *value, *end;
+    size_t len;
+    int i;
+
+    while (fgets(line, sizeof(line), fp)) {
+        value = strchr(line, '=');
+        len = strlen(line);
+
+        /* a line cut short, by its length or a partial write */
+        if (!value || line[len - 1] != '\n')
+            return false;
+
+        *value++ = '\0';
+        line[len - 1] = '\0';
+
+        for (i = 0; i < NUM_CAPS_FIELDS; i++) {
+            if (!strcmp(line, caps_fields[i].name))
+                break;
+        }
+
+        if (i == NUM_CAPS_FIELDS || (seen & (1 << i)))
+            return false;
+
+        if (caps_fields[i].size) {
+            if (strlen(value) >= caps_fields[i].size)
+                return false;
+
+            strcpy((char *)file + caps_fields[i].offset, value);
+        } else {
+            *(int *)((char *)file + caps_fields[i].offset) = strtol(value, &end, 0);
+
+            if (end == value || *end != '\0')
+                return false;
+        }
+
+        seen |= (1 << i);
+    }
+
+    return seen == (1 << NUM_CAPS_FIELDS) - 1;
+}
+
+bool
+intel_caps_cache_load(const char *path,
+                      const struct intel_caps_key *key,
+                      struct intel_caps *caps)
+{
+    struct intel_caps_file file;
+    bool valid;
+    FILE *fp;
+
+    fp = fopen(path, "r");
+
+    if (!fp)
+        return false;
+
+    memset(&file, 0, sizeof(file));
+    valid = intel_caps_cache_parse(fp, &file);
+    fclose(fp);
+
+    if (!valid ||
+        file.version != INTEL_CAPS_CACHE_VERSION ||
+        file.key.device_id != key->device_id ||
+        file.key.revision != key->revision ||
+        strcmp(file.key.kernel, key->kernel) ||
+        strcmp(file.key.boot_id, key->boot_id))
+        return false;
+
+    *caps = file.caps;
+
+    return true;
+}
+
+/*
+ * The file is written aside and renamed over the cache, a process
+ * initializing at the same time reads either file whole.
+ */
+bool
+intel_caps_cache_store(const char *path,
+                       const struct intel_caps_key *key,
+                       const struct intel_caps *caps)
+{
+    struct intel_caps_file file;
+    char tmp_path[4096];
+    const char *value;
+    int i, ret;
+    FILE *fp;
+
+    file.version = INTEL_CAPS_CACHE_VERSION;
+    file.key = *key;
+    file.caps = *caps;
+
+    ret = snprintf(tmp_path, sizeof(tmp_path), "%s.%d", path, (int)getpid());
+
+    if (ret < 0 || ret >= sizeof(tmp_path))
+        return false;
+
+    fp = fopen(tmp_path, "w");
+
+    if (!fp)
+        return false;
+
+    for (i = 0; i < NUM_CAPS_FIELDS; i++) {
+        value = (const char *)&file + caps_fields[i].offset;
+
+        if (caps_fields[i].size) {
+            if (strchr(value, '\n'))
+                break;
+
+            fprintf(fp, "%s=%s\n", caps_fields[i].name, value);
+        } else
+            fprintf(fp, "%s=%d\n", caps_fields[i].name, *(const int *)value);
+    }
+
+    ret = ferror(fp);
+
+    if (fclose(fp))
+        ret = -1;
+
+    if (ret || i < NUM_CAPS_FIELDS) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    if (rename(tmp_path, path)) {
+        unlink(tmp_path);
+        return false;
+    }
+
+    return true;
+}
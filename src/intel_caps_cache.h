@@ -0,0 +1,72 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_CAPS_CACHE_H_
+#define _INTEL_CAPS_CACHE_H_
+
+#include <stdbool.h>
+
+#define INTEL_CAPS_CACHE_VERSION        1
+
+/*
+ * A cache of the device capabilities probed at init, for the processes
+ * that initialize the driver many times over. It is a small text file
+ * selected with VA_INTEL_CAPS_CACHE=<path>, written on a miss and read
+ * back by the next init on the same device and kernel.
+ */
+
+/* What the capabilities were probed on, a file for another key is a miss */
+struct intel_caps_key {
+    int device_id;
+    int revision;
+    char kernel[160];                   /* uname release and version */
+    char boot_id[40];                   /* the firmware is loaded per boot */
+};
+
+struct intel_caps {
+    int has_exec2;
+    int has_bsd;
+    int has_blt;
+    int has_vebox;
+    int has_bsd2;
+    int has_huc;
+    int eu_total;
+    char cpu_model[49];                 /* the CPUID brand string, empty if unknown */
+};
+
+void
+intel_caps_cache_get_key(int device_id, int revision,
+                         struct intel_caps_key *key);
+
+bool
+intel_caps_cache_load(const char *path,
+                      const struct intel_caps_key *key,
+                      struct intel_caps *caps);
+
+bool
+intel_caps_cache_store(const char *path,
+                       const struct intel_caps_key *key,
+                       const struct intel_caps *caps);
+
+#endif /* _INTEL_CAPS_CACHE_H_ */
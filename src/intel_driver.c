@@ -29,11 +29,14 @@
 
 #include "sysdeps.h"
 
+#include <cpuid.h>
+#include <errno.h>
 #include <va/va_drmcommon.h>
 
 #include "intel_batchbuffer.h"
 #include "intel_memman.h"
 #include "intel_driver.h"
+#include "intel_caps_cache.h"
 uint32_t g_intel_debug_option_flags = 0;
 
 #ifdef I915_PARAM_HAS_BSD2
@@ -61,6 +64,24 @@ intel_driver_get_param(struct intel_driver_data *intel, int param, int *value)
 {
     struct drm_i915_getparam gp;
 
+    if (intel->null_hw) {
+        switch (param) {
+        case I915_PARAM_HAS_EXECBUF2:
+        case I915_PARAM_HAS_BSD:
+        case I915_PARAM_HAS_BLT:
+        case I915_PARAM_HAS_VEBOX:
+            *value = 1;
+            return True;
+
+        case LOCAL_I915_PARAM_HAS_BSD2:
+            *value = (intel->device_info->gt >= 3);
+            return True;
+
+        default:
+            return False;
+        }
+    }
+
     gp.param = param;
     gp.value = value;
 
@@ -88,6 +109,72 @@ static void intel_driver_get_revid(struct intel_driver_data *intel, int *value)
     return;
 }
 
+static void cpuid(unsigned int op,
+                  uint32_t *eax, uint32_t *ebx,
+                  uint32_t *ecx, uint32_t *edx)
+{
+    __cpuid_count(op, 0, *eax, *ebx, *ecx, *edx);
+}
+
+/*
+ * This function doesn't check the length. And the caller should
+ * assure that the length of input string should be greater than 48.
+ */
+static int intel_driver_detect_cpustring(char *model_id)
+{
+    uint32_t *rdata;
+
+    if (model_id == NULL)
+        return -EINVAL;
+
+    rdata = (uint32_t *)model_id;
+
+    /* obtain the max supported extended CPUID info */
+    cpuid(0x80000000, &rdata[0], &rdata[1], &rdata[2], &rdata[3]);
+
+    /* If the max extended CPUID info is less than 0x80000004, fail */
+    if (rdata[0] < 0x80000004)
+        return -EINVAL;
+
+    /* obtain the CPUID string */
+    cpuid(0x80000002, &rdata[0], &rdata[1], &rdata[2], &rdata[3]);
+    cpuid(0x80000003, &rdata[4], &rdata[5], &rdata[6], &rdata[7]);
+    cpuid(0x80000004, &rdata[8], &rdata[9], &rdata[10], &rdata[11]);
+
+    *(model_id + 48) = '\0';
+    return 0;
+}
+
+/* The capabilities of the kernel, the device and the CPU, skipped on a cache hit */
+static void
+intel_driver_probe_caps(struct intel_driver_data *intel, struct intel_caps *caps)
+{
+    int ret_value = 0;
+
+    memset(caps, 0, sizeof(*caps));
+
+    if (intel_driver_get_param(intel, I915_PARAM_HAS_EXECBUF2, &ret_value))
+        caps->has_exec2 = !!ret_value;
+    if (intel_driver_get_param(intel, I915_PARAM_HAS_BSD, &ret_value))
+        caps->has_bsd = !!ret_value;
+    if (intel_driver_get_param(intel, I915_PARAM_HAS_BLT, &ret_value))
+        caps->has_blt = !!ret_value;
+    if (intel_driver_get_param(intel, I915_PARAM_HAS_VEBOX, &ret_value))
+        caps->has_vebox = !!ret_value;
+    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_BSD2, &ret_value))
+        caps->has_bsd2 = !!ret_value;
+
+    ret_value = 0;
+
+    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_HUC, &ret_value))
+        caps->has_huc = !!ret_value;
+    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_EU_TOTAL, &ret_value))
+        caps->eu_total = ret_value;
+
+    if (intel_driver_detect_cpustring(caps->cpu_model))
+        memset(caps->cpu_model, 0, sizeof(caps->cpu_model));
+}
+
 extern const struct intel_device_info *i965_get_device_info(int devid);
 
 bool
@@ -95,9 +182,10 @@ intel_driver_init(VADriverContextP ctx)
 {
     struct intel_driver_data *intel = intel_driver_data(ctx);
     struct drm_state * const drm_state = (struct drm_state *)ctx->drm_state;
-    int has_exec2 = 0, has_bsd = 0, has_blt = 0, has_vebox = 0;
+    struct intel_caps_key caps_key;
+    struct intel_caps caps;
+    char *caps_path = NULL;
     char *env_str = NULL;
-    int ret_value = 0;
 
     g_intel_debug_option_flags = 0;
     if ((env_str = getenv("VA_INTEL_DEBUG")))
@@ -106,15 +194,27 @@ intel_driver_init(VADriverContextP ctx)
     if (g_intel_debug_option_flags)
         fprintf(stderr, "g_intel_debug_option_flags:%x\n", g_intel_debug_option_flags);
 
-    ASSERT_RET(drm_state, false);
-    ASSERT_RET((VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_DRI1) ||
+    intel->null_hw = 0;
+    if ((env_str = getenv("VA_INTEL_NULL_HW"))) {
+        intel->null_hw = 1;
+        intel->fd = -1;
+        intel->dri2Enabled = 1;
+        intel->device_id = strtol(env_str, NULL, 0);
+        fprintf(stderr, "VA_INTEL_NULL_HW: no device, faking PCI id 0x%04x\n", intel->device_id);
+    }
+
+    ASSERT_RET(intel->null_hw || drm_state, false);
+    ASSERT_RET(intel->null_hw ||
+               (VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_DRI1) ||
                 VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_DRI2) ||
                 VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_CUSTOM)),
                false);
 
-    intel->fd = drm_state->fd;
-    intel->dri2Enabled = (VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_DRI2) ||
-                          VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_CUSTOM));
+    if (!intel->null_hw) {
+        intel->fd = drm_state->fd;
+        intel->dri2Enabled = (VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_DRI2) ||
+                              VA_CHECK_DRM_AUTH_TYPE(ctx, VA_DRM_AUTH_CUSTOM));
+    }
 
     if (!intel->dri2Enabled) {
         return false;
@@ -132,39 +232,52 @@ intel_driver_init(VADriverContextP ctx)
     if (!intel->device_info)
         return false;
 
-    if (intel_driver_get_param(intel, I915_PARAM_HAS_EXECBUF2, &has_exec2))
-        intel->has_exec2 = has_exec2;
-    if (intel_driver_get_param(intel, I915_PARAM_HAS_BSD, &has_bsd))
-        intel->has_bsd = has_bsd;
-    if (intel_driver_get_param(intel, I915_PARAM_HAS_BLT, &has_blt))
-        intel->has_blt = has_blt;
-    if (intel_driver_get_param(intel, I915_PARAM_HAS_VEBOX, &has_vebox))
-        intel->has_vebox = !!has_vebox;
-
-    intel->has_bsd2 = 0;
-    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_BSD2, &ret_value))
-        intel->has_bsd2 = !!ret_value;
-
-    intel->has_huc = 0;
-    ret_value = 0;
+    if (intel->null_hw)
+        intel->revision = 2;
+    else
+        intel_driver_get_revid(intel, &intel->revision);
+
+    /* the caps of VA_INTEL_NULL_HW are made up, they would end up under
+     * the key of the real device */
+    intel->caps_from_cache = 0;
+    if (!intel->null_hw && (caps_path = getenv("VA_INTEL_CAPS_CACHE"))) {
+        intel_caps_cache_get_key(intel->device_id, intel->revision, &caps_key);
+        intel->caps_from_cache = intel_caps_cache_load(caps_path, &caps_key, &caps);
+    }
 
-    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_HAS_HUC, &ret_value))
-        intel->has_huc = !!ret_value;
+    if (!intel->caps_from_cache) {
+        intel_driver_probe_caps(intel, &caps);
 
-    intel->eu_total = 0;
-    if (intel_driver_get_param(intel, LOCAL_I915_PARAM_EU_TOTAL, &ret_value)) {
-        intel->eu_total = ret_value;
+        /* not fatal, the next init probes again */
+        if (caps_path)
+            intel_caps_cache_store(caps_path, &caps_key, &caps);
     }
 
+    intel->has_exec2 = !!caps.has_exec2;
+    intel->has_bsd = !!caps.has_bsd;
+    intel->has_blt = !!caps.has_blt;
+    intel->has_vebox = !!caps.has_vebox;
+    intel->has_bsd2 = !!caps.has_bsd2;
+    intel->has_huc = !!caps.has_huc;
+    intel->eu_total = caps.eu_total;
+    memcpy(intel->cpu_model, caps.cpu_model, sizeof(intel->cpu_model));
+
     intel->mocs_state = 0;
 
+    intel->enc_scene_analysis = 0;
+    if ((env_str = getenv("VA_INTEL_ENC_SCENE_ANALYSIS")))
+        intel->enc_scene_analysis = atoi(env_str);
+
+    intel->enc_brc_stats = 0;
+    if ((env_str = getenv("VA_INTEL_ENC_BRC_STATS")))
+        intel->enc_brc_stats = atoi(env_str);
+
 #define GEN9_PTE_CACHE    2
 
     if (IS_GEN9(intel->device_info) ||
         IS_GEN10(intel->device_info))
         intel->mocs_state = GEN9_PTE_CACHE;
 
-    intel_driver_get_revid(intel, &intel->revision);
     return true;
 }
 
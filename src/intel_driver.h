@@ -9,6 +9,7 @@
 #include <drm.h>
 #include <i915_drm.h>
 #include <intel_bufmgr.h>
+#include "intel_null_hw.h"
 
 #include <va/va_backend.h>
 #include "va_backend_compat.h"
@@ -177,6 +178,7 @@ struct intel_driver_data {
     int revision;
 
     int dri2Enabled;
+    int null_hw;                /* VA_INTEL_NULL_HW: no device, see intel_null_hw.h */
 
     sigset_t sa_mask;
     pthread_mutex_t ctxmutex;
@@ -192,9 +194,14 @@ struct intel_driver_data {
     unsigned int has_huc    : 1; /* Flag: has a fully loaded HuC firmware? */
 
     int eu_total;
+    char cpu_model[49];         /* the CPUID brand string, empty if unknown */
+    int caps_from_cache;        /* VA_INTEL_CAPS_CACHE: the above were not probed */
 
     const struct intel_device_info *device_info;
     unsigned int mocs_state;
+
+    int enc_scene_analysis; /* VA_INTEL_ENC_SCENE_ANALYSIS: 1 reports scene hints, 2 adapts the coding too */
+    int enc_brc_stats;      /* VA_INTEL_ENC_BRC_STATS: append the rate control statistics to the coded buffers */
 };
 
 bool intel_driver_init(VADriverContextP ctx);
@@ -31,6 +31,8 @@
 #include <va/va.h>
 #include <intel_bufmgr.h>
 
+struct i965_dmv_pool;
+
 typedef struct gen_codec_surface GenCodecSurface;
 
 struct gen_codec_surface {
@@ -43,6 +45,7 @@ struct gen_avc_surface {
     dri_bo *dmv_top;
     dri_bo *dmv_bottom;
     int dmv_bottom_flag;
+    struct i965_dmv_pool *dmv_pool;     /* where the DMVs go back, NULL if not pooled */
 };
 
 extern void gen_free_avc_surface(void **data);
@@ -54,6 +57,7 @@ typedef struct gen_hevc_surface GenHevcSurface;
 struct gen_hevc_surface {
     GenCodecSurface base;
     dri_bo *motion_vector_temporal_bo;
+    struct i965_dmv_pool *dmv_pool;     /* idem for motion_vector_temporal_bo */
     //Encoding HEVC10:internal surface keep for P010->NV12 , this is only for hevc10 to save the P010->NV12
     struct object_surface *nv12_surface_obj;
     VASurfaceID nv12_surface_id;
@@ -31,32 +31,32 @@
 #include "intel_media.h"
 #include "i965_drv_video.h"
 
-static pthread_mutex_t free_avc_surface_lock = PTHREAD_MUTEX_INITIALIZER;
+/*
+ * The private data of a surface is taken out of it atomically, only the
+ * caller getting it frees it.
+ */
+static void *
+gen_take_surface_data(void **data)
+{
+    return __atomic_exchange_n(data, NULL, __ATOMIC_ACQ_REL);
+}
 
 void
 gen_free_avc_surface(void **data)
 {
     GenAvcSurface *avc_surface;
 
-    pthread_mutex_lock(&free_avc_surface_lock);
-
-    avc_surface = *data;
+    avc_surface = gen_take_surface_data(data);
 
-    if (!avc_surface) {
-        pthread_mutex_unlock(&free_avc_surface_lock);
+    if (!avc_surface)
         return;
-    }
-
 
-    dri_bo_unreference(avc_surface->dmv_top);
+    i965_dmv_pool_put(avc_surface->dmv_pool, avc_surface->dmv_top);
     avc_surface->dmv_top = NULL;
-    dri_bo_unreference(avc_surface->dmv_bottom);
+    i965_dmv_pool_put(avc_surface->dmv_pool, avc_surface->dmv_bottom);
     avc_surface->dmv_bottom = NULL;
 
     free(avc_surface);
-    *data = NULL;
-
-    pthread_mutex_unlock(&free_avc_surface_lock);
 }
 
 /* This is to convert one float to the given format interger.
@@ -83,23 +83,17 @@ int intel_format_convert(float src, int out_int_bits, int out_frac_bits, int out
     return output_value;
 }
 
-static pthread_mutex_t free_hevc_surface_lock = PTHREAD_MUTEX_INITIALIZER;
-
 void
 gen_free_hevc_surface(void **data)
 {
     GenHevcSurface *hevc_surface;
 
-    pthread_mutex_lock(&free_hevc_surface_lock);
+    hevc_surface = gen_take_surface_data(data);
 
-    hevc_surface = *data;
-
-    if (!hevc_surface) {
-        pthread_mutex_unlock(&free_hevc_surface_lock);
+    if (!hevc_surface)
         return;
-    }
 
-    dri_bo_unreference(hevc_surface->motion_vector_temporal_bo);
+    i965_dmv_pool_put(hevc_surface->dmv_pool, hevc_surface->motion_vector_temporal_bo);
     hevc_surface->motion_vector_temporal_bo = NULL;
 
     if (hevc_surface->nv12_surface_obj) {
@@ -109,30 +103,18 @@ gen_free_hevc_surface(void **data)
     }
 
     free(hevc_surface);
-    *data = NULL;
-
-    pthread_mutex_unlock(&free_hevc_surface_lock);
 }
 
-static pthread_mutex_t free_vp9_surface_lock = PTHREAD_MUTEX_INITIALIZER;
-
 void gen_free_vp9_surface(void **data)
 {
     GenVP9Surface *vp9_surface;
 
-    pthread_mutex_lock(&free_vp9_surface_lock);
+    vp9_surface = gen_take_surface_data(data);
 
-    vp9_surface = *data;
-
-    if (!vp9_surface) {
-        pthread_mutex_unlock(&free_vp9_surface_lock);
+    if (!vp9_surface)
         return;
-    }
 
     free(vp9_surface);
-    *data = NULL;
-
-    pthread_mutex_unlock(&free_vp9_surface_lock);
 }
 
 extern VAStatus
@@ -34,7 +34,10 @@
 Bool
 intel_memman_init(struct intel_driver_data *intel)
 {
-    intel->bufmgr = intel_bufmgr_gem_init(intel->fd, BATCH_SIZE);
+    if (intel->null_hw)
+        intel->bufmgr = intel_null_hw_bufmgr_init(intel->device_id);
+    else
+        intel->bufmgr = intel_bufmgr_gem_init(intel->fd, BATCH_SIZE);
 
     if (!intel->bufmgr)
         return False;
@@ -0,0 +1,555 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include <drm.h>
+#include <i915_drm.h>
+
+#define INTEL_NULL_HW_NO_REDIRECT
+#include "intel_null_hw.h"
+
+#define NULL_HW_PAGE_SIZE       4096
+#define NULL_HW_ALIGN(v, a)     (((v) + (a) - 1) & ~((unsigned long)(a) - 1))
+
+struct intel_null_hw_bufmgr {
+    int device_id;
+    uint64_t next_offset;               /* the fake GPU address of the next BO */
+    int next_handle;
+    pthread_mutex_t mutex;
+
+    struct intel_null_hw_bufmgr *next;
+};
+
+struct intel_null_hw_bo {
+    drm_intel_bo base;
+
+    int refcount;
+    int map_count;
+    uint32_t tiling_mode;
+    void *mem;
+
+    /* the targets of the relocations, referenced as by libdrm */
+    drm_intel_bo **reloc_targets;
+    int num_relocs;
+    int max_relocs;
+};
+
+static struct intel_null_hw_stats intel_null_hw_stats;
+
+static intel_null_hw_exec_hook intel_null_hw_exec_hook_func;
+static void *intel_null_hw_exec_hook_data;
+
+/*
+ * The null buffer managers of the process, usually none or one. The list
+ * only changes at init and terminate.
+ */
+static struct intel_null_hw_bufmgr *intel_null_hw_bufmgrs;
+static pthread_mutex_t intel_null_hw_bufmgrs_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+int
+intel_null_hw_bufmgr_is_null(dri_bufmgr *bufmgr)
+{
+    struct intel_null_hw_bufmgr *null_bufmgr;
+
+    for (null_bufmgr = intel_null_hw_bufmgrs; null_bufmgr; null_bufmgr = null_bufmgr->next) {
+        if ((dri_bufmgr *)null_bufmgr == bufmgr)
+            return 1;
+    }
+
+    return 0;
+}
+
+static int
+intel_null_hw_bo_is_null(drm_intel_bo *bo)
+{
+    return bo && intel_null_hw_bufmgrs && intel_null_hw_bufmgr_is_null(bo->bufmgr);
+}
+
+dri_bufmgr *
+intel_null_hw_bufmgr_init(int device_id)
+{
+    struct intel_null_hw_bufmgr *null_bufmgr;
+
+    null_bufmgr = calloc(1, sizeof(*null_bufmgr));
+
+    if (!null_bufmgr)
+        return NULL;
+
+    null_bufmgr->device_id = device_id;
+    null_bufmgr->next_offset = NULL_HW_PAGE_SIZE;
+    pthread_mutex_init(&null_bufmgr->mutex, NULL);
+
+    pthread_mutex_lock(&intel_null_hw_bufmgrs_mutex);
+    null_bufmgr->next = intel_null_hw_bufmgrs;
+    intel_null_hw_bufmgrs = null_bufmgr;
+    pthread_mutex_unlock(&intel_null_hw_bufmgrs_mutex);
+
+    return (dri_bufmgr *)null_bufmgr;
+}
+
+void
+intel_null_hw_bufmgr_destroy(drm_intel_bufmgr *bufmgr)
+{
+    struct intel_null_hw_bufmgr **link;
+
+    if (!intel_null_hw_bufmgr_is_null(bufmgr)) {
+        drm_intel_bufmgr_destroy(bufmgr);
+        return;
+    }
+
+    pthread_mutex_lock(&intel_null_hw_bufmgrs_mutex);
+
+    for (link = &intel_null_hw_bufmgrs; *link; link = &(*link)->next) {
+        if ((dri_bufmgr *)*link == bufmgr) {
+            *link = (*link)->next;
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&intel_null_hw_bufmgrs_mutex);
+
+    pthread_mutex_destroy(&((struct intel_null_hw_bufmgr *)bufmgr)->mutex);
+    free(bufmgr);
+}
+
+void
+intel_null_hw_get_stats(struct intel_null_hw_stats *stats)
+{
+    stats->num_allocs = __sync_fetch_and_add(&intel_null_hw_stats.num_allocs, 0);
+    stats->alloc_bytes = __sync_fetch_and_add(&intel_null_hw_stats.alloc_bytes, 0);
+    stats->num_execs = __sync_fetch_and_add(&intel_null_hw_stats.num_execs, 0);
+}
+
+void
+intel_null_hw_set_exec_hook(intel_null_hw_exec_hook hook, void *data)
+{
+    intel_null_hw_exec_hook_func = hook;
+    intel_null_hw_exec_hook_data = data;
+}
+
+static drm_intel_bo *
+intel_null_hw_bo_create(drm_intel_bufmgr *bufmgr, unsigned long size,
+                        unsigned int alignment, uint32_t tiling_mode)
+{
+    struct intel_null_hw_bufmgr *null_bufmgr = (struct intel_null_hw_bufmgr *)bufmgr;
+    struct intel_null_hw_bo *null_bo;
+
+    null_bo = calloc(1, sizeof(*null_bo));
+
+    if (!null_bo)
+        return NULL;
+
+    /* zeroed like the pages of a new GEM object */
+    size = NULL_HW_ALIGN(size ? size : 1, NULL_HW_PAGE_SIZE);
+    null_bo->mem = calloc(1, size);
+
+    if (!null_bo->mem) {
+        free(null_bo);
+        return NULL;
+    }
+
+    null_bo->refcount = 1;
+    null_bo->tiling_mode = tiling_mode;
+    null_bo->base.size = size;
+    null_bo->base.align = alignment;
+    null_bo->base.bufmgr = bufmgr;
+
+    pthread_mutex_lock(&null_bufmgr->mutex);
+    null_bo->base.handle = ++null_bufmgr->next_handle;
+    null_bo->base.offset64 = null_bufmgr->next_offset;
+    null_bufmgr->next_offset += size;
+    pthread_mutex_unlock(&null_bufmgr->mutex);
+
+    null_bo->base.offset = null_bo->base.offset64;
+
+    return &null_bo->base;
+}
+
+drm_intel_bo *
+intel_null_hw_bo_alloc(drm_intel_bufmgr *bufmgr, const char *name,
+                       unsigned long size, unsigned int alignment)
+{
+    __sync_fetch_and_add(&intel_null_hw_stats.num_allocs, 1);
+    __sync_fetch_and_add(&intel_null_hw_stats.alloc_bytes, size);
+
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        return drm_intel_bo_alloc(bufmgr, name, size, alignment);
+
+    return intel_null_hw_bo_create(bufmgr, size, alignment, I915_TILING_NONE);
+}
+
+drm_intel_bo *
+intel_null_hw_bo_alloc_tiled(drm_intel_bufmgr *bufmgr, const char *name,
+                             int x, int y, int cpp, uint32_t *tiling_mode,
+                             unsigned long *pitch, unsigned long flags)
+{
+    unsigned long stride, height;
+
+    if (!intel_null_hw_bufmgr_is_null(bufmgr)) {
+        drm_intel_bo *bo = drm_intel_bo_alloc_tiled(bufmgr, name, x, y, cpp,
+                                                    tiling_mode, pitch, flags);
+
+        __sync_fetch_and_add(&intel_null_hw_stats.num_allocs, 1);
+
+        if (bo)
+            __sync_fetch_and_add(&intel_null_hw_stats.alloc_bytes, bo->size);
+
+        return bo;
+    }
+
+    /* the layout of the i915 buffer manager */
+    switch (*tiling_mode) {
+    case I915_TILING_X:
+        stride = NULL_HW_ALIGN(x * cpp, 512);
+        height = NULL_HW_ALIGN(y, 8);
+        break;
+
+    case I915_TILING_Y:
+        stride = NULL_HW_ALIGN(x * cpp, 128);
+        height = NULL_HW_ALIGN(y, 32);
+        break;
+
+    default:
+        stride = NULL_HW_ALIGN(x * cpp, 64);
+        height = NULL_HW_ALIGN(y, 2);
+        break;
+    }
+
+    *pitch = stride;
+
+    __sync_fetch_and_add(&intel_null_hw_stats.num_allocs, 1);
+    __sync_fetch_and_add(&intel_null_hw_stats.alloc_bytes, stride * height);
+
+    return intel_null_hw_bo_create(bufmgr, stride * height, 0, *tiling_mode);
+}
+
+void
+intel_null_hw_bo_reference(drm_intel_bo *bo)
+{
+    if (!intel_null_hw_bo_is_null(bo)) {
+        drm_intel_bo_reference(bo);
+        return;
+    }
+
+    __sync_fetch_and_add(&((struct intel_null_hw_bo *)bo)->refcount, 1);
+}
+
+void
+intel_null_hw_bo_unreference(drm_intel_bo *bo)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo)) {
+        drm_intel_bo_unreference(bo);
+        return;
+    }
+
+    if (__sync_sub_and_fetch(&null_bo->refcount, 1) == 0) {
+        int i;
+
+        for (i = 0; i < null_bo->num_relocs; i++)
+            intel_null_hw_bo_unreference(null_bo->reloc_targets[i]);
+
+        free(null_bo->reloc_targets);
+        free(null_bo->mem);
+        free(null_bo);
+    }
+}
+
+int
+intel_null_hw_bo_map(drm_intel_bo *bo, int write_enable)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_map(bo, write_enable);
+
+    null_bo->map_count++;
+    bo->virtual = null_bo->mem;
+
+    return 0;
+}
+
+int
+intel_null_hw_bo_unmap(drm_intel_bo *bo)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_unmap(bo);
+
+    if (null_bo->map_count > 0 && --null_bo->map_count == 0)
+        bo->virtual = NULL;
+
+    return 0;
+}
+
+int
+intel_null_hw_gem_bo_map_gtt(drm_intel_bo *bo)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_gem_bo_map_gtt(bo);
+
+    /* the memory is linear whatever the tiling */
+    return intel_null_hw_bo_map(bo, 1);
+}
+
+int
+intel_null_hw_gem_bo_unmap_gtt(drm_intel_bo *bo)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_gem_bo_unmap_gtt(bo);
+
+    return intel_null_hw_bo_unmap(bo);
+}
+
+int
+intel_null_hw_bo_subdata(drm_intel_bo *bo, unsigned long offset,
+                         unsigned long size, const void *data)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_subdata(bo, offset, size, data);
+
+    if (offset + size > bo->size)
+        return -EINVAL;
+
+    memcpy((uint8_t *)null_bo->mem + offset, data, size);
+
+    return 0;
+}
+
+int
+intel_null_hw_bo_get_subdata(drm_intel_bo *bo, unsigned long offset,
+                             unsigned long size, void *data)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_get_subdata(bo, offset, size, data);
+
+    if (offset + size > bo->size)
+        return -EINVAL;
+
+    memcpy(data, (uint8_t *)null_bo->mem + offset, size);
+
+    return 0;
+}
+
+void
+intel_null_hw_bo_wait_rendering(drm_intel_bo *bo)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        drm_intel_bo_wait_rendering(bo);
+}
+
+int
+intel_null_hw_bo_busy(drm_intel_bo *bo)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_busy(bo);
+
+    return 0;
+}
+
+/* As libdrm, the relocations of a BO are kept until it is released */
+int
+intel_null_hw_bo_references(drm_intel_bo *bo, drm_intel_bo *target_bo)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+    int i;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_references(bo, target_bo);
+
+    for (i = 0; i < null_bo->num_relocs; i++) {
+        if (null_bo->reloc_targets[i] == target_bo ||
+            intel_null_hw_bo_references(null_bo->reloc_targets[i], target_bo))
+            return 1;
+    }
+
+    return 0;
+}
+
+drm_intel_bo * const *
+intel_null_hw_bo_get_reloc_targets(drm_intel_bo *bo, int *num_targets)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo)) {
+        *num_targets = 0;
+        return NULL;
+    }
+
+    *num_targets = null_bo->num_relocs;
+
+    return null_bo->reloc_targets;
+}
+
+/*
+ * The driver writes the presumed offset of the target itself, the null
+ * backend never relocates anything. The targets are only tracked for
+ * intel_null_hw_bo_references() and the tests.
+ */
+int
+intel_null_hw_bo_emit_reloc(drm_intel_bo *bo, uint32_t offset,
+                            drm_intel_bo *target_bo, uint32_t target_offset,
+                            uint32_t read_domains, uint32_t write_domain)
+{
+    struct intel_null_hw_bo *null_bo = (struct intel_null_hw_bo *)bo;
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_emit_reloc(bo, offset, target_bo, target_offset,
+                                       read_domains, write_domain);
+
+    assert(offset + 4 <= bo->size);
+
+    /* consecutive relocations usually point to the same BO */
+    if (null_bo->num_relocs &&
+        null_bo->reloc_targets[null_bo->num_relocs - 1] == target_bo)
+        return 0;
+
+    if (null_bo->num_relocs == null_bo->max_relocs) {
+        int max_relocs = null_bo->max_relocs ? null_bo->max_relocs * 2 : 16;
+        drm_intel_bo **reloc_targets = realloc(null_bo->reloc_targets,
+                                               max_relocs * sizeof(*reloc_targets));
+
+        if (!reloc_targets)
+            return -ENOMEM;
+
+        null_bo->reloc_targets = reloc_targets;
+        null_bo->max_relocs = max_relocs;
+    }
+
+    intel_null_hw_bo_reference(target_bo);
+    null_bo->reloc_targets[null_bo->num_relocs++] = target_bo;
+
+    return 0;
+}
+
+int
+intel_null_hw_bo_get_tiling(drm_intel_bo *bo, uint32_t *tiling_mode,
+                            uint32_t *swizzle_mode)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_get_tiling(bo, tiling_mode, swizzle_mode);
+
+    *tiling_mode = ((struct intel_null_hw_bo *)bo)->tiling_mode;
+    *swizzle_mode = I915_BIT_6_SWIZZLE_NONE;
+
+    return 0;
+}
+
+int
+intel_null_hw_bo_flink(drm_intel_bo *bo, uint32_t *name)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_flink(bo, name);
+
+    return -ENODEV;
+}
+
+int
+intel_null_hw_bo_gem_export_to_prime(drm_intel_bo *bo, int *prime_fd)
+{
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_gem_export_to_prime(bo, prime_fd);
+
+    return -ENODEV;
+}
+
+drm_intel_bo *
+intel_null_hw_bo_gem_create_from_prime(drm_intel_bufmgr *bufmgr,
+                                       int prime_fd, int size)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        return drm_intel_bo_gem_create_from_prime(bufmgr, prime_fd, size);
+
+    return NULL;
+}
+
+drm_intel_bo *
+intel_null_hw_bo_gem_create_from_name(drm_intel_bufmgr *bufmgr,
+                                      const char *name, unsigned int handle)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        return drm_intel_bo_gem_create_from_name(bufmgr, name, handle);
+
+    return NULL;
+}
+
+int
+intel_null_hw_bo_mrb_exec(drm_intel_bo *bo, int used,
+                          struct drm_clip_rect *cliprects, int num_cliprects,
+                          int DR4, unsigned int flags)
+{
+    __sync_fetch_and_add(&intel_null_hw_stats.num_execs, 1);
+
+    if (!intel_null_hw_bo_is_null(bo))
+        return drm_intel_bo_mrb_exec(bo, used, cliprects, num_cliprects, DR4, flags);
+
+    assert(used <= bo->size);
+
+    if (intel_null_hw_exec_hook_func)
+        intel_null_hw_exec_hook_func(intel_null_hw_exec_hook_data, bo, used, flags);
+
+    return 0;
+}
+
+int
+intel_null_hw_bufmgr_gem_get_devid(drm_intel_bufmgr *bufmgr)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        return drm_intel_bufmgr_gem_get_devid(bufmgr);
+
+    return ((struct intel_null_hw_bufmgr *)bufmgr)->device_id;
+}
+
+void
+intel_null_hw_bufmgr_gem_enable_reuse(drm_intel_bufmgr *bufmgr)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        drm_intel_bufmgr_gem_enable_reuse(bufmgr);
+}
+
+void
+intel_null_hw_bufmgr_gem_set_aub_filename(drm_intel_bufmgr *bufmgr,
+                                          const char *filename)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        drm_intel_bufmgr_gem_set_aub_filename(bufmgr, filename);
+}
+
+void
+intel_null_hw_bufmgr_gem_set_aub_dump(drm_intel_bufmgr *bufmgr, int enable)
+{
+    if (!intel_null_hw_bufmgr_is_null(bufmgr))
+        drm_intel_bufmgr_gem_set_aub_dump(bufmgr, enable);
+}
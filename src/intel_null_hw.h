@@ -0,0 +1,192 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef _INTEL_NULL_HW_H_
+#define _INTEL_NULL_HW_H_
+
+#include <stdint.h>
+#include <intel_bufmgr.h>
+
+/*
+ * A buffer manager without a device, for measuring the CPU side of the
+ * driver. The BOs are plain memory, the batches are dropped and every BO
+ * is idle. It is selected at init with VA_INTEL_NULL_HW=<PCI id>, the id
+ * picks the device info and codecs as for the real device.
+ *
+ * All the buffer manager calls of the driver go through the
+ * intel_null_hw_* functions below, they pick the null backend or libdrm
+ * from the buffer manager of the BO.
+ */
+
+/* The buffer manager calls of this process, of either backend */
+struct intel_null_hw_stats {
+    uint64_t num_allocs;
+    uint64_t alloc_bytes;
+    uint64_t num_execs;
+};
+
+dri_bufmgr *
+intel_null_hw_bufmgr_init(int device_id);
+
+int
+intel_null_hw_bufmgr_is_null(dri_bufmgr *bufmgr);
+
+void
+intel_null_hw_get_stats(struct intel_null_hw_stats *stats);
+
+/*
+ * Called with every batch the null backend drops, before it returns to
+ * the driver: the ring is in flags. Meant for the tests, the hook is set
+ * while no batch is submitted.
+ */
+typedef void (*intel_null_hw_exec_hook)(void *data, drm_intel_bo *bo,
+                                        int used, unsigned int flags);
+
+void
+intel_null_hw_set_exec_hook(intel_null_hw_exec_hook hook, void *data);
+
+/*
+ * The targets of the relocations of a null BO in the order they were
+ * emitted, consecutive relocations to the same target are listed once.
+ */
+drm_intel_bo * const *
+intel_null_hw_bo_get_reloc_targets(drm_intel_bo *bo, int *num_targets);
+
+drm_intel_bo *
+intel_null_hw_bo_alloc(drm_intel_bufmgr *bufmgr, const char *name,
+                       unsigned long size, unsigned int alignment);
+
+drm_intel_bo *
+intel_null_hw_bo_alloc_tiled(drm_intel_bufmgr *bufmgr, const char *name,
+                             int x, int y, int cpp, uint32_t *tiling_mode,
+                             unsigned long *pitch, unsigned long flags);
+
+void
+intel_null_hw_bo_reference(drm_intel_bo *bo);
+
+void
+intel_null_hw_bo_unreference(drm_intel_bo *bo);
+
+int
+intel_null_hw_bo_map(drm_intel_bo *bo, int write_enable);
+
+int
+intel_null_hw_bo_unmap(drm_intel_bo *bo);
+
+int
+intel_null_hw_gem_bo_map_gtt(drm_intel_bo *bo);
+
+int
+intel_null_hw_gem_bo_unmap_gtt(drm_intel_bo *bo);
+
+int
+intel_null_hw_bo_subdata(drm_intel_bo *bo, unsigned long offset,
+                         unsigned long size, const void *data);
+
+int
+intel_null_hw_bo_get_subdata(drm_intel_bo *bo, unsigned long offset,
+                             unsigned long size, void *data);
+
+void
+intel_null_hw_bo_wait_rendering(drm_intel_bo *bo);
+
+int
+intel_null_hw_bo_busy(drm_intel_bo *bo);
+
+int
+intel_null_hw_bo_references(drm_intel_bo *bo, drm_intel_bo *target_bo);
+
+int
+intel_null_hw_bo_emit_reloc(drm_intel_bo *bo, uint32_t offset,
+                            drm_intel_bo *target_bo, uint32_t target_offset,
+                            uint32_t read_domains, uint32_t write_domain);
+
+int
+intel_null_hw_bo_get_tiling(drm_intel_bo *bo, uint32_t *tiling_mode,
+                            uint32_t *swizzle_mode);
+
+int
+intel_null_hw_bo_flink(drm_intel_bo *bo, uint32_t *name);
+
+int
+intel_null_hw_bo_gem_export_to_prime(drm_intel_bo *bo, int *prime_fd);
+
+drm_intel_bo *
+intel_null_hw_bo_gem_create_from_prime(drm_intel_bufmgr *bufmgr,
+                                       int prime_fd, int size);
+
+drm_intel_bo *
+intel_null_hw_bo_gem_create_from_name(drm_intel_bufmgr *bufmgr,
+                                      const char *name, unsigned int handle);
+
+int
+intel_null_hw_bo_mrb_exec(drm_intel_bo *bo, int used,
+                          struct drm_clip_rect *cliprects, int num_cliprects,
+                          int DR4, unsigned int flags);
+
+int
+intel_null_hw_bufmgr_gem_get_devid(drm_intel_bufmgr *bufmgr);
+
+void
+intel_null_hw_bufmgr_gem_enable_reuse(drm_intel_bufmgr *bufmgr);
+
+void
+intel_null_hw_bufmgr_gem_set_aub_filename(drm_intel_bufmgr *bufmgr,
+                                          const char *filename);
+
+void
+intel_null_hw_bufmgr_gem_set_aub_dump(drm_intel_bufmgr *bufmgr, int enable);
+
+void
+intel_null_hw_bufmgr_destroy(drm_intel_bufmgr *bufmgr);
+
+#ifndef INTEL_NULL_HW_NO_REDIRECT
+#define drm_intel_bo_alloc                      intel_null_hw_bo_alloc
+#define drm_intel_bo_alloc_tiled                intel_null_hw_bo_alloc_tiled
+#define drm_intel_bo_reference                  intel_null_hw_bo_reference
+#define drm_intel_bo_unreference                intel_null_hw_bo_unreference
+#define drm_intel_bo_map                        intel_null_hw_bo_map
+#define drm_intel_bo_unmap                      intel_null_hw_bo_unmap
+#define drm_intel_gem_bo_map_gtt                intel_null_hw_gem_bo_map_gtt
+#define drm_intel_gem_bo_unmap_gtt              intel_null_hw_gem_bo_unmap_gtt
+#define drm_intel_bo_subdata                    intel_null_hw_bo_subdata
+#define drm_intel_bo_get_subdata                intel_null_hw_bo_get_subdata
+#define drm_intel_bo_wait_rendering             intel_null_hw_bo_wait_rendering
+#define drm_intel_bo_busy                       intel_null_hw_bo_busy
+#define drm_intel_bo_references                 intel_null_hw_bo_references
+#define drm_intel_bo_emit_reloc                 intel_null_hw_bo_emit_reloc
+#define drm_intel_bo_get_tiling                 intel_null_hw_bo_get_tiling
+#define drm_intel_bo_flink                      intel_null_hw_bo_flink
+#define drm_intel_bo_gem_export_to_prime        intel_null_hw_bo_gem_export_to_prime
+#define drm_intel_bo_gem_create_from_prime      intel_null_hw_bo_gem_create_from_prime
+#define drm_intel_bo_gem_create_from_name       intel_null_hw_bo_gem_create_from_name
+#define drm_intel_bo_mrb_exec                   intel_null_hw_bo_mrb_exec
+#define drm_intel_bufmgr_gem_get_devid          intel_null_hw_bufmgr_gem_get_devid
+#define drm_intel_bufmgr_gem_enable_reuse       intel_null_hw_bufmgr_gem_enable_reuse
+#define drm_intel_bufmgr_gem_set_aub_filename   intel_null_hw_bufmgr_gem_set_aub_filename
+#define drm_intel_bufmgr_gem_set_aub_dump       intel_null_hw_bufmgr_gem_set_aub_dump
+#define drm_intel_bufmgr_destroy                intel_null_hw_bufmgr_destroy
+#endif
+
+#endif /* _INTEL_NULL_HW_H_ */
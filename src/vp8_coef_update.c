@@ -0,0 +1,167 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <stdint.h>
+
+#include "vp8_probs.h"
+#include "vp8_coef_update.h"
+
+/*
+ * The token tree of RFC 6386 (section 13.2): a positive entry is the
+ * index of the next node pair, the others are minus a token.
+ */
+enum {
+    DCT_0, DCT_1, DCT_2, DCT_3, DCT_4,
+    DCT_CAT1, DCT_CAT2, DCT_CAT3, DCT_CAT4, DCT_CAT5, DCT_CAT6,
+    DCT_EOB,
+};
+
+static const signed char vp8_coef_tree[2 * VP8_COEF_NODES] = {
+    -DCT_EOB, 2,
+    -DCT_0, 4,
+    -DCT_1, 6,
+    8, 12,
+    -DCT_2, 10,
+    -DCT_3, -DCT_4,
+    14, 16,
+    -DCT_CAT1, -DCT_CAT2,
+    18, 20,
+    -DCT_CAT3, -DCT_CAT4,
+    -DCT_CAT5, -DCT_CAT6,
+};
+
+static unsigned int
+vp8_coef_tree_counts(int node,
+                     const unsigned int *token_counts,
+                     unsigned int (*branch_counts)[2])
+{
+    unsigned int count[2];
+    int i, next;
+
+    for (i = 0; i < 2; i++) {
+        next = vp8_coef_tree[node + i];
+
+        if (next > 0)
+            count[i] = vp8_coef_tree_counts(next, token_counts, branch_counts);
+        else
+            count[i] = token_counts[-next];
+
+        branch_counts[node >> 1][i] = count[i];
+    }
+
+    return count[0] + count[1];
+}
+
+void
+vp8_coef_branch_counts(const unsigned int token_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_TOKENS],
+                       unsigned int branch_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES][2])
+{
+    int i, j, k;
+
+    for (i = 0; i < VP8_COEF_BLOCK_TYPES; i++)
+        for (j = 0; j < VP8_COEF_BANDS; j++)
+            for (k = 0; k < VP8_COEF_CONTEXTS; k++)
+                vp8_coef_tree_counts(0, token_counts[i][j][k], branch_counts[i][j][k]);
+}
+
+/* The costs are in 1/256 bit, as in vp8_prob_cost[] */
+#define VP8_COST_ZERO(p)        (vp8_prob_cost[p])
+#define VP8_COST_ONE(p)         (vp8_prob_cost[255 - (p)])
+
+/* The nodes of a block type, evaluated at once */
+#define VP8_COEF_CHUNK          (VP8_NUM_COEF_PROBS / VP8_COEF_BLOCK_TYPES)
+
+/*
+ * The savings of the nodes, over flat arrays of doubles and without
+ * branches so that the compiler vectorizes it. The doubles are exact
+ * here: a count times a cost stays well within 2^53.
+ */
+static void
+vp8_coef_update_savings(const double *count0, const double *count1,
+                        const double *delta0, const double *delta1,
+                        const double *update_cost, double *savings)
+{
+    int n;
+
+    for (n = 0; n < VP8_COEF_CHUNK; n++)
+        savings[n] = count0[n] * delta0[n] + count1[n] * delta1[n] - update_cost[n];
+}
+
+unsigned int
+vp8_coef_update_search(const unsigned char probs[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES],
+                       const unsigned int branch_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES][2],
+                       unsigned char new_probs[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES],
+                       unsigned char update_flags[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES])
+{
+    const unsigned char *old_p, *upd_p;
+    const unsigned int (*ct)[2];
+    unsigned char *out_p, *out_flag;
+    unsigned char cand_p[VP8_COEF_CHUNK];
+    double count0[VP8_COEF_CHUNK], count1[VP8_COEF_CHUNK];
+    double delta0[VP8_COEF_CHUNK], delta1[VP8_COEF_CHUNK];
+    double update_cost[VP8_COEF_CHUNK];
+    double savings[VP8_COEF_CHUNK];
+    uint64_t num, total = 0;
+    unsigned int sum, p;
+    int i, n;
+
+    for (i = 0; i < VP8_COEF_BLOCK_TYPES; i++) {
+        old_p = &probs[i][0][0][0];
+        upd_p = &vp8_coef_update_probs[i][0][0][0];
+        ct = (const unsigned int (*)[2])branch_counts[i];
+        out_p = &new_probs[i][0][0][0];
+        out_flag = &update_flags[i][0][0][0];
+
+        /* the lookups and the divisions */
+        for (n = 0; n < VP8_COEF_CHUNK; n++) {
+            sum = ct[n][0] + ct[n][1];
+            p = old_p[n];
+
+            if (sum) {
+                num = (uint64_t)ct[n][0] * 256 + (sum >> 1);
+                p = num / sum;
+                p = p < 1 ? 1 : (p > 255 ? 255 : p);
+            }
+
+            cand_p[n] = p;
+            count0[n] = ct[n][0];
+            count1[n] = ct[n][1];
+            delta0[n] = VP8_COST_ZERO(old_p[n]) - VP8_COST_ZERO(p);
+            delta1[n] = VP8_COST_ONE(old_p[n]) - VP8_COST_ONE(p);
+            update_cost[n] = 8 * 256 + VP8_COST_ONE(upd_p[n]) - VP8_COST_ZERO(upd_p[n]);
+        }
+
+        vp8_coef_update_savings(count0, count1, delta0, delta1, update_cost, savings);
+
+        for (n = 0; n < VP8_COEF_CHUNK; n++) {
+            out_flag[n] = savings[n] > 0;
+            out_p[n] = out_flag[n] ? cand_p[n] : old_p[n];
+
+            if (out_flag[n])
+                total += (uint64_t)savings[n];
+        }
+    }
+
+    return total >> 8;
+}
@@ -0,0 +1,61 @@
+/*
+ * Copyright © 2026 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+/*
+ * The search for the coefficient probability updates of a VP8 frame
+ * header (RFC 6386, section 13.4), from the token counts of an earlier
+ * frame. No encoder feeds it yet: the layout of the token statistics the
+ * PAK writes is not documented.
+ */
+
+#ifndef VP8_COEF_UPDATE_H
+#define VP8_COEF_UPDATE_H
+
+#define VP8_COEF_BLOCK_TYPES            4
+#define VP8_COEF_BANDS                  8
+#define VP8_COEF_CONTEXTS               3
+#define VP8_COEF_NODES                  11
+#define VP8_COEF_TOKENS                 12      /* dct_eob is the last one */
+
+#define VP8_NUM_COEF_PROBS              (VP8_COEF_BLOCK_TYPES * VP8_COEF_BANDS * \
+                                         VP8_COEF_CONTEXTS * VP8_COEF_NODES)
+
+/* The number of 0 and 1 decisions taken at every node of the token trees */
+void
+vp8_coef_branch_counts(const unsigned int token_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_TOKENS],
+                       unsigned int branch_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES][2]);
+
+/*
+ * Pick the probabilities worth updating: the ones whose new value saves
+ * more bits on the given branch counts than sending it costs. new_probs
+ * gets the probabilities to code the frame with, update_flags the flags
+ * of the frame header. Returns the bits saved.
+ */
+unsigned int
+vp8_coef_update_search(const unsigned char probs[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES],
+                       const unsigned int branch_counts[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES][2],
+                       unsigned char new_probs[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES],
+                       unsigned char update_flags[VP8_COEF_BLOCK_TYPES][VP8_COEF_BANDS][VP8_COEF_CONTEXTS][VP8_COEF_NODES]);
+
+#endif /* VP8_COEF_UPDATE_H */
@@ -0,0 +1,749 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_test_fixture.h"
+
+extern "C" {
+    #include "i965_avc_encoder_common.h"
+}
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <vector>
+
+namespace AVC {
+namespace Encode {
+
+/*
+ * The gen9 AVC encoder on VA_INTEL_NULL_HW: the kernels never run, so the
+ * buffers the CPU fills for them can be read back after a frame and the
+ * batches are seen as the driver submits them.
+ */
+class AVCENullHWTest
+    : public I965TestFixture
+{
+protected:
+    static const unsigned gopSize = 8;
+
+    /* a batch dropped by the null backend */
+    struct Exec {
+        unsigned ring;
+        unsigned flags;
+        std::vector<drm_intel_bo *> relocs;
+    };
+
+    void TearDown()
+    {
+        intel_null_hw_set_exec_hook(NULL, NULL);
+        I965TestFixture::TearDown();
+    }
+
+    bool isSkipped()
+    {
+        struct i965_driver_data *i965(*this);
+        bool supported = i965 and HAS_H264_ENCODING(i965)
+            and (IS_GEN9(i965->intel.device_info)
+                or IS_GEN10(i965->intel.device_info));
+
+        if (not I965TestEnvironment::instance()->isNullHW() or not supported) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " needs VA_INTEL_NULL_HW on a gen9 AVC encoder"
+                << std::endl;
+            return true;
+        }
+
+        return false;
+    }
+
+    static void recordExec(void *data, drm_intel_bo *bo, int, unsigned flags)
+    {
+        std::vector<Exec> *execs = static_cast<std::vector<Exec> *>(data);
+        drm_intel_bo * const *targets;
+        int numTargets;
+        Exec exec;
+
+        targets = intel_null_hw_bo_get_reloc_targets(bo, &numTargets);
+        exec.ring = flags & I915_EXEC_RING_MASK;
+        exec.flags = flags;
+        exec.relocs.assign(targets, targets + numTargets);
+        execs->push_back(exec);
+    }
+
+    /* records the batches submitted until the next call */
+    void recordExecs(std::vector<Exec>& execs)
+    {
+        execs.clear();
+        intel_null_hw_set_exec_hook(recordExec, &execs);
+    }
+
+    void stopRecording()
+    {
+        intel_null_hw_set_exec_hook(NULL, NULL);
+    }
+
+    void createStream(uint32_t rc, unsigned w = 320, unsigned h = 240)
+    {
+        VAConfigAttrib a = { type:VAConfigAttribRateControl, value:rc };
+        ConfigAttribs attribs(1, a);
+
+        width = w;
+        height = h;
+
+        ASSERT_NO_FAILURE(
+            inputs = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 1));
+        ASSERT_NO_FAILURE(
+            recons = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+        ASSERT_NO_FAILURE(
+            config = createConfig(
+                VAProfileH264Main, VAEntrypointEncSlice, attribs));
+        ASSERT_NO_FAILURE(
+            context = createContext(config, width, height, 0, recons));
+        ASSERT_NO_FAILURE(
+            coded = createBuffer(
+                context, VAEncCodedBufferType, width * height * 3 / 2));
+    }
+
+    void destroyStream()
+    {
+        destroyBuffer(coded);
+        destroyContext(context);
+        destroyConfig(config);
+        destroySurfaces(recons);
+        destroySurfaces(inputs);
+    }
+
+    template <typename T>
+    VABufferID createMisc(VAEncMiscParameterType type, const T& data)
+    {
+        std::vector<uint8_t> buffer(sizeof(VAEncMiscParameterBuffer) + sizeof(T));
+        VAEncMiscParameterBuffer *misc =
+            reinterpret_cast<VAEncMiscParameterBuffer *>(buffer.data());
+
+        misc->type = type;
+        std::memcpy(misc->data, &data, sizeof(T));
+
+        return createBuffer(context, VAEncMiscParameterBufferType,
+            buffer.size(), 1, buffer.data());
+    }
+
+    /* frame i of an IPPP stream, preset 0 leaves the quality level alone */
+    void encode(unsigned i, uint32_t rc, uint32_t preset = 0)
+    {
+        VAEncSequenceParameterBufferH264 seq;
+        VAEncPictureParameterBufferH264 pic;
+        VAEncSliceParameterBufferH264 slice;
+        VAEncMiscParameterRateControl rateControl;
+        VAEncMiscParameterHRD hrd;
+        VAEncMiscParameterBufferQualityLevel quality;
+        const bool idr(i % gopSize == 0);
+        const unsigned bitrate(1000000);
+        VAPictureH264 last;
+        std::vector<VABufferID> buffers;
+
+        std::memset(&last, 0, sizeof(last));
+        if (not idr) {
+            last.picture_id = recons[(i + 1) % recons.size()];
+            last.frame_idx = (i - 1) % gopSize;
+            last.flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+            last.TopFieldOrderCnt = last.BottomFieldOrderCnt =
+                (i % gopSize - 1) * 2;
+        }
+
+        std::memset(&seq, 0, sizeof(seq));
+        seq.level_idc = 30;
+        seq.intra_period = gopSize;
+        seq.intra_idr_period = gopSize;
+        seq.ip_period = 1;
+        seq.bits_per_second = rc == VA_RC_CQP ? 0 : bitrate;
+        seq.max_num_ref_frames = 1;
+        seq.picture_width_in_mbs = width / 16;
+        seq.picture_height_in_mbs = height / 16;
+        seq.seq_fields.bits.chroma_format_idc = 1;
+        seq.seq_fields.bits.frame_mbs_only_flag = 1;
+        seq.seq_fields.bits.direct_8x8_inference_flag = 1;
+        seq.seq_fields.bits.log2_max_frame_num_minus4 = 4;
+        seq.seq_fields.bits.log2_max_pic_order_cnt_lsb_minus4 = 4;
+        seq.time_scale = 60;
+        seq.num_units_in_tick = 1;
+
+        std::memset(&pic, 0, sizeof(pic));
+        pic.CurrPic.picture_id = recons[i % recons.size()];
+        pic.CurrPic.frame_idx = i % gopSize;
+        pic.CurrPic.flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+        pic.CurrPic.TopFieldOrderCnt = pic.CurrPic.BottomFieldOrderCnt =
+            (i % gopSize) * 2;
+        for (unsigned j(0); j < 16; ++j) {
+            pic.ReferenceFrames[j].picture_id = VA_INVALID_SURFACE;
+            pic.ReferenceFrames[j].flags = VA_PICTURE_H264_INVALID;
+        }
+        if (not idr)
+            pic.ReferenceFrames[0] = last;
+        pic.coded_buf = coded;
+        pic.frame_num = i % gopSize;
+        pic.pic_init_qp = 26;
+        pic.pic_fields.bits.idr_pic_flag = idr;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        pic.pic_fields.bits.entropy_coding_mode_flag = 1;
+        pic.pic_fields.bits.deblocking_filter_control_present_flag = 1;
+
+        std::memset(&slice, 0, sizeof(slice));
+        slice.num_macroblocks = (width / 16) * (height / 16);
+        slice.slice_type = idr ? 2 : 0;
+        slice.idr_pic_id = i / gopSize;
+        slice.pic_order_cnt_lsb = (i % gopSize) * 2;
+        for (unsigned j(0); j < 32; ++j) {
+            slice.RefPicList0[j].picture_id = VA_INVALID_SURFACE;
+            slice.RefPicList0[j].flags = VA_PICTURE_H264_INVALID;
+            slice.RefPicList1[j] = slice.RefPicList0[j];
+        }
+        if (not idr)
+            slice.RefPicList0[0] = last;
+
+        if (idr) {
+            buffers.push_back(createBuffer(context,
+                VAEncSequenceParameterBufferType, sizeof(seq), 1, &seq));
+        }
+        if (rc != VA_RC_CQP) {
+            std::memset(&rateControl, 0, sizeof(rateControl));
+            rateControl.bits_per_second = bitrate;
+            rateControl.target_percentage = rc == VA_RC_VBR ? 80 : 100;
+            rateControl.window_size = 1000;
+
+            std::memset(&hrd, 0, sizeof(hrd));
+            hrd.buffer_size = bitrate;
+            hrd.initial_buffer_fullness = bitrate / 2;
+
+            buffers.push_back(createMisc(
+                VAEncMiscParameterTypeRateControl, rateControl));
+            buffers.push_back(createMisc(VAEncMiscParameterTypeHRD, hrd));
+        }
+        if (preset) {
+            std::memset(&quality, 0, sizeof(quality));
+            quality.quality_level = preset;
+
+            buffers.push_back(createMisc(
+                VAEncMiscParameterTypeQualityLevel, quality));
+        }
+        buffers.push_back(createBuffer(context,
+            VAEncPictureParameterBufferType, sizeof(pic), 1, &pic));
+        buffers.push_back(createBuffer(context,
+            VAEncSliceParameterBufferType, sizeof(slice), 1, &slice));
+
+        beginPicture(context, inputs[0]);
+        renderPicture(context, buffers.data(), buffers.size());
+        endPicture(context);
+
+        for (auto id : buffers)
+            destroyBuffer(id);
+    }
+
+    struct encoder_vme_mfc_context *vmeContext()
+    {
+        struct object_context *obj_context = CONTEXT(context);
+        if (not obj_context) return NULL;
+
+        struct intel_encoder_context *encoder_context =
+            reinterpret_cast<struct intel_encoder_context *>(
+                obj_context->hw_context);
+        if (not encoder_context) return NULL;
+
+        return static_cast<struct encoder_vme_mfc_context *>(
+            encoder_context->vme_context);
+    }
+
+    unsigned width = 320;
+    unsigned height = 240;
+    Surfaces inputs;
+    Surfaces recons;
+    VAConfigID config = VA_INVALID_ID;
+    VAContextID context = VA_INVALID_ID;
+    VABufferID coded = VA_INVALID_ID;
+};
+
+/*
+ * The BRC constant data of a frame is copied from a table cached across
+ * frames, check it against the tables the driver built for every frame
+ * before, for every preset with every kernel rate control.
+ */
+class AVCEBRCConstDataTest
+    : public AVCENullHWTest
+{
+protected:
+    static const unsigned framesPerPreset = 4;
+
+    /*
+     * gen9_avc_init_brc_const_data() as it was before the tables were
+     * cached, writing into a zeroed buffer. The reference list QPs are
+     * filled for the single reference of the P frames the test encodes.
+     */
+    static void baselineConstData(struct i965_driver_data *i965,
+        struct generic_enc_codec_state *generic_state,
+        struct avc_enc_state *avc_state, unsigned char *data)
+    {
+        static const unsigned int slice_type_kernel[3] = {1, 2, 0};
+        unsigned char *data_tmp = NULL;
+        unsigned int size = 0;
+        unsigned int table_idx = 0;
+        unsigned int block_based_skip_enable = avc_state->block_based_skip_enable;
+        int i = 0;
+        unsigned int transform_8x8_mode_flag = avc_state->transform_8x8_mode_enable;
+
+        table_idx = slice_type_kernel[generic_state->frame_type];
+
+        size = sizeof(gen9_avc_qp_adjustment_dist_threshold_max_frame_threshold_dist_qp_adjustment_ipb);
+        memcpy(data, gen9_avc_qp_adjustment_dist_threshold_max_frame_threshold_dist_qp_adjustment_ipb, size * sizeof(unsigned char));
+
+        data += size;
+
+        size = 128;
+        switch (generic_state->frame_type) {
+        case SLICE_TYPE_P:
+            memcpy(data, gen9_avc_skip_value_p[block_based_skip_enable][transform_8x8_mode_flag], size * sizeof(unsigned char));
+            break;
+        case SLICE_TYPE_B:
+            memcpy(data, gen9_avc_skip_value_b[block_based_skip_enable][transform_8x8_mode_flag], size * sizeof(unsigned char));
+            break;
+        default:
+            break;
+        }
+
+        if ((generic_state->frame_type != SLICE_TYPE_I) && avc_state->non_ftq_skip_threshold_lut_input_enable) {
+            for (i = 0; i < AVC_QP_MAX ; i++) {
+                *(data + 1 + (i * 2)) = (unsigned char)i965_avc_calc_skip_value(block_based_skip_enable, transform_8x8_mode_flag, avc_state->non_ftq_skip_threshold_lut[i]);
+            }
+        }
+        data += size;
+
+        size = 32 + 32 + 32 + 160;
+        memset(data, 0xff, 32);
+        memset(data + 32 + 32, 0xff, 32);
+        if (generic_state->frame_type == SLICE_TYPE_P)
+            *data = avc_state->list_ref_idx[0][0];
+        data += size;
+
+        size = 1664;
+        memcpy(data, (unsigned char *)&gen9_avc_mode_mv_cost_table[table_idx][0][0], size * sizeof(unsigned char));
+
+        if (avc_state->old_mode_cost_enable) {
+            data_tmp = data;
+            for (i = 0; i < AVC_QP_MAX ; i++) {
+                *(data_tmp + 3) = (unsigned int)gen9_avc_old_intra_mode_cost[i];
+                data_tmp += 16;
+            }
+        }
+
+        if (avc_state->ftq_skip_threshold_lut_input_enable) {
+            for (i = 0; i < AVC_QP_MAX ; i++) {
+                *(data + (i * 32) + 24) =
+                    *(data + (i * 32) + 25) =
+                        *(data + (i * 32) + 27) =
+                            *(data + (i * 32) + 28) =
+                                *(data + (i * 32) + 29) =
+                                    *(data + (i * 32) + 30) =
+                                        *(data + (i * 32) + 31) = avc_state->ftq_skip_threshold_lut[i];
+            }
+        }
+        data += size;
+
+        size = 128;
+        memcpy(data, (unsigned char *)&gen9_avc_ref_cost[table_idx][0], size * sizeof(unsigned char));
+        data += size;
+
+        size = 64;
+        if (avc_state->adaptive_intra_scaling_enable) {
+            memcpy(data, (unsigned char *)gen9_avc_adaptive_intra_scaling_factor, size * sizeof(unsigned char));
+        } else {
+            memcpy(data, (unsigned char *)gen9_avc_intra_scaling_factor, size * sizeof(unsigned char));
+        }
+
+        if (IS_KBL(i965->intel.device_info) ||
+            IS_GEN10(i965->intel.device_info) ||
+            IS_GLK(i965->intel.device_info)) {
+            data += size;
+
+            size = 512;
+            memcpy(data, (unsigned char *)gen95_avc_lambda_data, size * sizeof(unsigned char));
+            data += size;
+
+            size = 64;
+            memcpy(data, (unsigned char *)gen95_avc_ftq25, size * sizeof(unsigned char));
+        }
+    }
+
+    /* the constant data the last frame ran with against the tables built
+     * the way the driver did before caching them */
+    void checkConstData()
+    {
+        struct encoder_vme_mfc_context *vme_context(vmeContext());
+        ASSERT_PTR(vme_context);
+
+        struct i965_avc_encoder_context *avc_ctx =
+            static_cast<struct i965_avc_encoder_context *>(
+                vme_context->private_enc_ctx);
+        struct generic_enc_codec_state *generic_state =
+            static_cast<struct generic_enc_codec_state *>(
+                vme_context->generic_enc_state);
+        struct avc_enc_state *avc_state =
+            static_cast<struct avc_enc_state *>(
+                vme_context->private_enc_state);
+
+        ASSERT_TRUE(generic_state->brc_enabled);
+        ASSERT_PTR(avc_ctx->brc_const_data_cache.data);
+
+        const unsigned size(avc_ctx->brc_const_data_cache.size);
+        ASSERT_GE(size, unsigned(I965_AVC_BRC_CONST_DATA_REF_QP_OFFSET
+            + I965_AVC_BRC_CONST_DATA_REF_QP_SIZE));
+
+        std::vector<uint8_t> expected(size, 0);
+        baselineConstData(*this, generic_state, avc_state, expected.data());
+
+        dri_bo *bo = avc_ctx->res_brc_const_data_buffer.bo;
+        ASSERT_PTR(bo);
+        ASSERT_EQ(0, dri_bo_map(bo, 0));
+
+        const uint8_t *actual = static_cast<const uint8_t *>(bo->virtual);
+        unsigned mismatch(size);
+        for (unsigned j(0); j < size; ++j) {
+            if (actual[j] != expected[j]) {
+                mismatch = j;
+                break;
+            }
+        }
+
+        dri_bo_unmap(bo);
+
+        EXPECT_EQ(size, mismatch)
+            << "first difference at byte " << mismatch
+            << ", frame type " << generic_state->frame_type
+            << ", preset " << generic_state->preset;
+    }
+};
+
+TEST_F(AVCEBRCConstDataTest, MatchesBaselineTablesForEveryPreset)
+{
+    if (isSkipped())
+        return;
+
+    struct i965_driver_data *i965(*this);
+    const uint32_t rcModes[] = { VA_RC_CBR, VA_RC_VBR };
+    /* each preset in turn sees I and P frames */
+    const unsigned numFrames(2 * ENCODER_QUALITY_RANGE_AVC * framesPerPreset);
+
+    for (const uint32_t rc : rcModes) {
+        if (not (i965->codec_info->h264_brc_mode & rc))
+            continue;
+
+        ASSERT_NO_FAILURE(createStream(rc));
+
+        for (unsigned i(0); i < numFrames; ++i) {
+            const uint32_t preset(
+                1 + (i / framesPerPreset) % ENCODER_QUALITY_RANGE_AVC);
+
+            SCOPED_TRACE(::testing::Message() << "rc " << rc
+                << ", preset " << preset << ", frame " << i);
+
+            ASSERT_NO_FAILURE(encode(i, rc, preset));
+            ASSERT_NO_FAILURE(checkConstData());
+        }
+
+        destroyStream();
+    }
+}
+
+/*
+ * The kernels of the VME stage are queued into a single batch: check the
+ * batches of every frame and the order the kernels were queued in, known
+ * from the instruction BO of their GPE context in the state base address.
+ */
+class AVCEVMEBatchTest
+    : public AVCENullHWTest
+{
+protected:
+    /* the kernels in the order gen9_avc_vme_gpe_kernel_run() runs them,
+     * the GPE contexts are set up with the encoder context */
+    enum Stage {
+        BRCInitReset,
+        Scaling,
+        ME,
+        SFD,
+        BRCUpdate,
+        WP,
+        MBEnc,
+    };
+
+    void addStage(struct i965_gpe_context *gpe_context, Stage stage)
+    {
+        if (gpe_context->instruction_state.bo)
+            stages[gpe_context->instruction_state.bo] = stage;
+    }
+
+    void mapStages()
+    {
+        struct encoder_vme_mfc_context *vme_context(vmeContext());
+        ASSERT_PTR(vme_context);
+
+        struct i965_avc_encoder_context *avc_ctx =
+            static_cast<struct i965_avc_encoder_context *>(
+                vme_context->private_enc_ctx);
+
+        stages.clear();
+
+        for (unsigned i(0); i < NUM_GEN9_AVC_KERNEL_BRC; ++i) {
+            addStage(&avc_ctx->context_brc.gpe_contexts[i],
+                i == GEN9_AVC_KERNEL_BRC_INIT || i == GEN9_AVC_KERNEL_BRC_RESET
+                ? BRCInitReset : BRCUpdate);
+        }
+        for (unsigned i(0); i < NUM_GEN9_AVC_KERNEL_SCALING; ++i)
+            addStage(&avc_ctx->context_scaling.gpe_contexts[i], Scaling);
+        for (unsigned i(0); i < NUM_GEN9_AVC_KERNEL_ME; ++i)
+            addStage(&avc_ctx->context_me.gpe_contexts[i], ME);
+        addStage(&avc_ctx->context_sfd.gpe_contexts, SFD);
+        addStage(&avc_ctx->context_wp.gpe_contexts, WP);
+        for (unsigned i(0); i < NUM_GEN9_AVC_KERNEL_MBENC; ++i)
+            addStage(&avc_ctx->context_mbenc.gpe_contexts[i], MBEnc);
+    }
+
+    /* the kernels queued into a batch, a kernel run twice in a row once */
+    std::vector<Stage> kernels(const Exec& exec)
+    {
+        std::vector<Stage> result;
+
+        for (auto bo : exec.relocs) {
+            auto it = stages.find(bo);
+
+            if (it != stages.end()
+                and (result.empty() or result.back() != it->second))
+                result.push_back(it->second);
+        }
+
+        return result;
+    }
+
+    std::map<drm_intel_bo *, Stage> stages;
+};
+
+TEST_F(AVCEVMEBatchTest, CQPSubmitsOneVMEBatchPerFrame)
+{
+    if (isSkipped())
+        return;
+
+    const unsigned numFrames(2 * gopSize);
+    std::vector<Exec> execs;
+
+    ASSERT_NO_FAILURE(createStream(VA_RC_CQP, 640, 480));
+    ASSERT_NO_FAILURE(mapStages());
+
+    for (unsigned i(0); i < numFrames; ++i) {
+        const bool idr(i % gopSize == 0);
+
+        SCOPED_TRACE(::testing::Message() << "frame " << i);
+
+        recordExecs(execs);
+        ASSERT_NO_FAILURE(encode(i, VA_RC_CQP));
+        stopRecording();
+
+        unsigned numRender(0), numOther(0);
+        std::vector<Stage> queued;
+
+        for (const Exec& exec : execs) {
+            if (exec.ring == I915_EXEC_RENDER) {
+                ++numRender;
+                queued = kernels(exec);
+            } else {
+                EXPECT_EQ(unsigned(I915_EXEC_BSD), exec.ring);
+                ++numOther;
+            }
+        }
+
+        EXPECT_EQ(1u, numRender);
+        EXPECT_LE(1u, numOther);
+
+        /* in stage order, ending with a single MBEnc */
+        EXPECT_TRUE(std::is_sorted(queued.begin(), queued.end()));
+        ASSERT_FALSE(queued.empty());
+        EXPECT_EQ(MBEnc, queued.back());
+        EXPECT_EQ(1, std::count(queued.begin(), queued.end(), MBEnc));
+        EXPECT_NE(queued.end(), std::find(queued.begin(), queued.end(), Scaling));
+        EXPECT_EQ(not idr, queued.end()
+            != std::find(queued.begin(), queued.end(), ME));
+    }
+
+    destroyStream();
+}
+
+TEST_F(AVCEVMEBatchTest, BRCKeepsKernelOrder)
+{
+    if (isSkipped())
+        return;
+
+    struct i965_driver_data *i965(*this);
+    if (not (i965->codec_info->h264_brc_mode & VA_RC_CBR))
+        return;
+
+    const unsigned numFrames(2 * gopSize);
+    std::vector<Exec> execs;
+
+    ASSERT_NO_FAILURE(createStream(VA_RC_CBR, 640, 480));
+    ASSERT_NO_FAILURE(mapStages());
+
+    for (unsigned i(0); i < numFrames; ++i) {
+        SCOPED_TRACE(::testing::Message() << "frame " << i);
+
+        recordExecs(execs);
+        ASSERT_NO_FAILURE(encode(i, VA_RC_CBR));
+        stopRecording();
+
+        /* a CPU write to a buffer in use submits the kernels queued so
+         * far, the order holds across the batches of the VME stage */
+        std::vector<Stage> queued;
+
+        for (const Exec& exec : execs) {
+            if (exec.ring != I915_EXEC_RENDER)
+                continue;
+
+            std::vector<Stage> batch(kernels(exec));
+            queued.insert(queued.end(), batch.begin(), batch.end());
+        }
+
+        ASSERT_FALSE(queued.empty());
+        EXPECT_TRUE(std::is_sorted(queued.begin(), queued.end()));
+        EXPECT_EQ(MBEnc, queued.back());
+        EXPECT_NE(queued.end(),
+            std::find(queued.begin(), queued.end(), BRCUpdate));
+        if (i == 0)
+            EXPECT_EQ(BRCInitReset, queued.front());
+    }
+
+    destroyStream();
+}
+
+/*
+ * Without BRC the frames of a GOP go to the VDBox that wrote their reference
+ * and the next IDR to the other one, so the two rings run PAKs at the same
+ * time and each needs its own row store buffers.
+ */
+class AVCEPakPipeTest
+    : public AVCENullHWTest
+{
+protected:
+    /* the VDBox select bits of a BSD exec, as in intel_batchbuffer.c */
+    enum {
+        BSDRing0 = 1 << 13,
+        BSDRing1 = 2 << 13,
+        BSDRingMask = 3 << 13,
+    };
+
+    typedef std::vector<drm_intel_bo *> RowStores;
+
+    RowStores rowStores(unsigned pipe)
+    {
+        struct i965_avc_encoder_context *avc_ctx =
+            static_cast<struct i965_avc_encoder_context *>(
+                vmeContext()->private_enc_ctx);
+        RowStores bos;
+
+        bos.push_back(avc_ctx->res_intra_row_store_scratch_buffer[pipe].bo);
+        bos.push_back(
+            avc_ctx->res_deblocking_filter_row_store_scratch_buffer[pipe].bo);
+        bos.push_back(avc_ctx->res_bsd_mpc_row_store_scratch_buffer[pipe].bo);
+
+        return bos;
+    }
+
+    static bool relocates(const Exec& exec, drm_intel_bo *bo)
+    {
+        return std::find(exec.relocs.begin(), exec.relocs.end(), bo)
+            != exec.relocs.end();
+    }
+};
+
+TEST_F(AVCEPakPipeTest, RowStoresFollowThePipe)
+{
+    if (isSkipped())
+        return;
+
+    struct i965_driver_data *i965(*this);
+    if (not i965->intel.has_bsd2)
+        return;
+
+    const unsigned numFrames(2 * gopSize);
+    std::vector<Exec> execs;
+    RowStores first[I965_AVC_MAX_PAK_PIPES];
+    bool used[I965_AVC_MAX_PAK_PIPES] = { false, false };
+
+    ASSERT_NO_FAILURE(createStream(VA_RC_CQP));
+    ASSERT_PTR(vmeContext());
+
+    for (unsigned i(0); i < numFrames; ++i) {
+        SCOPED_TRACE(::testing::Message() << "frame " << i);
+
+        recordExecs(execs);
+        ASSERT_NO_FAILURE(encode(i, VA_RC_CQP));
+        stopRecording();
+
+        unsigned numPak(0);
+
+        for (const Exec& exec : execs) {
+            if (exec.ring != I915_EXEC_BSD
+                or not (exec.flags & BSDRingMask))
+                continue;
+
+            const unsigned select(exec.flags & BSDRingMask);
+            ASSERT_TRUE(select == BSDRing0 or select == BSDRing1);
+
+            const unsigned pipe(select == BSDRing1 ? 1 : 0);
+            const RowStores mine(rowStores(pipe));
+            const RowStores other(rowStores(1 - pipe));
+
+            ++numPak;
+            used[pipe] = true;
+
+            for (drm_intel_bo *bo : mine) {
+                ASSERT_PTR(bo);
+                EXPECT_TRUE(relocates(exec, bo));
+            }
+            for (drm_intel_bo *bo : other) {
+                if (bo)
+                    EXPECT_FALSE(relocates(exec, bo));
+            }
+
+            /* allocated once, the frame size does not change */
+            if (first[pipe].empty())
+                first[pipe] = mine;
+            EXPECT_TRUE(first[pipe] == mine);
+        }
+
+        EXPECT_LE(1u, numPak);
+    }
+
+    EXPECT_TRUE(used[0]);
+    EXPECT_TRUE(used[1]);
+
+    destroyStream();
+}
+
+} // namespace Encode
+} // namespace AVC
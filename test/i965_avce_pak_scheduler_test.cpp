@@ -0,0 +1,134 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_avc_encoder_common.h"
+}
+
+#include <vector>
+
+namespace AVC {
+namespace Encode {
+
+class AVCEPakSchedulerTest
+    : public ::testing::Test
+{
+protected:
+    // Runs the frames through the scheduler and returns the pipe of each one,
+    // frame i is reconstructed into surface i and refs[i] are its references
+    std::vector<int> schedule(int numPipes,
+        const std::vector<std::vector<VASurfaceID> >& refs, bool brc = false)
+    {
+        i965_avc_pak_scheduler scheduler;
+        std::vector<int> pipes;
+
+        i965_avc_pak_scheduler_init(&scheduler, numPipes);
+        for (size_t i(0); i < refs.size(); ++i) {
+            pipes.push_back(i965_avc_pak_scheduler_select(&scheduler,
+                refs[i].data(), refs[i].size(), brc));
+            i965_avc_pak_scheduler_commit(&scheduler, pipes.back(), i);
+        }
+        return pipes;
+    }
+};
+
+TEST_F(AVCEPakSchedulerTest, SinglePipe)
+{
+    const std::vector<std::vector<VASurfaceID> > refs = {
+        {}, {0}, {}, {}, {3},
+    };
+
+    EXPECT_EQ(std::vector<int>({0, 0, 0, 0, 0}), schedule(1, refs));
+}
+
+TEST_F(AVCEPakSchedulerTest, IntraOnlyAlternates)
+{
+    const std::vector<std::vector<VASurfaceID> > refs(6);
+
+    EXPECT_EQ(std::vector<int>({0, 1, 0, 1, 0, 1}), schedule(2, refs));
+}
+
+TEST_F(AVCEPakSchedulerTest, PFramesFollowTheirReference)
+{
+    // IPPP, then a new GOP that starts on the other pipe
+    const std::vector<std::vector<VASurfaceID> > refs = {
+        {}, {0}, {1}, {2}, {}, {4}, {5, VA_INVALID_SURFACE},
+    };
+
+    EXPECT_EQ(std::vector<int>({0, 0, 0, 0, 1, 1, 1}), schedule(2, refs));
+}
+
+TEST_F(AVCEPakSchedulerTest, NonReferenceBFramesRunInParallel)
+{
+    // encoding order I0 P1 B2 B3 P4 B5 B6, the B frames reference I0/P1 or
+    // P1/P4 and nothing references them
+    const std::vector<std::vector<VASurfaceID> > refs = {
+        {}, {0}, {0, 1}, {0, 1}, {1}, {1, 4}, {1, 4},
+    };
+
+    EXPECT_EQ(std::vector<int>({0, 0, 0, 1, 0, 0, 1}), schedule(2, refs));
+}
+
+TEST_F(AVCEPakSchedulerTest, MostRecentReferenceWins)
+{
+    // frame 2 references the frames written by both pipes
+    const std::vector<std::vector<VASurfaceID> > refs = {
+        {}, {}, {0, 1}, {},
+    };
+
+    EXPECT_EQ(std::vector<int>({0, 1, 1, 0}), schedule(2, refs));
+}
+
+TEST_F(AVCEPakSchedulerTest, BRCStaysOnFirstPipe)
+{
+    const std::vector<std::vector<VASurfaceID> > refs(4);
+
+    EXPECT_EQ(std::vector<int>({0, 0, 0, 0}), schedule(2, refs, true));
+}
+
+// A frame that fails before it runs leaves the scheduler untouched
+TEST_F(AVCEPakSchedulerTest, SelectWithoutCommit)
+{
+    i965_avc_pak_scheduler scheduler;
+    const VASurfaceID ref(0);
+
+    i965_avc_pak_scheduler_init(&scheduler, 2);
+    EXPECT_EQ(0, i965_avc_pak_scheduler_select(&scheduler, NULL, 0, false));
+    i965_avc_pak_scheduler_commit(&scheduler, 0, 0);
+
+    // the next I frame goes to the other pipe, until it runs
+    EXPECT_EQ(1, i965_avc_pak_scheduler_select(&scheduler, NULL, 0, false));
+    EXPECT_EQ(1, i965_avc_pak_scheduler_select(&scheduler, NULL, 0, false));
+    EXPECT_EQ(0, scheduler.last_pipe);
+    EXPECT_EQ(VA_INVALID_SURFACE, scheduler.last_recon[1]);
+
+    // a P frame still follows its reference on the first pipe
+    EXPECT_EQ(0, i965_avc_pak_scheduler_select(&scheduler, &ref, 1, false));
+}
+
+} // namespace Encode
+} // namespace AVC
@@ -0,0 +1,139 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_avc_encoder_common.h"
+}
+
+#include <vector>
+
+namespace AVC {
+namespace Encode {
+
+static const uint32_t Cut(I965_ENCODER_STATUS_HINT_SCENE_CUT);
+static const uint32_t Static(I965_ENCODER_STATUS_HINT_STATIC_SCENE);
+static const int32_t Intra(-1);
+
+class AVCESceneDetectorTest
+    : public ::testing::Test
+{
+protected:
+    // Runs a trace of distortions per MB through the detector and returns
+    // the hints of every frame, Intra marks a frame without ME
+    std::vector<uint32_t> detect(const std::vector<int32_t>& trace)
+    {
+        static const unsigned NumMBs = 120 * 68;
+        i965_avc_scene_detector detector;
+        std::vector<uint32_t> hints;
+
+        i965_avc_scene_detector_init(&detector);
+        for (size_t i(0); i < trace.size(); ++i) {
+            if (trace[i] == Intra) {
+                hints.push_back(i965_avc_scene_detector_update(&detector, 0, 0));
+            } else {
+                hints.push_back(i965_avc_scene_detector_update(&detector,
+                    uint64_t(trace[i]) * NumMBs, NumMBs));
+            }
+            EXPECT_EQ(hints.back(), detector.hints);
+        }
+        return hints;
+    }
+};
+
+TEST_F(AVCESceneDetectorTest, SteadyMotion)
+{
+    const std::vector<int32_t> trace = {
+        Intra, 300, 340, 280, 310, 500, 260, 320, Intra, 330, 290,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>(trace.size(), 0), detect(trace));
+}
+
+TEST_F(AVCESceneDetectorTest, SceneCut)
+{
+    const std::vector<int32_t> trace = {
+        Intra, 100, 110, 90, 100, 900, 120, 100, 1000, 110,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>({0, 0, 0, 0, 0, Cut, 0, 0, Cut, 0}),
+        detect(trace));
+}
+
+TEST_F(AVCESceneDetectorTest, CutNeedsHistory)
+{
+    // not enough frames in the average at the start and after a cut
+    const std::vector<int32_t> trace = {
+        Intra, 100, 900, 100, 100, 100, 1000, 100, 900,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>({0, 0, 0, 0, 0, 0, Cut, 0, 0}),
+        detect(trace));
+}
+
+TEST_F(AVCESceneDetectorTest, SmallJumpIsNoCut)
+{
+    // a large ratio on a low distortion
+    const std::vector<int32_t> low = {
+        Intra, 20, 20, 200, 20,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>(low.size(), 0), detect(low));
+
+    // a fade raises the distortion slowly
+    const std::vector<int32_t> fade = {
+        Intra, 200, 260, 338, 439, 571, 742, 965, 1254, 1630,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>(fade.size(), 0), detect(fade));
+}
+
+TEST_F(AVCESceneDetectorTest, StaticScene)
+{
+    const std::vector<int32_t> trace = {
+        Intra, 10, 8, 12, 9, 24, 10, 40, 8, 8, 20,
+    };
+
+    // a frame above the exit threshold ends the static scene, a frame
+    // between both thresholds keeps it but does not start one
+    EXPECT_EQ(std::vector<uint32_t>({
+        0, 0, 0, Static, Static, Static, Static, 0, 0, 0, 0,
+    }), detect(trace));
+}
+
+TEST_F(AVCESceneDetectorTest, IntraFramesKeepTheState)
+{
+    const std::vector<int32_t> trace = {
+        Intra, 4, 4, 4, Intra, 4, 4, Intra, 600, 100, 100, Intra, 900,
+    };
+
+    EXPECT_EQ(std::vector<uint32_t>({
+        0, 0, 0, Static, Static, Static, Static, Static, Cut, 0, 0, 0, Cut,
+    }), detect(trace));
+}
+
+} // namespace Encode
+} // namespace AVC
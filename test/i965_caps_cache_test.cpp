@@ -0,0 +1,177 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "intel_caps_cache.h"
+}
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+
+namespace CapsCache {
+
+class CapsCacheTest
+    : public ::testing::Test
+{
+protected:
+    void SetUp()
+    {
+        std::ostringstream os;
+        os << "/tmp/i965_caps_cache_test." << getpid();
+        path = os.str();
+
+        intel_caps_cache_get_key(0x1912, 2, &key);
+
+        std::memset(&caps, 0, sizeof(caps));
+        caps.has_exec2 = caps.has_bsd = caps.has_blt = caps.has_vebox = 1;
+        caps.has_huc = 1;
+        caps.eu_total = 24;
+        std::strcpy(caps.cpu_model, "       Intel(R) Core(TM) i5-6600K CPU @ 3.50GHz");
+    }
+
+    void TearDown()
+    {
+        std::remove(path.c_str());
+    }
+
+    std::string read()
+    {
+        std::ifstream file(path.c_str());
+        std::ostringstream os;
+        os << file.rdbuf();
+        return os.str();
+    }
+
+    void write(const std::string& contents)
+    {
+        std::ofstream file(path.c_str(), std::ios::trunc);
+        file << contents;
+    }
+
+    std::string path;
+    struct intel_caps_key key;
+    struct intel_caps caps;
+};
+
+TEST_F(CapsCacheTest, RoundTrip)
+{
+    struct intel_caps loaded;
+
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    ASSERT_TRUE(intel_caps_cache_store(path.c_str(), &key, &caps));
+    ASSERT_TRUE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    EXPECT_EQ(caps.has_exec2, loaded.has_exec2);
+    EXPECT_EQ(caps.has_bsd, loaded.has_bsd);
+    EXPECT_EQ(caps.has_blt, loaded.has_blt);
+    EXPECT_EQ(caps.has_vebox, loaded.has_vebox);
+    EXPECT_EQ(caps.has_bsd2, loaded.has_bsd2);
+    EXPECT_EQ(caps.has_huc, loaded.has_huc);
+    EXPECT_EQ(caps.eu_total, loaded.eu_total);
+    EXPECT_STREQ(caps.cpu_model, loaded.cpu_model);
+
+    // the file is written aside and renamed, nothing is left behind
+    std::ostringstream tmp;
+    tmp << path << "." << getpid();
+    EXPECT_NE(0, access(tmp.str().c_str(), F_OK));
+}
+
+TEST_F(CapsCacheTest, KeyMismatch)
+{
+    struct intel_caps loaded;
+    struct intel_caps_key other;
+
+    ASSERT_TRUE(intel_caps_cache_store(path.c_str(), &key, &caps));
+
+    other = key;
+    other.device_id = 0x5912;
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &other, &loaded));
+
+    other = key;
+    other.revision = 3;
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &other, &loaded));
+
+    other = key;
+    std::strcpy(other.kernel, "4.14.0 #1 SMP");
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &other, &loaded));
+
+    other = key;
+    std::strcpy(other.boot_id, "00000000-0000-0000-0000-000000000000");
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &other, &loaded));
+
+    EXPECT_TRUE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+}
+
+TEST_F(CapsCacheTest, Invalid)
+{
+    struct intel_caps loaded;
+
+    ASSERT_TRUE(intel_caps_cache_store(path.c_str(), &key, &caps));
+    const std::string valid(read());
+
+    // cut anywhere, including the last newline
+    for (size_t len(0); len < valid.size(); ++len) {
+        write(valid.substr(0, len));
+        EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded))
+            << "length " << len;
+    }
+
+    // another version of the format
+    std::string other(valid);
+    other.replace(other.find("version=1"), 9, "version=0");
+    write(other);
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    // a field twice
+    write(valid + "eu_total=48\n");
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    // an unknown field
+    write(valid + "has_guc=1\n");
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    // not a number
+    other = valid;
+    other.replace(other.find("eu_total=24"), 11, "eu_total=2x");
+    write(other);
+    EXPECT_FALSE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+
+    write(valid);
+    EXPECT_TRUE(intel_caps_cache_load(path.c_str(), &key, &loaded));
+}
+
+TEST_F(CapsCacheTest, NotWritable)
+{
+    EXPECT_FALSE(intel_caps_cache_store(
+        "/nonexistent/i965_caps_cache", &key, &caps));
+}
+
+} // namespace CapsCache
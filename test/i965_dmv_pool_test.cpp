@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_test_fixture.h"
+
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace DMVPool {
+
+class DMVPoolTest
+    : public I965TestFixture
+{
+protected:
+    void SetUp()
+    {
+        I965TestFixture::SetUp();
+
+        struct i965_driver_data *i965(*this);
+        ASSERT_PTR(i965);
+
+        i965_dmv_pool_init(&pool, i965->intel.bufmgr, "dmv pool test");
+    }
+
+    void TearDown()
+    {
+        i965_dmv_pool_fini(&pool);
+
+        I965TestFixture::TearDown();
+    }
+
+    struct i965_dmv_pool_stats stats()
+    {
+        struct i965_dmv_pool_stats s;
+        i965_dmv_pool_get_stats(&pool, &s);
+        return s;
+    }
+
+    struct i965_dmv_pool pool;
+};
+
+TEST_F(DMVPoolTest, ReusedBySize)
+{
+    dri_bo *a = i965_dmv_pool_get(&pool, 0x10000);
+    dri_bo *b = i965_dmv_pool_get(&pool, 0x10000);
+    ASSERT_PTR(a);
+    ASSERT_PTR(b);
+    EXPECT_NE(a, b);
+    EXPECT_GE(a->size, 0x10000u);
+
+    i965_dmv_pool_put(&pool, a);
+    i965_dmv_pool_put(&pool, b);
+
+    // the same BOs come back, in any order
+    std::set<dri_bo *> bos{a, b};
+    dri_bo *c = i965_dmv_pool_get(&pool, 0x10000);
+    dri_bo *d = i965_dmv_pool_get(&pool, 0x10000);
+    EXPECT_EQ(1u, bos.count(c));
+    EXPECT_EQ(1u, bos.count(d));
+    EXPECT_NE(c, d);
+
+    EXPECT_EQ(2u, stats().num_allocs);
+    EXPECT_EQ(2u, stats().num_reuses);
+    EXPECT_EQ(2u, stats().num_returns);
+    EXPECT_EQ(0u, stats().num_drops);
+
+    i965_dmv_pool_put(&pool, c);
+    i965_dmv_pool_put(&pool, d);
+}
+
+TEST_F(DMVPoolTest, SizesKeptApart)
+{
+    dri_bo *small = i965_dmv_pool_get(&pool, 0x10000);
+    ASSERT_PTR(small);
+    i965_dmv_pool_put(&pool, small);
+
+    // too small for this size
+    dri_bo *large = i965_dmv_pool_get(&pool, 0x40000);
+    ASSERT_PTR(large);
+    EXPECT_NE(small, large);
+    EXPECT_GE(large->size, 0x40000u);
+    i965_dmv_pool_put(&pool, large);
+
+    // and too large for this one
+    dri_bo *tiny = i965_dmv_pool_get(&pool, 0x1000);
+    ASSERT_PTR(tiny);
+    EXPECT_NE(small, tiny);
+    EXPECT_NE(large, tiny);
+    i965_dmv_pool_put(&pool, tiny);
+
+    EXPECT_EQ(3u, stats().num_allocs);
+    EXPECT_EQ(0u, stats().num_reuses);
+    EXPECT_EQ(3u, stats().num_returns);
+}
+
+TEST_F(DMVPoolTest, Bounded)
+{
+    std::vector<dri_bo *> bos;
+
+    // a bucket holds I965_DMV_POOL_SLOTS BOs
+    for (unsigned i(0); i < I965_DMV_POOL_SLOTS + 1; ++i)
+        bos.push_back(i965_dmv_pool_get(&pool, 0x10000));
+    for (auto bo : bos)
+        i965_dmv_pool_put(&pool, bo);
+
+    EXPECT_EQ(unsigned(I965_DMV_POOL_SLOTS), stats().num_returns);
+    EXPECT_EQ(1u, stats().num_drops);
+    EXPECT_EQ(I965_DMV_POOL_SLOTS * bos[0]->size, stats().num_bytes);
+
+    // and there are I965_DMV_POOL_BUCKETS sizes, a new one takes the
+    // bucket of the least recently used
+    for (unsigned i(1); i <= I965_DMV_POOL_BUCKETS; ++i)
+        i965_dmv_pool_put(&pool, i965_dmv_pool_get(&pool, 0x100000 * i));
+
+    EXPECT_EQ(I965_DMV_POOL_SLOTS + I965_DMV_POOL_BUCKETS + 0u,
+        stats().num_returns);
+    EXPECT_EQ(1u, stats().num_drops);
+    EXPECT_EQ(unsigned(I965_DMV_POOL_SLOTS), stats().num_evictions);
+
+    // the newest sizes are still pooled
+    const uint32_t reuses(stats().num_reuses);
+    for (unsigned i(1); i <= I965_DMV_POOL_BUCKETS; ++i)
+        i965_dmv_pool_put(&pool, i965_dmv_pool_get(&pool, 0x100000 * i));
+    EXPECT_EQ(reuses + I965_DMV_POOL_BUCKETS, stats().num_reuses);
+}
+
+TEST_F(DMVPoolTest, EmptyBucketReleased)
+{
+    for (unsigned i(1); i <= I965_DMV_POOL_BUCKETS; ++i)
+        i965_dmv_pool_put(&pool, i965_dmv_pool_get(&pool, 0x10000 * i));
+
+    // taking the BO of a size back frees its bucket for another size
+    dri_bo *bo = i965_dmv_pool_get(&pool, 0x10000);
+    ASSERT_PTR(bo);
+    i965_dmv_pool_put(&pool, i965_dmv_pool_get(&pool, 0x200000));
+
+    EXPECT_EQ(0u, stats().num_evictions);
+    EXPECT_EQ(0u, stats().num_drops);
+
+    i965_dmv_pool_put(&pool, bo);
+}
+
+TEST_F(DMVPoolTest, CappedInBytes)
+{
+    pool.max_bytes = 0x100000;
+
+    std::vector<dri_bo *> bos;
+    for (unsigned i(0); i < 4; ++i)
+        bos.push_back(i965_dmv_pool_get(&pool, 0x40000));
+    dri_bo *other = i965_dmv_pool_get(&pool, 0x10000);
+
+    for (auto bo : bos)
+        i965_dmv_pool_put(&pool, bo);
+    EXPECT_GE(pool.max_bytes, stats().num_bytes);
+
+    // the other size gets in, a BO of the least recently used size goes
+    i965_dmv_pool_put(&pool, other);
+    EXPECT_GE(pool.max_bytes, stats().num_bytes);
+    EXPECT_LE(1u, stats().num_evictions);
+    EXPECT_EQ(other, i965_dmv_pool_get(&pool, 0x10000));
+    i965_dmv_pool_put(&pool, other);
+
+    // larger than the whole pool
+    i965_dmv_pool_put(&pool, i965_dmv_pool_get(&pool, 0x200000));
+    EXPECT_EQ(1u, stats().num_drops);
+    EXPECT_GE(pool.max_bytes, stats().num_bytes);
+}
+
+TEST_F(DMVPoolTest, NotPooled)
+{
+    struct i965_driver_data *i965(*this);
+    dri_bo *bo = dri_bo_alloc(i965->intel.bufmgr, "dmv", 0x1000, 0x1000);
+    ASSERT_PTR(bo);
+
+    // no pool, the BO is released
+    i965_dmv_pool_put(NULL, bo);
+    i965_dmv_pool_put(&pool, NULL);
+
+    EXPECT_EQ(0u, stats().num_returns);
+    EXPECT_EQ(0u, stats().num_drops);
+}
+
+TEST_F(DMVPoolTest, Threads)
+{
+    const unsigned numThreads(8), numIterations(1000);
+    std::mutex mutex;
+    std::set<dri_bo *> held;
+    bool sharedBO(false);
+    std::vector<std::thread> threads;
+
+    for (unsigned t(0); t < numThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            for (unsigned i(0); i < numIterations; ++i) {
+                dri_bo *bo = i965_dmv_pool_get(&pool, 0x10000 * (1 + t % 2));
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    sharedBO |= not held.insert(bo).second;
+                }
+
+                std::this_thread::yield();
+
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    held.erase(bo);
+                }
+
+                i965_dmv_pool_put(&pool, bo);
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    // a BO is never handed out twice and all of them are accounted for
+    EXPECT_FALSE(sharedBO);
+    EXPECT_EQ(numThreads * numIterations,
+        stats().num_allocs + stats().num_reuses);
+    EXPECT_EQ(numThreads * numIterations,
+        stats().num_returns + stats().num_drops);
+    EXPECT_EQ(0u, stats().num_drops);
+}
+
+} // namespace DMVPool
@@ -0,0 +1,215 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_encoder_layer_brc.h"
+}
+
+#include <deque>
+#include <functional>
+#include <vector>
+
+namespace EncoderLayerBRC {
+
+class EncoderLayerBRCTest
+    : public ::testing::Test
+{
+protected:
+    // Three layers at 7.5, 15 and 30 fps, the base layer holds half of
+    // the bitrate
+    virtual void SetUp()
+    {
+        const double bitsPerSecond[] = {400000, 600000, 800000};
+        const double framesPerSecond[] = {7.5, 15, 30};
+
+        i965_encoder_layer_brc_init(&brc, 3, bitsPerSecond, framesPerSecond,
+            800000, 400000);
+    }
+
+    // The layer of frame i, the usual dyadic pattern
+    static unsigned layerOf(unsigned i)
+    {
+        static const unsigned pattern[] = {0, 2, 1, 2};
+        return pattern[i % 4];
+    }
+
+    // Encodes numFrames frames, size(layer, budget) gives the size of every
+    // frame and the sizes come back delay frames later
+    std::vector<double> simulate(unsigned numFrames,
+        std::function<double(unsigned, double)> size, unsigned delay = 0)
+    {
+        std::deque<double> sizes;
+        std::vector<double> budgets;
+
+        for (unsigned i(0); i < numFrames; ++i) {
+            const unsigned layer(layerOf(i));
+            const double budget(i965_encoder_layer_brc_begin_frame(&brc, layer));
+
+            budgets.push_back(budget);
+            i965_encoder_layer_brc_set_frame_id(&brc, i + 1);
+            sizes.push_back(size(layer, budget));
+
+            if (sizes.size() > delay) {
+                i965_encoder_layer_brc_end_frame(&brc, sizes.front());
+                sizes.pop_front();
+            }
+        }
+
+        while (!sizes.empty()) {
+            i965_encoder_layer_brc_end_frame(&brc, sizes.front());
+            sizes.pop_front();
+        }
+        return budgets;
+    }
+
+    i965_encoder_layer_brc brc;
+};
+
+TEST_F(EncoderLayerBRCTest, Budgets)
+{
+    EXPECT_DOUBLE_EQ(400000 / 7.5, brc.frame_budget[0]);
+    EXPECT_DOUBLE_EQ(200000 / 7.5, brc.frame_budget[1]);
+    EXPECT_DOUBLE_EQ(200000 / 15., brc.frame_budget[2]);
+
+    EXPECT_DOUBLE_EQ(400000 / 30., brc.input_bits[0]);
+    EXPECT_DOUBLE_EQ(800000 / 30., brc.input_bits[2]);
+
+    EXPECT_DOUBLE_EQ(400000, brc.buffer_size[0]);
+    EXPECT_DOUBLE_EQ(800000, brc.buffer_size[2]);
+    EXPECT_DOUBLE_EQ(200000, brc.fullness[0]);
+    EXPECT_DOUBLE_EQ(400000, brc.fullness[2]);
+}
+
+TEST_F(EncoderLayerBRCTest, OnBudget)
+{
+    const std::vector<double> budgets(simulate(400,
+        [](unsigned, double budget) { return budget; }));
+
+    // every frame gets the full budget of its layer and no buffer drifts
+    for (unsigned i(0); i < budgets.size(); ++i)
+        EXPECT_DOUBLE_EQ(brc.frame_budget[layerOf(i)], budgets[i]) << i;
+    EXPECT_GT(brc.max_bits, brc.budget);
+
+    for (unsigned i(0); i < brc.num_layers; ++i) {
+        EXPECT_EQ(0u, brc.num_underflows[i]);
+        EXPECT_NEAR(brc.buffer_size[i] / 2, brc.fullness[i], 1) << i;
+    }
+}
+
+TEST_F(EncoderLayerBRCTest, EnhancementOvershoot)
+{
+    // the top layer is 4 times over budget, the base layer is on budget
+    simulate(400, [](unsigned layer, double budget) {
+        return layer == 2 ? budget * 4 : budget;
+    });
+
+    // the whole stream underflows, the base and middle layer sub-streams
+    // stay conforming so the top layer can be dropped
+    EXPECT_GT(brc.num_underflows[2], 0u);
+    EXPECT_EQ(0u, brc.num_underflows[1]);
+    EXPECT_EQ(0u, brc.num_underflows[0]);
+}
+
+TEST_F(EncoderLayerBRCTest, BaseOvershootShrinksTheBudget)
+{
+    // base frames twice over budget for a while, then the encoder follows
+    // the budget again
+    std::vector<double> budgets(simulate(64,
+        [](unsigned layer, double budget) {
+            return layer == 0 ? budget * 2 : budget;
+        }));
+
+    EXPECT_LT(budgets[60], brc.frame_budget[0]);
+    EXPECT_DOUBLE_EQ(brc.fullness[2] + brc.budget, brc.max_bits);
+
+    const unsigned numUnderflows(brc.num_underflows[0]);
+
+    budgets = simulate(400, [](unsigned, double budget) { return budget; });
+
+    EXPECT_DOUBLE_EQ(brc.frame_budget[0], budgets[396]);
+    EXPECT_EQ(numUnderflows, brc.num_underflows[0]);
+}
+
+TEST_F(EncoderLayerBRCTest, LateSizes)
+{
+    i965_encoder_layer_brc immediate;
+    const auto size = [](unsigned layer, double budget) {
+        return budget * (layer == 1 ? 0.9 : layer == 2 ? 1.05 : 1);
+    };
+
+    simulate(200, size);
+    immediate = brc;
+
+    SetUp();
+    simulate(200, size, 6);
+
+    // the buffers end up the same as long as none of them overflows
+    for (unsigned i(0); i < brc.num_layers; ++i) {
+        EXPECT_EQ(0u, brc.num_underflows[i]);
+        EXPECT_NEAR(immediate.fullness[i], brc.fullness[i], 1) << i;
+        EXPECT_LT(brc.fullness[i], brc.buffer_size[i]) << i;
+    }
+}
+
+TEST_F(EncoderLayerBRCTest, Pending)
+{
+    uint32_t frameID(0);
+
+    EXPECT_FALSE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+
+    // the frame id is not known until the frame goes to the PAK
+    i965_encoder_layer_brc_begin_frame(&brc, 0);
+    ASSERT_TRUE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+    EXPECT_EQ(0u, frameID);
+    i965_encoder_layer_brc_set_frame_id(&brc, 7);
+    i965_encoder_layer_brc_begin_frame(&brc, 2);
+    i965_encoder_layer_brc_set_frame_id(&brc, 8);
+
+    ASSERT_TRUE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+    EXPECT_EQ(7u, frameID);
+
+    // an unknown size keeps the budget
+    const double fullness(brc.fullness[0]);
+    i965_encoder_layer_brc_end_frame(&brc, -1);
+    EXPECT_DOUBLE_EQ(fullness, brc.fullness[0]);
+
+    ASSERT_TRUE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+    EXPECT_EQ(8u, frameID);
+    i965_encoder_layer_brc_end_frame(&brc, 0);
+    EXPECT_FALSE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+
+    // frames that never complete are dropped
+    for (unsigned i(0); i < I965_ENCODER_LAYER_BRC_MAX_PENDING + 8; ++i) {
+        i965_encoder_layer_brc_begin_frame(&brc, layerOf(i));
+        i965_encoder_layer_brc_set_frame_id(&brc, 100 + i);
+    }
+    EXPECT_EQ(unsigned(I965_ENCODER_LAYER_BRC_MAX_PENDING), brc.num_pending);
+    ASSERT_TRUE(i965_encoder_layer_brc_oldest_pending(&brc, &frameID));
+    EXPECT_EQ(108u, frameID);
+}
+
+} // namespace EncoderLayerBRC
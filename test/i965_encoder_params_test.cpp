@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_drv_video.h"
+    #include "i965_encoder_params.h"
+}
+
+#include <cstring>
+#include <vector>
+
+namespace EncoderParams {
+
+class EncoderParamsTest
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        params = i965_encoder_params();
+        std::memset(&state, 0, sizeof(state));
+    }
+
+    virtual void TearDown()
+    {
+        i965_encoder_params_free(&params);
+    }
+
+    // a buffer store the way vaCreateBuffer() makes one
+    buffer_store store(std::vector<uint8_t>& data)
+    {
+        buffer_store s = buffer_store();
+        s.buffer = data.data();
+        s.size = data.size();
+        s.num_elements = 1;
+        return s;
+    }
+
+    int update()
+    {
+        return i965_encoder_params_update(&params, &state);
+    }
+
+    enum {
+        Seq = 1 << I965_ENCODER_PARAMS_SEQ,
+        Misc = 1 << I965_ENCODER_PARAMS_MISC,
+    };
+
+    i965_encoder_params params;
+    encode_state state;
+};
+
+TEST(EncoderParamsHashTest, Chained)
+{
+    const uint8_t data[] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+    const uint64_t basis(0xcbf29ce484222325ULL);
+
+    // the empty input leaves the basis, a hash can be carried over buffers
+    EXPECT_EQ(basis, i965_encoder_params_hash(basis, data, 0));
+    EXPECT_EQ(i965_encoder_params_hash(basis, data, sizeof(data)),
+        i965_encoder_params_hash(
+            i965_encoder_params_hash(basis, data, 3), data + 3, 5));
+    EXPECT_NE(i965_encoder_params_hash(basis, data, sizeof(data)),
+        i965_encoder_params_hash(basis, data + 1, sizeof(data) - 1));
+
+    // FNV-1a of "a"
+    EXPECT_EQ(0xaf63dc4c8601ec8cULL, i965_encoder_params_hash(basis, "a", 1));
+}
+
+TEST(EncoderParamsSnapshotTest, Update)
+{
+    i965_encoder_params_snapshot snapshot = i965_encoder_params_snapshot();
+    std::vector<uint8_t> a(100, 0x11), b(28, 0x22);
+    const void *data[] = { a.data(), b.data() };
+    unsigned sizes[] = { unsigned(a.size()), unsigned(b.size()) };
+
+    EXPECT_TRUE(i965_encoder_params_snapshot_update(&snapshot, data, sizes, 2));
+    EXPECT_FALSE(i965_encoder_params_snapshot_update(&snapshot, data, sizes, 2));
+    EXPECT_EQ(128u, snapshot.size);
+
+    // the same bytes split differently are the same parameters
+    a.resize(a.size() + b.size(), 0x22);
+    const void *whole[] = { a.data() };
+    unsigned wholeSize[] = { 128 };
+    EXPECT_FALSE(
+        i965_encoder_params_snapshot_update(&snapshot, whole, wholeSize, 1));
+
+    // every byte counts
+    for (unsigned i(0); i < a.size(); i += 17) {
+        a[i] ^= 0x80;
+        EXPECT_TRUE(
+            i965_encoder_params_snapshot_update(&snapshot, whole, wholeSize, 1)) << i;
+        EXPECT_FALSE(
+            i965_encoder_params_snapshot_update(&snapshot, whole, wholeSize, 1)) << i;
+    }
+
+    // a prefix of the snapshot is a change, and so is nothing at all
+    wholeSize[0] = 127;
+    EXPECT_TRUE(
+        i965_encoder_params_snapshot_update(&snapshot, whole, wholeSize, 1));
+    EXPECT_TRUE(i965_encoder_params_snapshot_update(&snapshot, NULL, NULL, 0));
+    EXPECT_FALSE(i965_encoder_params_snapshot_update(&snapshot, NULL, NULL, 0));
+
+    free(snapshot.data);
+}
+
+TEST_F(EncoderParamsTest, Sequence)
+{
+    std::vector<uint8_t> seq(64, 0x5a), pic(32, 0);
+    buffer_store seqStore(store(seq)), picStore(store(pic));
+
+    state.seq_param_ext = &seqStore;
+    state.pic_param_ext = &picStore;
+
+    // all is new on the first frame
+    EXPECT_EQ(Seq | Misc, update());
+    EXPECT_EQ(1u, params.num_frames);
+
+    // the picture parameters are not tracked
+    for (unsigned i(1); i < 10; ++i) {
+        pic[0] = i;
+        EXPECT_EQ(0, update()) << i;
+        EXPECT_FALSE(I965_ENCODER_PARAMS_CHANGED(&params, I965_ENCODER_PARAMS_SEQ));
+    }
+
+    // the application sends the same sequence again in a new buffer
+    std::vector<uint8_t> seq2(seq);
+    buffer_store seq2Store(store(seq2));
+    state.seq_param_ext = &seq2Store;
+    EXPECT_EQ(0, update());
+
+    seq2[63] = 0;
+    EXPECT_EQ(Seq, update());
+
+    EXPECT_EQ(12u, params.num_frames);
+    EXPECT_EQ(2u, params.num_changed[I965_ENCODER_PARAMS_SEQ]);
+    EXPECT_EQ(1u, params.num_changed[I965_ENCODER_PARAMS_MISC]);
+
+    i965_encoder_params_skip(&params, I965_ENCODER_PARAMS_SEQ);
+    EXPECT_EQ(1u, params.num_skipped[I965_ENCODER_PARAMS_SEQ]);
+}
+
+TEST_F(EncoderParamsTest, Misc)
+{
+    std::vector<uint8_t> rc(24, 1), hrd(12, 2);
+    buffer_store rcStore(store(rc)), hrdStore(store(hrd));
+
+    EXPECT_EQ(Seq | Misc, update());
+    EXPECT_EQ(0, update());
+
+    state.misc_param[VAEncMiscParameterTypeRateControl][0] = &rcStore;
+    EXPECT_EQ(Misc, update());
+    EXPECT_EQ(0, update());
+
+    state.misc_param[VAEncMiscParameterTypeHRD][0] = &hrdStore;
+    EXPECT_EQ(Misc, update());
+    EXPECT_EQ(0, update());
+
+    rc[4] = 7;
+    EXPECT_EQ(Misc, update());
+
+    // the same parameters for another temporal layer
+    state.misc_param[VAEncMiscParameterTypeRateControl][0] = NULL;
+    state.misc_param[VAEncMiscParameterTypeRateControl][1] = &rcStore;
+    EXPECT_EQ(Misc, update());
+    EXPECT_EQ(0, update());
+
+    // not sent again for a frame
+    state.misc_param[VAEncMiscParameterTypeRateControl][1] = NULL;
+    state.misc_param[VAEncMiscParameterTypeHRD][0] = NULL;
+    EXPECT_EQ(Misc, update());
+    EXPECT_EQ(0, update());
+}
+
+TEST_F(EncoderParamsTest, Invalidate)
+{
+    std::vector<uint8_t> seq(64, 0x5a);
+    buffer_store seqStore(store(seq));
+
+    state.seq_param_ext = &seqStore;
+
+    EXPECT_EQ(Seq | Misc, update());
+    EXPECT_EQ(0, update());
+
+    // a codec failing on the frame derives again on the next one
+    i965_encoder_params_invalidate(&params);
+    EXPECT_EQ(Seq | Misc, update());
+    EXPECT_EQ(0, update());
+}
+
+TEST_F(EncoderParamsTest, Disabled)
+{
+    std::vector<uint8_t> seq(64, 0x5a);
+    buffer_store seqStore(store(seq));
+
+    state.seq_param_ext = &seqStore;
+    params.disabled = 1;
+
+    // the same buffers, seen as changed on every frame
+    for (unsigned i(0); i < 3; ++i)
+        EXPECT_EQ(Seq | Misc, update()) << i;
+    EXPECT_EQ(3u, params.num_changed[I965_ENCODER_PARAMS_SEQ]);
+
+    // tracked again from the next frame on
+    params.disabled = 0;
+    EXPECT_EQ(Seq | Misc, update());
+    EXPECT_EQ(0, update());
+}
+
+} // namespace EncoderParams
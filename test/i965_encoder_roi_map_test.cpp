@@ -0,0 +1,234 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "test_utils.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_encoder_roi_map.h"
+}
+
+#include <algorithm>
+#include <vector>
+
+namespace EncoderROIMap {
+
+typedef std::vector<i965_encoder_roi_rect> Rects;
+
+class EncoderROIMapTest
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        i965_encoder_roi_map_reset(&map);
+    }
+
+    // Paints the whole map the way the per MB loops of the encoders did,
+    // the last rectangle holding an MB wins
+    static void reference(std::vector<uint8_t>& buf, unsigned pitch,
+        unsigned elemSize, unsigned width, unsigned height,
+        uint8_t background, const Rects& rects)
+    {
+        for (unsigned row(0); row < height; ++row) {
+            for (unsigned col(0); col < width; ++col) {
+                uint8_t value(background);
+
+                for (const auto& rect : rects) {
+                    if (col >= rect.left && col < rect.right &&
+                        row >= rect.top && row < rect.bottom)
+                        value = rect.value;
+                }
+                buf[row * pitch + col * elemSize] = value;
+            }
+        }
+    }
+
+    static i965_encoder_roi_rect rect(unsigned left, unsigned top,
+        unsigned width, unsigned height, uint8_t value)
+    {
+        i965_encoder_roi_rect r = {
+            (unsigned short)left, (unsigned short)(left + width),
+            (unsigned short)top, (unsigned short)(top + height), value
+        };
+        return r;
+    }
+
+    // Moves the rectangles around like tracked faces: most of them stay,
+    // some move a little, one comes or goes now and then
+    static void move(Rects& rects, unsigned width, unsigned height)
+    {
+        static const RandomValueGenerator<int> percent(0, 99);
+        static const RandomValueGenerator<int> step(-2, 2);
+        static const RandomValueGenerator<int> size(1, 24);
+        static const RandomValueGenerator<int> value(1, 51);
+
+        for (auto& r : rects) {
+            if (percent() < 30) {
+                const int dx(step()), dy(step());
+
+                r.left = std::max(0, r.left + dx);
+                r.right = std::max<int>(r.left + 1, r.right + dx);
+                r.top = std::max(0, r.top + dy);
+                r.bottom = std::max<int>(r.top + 1, r.bottom + dy);
+            }
+            if (percent() < 5)
+                r.value = value();
+        }
+
+        if (percent() < 10 && !rects.empty())
+            rects.erase(rects.begin() + percent() % rects.size());
+
+        if (percent() < 10 && rects.size() < I965_ENCODER_ROI_MAP_MAX_RECTS) {
+            const RandomValueGenerator<int> left(0, width - 1);
+            const RandomValueGenerator<int> top(0, height - 1);
+
+            rects.push_back(rect(left(), top(), size(), size(), value()));
+        }
+    }
+
+    unsigned paint(std::vector<uint8_t>& buf, unsigned pitch, unsigned elemSize,
+        unsigned width, unsigned height, uint8_t background, const Rects& rects)
+    {
+        return i965_encoder_roi_map_paint(&map, buf.data(), pitch, elemSize,
+            width, height, background, rects.data(), rects.size());
+    }
+
+    i965_encoder_roi_map map;
+};
+
+TEST_F(EncoderROIMapTest, Paint)
+{
+    std::vector<uint8_t> buf(8 * 6, 0xff), ref(buf);
+    Rects rects = {rect(1, 1, 3, 2, 10), rect(2, 2, 4, 3, 20)};
+
+    EXPECT_EQ(1u, paint(buf, 8, 1, 8, 6, 30, rects));
+    reference(ref, 8, 1, 8, 6, 30, rects);
+    EXPECT_EQ(ref, buf);
+
+    // nothing changed, nothing repainted
+    EXPECT_EQ(0u, paint(buf, 8, 1, 8, 6, 30, rects));
+
+    // the area of the old and new rectangle
+    rects[1] = rect(3, 3, 4, 3, 20);
+    EXPECT_EQ(2u, paint(buf, 8, 1, 8, 6, 30, rects));
+    reference(ref, 8, 1, 8, 6, 30, rects);
+    EXPECT_EQ(ref, buf);
+
+    // a new value only repaints its rectangle
+    rects[0].value = 11;
+    EXPECT_EQ(1u, paint(buf, 8, 1, 8, 6, 30, rects));
+    reference(ref, 8, 1, 8, 6, 30, rects);
+    EXPECT_EQ(ref, buf);
+
+    // a new background repaints everything
+    EXPECT_EQ(1u, paint(buf, 8, 1, 8, 6, 31, rects));
+    EXPECT_EQ(8u, map.dirty[0].right);
+    EXPECT_EQ(6u, map.dirty[0].bottom);
+    reference(ref, 8, 1, 8, 6, 31, rects);
+    EXPECT_EQ(ref, buf);
+
+    rects.clear();
+    EXPECT_EQ(2u, paint(buf, 8, 1, 8, 6, 31, rects));
+    reference(ref, 8, 1, 8, 6, 31, rects);
+    EXPECT_EQ(ref, buf);
+}
+
+TEST_F(EncoderROIMapTest, Clip)
+{
+    std::vector<uint8_t> buf(8 * 6), ref(buf);
+    const Rects rects = {rect(6, 4, 10, 10, 1), rect(8, 0, 2, 2, 2)};
+    const Rects clipped = {rect(6, 4, 2, 2, 1)};
+
+    paint(buf, 8, 1, 8, 6, 0, rects);
+    reference(ref, 8, 1, 8, 6, 0, clipped);
+    EXPECT_EQ(ref, buf);
+    EXPECT_EQ(8u, map.rects[0].right);
+    EXPECT_EQ(map.rects[1].left, map.rects[1].right);
+}
+
+TEST_F(EncoderROIMapTest, BitExact)
+{
+    const unsigned width(120), height(68);
+    Rects rects;
+
+    std::srand(0x5eed);
+
+    for (const unsigned elemSize : {1u, 64u}) {
+        // a pitch wider than the row, the bytes around the values stay
+        const unsigned pitch(width * elemSize + 32);
+        std::vector<uint8_t> buf(pitch * height, 0xa5), ref(buf);
+        uint8_t background(0);
+
+        SetUp();
+        rects.clear();
+
+        for (unsigned frame(0); frame < 500; ++frame) {
+            move(rects, width, height);
+
+            if (frame % 97 == 0)
+                background++;
+
+            paint(buf, pitch, elemSize, width, height, background, rects);
+            reference(ref, pitch, elemSize, width, height, background, rects);
+            ASSERT_EQ(ref, buf) << "elemSize " << elemSize << " frame " << frame;
+        }
+    }
+}
+
+TEST_F(EncoderROIMapTest, Benchmark)
+{
+    // 4K in MBs, a few faces moving a little every frame
+    const unsigned width(240), height(135), elemSize(64), numFrames(200);
+    std::vector<uint8_t> full(width * height * elemSize), incremental(full);
+    Rects rects;
+    Timer timer;
+    long fullTime(0), incrementalTime(0);
+
+    std::srand(0xface);
+    for (unsigned i(0); i < I965_ENCODER_ROI_MAP_MAX_RECTS; ++i)
+        rects.push_back(rect(i * 28, i * 15, 12, 14, i + 1));
+
+    for (unsigned frame(0); frame < numFrames; ++frame) {
+        move(rects, width, height);
+
+        timer.reset();
+        reference(full, width * elemSize, elemSize, width, height, 0, rects);
+        fullTime += timer.elapsed();
+
+        timer.reset();
+        paint(incremental, width * elemSize, elemSize, width, height, 0, rects);
+        incrementalTime += timer.elapsed();
+
+        ASSERT_EQ(full, incremental) << frame;
+    }
+
+    ::testing::Test::RecordProperty("full_us_per_frame", fullTime / numFrames);
+    ::testing::Test::RecordProperty("incremental_us_per_frame", incrementalTime / numFrames);
+    std::cout << "4K stream-in ROI, us per frame: full " << fullTime / numFrames
+              << ", incremental " << incrementalTime / numFrames << std::endl;
+}
+
+} // namespace EncoderROIMap
@@ -0,0 +1,403 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_encoder_status.h"
+}
+
+#include <cstddef>
+#include <vector>
+
+namespace EncoderStatus {
+
+class EncoderStatusRingTest
+    : public ::testing::Test
+{
+protected:
+    static const unsigned NumSlots = 8;
+    static const unsigned NumPipes = 2;
+
+    virtual void SetUp()
+    {
+        i965_encoder_status_record *pipeRecords[NumPipes];
+
+        ring = i965_encoder_status_ring();
+        for (unsigned i(0); i < NumPipes; ++i) {
+            records[i].resize(NumSlots);
+            pipeRecords[i] = records[i].data();
+        }
+        i965_encoder_status_ring_init(&ring, pipeRecords, NumPipes, NumSlots);
+    }
+
+    virtual void TearDown()
+    {
+        i965_encoder_status_ring_free(&ring);
+    }
+
+    uint32_t begin(VABufferID codedBuf)
+    {
+        return i965_encoder_status_ring_begin_frame(&ring, codedBuf, NULL);
+    }
+
+    // Writes the status of a frame the way the PAK does, frame id last
+    void complete(uint32_t frameID, uint32_t bytes, unsigned pipe = 0)
+    {
+        i965_encoder_status_record& record = records[pipe][frameID % NumSlots];
+
+        ring.slots[frameID % NumSlots].pipe = pipe;
+
+        record.bs_byte_count_frame = bytes;
+        record.num_passes = 1;
+        record.frame_id = frameID;
+    }
+
+    // The status of a frame, or the error of the query
+    VAStatus query(uint32_t frameID, i965_encoder_status_record& record)
+    {
+        return i965_encoder_status_ring_query(&ring, frameID, &record);
+    }
+
+    std::vector<i965_encoder_status_record> harvest(unsigned max = NumSlots)
+    {
+        std::vector<i965_encoder_status_record> out(max);
+
+        out.resize(i965_encoder_status_ring_harvest(&ring, out.data(), max));
+        return out;
+    }
+
+    i965_encoder_status_ring ring;
+    std::vector<i965_encoder_status_record> records[NumPipes];
+};
+
+TEST_F(EncoderStatusRingTest, OutOfOrderCompletion)
+{
+    std::vector<uint32_t> ids;
+    i965_encoder_status_record record;
+
+    for (unsigned i(0); i < 4; ++i)
+        ids.push_back(begin(0x08000000 + i));
+
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(ids[0], record));
+
+    // the later frames finish first, each one is reported on its own
+    complete(ids[2], 300);
+    complete(ids[1], 200);
+
+    ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[2], record));
+    EXPECT_EQ(ids[2], record.frame_id);
+    EXPECT_EQ(0x08000002u, record.coded_buf);
+    EXPECT_EQ(300u, record.bs_byte_count_frame);
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(ids[0], record));
+
+    complete(ids[0], 100);
+
+    for (unsigned i(0); i < 3; ++i) {
+        ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[i], record));
+        EXPECT_EQ(ids[i], record.frame_id);
+        EXPECT_EQ(0x08000000 + i, record.coded_buf);
+        EXPECT_EQ(100 * (i + 1), record.bs_byte_count_frame);
+        EXPECT_EQ(1u, record.num_passes);
+    }
+
+    // a done frame stays in the ring, the last one is still in flight
+    EXPECT_EQ(VA_STATUS_SUCCESS, query(ids[1], record));
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(ids[3], record));
+    EXPECT_EQ(VA_STATUS_ERROR_INVALID_PARAMETER, query(ids[3] + 1, record));
+
+    complete(ids[3], 400);
+    ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[3], record));
+    EXPECT_EQ(400u, record.bs_byte_count_frame);
+}
+
+TEST_F(EncoderStatusRingTest, StaleStatusIsIgnored)
+{
+    const uint32_t first(begin(0x08000000));
+    i965_encoder_status_record record;
+
+    complete(first, 100);
+    ASSERT_EQ(VA_STATUS_SUCCESS, query(first, record));
+
+    // the slot is reused after wrapping around, the old status must not
+    // be reported for the new frame
+    uint32_t id(0);
+    for (unsigned i(0); i < NumSlots; ++i) {
+        id = begin(0x08000100 + i);
+        if (id % NumSlots != first % NumSlots)
+            complete(id, 1);
+    }
+    ASSERT_EQ(first % NumSlots, id % NumSlots);
+
+    EXPECT_EQ(VA_STATUS_ERROR_INVALID_PARAMETER, query(first, record));
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(id, record));
+    records[0][id % NumSlots].frame_id = first;
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(id, record));
+}
+
+TEST_F(EncoderStatusRingTest, TwoPipes)
+{
+    std::vector<uint32_t> ids;
+    i965_encoder_status_record record;
+
+    for (unsigned i(0); i < 4; ++i)
+        ids.push_back(begin(0x08000000 + i));
+
+    // the odd frames run on the second pipe and finish first
+    complete(ids[3], 4000, 1);
+    complete(ids[1], 2000, 1);
+
+    ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[1], record));
+    EXPECT_EQ(2000u, record.bs_byte_count_frame);
+    EXPECT_EQ(0x08000001u, record.coded_buf);
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(ids[0], record));
+
+    complete(ids[0], 1000, 0);
+    complete(ids[2], 3000, 0);
+
+    for (unsigned i(0); i < ids.size(); ++i) {
+        ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[i], record));
+        EXPECT_EQ(ids[i], record.frame_id);
+        EXPECT_EQ(1000 * (i + 1), record.bs_byte_count_frame);
+    }
+}
+
+TEST_F(EncoderStatusRingTest, OverwriteOldestWhenFull)
+{
+    std::vector<uint32_t> ids;
+    i965_encoder_status_record record;
+
+    for (unsigned i(0); i < NumSlots + 2; ++i)
+        ids.push_back(begin(0x08000000 + i));
+
+    EXPECT_EQ(VA_STATUS_ERROR_INVALID_PARAMETER, query(ids[0], record));
+    EXPECT_EQ(VA_STATUS_ERROR_INVALID_PARAMETER, query(ids[1], record));
+
+    for (unsigned i(2); i < ids.size(); ++i)
+        complete(ids[i], i);
+
+    for (unsigned i(2); i < ids.size(); ++i) {
+        ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[i], record));
+        EXPECT_EQ(ids[i], record.frame_id);
+        EXPECT_EQ(i, record.bs_byte_count_frame);
+    }
+}
+
+TEST_F(EncoderStatusRingTest, Hints)
+{
+    std::vector<uint32_t> ids;
+    i965_encoder_status_record record;
+
+    // no frame yet, nothing to attach the hints to
+    EXPECT_EQ(0u, i965_encoder_status_ring_last_frame_id(&ring));
+    i965_encoder_status_ring_set_hints(&ring, 0, I965_ENCODER_STATUS_HINT_SCENE_CUT);
+
+    ids.push_back(begin(0x08000000));
+    EXPECT_EQ(ids.back(), i965_encoder_status_ring_last_frame_id(&ring));
+    ids.push_back(begin(0x08000001));
+    ids.push_back(begin(0x08000002));
+
+    // the hints of a frame come once the next ones are begun
+    i965_encoder_status_ring_set_hints(&ring, ids[0], I965_ENCODER_STATUS_HINT_SCENE_CUT);
+    i965_encoder_status_ring_set_hints(&ring, ids[2], I965_ENCODER_STATUS_HINT_STATIC_SCENE);
+    EXPECT_EQ(ids[2], i965_encoder_status_ring_last_frame_id(&ring));
+
+    for (unsigned i(0); i < ids.size(); ++i)
+        complete(ids[i], 100);
+
+    const uint32_t expected[] = {
+        I965_ENCODER_STATUS_HINT_SCENE_CUT,
+        0,
+        I965_ENCODER_STATUS_HINT_STATIC_SCENE,
+    };
+
+    for (unsigned i(0); i < ids.size(); ++i) {
+        ASSERT_EQ(VA_STATUS_SUCCESS, query(ids[i], record));
+        EXPECT_EQ(expected[i], record.hints);
+    }
+
+    // a reused slot starts without hints
+    for (unsigned i(0); i < NumSlots; ++i)
+        begin(0x08000100 + i);
+    EXPECT_EQ(0u, ring.slots[ids[0] % NumSlots].hints);
+
+    // the frame has left the ring, its hints do not land on the new one
+    i965_encoder_status_ring_set_hints(&ring, ids[0], I965_ENCODER_STATUS_HINT_SCENE_CUT);
+    EXPECT_EQ(0u, ring.slots[ids[0] % NumSlots].hints);
+}
+
+TEST_F(EncoderStatusRingTest, HarvestInEncodingOrder)
+{
+    std::vector<uint32_t> ids;
+    i965_encoder_status_record record;
+
+    for (unsigned i(0); i < 4; ++i)
+        ids.push_back(begin(0x08000000 + i));
+
+    EXPECT_TRUE(harvest().empty());
+
+    // nothing is handed out before frame 0 completes
+    complete(ids[2], 300);
+    complete(ids[1], 200);
+    EXPECT_TRUE(harvest().empty());
+
+    complete(ids[0], 100);
+
+    std::vector<i965_encoder_status_record> done(harvest());
+    ASSERT_EQ(3u, done.size());
+    for (unsigned i(0); i < done.size(); ++i) {
+        EXPECT_EQ(ids[i], done[i].frame_id);
+        EXPECT_EQ(0x08000000 + i, done[i].coded_buf);
+        EXPECT_EQ(100 * (i + 1), done[i].bs_byte_count_frame);
+    }
+
+    // harvested frames can still be queried, and are handed out once
+    EXPECT_EQ(VA_STATUS_SUCCESS, query(ids[1], record));
+    EXPECT_TRUE(harvest().empty());
+
+    complete(ids[3], 400);
+    done = harvest();
+    ASSERT_EQ(1u, done.size());
+    EXPECT_EQ(400u, done[0].bs_byte_count_frame);
+}
+
+TEST_F(EncoderStatusRingTest, HarvestInBatches)
+{
+    std::vector<uint32_t> ids;
+
+    for (unsigned i(0); i < 6; ++i)
+        ids.push_back(begin(0x08000000 + i));
+
+    for (unsigned i(6); i > 0; --i)
+        complete(ids[i - 1], 10 * i);
+
+    std::vector<i965_encoder_status_record> done(harvest(4));
+    ASSERT_EQ(4u, done.size());
+    EXPECT_EQ(ids[3], done[3].frame_id);
+
+    done = harvest(4);
+    ASSERT_EQ(2u, done.size());
+    EXPECT_EQ(ids[4], done[0].frame_id);
+    EXPECT_EQ(60u, done[1].bs_byte_count_frame);
+    EXPECT_TRUE(harvest().empty());
+}
+
+TEST_F(EncoderStatusRingTest, HarvestCountsOverwrittenFrames)
+{
+    std::vector<uint32_t> ids;
+
+    ids.push_back(begin(0x08000000));
+    complete(ids[0], 1);
+    ASSERT_EQ(1u, harvest().size());
+
+    // a harvested frame is overwritten silently, the others are counted
+    for (unsigned i(1); i < NumSlots + 3; ++i)
+        ids.push_back(begin(0x08000000 + i));
+    EXPECT_EQ(2u, ring.num_dropped);
+
+    for (unsigned i(3); i < ids.size(); ++i)
+        complete(ids[i], i);
+
+    std::vector<i965_encoder_status_record> done(harvest());
+    ASSERT_EQ(size_t(NumSlots), done.size());
+    EXPECT_EQ(ids[3], done.front().frame_id);
+    EXPECT_EQ(ids.back(), done.back().frame_id);
+}
+
+// The ring holds the coded buffer of a frame in flight only
+TEST_F(EncoderStatusRingTest, CodedBufferReleasedOnceDone)
+{
+    dri_bufmgr *bufmgr(intel_null_hw_bufmgr_init(0x1912));
+    ASSERT_PTR(bufmgr);
+
+    dri_bo *coded[2] = {
+        dri_bo_alloc(bufmgr, "coded 0", 4096, 4096),
+        dri_bo_alloc(bufmgr, "coded 1", 4096, 4096),
+    };
+    ASSERT_PTR(coded[0]);
+    ASSERT_PTR(coded[1]);
+
+    i965_encoder_status_record record;
+    const uint32_t first(
+        i965_encoder_status_ring_begin_frame(&ring, 0x08000000, coded[0]));
+    const uint32_t second(
+        i965_encoder_status_ring_begin_frame(&ring, 0x08000001, coded[1]));
+
+    EXPECT_EQ(coded[0], ring.slots[first % NumSlots].coded_bo);
+    EXPECT_EQ(coded[1], ring.slots[second % NumSlots].coded_bo);
+
+    // done once queried
+    complete(first, 100);
+    ASSERT_EQ(VA_STATUS_SUCCESS, query(first, record));
+    EXPECT_PTR_NULL(ring.slots[first % NumSlots].coded_bo);
+
+    // or when the next frame starts
+    complete(second, 200);
+    const uint32_t third(
+        i965_encoder_status_ring_begin_frame(&ring, 0x08000000, coded[0]));
+    EXPECT_PTR_NULL(ring.slots[second % NumSlots].coded_bo);
+    EXPECT_EQ(coded[0], ring.slots[third % NumSlots].coded_bo);
+
+    // the application destroys the coded buffer of a frame in flight
+    i965_encoder_status_ring_forget_coded_bo(&ring, coded[0]);
+    EXPECT_PTR_NULL(ring.slots[third % NumSlots].coded_bo);
+    EXPECT_EQ(VA_STATUS_ERROR_SURFACE_BUSY, query(third, record));
+    complete(third, 300);
+    EXPECT_EQ(VA_STATUS_SUCCESS, query(third, record));
+
+    dri_bo_unreference(coded[0]);
+    dri_bo_unreference(coded[1]);
+    i965_encoder_status_ring_free(&ring);
+    dri_bufmgr_destroy(bufmgr);
+}
+
+// Applications read the statistics as they are, no field may move
+TEST(EncoderBrcStatsTest, Layout)
+{
+    EXPECT_EQ(1, I965_CODED_BUFFER_BRC_STATS_VERSION);
+    EXPECT_EQ(size_t(64), sizeof(i965_coded_buffer_brc_stats));
+
+    EXPECT_EQ(size_t(0), offsetof(i965_coded_buffer_brc_stats, version));
+    EXPECT_EQ(size_t(4), offsetof(i965_coded_buffer_brc_stats, size));
+    EXPECT_EQ(size_t(8), offsetof(i965_coded_buffer_brc_stats, frame_id));
+    EXPECT_EQ(size_t(12), offsetof(i965_coded_buffer_brc_stats, target_bits));
+    EXPECT_EQ(size_t(16), offsetof(i965_coded_buffer_brc_stats, actual_bytes));
+    EXPECT_EQ(size_t(20), offsetof(i965_coded_buffer_brc_stats, actual_bytes_nh));
+    EXPECT_EQ(size_t(24), offsetof(i965_coded_buffer_brc_stats, qp_status_reg));
+    EXPECT_EQ(size_t(28), offsetof(i965_coded_buffer_brc_stats, image_status_ctrl));
+    EXPECT_EQ(size_t(32), offsetof(i965_coded_buffer_brc_stats, num_passes));
+    EXPECT_EQ(size_t(36), offsetof(i965_coded_buffer_brc_stats, hrd_buffer_size));
+    EXPECT_EQ(size_t(40), offsetof(i965_coded_buffer_brc_stats, hrd_buffer_fullness));
+    EXPECT_EQ(size_t(44), offsetof(i965_coded_buffer_brc_stats, hrd_num_underflows));
+    EXPECT_EQ(size_t(48), offsetof(i965_coded_buffer_brc_stats, hints));
+
+    // the header of the coded buffer stays one page, the PAK writes the
+    // statistics with 4 bytes stores
+    EXPECT_LE(sizeof(i965_coded_buffer_segment), size_t(0x1000));
+    EXPECT_EQ(size_t(0), offsetof(i965_coded_buffer_segment, brc_stats) % 4);
+    EXPECT_EQ(size_t(0), offsetof(i965_coded_buffer_segment, codec_private_data) % 16);
+}
+
+} // namespace EncoderStatus
@@ -0,0 +1,284 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_drv_video.h"
+    #include "i965_decoder_utils.h"
+    #include "intel_media.h"
+}
+
+#include <map>
+#include <set>
+#include <vector>
+
+namespace FrameStore {
+
+class FrameStoreTest
+    : public ::testing::Test
+{
+protected:
+    static const unsigned NumSurfaces = 32;
+
+    virtual void SetUp()
+    {
+        bo = dri_bo();
+        surfaces.resize(NumSurfaces);
+        codecSurfaces.resize(NumSurfaces);
+        for (unsigned i(0); i < NumSurfaces; ++i) {
+            surfaces[i] = object_surface();
+            surfaces[i].base.id = 0x04000000 + i;
+            surfaces[i].bo = &bo;
+            codecSurfaces[i].frame_store_id = -1;
+            surfaces[i].private_data = &codecSurfaces[i];
+        }
+        reset();
+    }
+
+    void reset()
+    {
+        for (unsigned i(0); i < MAX_GEN_REFERENCE_FRAMES; ++i) {
+            frameStore[i].surface_id = VA_INVALID_ID;
+            frameStore[i].frame_store_id = -1;
+            frameStore[i].obj_surface = NULL;
+            frameStore[i].ref_age = 0;
+        }
+        for (unsigned i(0); i < NumSurfaces; ++i)
+            codecSurfaces[i].frame_store_id = -1;
+        fsContext = GenFrameStoreContext();
+        decodeState = decode_state();
+    }
+
+    VASurfaceID surfaceID(int i) const
+    {
+        return surfaces[i].base.id;
+    }
+
+    void setReferences(const std::vector<int>& refs)
+    {
+        for (unsigned i(0); i < ARRAY_ELEMS(decodeState.reference_objects); ++i) {
+            decodeState.reference_objects[i] =
+                (i < refs.size() && refs[i] >= 0) ? &surfaces[refs[i]] : NULL;
+        }
+    }
+
+    // Runs one AVC picture and returns the surface index to slot mapping
+    std::map<int, int> decodeAVC(int poc, const std::vector<int>& refs)
+    {
+        VAPictureParameterBufferH264 picParam = {};
+        std::map<int, int> slots;
+        std::set<int> used;
+
+        picParam.CurrPic.TopFieldOrderCnt = poc;
+        picParam.CurrPic.BottomFieldOrderCnt = poc;
+
+        setReferences(refs);
+        intel_update_avc_frame_store_index(NULL, &decodeState, &picParam,
+            frameStore, &fsContext);
+
+        for (const int ref : refs) {
+            const int id(codecSurfaces[ref].frame_store_id);
+
+            EXPECT_LE(0, id);
+            EXPECT_GT(MAX_GEN_REFERENCE_FRAMES, id);
+            if (id < 0 || id >= MAX_GEN_REFERENCE_FRAMES)
+                continue;
+            EXPECT_EQ(surfaceID(ref), frameStore[id].surface_id);
+            EXPECT_TRUE(&surfaces[ref] == frameStore[id].obj_surface);
+            EXPECT_TRUE(used.insert(id).second) << "slot " << id << " shared";
+            slots[ref] = id;
+        }
+        return slots;
+    }
+
+    dri_bo bo;
+    std::vector<object_surface> surfaces;
+    std::vector<GenCodecSurface> codecSurfaces;
+    GenFrameStore frameStore[MAX_GEN_REFERENCE_FRAMES];
+    GenFrameStoreContext fsContext;
+    decode_state decodeState;
+};
+
+TEST_F(FrameStoreTest, AVCSlidingWindow)
+{
+    std::map<int, int> previous;
+
+    // IPPP... with 4 reference frames out of a pool of 8 surfaces
+    for (int frame(1); frame < 64; ++frame) {
+        std::vector<int> refs;
+        for (int r(1); r <= 4 && frame - r >= 0; ++r)
+            refs.push_back((frame - r) % 8);
+
+        const std::map<int, int> slots = decodeAVC(2 * frame, refs);
+        ASSERT_FALSE(HasFailure()) << "frame " << frame;
+
+        // references carried over keep their slot
+        for (const auto& slot : slots) {
+            const auto prev = previous.find(slot.first);
+            if (prev != previous.end())
+                EXPECT_EQ(prev->second, slot.second);
+        }
+        previous = slots;
+    }
+}
+
+TEST_F(FrameStoreTest, AVCFullDPB)
+{
+    std::vector<int> refs;
+
+    for (int i(0); i < MAX_GEN_REFERENCE_FRAMES; ++i)
+        refs.push_back(i);
+    decodeAVC(0, refs);
+    ASSERT_FALSE(HasFailure());
+
+    // replace every other reference with a new surface
+    for (int i(0); i < MAX_GEN_REFERENCE_FRAMES; i += 2)
+        refs[i] += MAX_GEN_REFERENCE_FRAMES;
+    decodeAVC(2, refs);
+    ASSERT_FALSE(HasFailure());
+}
+
+TEST_F(FrameStoreTest, AVCLeastRecentlyUsed)
+{
+    // occupy slots 0..3
+    std::map<int, int> slots = decodeAVC(0, {0, 1, 2, 3});
+    ASSERT_FALSE(HasFailure());
+    for (int i(0); i < 4; ++i)
+        EXPECT_EQ(i, slots[i]);
+
+    // surfaces 1 and 3 retire, 2 then 0 later on
+    decodeAVC(2, {0, 2});
+    decodeAVC(4, {2});
+    ASSERT_FALSE(HasFailure());
+
+    // never used slots come first, then the oldest retired ones
+    slots = decodeAVC(6, {2, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+        21, 22, 23, 24});
+    ASSERT_FALSE(HasFailure());
+    EXPECT_EQ(2, slots[2]);
+    for (int i(10); i < 22; ++i)
+        EXPECT_EQ(i - 6, slots[i]);
+    EXPECT_EQ(1, slots[22]);
+    EXPECT_EQ(3, slots[23]);
+    EXPECT_EQ(0, slots[24]);
+}
+
+TEST_F(FrameStoreTest, AVCDeterministic)
+{
+    std::vector<std::map<int, int> > runs[2];
+
+    for (unsigned run(0); run < 2; ++run) {
+        reset();
+        std::srand(42);
+        for (int frame(0); frame < 128; ++frame) {
+            std::set<int> refs;
+            const int count(std::rand() % MAX_GEN_REFERENCE_FRAMES);
+            while (refs.size() < (size_t)count)
+                refs.insert(std::rand() % NumSurfaces);
+            runs[run].push_back(decodeAVC(frame,
+                std::vector<int>(refs.begin(), refs.end())));
+            ASSERT_FALSE(HasFailure()) << "frame " << frame;
+        }
+    }
+    EXPECT_TRUE(runs[0] == runs[1]);
+}
+
+TEST_F(FrameStoreTest, HEVCCompact)
+{
+    VAPictureParameterBufferHEVC picParam = {};
+
+    setReferences({3, -1, 5, -1, -1, 7});
+    intel_update_hevc_frame_store_index(NULL, &decodeState, &picParam,
+        frameStore, &fsContext);
+
+    const int expect[] = {3, 5, 7};
+    for (int i(0); i < MAX_GEN_HCP_REFERENCE_FRAMES; ++i) {
+        if (i < 3) {
+            EXPECT_EQ(surfaceID(expect[i]), frameStore[i].surface_id);
+            EXPECT_EQ(i, frameStore[i].frame_store_id);
+        } else {
+            EXPECT_INVALID_ID(frameStore[i].surface_id);
+            EXPECT_EQ(-1, frameStore[i].frame_store_id);
+        }
+    }
+}
+
+TEST_F(FrameStoreTest, VP8Fallback)
+{
+    VAPictureParameterBufferVP8 picParam = {};
+
+    picParam.last_ref_frame = surfaceID(1);
+    picParam.golden_ref_frame = VA_INVALID_ID;
+    picParam.alt_ref_frame = surfaceID(4);
+    setReferences({1, -1, 4});
+    intel_update_vp8_frame_store_index(NULL, &decodeState, &picParam,
+        frameStore);
+
+    EXPECT_EQ(surfaceID(1), frameStore[0].surface_id);
+    EXPECT_EQ(surfaceID(1), frameStore[1].surface_id);
+    EXPECT_EQ(surfaceID(4), frameStore[2].surface_id);
+    for (int i(3); i < MAX_GEN_REFERENCE_FRAMES; ++i)
+        EXPECT_EQ(frameStore[i % 2].surface_id, frameStore[i].surface_id);
+}
+
+TEST_F(FrameStoreTest, VP9Fallback)
+{
+    VADecPictureParameterBufferVP9 picParam = {};
+
+    for (unsigned i(0); i < ARRAY_ELEMS(picParam.reference_frames); ++i)
+        picParam.reference_frames[i] = surfaceID(i);
+    picParam.pic_fields.bits.last_ref_frame = 2;
+    picParam.pic_fields.bits.golden_ref_frame = 5;
+    picParam.pic_fields.bits.alt_ref_frame = 7;
+    picParam.reference_frames[7] = VA_INVALID_ID;
+    setReferences({2, 5, -1});
+    intel_update_vp9_frame_store_index(NULL, &decodeState, &picParam,
+        frameStore);
+
+    EXPECT_EQ(surfaceID(2), frameStore[0].surface_id);
+    EXPECT_EQ(surfaceID(5), frameStore[1].surface_id);
+    EXPECT_EQ(surfaceID(2), frameStore[2].surface_id);
+    for (int i(3); i < MAX_GEN_REFERENCE_FRAMES; ++i)
+        EXPECT_EQ(frameStore[i % 2].surface_id, frameStore[i].surface_id);
+}
+
+TEST_F(FrameStoreTest, VC1ForwardOnly)
+{
+    VAPictureParameterBufferVC1 picParam = {};
+
+    picParam.forward_reference_picture = surfaceID(6);
+    picParam.backward_reference_picture = VA_INVALID_ID;
+    setReferences({6});
+    intel_update_vc1_frame_store_index(NULL, &decodeState, &picParam,
+        frameStore);
+
+    for (int i(0); i < MAX_GEN_REFERENCE_FRAMES; ++i) {
+        EXPECT_EQ(surfaceID(6), frameStore[i].surface_id);
+        EXPECT_TRUE(&surfaces[6] == frameStore[i].obj_surface);
+    }
+}
+
+} // namespace FrameStore
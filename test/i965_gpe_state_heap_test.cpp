@@ -0,0 +1,246 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_test_fixture.h"
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+    #include "i965_gpe_utils.h"
+    #include "intel_batchbuffer.h"
+}
+
+/*
+ * The batches of these tests are never meant for the GPU, they need the
+ * null hardware backend: run them with VA_INTEL_NULL_HW=<PCI id> of a
+ * Gen8+ device, e.g. VA_INTEL_NULL_HW=0x1912.
+ */
+class GPEStateHeapTest
+    : public I965TestFixture
+{
+protected:
+    void SetUp()
+    {
+        I965TestFixture::SetUp();
+
+        memset(&heap, 0, sizeof(heap));
+        memset(gpe_contexts, 0, sizeof(gpe_contexts));
+        for (auto& gpe_context : gpe_contexts) {
+            gpe_context.surface_state_binding_table.length = 4096;
+            gpe_context.idrt.max_entries = 1;
+            gpe_context.idrt.entry_size = 32;
+            gpe_context.curbe.length = 128;
+        }
+        batch = NULL;
+    }
+
+    void TearDown()
+    {
+        for (auto& gpe_context : gpe_contexts)
+            gen8_gpe_context_destroy(&gpe_context);
+        i965_gpe_state_heap_destroy(&heap);
+        if (batch)
+            intel_batchbuffer_free(batch);
+        I965TestFixture::TearDown();
+    }
+
+    bool isSkipped()
+    {
+        struct i965_driver_data *i965(*this);
+
+        if (not I965TestEnvironment::instance()->isNullHW()) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " needs VA_INTEL_NULL_HW" << std::endl;
+            return true;
+        }
+
+        if (not i965 or i965->intel.device_info->gen < 8) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " is unsupported on this hardware" << std::endl;
+            return true;
+        }
+
+        return false;
+    }
+
+    /* the heap and its batch, as an encoder context sets them up */
+    void createHeap()
+    {
+        struct i965_driver_data *i965(*this);
+
+        batch = intel_batchbuffer_new(&i965->intel, I915_EXEC_RENDER, 0);
+        ASSERT_PTR(batch);
+
+        i965_gpe_state_heap_init(&heap, batch);
+        i965_gpe_context_set_state_heap(gpe_contexts, 2, &heap);
+    }
+
+    /* emits STATE_BASE_ADDRESS and the rest of the media state */
+    void setup(struct i965_gpe_context *gpe_context)
+    {
+        struct i965_driver_data *i965(*this);
+
+        if (i965->intel.device_info->gen >= 9)
+            gen9_gpe_pipeline_setup(*this, gpe_context, batch);
+        else
+            gen8_gpe_pipeline_setup(*this, gpe_context, batch);
+    }
+
+    struct i965_gpe_state_heap heap;
+    struct i965_gpe_context gpe_contexts[2];
+    struct intel_batchbuffer *batch;
+};
+
+TEST_F(GPEStateHeapTest, ReuseIdleState)
+{
+    if (isSkipped())
+        return;
+
+    ASSERT_NO_FAILURE(createHeap());
+
+    struct i965_gpe_context *gpe_context = &gpe_contexts[0];
+
+    for (unsigned i = 0; i < 16; ++i)
+        gen8_gpe_context_init(*this, gpe_context);
+
+    /* Only the first init allocates, nothing was ever submitted */
+    EXPECT_EQ(2u, heap.num_bo_allocs);
+    EXPECT_EQ(30u, heap.num_bo_reuses);
+}
+
+TEST_F(GPEStateHeapTest, KeepStateReferencedByBatch)
+{
+    if (isSkipped())
+        return;
+
+    ASSERT_NO_FAILURE(createHeap());
+
+    struct i965_gpe_context *gpe_context = &gpe_contexts[0];
+
+    gen8_gpe_context_init(*this, gpe_context);
+
+    dri_bo *surface_state_bo = gpe_context->surface_state_binding_table.bo;
+    dri_bo *dynamic_state_bo = gpe_context->dynamic_state.bo;
+
+    setup(gpe_context);
+
+    /* The state of the previous dispatch is still in the batch */
+    gen8_gpe_context_init(*this, gpe_context);
+
+    EXPECT_NE(surface_state_bo, gpe_context->surface_state_binding_table.bo);
+    EXPECT_NE(dynamic_state_bo, gpe_context->dynamic_state.bo);
+    EXPECT_EQ(4u, heap.num_bo_allocs);
+    EXPECT_EQ(0u, heap.num_bo_reuses);
+
+    /* Only the retired BOs that aren't in the batch get recycled */
+    gen8_gpe_context_init(*this, gpe_context);
+
+    EXPECT_EQ(4u, heap.num_bo_allocs);
+    EXPECT_EQ(2u, heap.num_bo_reuses);
+    EXPECT_NE(surface_state_bo, gpe_context->surface_state_binding_table.bo);
+    EXPECT_NE(dynamic_state_bo, gpe_context->dynamic_state.bo);
+}
+
+TEST_F(GPEStateHeapTest, ReuseStateOfSubmittedBatch)
+{
+    if (isSkipped())
+        return;
+
+    ASSERT_NO_FAILURE(createHeap());
+
+    struct i965_gpe_context *gpe_context = &gpe_contexts[0];
+
+    gen8_gpe_context_init(*this, gpe_context);
+
+    dri_bo *surface_state_bo = gpe_context->surface_state_binding_table.bo;
+    dri_bo *dynamic_state_bo = gpe_context->dynamic_state.bo;
+
+    setup(gpe_context);
+    intel_batchbuffer_flush(batch);
+
+    /* Once submitted, only the GPU may still use the state: the heap
+     * holds no reference on the batch buffer and recycles them right
+     * away as the null hardware is never busy */
+    gen8_gpe_context_init(*this, gpe_context);
+
+    EXPECT_EQ(surface_state_bo, gpe_context->surface_state_binding_table.bo);
+    EXPECT_EQ(dynamic_state_bo, gpe_context->dynamic_state.bo);
+    EXPECT_EQ(2u, heap.num_bo_allocs);
+    EXPECT_EQ(2u, heap.num_bo_reuses);
+    EXPECT_EQ(batch, heap.batch);
+}
+
+TEST_F(GPEStateHeapTest, EvictOldestRetiredState)
+{
+    if (isSkipped())
+        return;
+
+    ASSERT_NO_FAILURE(createHeap());
+
+    struct i965_gpe_context *gpe_context = &gpe_contexts[0];
+    std::vector<dri_bo *> retired;
+
+    /* Every dispatch keeps its state busy, nothing is recycled */
+    for (unsigned i = 0; i < GPE_STATE_HEAP_SLOTS + 2; ++i) {
+        gen8_gpe_context_init(*this, gpe_context);
+        retired.push_back(gpe_context->surface_state_binding_table.bo);
+        setup(gpe_context);
+    }
+    gen8_gpe_context_init(*this, gpe_context);
+
+    EXPECT_EQ(0u, heap.num_bo_reuses);
+
+    /* The most recently retired BOs are kept, oldest first */
+    const size_t first(retired.size() - GPE_STATE_HEAP_SLOTS);
+    for (unsigned i = 0; i < GPE_STATE_HEAP_SLOTS; ++i)
+        EXPECT_EQ(retired[first + i], heap.surface_state_bo[i]) << i;
+}
+
+TEST_F(GPEStateHeapTest, SharedAcrossContexts)
+{
+    if (isSkipped())
+        return;
+
+    ASSERT_NO_FAILURE(createHeap());
+
+    gen8_gpe_context_init(*this, &gpe_contexts[0]);
+
+    dri_bo *surface_state_bo = gpe_contexts[0].surface_state_binding_table.bo;
+    dri_bo *dynamic_state_bo = gpe_contexts[0].dynamic_state.bo;
+
+    setup(&gpe_contexts[0]);
+    gen8_gpe_context_init(*this, &gpe_contexts[0]);
+    intel_batchbuffer_flush(batch);
+
+    /* The other kernel picks up the state the first one retired */
+    gen8_gpe_context_init(*this, &gpe_contexts[1]);
+
+    EXPECT_EQ(surface_state_bo, gpe_contexts[1].surface_state_binding_table.bo);
+    EXPECT_EQ(dynamic_state_bo, gpe_contexts[1].dynamic_state.bo);
+    EXPECT_EQ(4u, heap.num_bo_allocs);
+    EXPECT_EQ(2u, heap.num_bo_reuses);
+}
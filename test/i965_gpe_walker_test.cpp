@@ -0,0 +1,254 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "i965_gpe_walker.h"
+}
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+
+namespace Walker {
+
+// The MB order previously open-coded in gen7_vme_walker_fill_vme_batchbuffer()
+bool
+referenceInBounds(int x, int y, int first, int num, int width, int height)
+{
+    if (x < 0 || x >= width || y < 0 || y >= height)
+        return false;
+    const int index(y * width + x);
+    return index >= first && index <= first + num;
+}
+
+std::vector<std::pair<int, int> >
+referenceOrder26(int width, int height, int first, int num)
+{
+    std::vector<std::pair<int, int> > order;
+    int x_outer(first % width), y_outer(first / width);
+
+    for (; x_outer < (width - 2) &&
+        referenceInBounds(x_outer, y_outer, first, num, width, height);) {
+        int x(x_outer), y(y_outer);
+        for (; referenceInBounds(x, y, first, num, width, height); x -= 2, ++y)
+            order.push_back(std::make_pair(x, y));
+        x_outer += 1;
+    }
+
+    const int xtemp_outer(std::max(width - 2, 0));
+    x_outer = xtemp_outer;
+    y_outer = first / width;
+    for (; referenceInBounds(x_outer, y_outer, first, num, width, height);) {
+        int x(x_outer), y(y_outer);
+        for (; referenceInBounds(x, y, first, num, width, height); x -= 2, ++y)
+            order.push_back(std::make_pair(x, y));
+        x_outer++;
+        if (x_outer >= width) {
+            y_outer += 1;
+            x_outer = xtemp_outer;
+        }
+    }
+
+    return order;
+}
+
+std::vector<std::pair<int, int> >
+order26(int width, int height, int first, int num)
+{
+    std::vector<std::pair<int, int> > order;
+    struct i965_walker_26_iter iter;
+    int x, y;
+
+    i965_walker_26_begin(&iter, width, height, first, num);
+    while (i965_walker_26_next(&iter, &x, &y))
+        order.push_back(std::make_pair(x, y));
+
+    return order;
+}
+
+TEST(WalkerTest, Order26)
+{
+    for (int width(1); width <= 10; ++width) {
+        for (int height(1); height <= 6; ++height) {
+            for (int first(0); first < width * height; ++first) {
+                for (int num(1); first + num <= width * height; ++num) {
+                    ASSERT_EQ(referenceOrder26(width, height, first, num),
+                        order26(width, height, first, num))
+                        << width << "x" << height << " first " << first
+                        << " num " << num;
+                }
+            }
+        }
+    }
+}
+
+TEST(WalkerTest, Order26Frame)
+{
+    // every MB once, after the MBs it waits on
+    const int width(120), height(68);
+    const std::vector<std::pair<int, int> > order(
+        order26(width, height, 0, width * height));
+    std::vector<int> rank(width * height, -1);
+
+    ASSERT_EQ(size_t(width * height), order.size());
+
+    for (size_t i(0); i < order.size(); ++i) {
+        const int x(order[i].first), y(order[i].second);
+        ASSERT_EQ(-1, rank[y * width + x]);
+        rank[y * width + x] = i;
+
+        if (x > 0) {
+            EXPECT_NE(-1, rank[y * width + x - 1]);
+        }
+        if (y > 0) {
+            EXPECT_NE(-1, rank[(y - 1) * width + x]);
+        }
+        if (y > 0 && x + 1 < width) {
+            EXPECT_NE(-1, rank[(y - 1) * width + x + 1]);
+        }
+    }
+}
+
+TEST(WalkerTest, CriticalPath)
+{
+    struct i965_walker_stats stats;
+
+    for (int width(2); width <= 40; width += 3) {
+        for (int height(1); height <= 30; height += 2) {
+            ASSERT_TRUE(i965_walker_simulate(WALKER_26_DEGREE,
+                width, height, 1, &stats));
+            EXPECT_EQ(unsigned(width * height), stats.num_blocks);
+            EXPECT_EQ(unsigned(width + 2 * (height - 1)), stats.critical_path);
+            EXPECT_EQ(unsigned(std::min((width + 1) / 2, height)),
+                stats.max_parallel);
+
+            ASSERT_TRUE(i965_walker_simulate(WALKER_45_DEGREE,
+                width, height, 1, &stats));
+            EXPECT_EQ(unsigned(width + height - 1), stats.critical_path);
+            EXPECT_EQ(unsigned(std::min(width, height)), stats.max_parallel);
+
+            // the single region walk of the HEVC kernels
+            struct gpe_media_object_walker_parameter param;
+            i965_walker_init_regions(WALKER_26_DEGREE, width, height, 1,
+                &param);
+            EXPECT_EQ(unsigned(width + 2 * (height - 1)),
+                param.local_loop_exec_count);
+        }
+    }
+
+    EXPECT_FALSE(i965_walker_simulate(WALKER_26_DEGREE, 0, 8, 1, &stats));
+    EXPECT_FALSE(i965_walker_simulate(WALKER_26_DEGREE, 8, 8, 0, &stats));
+}
+
+TEST(WalkerTest, Regions)
+{
+    struct i965_walker_stats stats;
+    const int width(120), height(68);
+
+    // the regions walk at once, every one as long as a frame of its height
+    for (int regions(1); regions <= 16; ++regions) {
+        const int regionHeight((height + regions - 1) / regions);
+
+        ASSERT_TRUE(i965_walker_simulate(WALKER_26_DEGREE,
+            width, height, regions, &stats));
+        EXPECT_EQ(unsigned(width + 2 * (regionHeight - 1)),
+            stats.critical_path) << regions;
+    }
+
+    // the Z patterns are no slower than their raster counterparts
+    const unsigned degrees[][2] = {
+        {WALKER_26Z_DEGREE, WALKER_26_DEGREE},
+        {WALKER_45Z_DEGREE, WALKER_45_DEGREE},
+    };
+
+    for (auto degree : degrees) {
+        struct i965_walker_stats z;
+        for (int regions(1); regions <= 8; regions *= 2) {
+            ASSERT_TRUE(i965_walker_simulate(degree[0],
+                width, height, regions, &z));
+            ASSERT_TRUE(i965_walker_simulate(degree[1],
+                width, height, regions, &stats));
+            EXPECT_LE(z.critical_path, stats.critical_path + 2);
+        }
+    }
+}
+
+TEST(WalkerTest, Parallelism)
+{
+    static const struct {
+        const char *name;
+        int width, height;          // in 16x16 blocks
+    } resolutions[] = {
+        {"720p", 80, 45},
+        {"1080p", 120, 68},
+        {"2160p", 240, 135},
+    };
+
+    for (auto res : resolutions) {
+        for (int regions(1); regions <= 4; regions *= 2) {
+            struct i965_walker_stats s26, s45;
+
+            ASSERT_TRUE(i965_walker_simulate(WALKER_26_DEGREE,
+                res.width, res.height, regions, &s26));
+            ASSERT_TRUE(i965_walker_simulate(WALKER_45_DEGREE,
+                res.width, res.height, regions, &s45));
+
+            // fewer dependencies, fewer steps
+            EXPECT_LT(s45.critical_path, s26.critical_path);
+
+            std::cout << res.name << " " << regions << " region(s): 26 degree "
+                << s26.critical_path << " steps, "
+                << double(s26.num_blocks) / s26.critical_path
+                << " blocks per step, 45 degree " << s45.critical_path
+                << " steps, " << double(s45.num_blocks) / s45.critical_path
+                << " blocks per step" << std::endl;
+        }
+    }
+}
+
+TEST(WalkerTest, BestNumRegions)
+{
+    // a 1080p frame is wide enough for 60 threads in one region ...
+    EXPECT_EQ(1, i965_walker_best_num_regions(WALKER_26_DEGREE,
+        120, 68, 60, 16));
+
+    // ... not for more
+    const int regions(i965_walker_best_num_regions(WALKER_26_DEGREE,
+        120, 68, 120, 16));
+    EXPECT_GT(regions, 1);
+
+    struct i965_walker_stats one, best;
+    ASSERT_TRUE(i965_walker_simulate(WALKER_26_DEGREE, 120, 68, 1, &one));
+    ASSERT_TRUE(i965_walker_simulate(WALKER_26_DEGREE, 120, 68, regions,
+        &best));
+    EXPECT_LT(best.critical_path, one.critical_path);
+
+    // never more regions than rows
+    EXPECT_LE(i965_walker_best_num_regions(WALKER_26_DEGREE,
+        8, 2, 1000, 16), 2);
+}
+
+} // namespace Walker
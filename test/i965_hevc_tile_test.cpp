@@ -0,0 +1,268 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "gen9_hevc_enc_utils.h"
+}
+
+#include <cstring>
+#include <vector>
+
+namespace HEVCTile {
+
+// The uniform_spacing_flag partitioning of the spec (6.5.1), the driver
+// is only ever given explicit tile sizes
+bool uniformLayout(struct gen9_hevc_tile_layout *layout, unsigned widthInLcu,
+    unsigned heightInLcu, unsigned numColumns, unsigned numRows)
+{
+    std::memset(layout, 0, sizeof(*layout));
+
+    if (not numColumns or numColumns > GEN9_HEVC_MAX_TILE_COLUMNS
+        or not numRows or numRows > GEN9_HEVC_MAX_TILE_ROWS
+        or numColumns > widthInLcu or numRows > heightInLcu)
+        return false;
+
+    layout->width_in_lcu = widthInLcu;
+    layout->height_in_lcu = heightInLcu;
+    layout->num_columns = numColumns;
+    layout->num_rows = numRows;
+
+    for (unsigned i(0); i <= numColumns; ++i)
+        layout->column_start[i] = i * widthInLcu / numColumns;
+
+    for (unsigned i(0); i <= numRows; ++i)
+        layout->row_start[i] = i * heightInLcu / numRows;
+
+    return true;
+}
+
+// The tile scan of the spec (6.5.1), built tile by tile
+struct Reference
+{
+    Reference(const struct gen9_hevc_tile_layout& layout)
+        : rsToTs(layout.width_in_lcu * layout.height_in_lcu)
+        , tsToRs(rsToTs.size())
+        , tileId(rsToTs.size())
+    {
+        unsigned ts(0), tile(0);
+
+        for (unsigned row(0); row < layout.num_rows; ++row) {
+            for (unsigned col(0); col < layout.num_columns; ++col, ++tile) {
+                for (unsigned y(layout.row_start[row]);
+                    y < layout.row_start[row + 1]; ++y) {
+                    for (unsigned x(layout.column_start[col]);
+                        x < layout.column_start[col + 1]; ++x, ++ts) {
+                        const unsigned rs(y * layout.width_in_lcu + x);
+                        rsToTs[rs] = ts;
+                        tsToRs[ts] = rs;
+                        tileId[rs] = tile;
+                    }
+                }
+            }
+        }
+    }
+
+    std::vector<unsigned> rsToTs, tsToRs, tileId;
+};
+
+void checkScan(const struct gen9_hevc_tile_layout& layout)
+{
+    const Reference ref(layout);
+
+    for (unsigned rs(0); rs < ref.rsToTs.size(); ++rs) {
+        ASSERT_EQ(ref.rsToTs[rs], gen9_hevc_tile_ctb_addr_rs_to_ts(&layout, rs))
+            << layout.num_columns << "x" << layout.num_rows << " rs " << rs;
+        ASSERT_EQ(ref.tsToRs[rs], gen9_hevc_tile_ctb_addr_ts_to_rs(&layout, rs))
+            << layout.num_columns << "x" << layout.num_rows << " ts " << rs;
+        ASSERT_EQ(ref.tileId[rs], gen9_hevc_tile_id(&layout, rs))
+            << layout.num_columns << "x" << layout.num_rows << " rs " << rs;
+    }
+}
+
+TEST(HEVCTileTest, Uniform)
+{
+    struct gen9_hevc_tile_layout layout;
+
+    // 4K at 32x32 LCUs
+    ASSERT_TRUE(uniformLayout(&layout, 120, 68, 4, 2));
+    EXPECT_EQ(4u, layout.num_columns);
+    EXPECT_EQ(2u, layout.num_rows);
+
+    const unsigned columns[] = {0, 30, 60, 90, 120};
+    const unsigned rows[] = {0, 34, 68};
+    for (unsigned i(0); i < 5; ++i)
+        EXPECT_EQ(columns[i], layout.column_start[i]);
+    for (unsigned i(0); i < 3; ++i)
+        EXPECT_EQ(rows[i], layout.row_start[i]);
+
+    // ((i + 1) * 11) / 5 - (i * 11) / 5
+    ASSERT_TRUE(uniformLayout(&layout, 11, 3, 5, 3));
+    const unsigned uneven[] = {0, 2, 4, 6, 8, 11};
+    for (unsigned i(0); i < 6; ++i)
+        EXPECT_EQ(uneven[i], layout.column_start[i]);
+
+    EXPECT_FALSE(uniformLayout(&layout, 4, 4, 5, 1));
+    EXPECT_FALSE(uniformLayout(&layout, 120, 68, 0, 1));
+    EXPECT_FALSE(uniformLayout(&layout, 120, 68,
+        GEN9_HEVC_MAX_TILE_COLUMNS + 1, 1));
+    EXPECT_FALSE(uniformLayout(&layout, 120, 68,
+        1, GEN9_HEVC_MAX_TILE_ROWS + 1));
+}
+
+TEST(HEVCTileTest, PictureParameters)
+{
+    struct gen9_hevc_tile_layout layout;
+    VAEncPictureParameterBufferHEVC pic_param;
+
+    memset(&pic_param, 0, sizeof(pic_param));
+
+    // no tiles, one tile
+    ASSERT_TRUE(gen9_hevc_tile_layout_init(&layout, 60, 34, &pic_param));
+    EXPECT_EQ(1u, layout.num_columns);
+    EXPECT_EQ(1u, layout.num_rows);
+    EXPECT_EQ(60u, layout.column_start[1]);
+    EXPECT_EQ(34u, layout.row_start[1]);
+
+    pic_param.pic_fields.bits.tiles_enabled_flag = 1;
+    pic_param.num_tile_columns_minus1 = 2;
+    pic_param.num_tile_rows_minus1 = 1;
+    pic_param.column_width_minus1[0] = 9;
+    pic_param.column_width_minus1[1] = 29;
+    pic_param.row_height_minus1[0] = 16;
+
+    // the last column and row take the rest
+    ASSERT_TRUE(gen9_hevc_tile_layout_init(&layout, 60, 34, &pic_param));
+    EXPECT_EQ(3u, layout.num_columns);
+    EXPECT_EQ(2u, layout.num_rows);
+    EXPECT_EQ(10u, layout.column_start[1]);
+    EXPECT_EQ(40u, layout.column_start[2]);
+    EXPECT_EQ(60u, layout.column_start[3]);
+    EXPECT_EQ(17u, layout.row_start[1]);
+    EXPECT_EQ(34u, layout.row_start[2]);
+    checkScan(layout);
+
+    // nothing left for the last column
+    pic_param.column_width_minus1[1] = 49;
+    EXPECT_FALSE(gen9_hevc_tile_layout_init(&layout, 60, 34, &pic_param));
+    pic_param.column_width_minus1[1] = 29;
+
+    pic_param.row_height_minus1[0] = 33;
+    EXPECT_FALSE(gen9_hevc_tile_layout_init(&layout, 60, 34, &pic_param));
+    pic_param.row_height_minus1[0] = 16;
+
+    // more tiles than LCUs
+    EXPECT_FALSE(gen9_hevc_tile_layout_init(&layout, 2, 34, &pic_param));
+    EXPECT_FALSE(gen9_hevc_tile_layout_init(&layout, 60, 1, &pic_param));
+}
+
+TEST(HEVCTileTest, Scan)
+{
+    struct gen9_hevc_tile_layout layout;
+
+    for (unsigned width(1); width <= 12; ++width) {
+        for (unsigned height(1); height <= 9; ++height) {
+            for (unsigned columns(1); columns <= width; ++columns) {
+                for (unsigned rows(1); rows <= height; ++rows) {
+                    ASSERT_TRUE(uniformLayout(&layout,
+                        width, height, columns, rows));
+                    checkScan(layout);
+                }
+            }
+        }
+    }
+}
+
+TEST(HEVCTileTest, Scan8K)
+{
+    struct gen9_hevc_tile_layout layout;
+
+    // 8K at 32x32 LCUs, with as many tiles as the spec allows
+    ASSERT_TRUE(uniformLayout(&layout, 240, 135,
+        GEN9_HEVC_MAX_TILE_COLUMNS, GEN9_HEVC_MAX_TILE_ROWS));
+    checkScan(layout);
+
+    // the first LCU of every tile
+    const Reference ref(layout);
+    unsigned ts(0);
+    for (unsigned row(0); row < layout.num_rows; ++row) {
+        for (unsigned col(0); col < layout.num_columns; ++col) {
+            const unsigned rs(layout.row_start[row] * 240 + layout.column_start[col]);
+            EXPECT_EQ(ts, gen9_hevc_tile_ctb_addr_rs_to_ts(&layout, rs));
+            EXPECT_EQ(row * layout.num_columns + col,
+                gen9_hevc_tile_id(&layout, rs));
+            ts += (layout.row_start[row + 1] - layout.row_start[row]) *
+                (layout.column_start[col + 1] - layout.column_start[col]);
+        }
+    }
+    EXPECT_EQ(240u * 135u, ts);
+}
+
+TEST(HEVCTileTest, TileRows)
+{
+    struct gen9_hevc_tile_layout layout;
+
+    // with a single tile column, the tile scan is the raster scan
+    ASSERT_TRUE(uniformLayout(&layout, 120, 68, 1, 4));
+    for (unsigned rs(0); rs < 120 * 68; ++rs) {
+        EXPECT_EQ(rs, gen9_hevc_tile_ctb_addr_rs_to_ts(&layout, rs));
+        EXPECT_EQ(rs, gen9_hevc_tile_ctb_addr_ts_to_rs(&layout, rs));
+        EXPECT_EQ(rs / 120 / 17, gen9_hevc_tile_id(&layout, rs));
+    }
+}
+
+TEST(HEVCTileTest, SliceSegments)
+{
+    struct gen9_hevc_tile_layout layout;
+
+    // 4 tiles of 17 LCU rows
+    ASSERT_TRUE(uniformLayout(&layout, 120, 68, 1, 4));
+    const unsigned tile(120 * 17);
+
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, 0, tile, false));
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, tile, 120, false));
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, 4 * tile - 1, 1, false));
+
+    // empty, past the picture or across two tiles
+    EXPECT_FALSE(gen9_hevc_tile_slice_is_valid(&layout, 0, 0, false));
+    EXPECT_FALSE(gen9_hevc_tile_slice_is_valid(&layout, 4 * tile - 1, 2, false));
+    EXPECT_FALSE(gen9_hevc_tile_slice_is_valid(&layout, tile - 1, 2, false));
+
+    // a dependent slice segment within a tile, or at the very first LCU
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, 0, 120, true));
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, tile + 120, 120, true));
+
+    // but never at the start of a later tile
+    for (unsigned i(1); i < 4; ++i)
+        EXPECT_FALSE(gen9_hevc_tile_slice_is_valid(&layout, i * tile, 120, true)) << i;
+
+    // in tile scan with tile columns too
+    ASSERT_TRUE(uniformLayout(&layout, 8, 4, 2, 2));
+    EXPECT_FALSE(gen9_hevc_tile_slice_is_valid(&layout, 8, 8, true));
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, 8, 8, false));
+    EXPECT_TRUE(gen9_hevc_tile_slice_is_valid(&layout, 12, 4, true));
+}
+
+} // namespace HEVCTile
@@ -0,0 +1,306 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_test_fixture.h"
+
+extern "C" {
+    #include "i965_defines.h"
+    #include "gen9_mfd.h"
+}
+
+#include <cstring>
+#include <vector>
+
+namespace HEVC {
+namespace Decode {
+
+/*
+ * The gen9 HEVC decoder on VA_INTEL_NULL_HW: the BCS batch of a picture
+ * is read back as the driver submits it and split into its commands.
+ */
+class HEVCDNullHWTest
+    : public I965TestFixture
+{
+protected:
+    typedef std::vector<uint32_t> Command;
+
+    enum {
+        width = 64,
+        height = 64,
+        numSlices = 4, /* one per row of 16x16 CTBs */
+    };
+
+    void TearDown()
+    {
+        intel_null_hw_set_exec_hook(NULL, NULL);
+        I965TestFixture::TearDown();
+    }
+
+    bool isSkipped()
+    {
+        struct i965_driver_data *i965(*this);
+        bool supported = i965 and HAS_HEVC_DECODING(i965)
+            and IS_GEN9(i965->intel.device_info);
+
+        if (not I965TestEnvironment::instance()->isNullHW() or not supported) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " needs VA_INTEL_NULL_HW on a gen9 HEVC decoder"
+                << std::endl;
+            return true;
+        }
+
+        return false;
+    }
+
+    static void recordBatch(void *data, drm_intel_bo *bo, int used, unsigned flags)
+    {
+        std::vector<uint32_t> *batch = static_cast<std::vector<uint32_t> *>(data);
+
+        if ((flags & I915_EXEC_RING_MASK) != I915_EXEC_BSD)
+            return;
+
+        batch->resize(used / 4);
+        drm_intel_bo_get_subdata(bo, 0, used, batch->data());
+    }
+
+    /* the commands of a BCS batch, MI_NOOPs dropped */
+    static std::vector<Command> split(const std::vector<uint32_t>& batch)
+    {
+        std::vector<Command> commands;
+        size_t i(0);
+
+        while (i < batch.size()) {
+            const uint32_t dw0(batch[i]);
+            size_t length;
+
+            if (dw0 >> 29 == 0) {
+                /* MI, the ones below 0x10 are a single dword */
+                length = ((dw0 >> 23) & 0x3f) < 0x10 ? 1 : (dw0 & 0x3f) + 2;
+            } else {
+                EXPECT_EQ(3u, dw0 >> 29) << "at dword " << i;
+                if (dw0 >> 29 != 3)
+                    break;
+                length = (dw0 & 0xfff) + 2;
+            }
+
+            EXPECT_LE(i + length, batch.size());
+            if (i + length > batch.size())
+                break;
+
+            if (dw0)
+                commands.push_back(Command(&batch[i], &batch[i + length]));
+
+            i += length;
+        }
+
+        return commands;
+    }
+
+    static uint32_t opcode(const Command& command)
+    {
+        return command[0] & 0xffff0000;
+    }
+
+    /* these point to BOs that are reallocated for every picture */
+    static bool hasRelocations(const Command& command)
+    {
+        return opcode(command) == HCP_PIPE_BUF_ADDR_STATE
+            or opcode(command) == HCP_IND_OBJ_BASE_ADDR_STATE;
+    }
+
+    struct gen9_hcpd_context *hcpdContext()
+    {
+        struct object_context *obj_context = CONTEXT(context);
+        if (not obj_context) return NULL;
+
+        return reinterpret_cast<struct gen9_hcpd_context *>(
+            obj_context->hw_context);
+    }
+
+    void createStream()
+    {
+        ASSERT_NO_FAILURE(
+            surfaces = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+        ASSERT_NO_FAILURE(
+            config = createConfig(VAProfileHEVCMain, VAEntrypointVLD));
+        ASSERT_NO_FAILURE(
+            context = createContext(config, width, height, 0, surfaces));
+    }
+
+    void destroyStream()
+    {
+        destroyContext(context);
+        destroyConfig(config);
+        destroySurfaces(surfaces);
+    }
+
+    /*
+     * A weighted P picture, every slice with the same reference list. The
+     * weights change at the third slice.
+     */
+    void decode(std::vector<uint32_t>& batch)
+    {
+        VAPictureParameterBufferHEVC pic;
+        VASliceParameterBufferHEVC slices[numSlices];
+        std::vector<uint8_t> data(numSlices * 16, 0x5a);
+        std::vector<VABufferID> buffers;
+
+        std::memset(&pic, 0, sizeof(pic));
+        pic.CurrPic.picture_id = surfaces[0];
+        pic.CurrPic.pic_order_cnt = 2;
+        for (unsigned i(0); i < 15; ++i) {
+            pic.ReferenceFrames[i].picture_id = VA_INVALID_SURFACE;
+            pic.ReferenceFrames[i].flags = VA_PICTURE_HEVC_INVALID;
+        }
+        pic.ReferenceFrames[0].picture_id = surfaces[1];
+        pic.ReferenceFrames[0].pic_order_cnt = 0;
+        pic.ReferenceFrames[0].flags = VA_PICTURE_HEVC_RPS_ST_CURR_BEFORE;
+        pic.pic_width_in_luma_samples = width;
+        pic.pic_height_in_luma_samples = height;
+        pic.pic_fields.bits.chroma_format_idc = 1;
+        pic.pic_fields.bits.weighted_pred_flag = 1;
+        pic.log2_min_luma_coding_block_size_minus3 = 0;
+        pic.log2_diff_max_min_luma_coding_block_size = 1;
+        pic.log2_diff_max_min_transform_block_size = 2;
+        pic.log2_max_pic_order_cnt_lsb_minus4 = 4;
+
+        std::memset(slices, 0, sizeof(slices));
+        for (unsigned i(0); i < numSlices; ++i) {
+            VASliceParameterBufferHEVC& slice(slices[i]);
+
+            slice.slice_data_size = 16;
+            slice.slice_data_offset = i * 16;
+            slice.slice_data_flag = VA_SLICE_DATA_FLAG_ALL;
+            slice.slice_data_byte_offset = 4;
+            slice.slice_segment_address = i * (width / 16);
+            std::memset(slice.RefPicList, 0xff, sizeof(slice.RefPicList));
+            slice.RefPicList[0][0] = 0;
+            slice.LongSliceFlags.fields.LastSliceOfPic = i == numSlices - 1;
+            slice.LongSliceFlags.fields.slice_type = 1; /* P */
+            slice.luma_log2_weight_denom = 6;
+            slice.delta_luma_weight_l0[0] = 1;
+            slice.luma_offset_l0[0] = i < 2 ? 2 : -2;
+            slice.five_minus_max_num_merge_cand = 0;
+        }
+
+        buffers.push_back(createBuffer(context,
+            VAPictureParameterBufferType, sizeof(pic), 1, &pic));
+        buffers.push_back(createBuffer(context,
+            VASliceParameterBufferType, sizeof(slices[0]), numSlices, slices));
+        buffers.push_back(createBuffer(context,
+            VASliceDataBufferType, data.size(), 1, data.data()));
+
+        batch.clear();
+        intel_null_hw_set_exec_hook(recordBatch, &batch);
+
+        beginPicture(context, surfaces[0]);
+        renderPicture(context, buffers.data(), buffers.size());
+        endPicture(context);
+
+        intel_null_hw_set_exec_hook(NULL, NULL);
+
+        for (auto id : buffers)
+            destroyBuffer(id);
+    }
+
+    Surfaces surfaces;
+    VAConfigID config = VA_INVALID_ID;
+    VAContextID context = VA_INVALID_ID;
+};
+
+/*
+ * The batch with the repeated HCP_REF_IDX_STATE and HCP_WEIGHTOFFSET
+ * dropped is the batch emitted with every slice programming them, minus
+ * those commands only, and the saved bytes are counted.
+ */
+TEST_F(HEVCDNullHWTest, SliceStateDedup)
+{
+    if (isSkipped())
+        return;
+
+    std::vector<uint32_t> baseline, deduped;
+    std::vector<Command> expected, commands;
+    Command lastRefIdx[2], lastWeights[2];
+    uint64_t skipped;
+
+    ASSERT_NO_FAILURE(createStream());
+
+    struct gen9_hcpd_context *hcpd(hcpdContext());
+    ASSERT_PTR(hcpd);
+    EXPECT_TRUE(hcpd->slice_state_dedup);
+
+    hcpd->slice_state_dedup = 0;
+    ASSERT_NO_FAILURE(decode(baseline));
+    EXPECT_EQ(0u, hcpd->skipped_slice_state_bytes);
+
+    hcpd->slice_state_dedup = 1;
+    ASSERT_NO_FAILURE(decode(deduped));
+    skipped = hcpd->skipped_slice_state_bytes;
+
+    ASSERT_FALSE(baseline.empty());
+    ASSERT_FALSE(deduped.empty());
+
+    /* the baseline programs both for every slice */
+    unsigned numRefIdx(0), numWeights(0);
+    for (const auto& command : split(baseline)) {
+        Command *last(NULL);
+
+        if (opcode(command) == HCP_REF_IDX_STATE) {
+            last = &lastRefIdx[command[1] & 1];
+            ++numRefIdx;
+        } else if (opcode(command) == HCP_WEIGHTOFFSET) {
+            last = &lastWeights[command[1] & 1];
+            ++numWeights;
+        }
+
+        if (last and *last == command)
+            continue;
+        if (last)
+            *last = command;
+
+        expected.push_back(command);
+    }
+    EXPECT_EQ(unsigned(numSlices), numRefIdx);
+    EXPECT_EQ(unsigned(numSlices), numWeights);
+
+    commands = split(deduped);
+    ASSERT_EQ(expected.size(), commands.size());
+    for (size_t i(0); i < commands.size(); ++i) {
+        if (hasRelocations(expected[i]))
+            EXPECT_EQ(opcode(expected[i]), opcode(commands[i])) << "command " << i;
+        else
+            EXPECT_EQ(expected[i], commands[i]) << "command " << i;
+    }
+
+    /* one ref idx state and one set of weights for the first two slices,
+     * one for the last two */
+    EXPECT_EQ(uint64_t(3 * 18 * 4 + 2 * 34 * 4), skipped);
+    EXPECT_EQ(skipped, (baseline.size() - deduped.size()) * 4);
+
+    destroyStream();
+}
+
+} // namespace Decode
+} // namespace HEVC
@@ -70,6 +70,10 @@ extern "C" {
     extern VAStatus i965_SyncSurface(
         VADriverContextP, VASurfaceID);
 
+    extern VAStatus VA_DRIVER_INIT_FUNC(VADriverContextP);
+
+    extern VAStatus i965_Terminate(VADriverContextP);
+
     extern struct hw_codec_info *i965_get_codec_info(int);
     extern const struct intel_device_info *i965_get_device_info(int);
 
@@ -0,0 +1,262 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_jpeg_test_data.h"
+#include "i965_test_fixture.h"
+
+#include <cstring>
+#include <vector>
+
+extern "C" {
+    #include "gen6_mfc.h"
+    #include "intel_null_hw.h"
+}
+
+/*
+ * Several JPEG pictures encoded by one vaEndPicture(): one picture
+ * parameter buffer per picture, the pictures after the first one are read
+ * from their reconstructed_picture. Checked on the null hardware backend,
+ * run with VA_INTEL_NULL_HW=<PCI id>.
+ */
+namespace JPEG {
+namespace Encode {
+
+class JPEGEncodeBatchTest
+    : public I965TestFixture
+{
+protected:
+    static const unsigned width = 320;
+    static const unsigned height = 240;
+
+    void SetUp()
+    {
+        I965TestFixture::SetUp();
+
+        struct i965_driver_data *i965(*this);
+        ASSERT_PTR(i965);
+
+        if (not I965TestEnvironment::instance()->isNullHW()) {
+            skipped = true;
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " needs VA_INTEL_NULL_HW" << std::endl;
+            return;
+        }
+
+        if (not HAS_JPEG_ENCODING(i965)) {
+            skipped = true;
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " is unsupported on this hardware" << std::endl;
+            return;
+        }
+
+        input = TestInput::create(VA_FOURCC_NV12, width, height);
+        ASSERT_PTR(input.get());
+
+        SurfaceAttribs attributes(1);
+        attributes.front().flags = VA_SURFACE_ATTRIB_SETTABLE;
+        attributes.front().type = VASurfaceAttribPixelFormat;
+        attributes.front().value.type = VAGenericValueTypeInteger;
+        attributes.front().value.value.i = input->image->fourcc;
+
+        ConfigAttribs attribs(
+            1, {type:VAConfigAttribRTFormat, value:input->image->format});
+
+        surfaces = createSurfaces(width, height, input->image->format,
+            I965_MAX_JPEG_BATCH + 1, attributes);
+        ASSERT_EQ(surfaces.size(), I965_MAX_JPEG_BATCH + 1u);
+
+        for (auto surface : surfaces)
+            ASSERT_NO_FAILURE(input->image->toSurface(surface));
+
+        config = createConfig(::JPEG::profile, entrypoint, attribs);
+        context = createContext(config, width, height, 0, surfaces);
+
+        for (size_t i(0); i < surfaces.size(); ++i)
+            coded.push_back(createBuffer(context, VAEncCodedBufferType,
+                (input->image->sizes.sum() + 8192u) * 2));
+    }
+
+    void TearDown()
+    {
+        for (auto id : coded)
+            destroyBuffer(id);
+        if (context != VA_INVALID_ID)
+            destroyContext(context);
+        if (config != VA_INVALID_ID)
+            destroyConfig(config);
+        if (not surfaces.empty())
+            destroySurfaces(surfaces);
+
+        I965TestFixture::TearDown();
+    }
+
+    const struct gen6_mfc_context *mfcContext()
+    {
+        struct i965_driver_data *i965(*this);
+        struct object_context const *obj_context = CONTEXT(context);
+        if (not obj_context) return NULL;
+
+        return reinterpret_cast<const struct gen6_mfc_context *>(
+            reinterpret_cast<const struct intel_encoder_context *>(
+                obj_context->hw_context)->mfc_context);
+    }
+
+    /* the buffers of a batch of num pictures, picture i from surfaces[i] */
+    Buffers createBatch(unsigned num, unsigned quality = 100,
+        bool mixedQuality = false)
+    {
+        Buffers buffers;
+        VAEncPackedHeaderParameterBuffer packed;
+        const uint8_t header(0xff);
+
+        std::memset(&packed, 0, sizeof(packed));
+        packed.type = VAEncPackedHeaderRawData;
+        packed.bit_length = 8;
+
+        buffers.push_back(createBuffer(context, VAQMatrixBufferType,
+            sizeof(IQMatrix), 1, &input->matrix));
+        buffers.push_back(createBuffer(context, VAHuffmanTableBufferType,
+            sizeof(HuffmanTable), 1, &input->huffman));
+
+        for (unsigned i(0); i < num; ++i) {
+            PictureParameter picture(input->picture);
+
+            picture.coded_buf = coded[i];
+            picture.reconstructed_picture = surfaces[i];
+            picture.quality = quality;
+            if (i and mixedQuality)
+                picture.quality = quality % 100 + 1;
+
+            buffers.push_back(createBuffer(context,
+                VAEncPictureParameterBufferType, sizeof(picture), 1, &picture));
+            buffers.push_back(createBuffer(context,
+                VAEncSliceParameterBufferType, sizeof(SliceParameter), 1,
+                &input->slice));
+            buffers.push_back(createBuffer(context,
+                VAEncPackedHeaderParameterBufferType, sizeof(packed), 1,
+                &packed));
+            buffers.push_back(createBuffer(context,
+                VAEncPackedHeaderDataBufferType, 1, 1, &header));
+        }
+
+        return buffers;
+    }
+
+    void destroyBatch(Buffers& buffers)
+    {
+        for (auto id : buffers)
+            destroyBuffer(id);
+        buffers.clear();
+    }
+
+    bool skipped = false;
+    TestInput::Shared input;
+    Surfaces surfaces;
+    std::vector<VABufferID> coded;
+    VAConfigID config = VA_INVALID_ID;
+    VAContextID context = VA_INVALID_ID;
+};
+
+TEST_F(JPEGEncodeBatchTest, OneSubmissionPerBatch)
+{
+    if (skipped)
+        return;
+
+    unsigned quality(50);
+
+    for (unsigned num : {1u, 2u, 5u, unsigned(I965_MAX_JPEG_BATCH)}) {
+        struct intel_null_hw_stats begin, end;
+        const struct gen6_mfc_context *mfc_context;
+        unsigned int updates;
+
+        // a new quality, the tables of the previous batch can't be reused
+        Buffers buffers = createBatch(num, quality++);
+
+        beginPicture(context, surfaces.front());
+        renderPicture(context, buffers.data(), buffers.size());
+
+        mfc_context = mfcContext();
+        ASSERT_PTR(mfc_context);
+        updates = mfc_context->jpeg_tables.num_updates;
+
+        intel_null_hw_get_stats(&begin);
+        endPicture(context);
+        intel_null_hw_get_stats(&end);
+
+        // the tables are computed once and the pictures sent at once
+        EXPECT_EQ(updates + 1, mfc_context->jpeg_tables.num_updates) << num;
+        EXPECT_EQ(begin.num_execs + 1, end.num_execs) << num;
+
+        destroyBatch(buffers);
+    }
+}
+
+TEST_F(JPEGEncodeBatchTest, TooManyPictures)
+{
+    if (skipped)
+        return;
+
+    struct i965_driver_data *i965(*this);
+    Buffers buffers = createBatch(I965_MAX_JPEG_BATCH + 1);
+
+    beginPicture(context, surfaces.front());
+    EXPECT_STATUS_EQ(VA_STATUS_ERROR_MAX_NUM_EXCEEDED,
+        i965_RenderPicture(*this, context, buffers.data(), buffers.size()));
+
+    // the picture over the limit is rejected before it is stored, the
+    // parameters of the last picture of the batch are still current
+    struct object_context *obj_context = CONTEXT(context);
+    ASSERT_PTR(obj_context);
+
+    const struct encode_state& encode(obj_context->codec_state.encode);
+    struct object_buffer *last = BUFFER(buffers[2 + 4 * (I965_MAX_JPEG_BATCH - 1)]);
+    ASSERT_PTR(last);
+
+    EXPECT_EQ(I965_MAX_JPEG_BATCH, encode.num_pic_params_ext);
+    EXPECT_EQ(last->buffer_store, encode.pic_param_ext);
+    EXPECT_EQ(last->buffer_store, encode.pic_params_ext[I965_MAX_JPEG_BATCH - 1]);
+
+    destroyBatch(buffers);
+}
+
+TEST_F(JPEGEncodeBatchTest, MixedQuality)
+{
+    if (skipped)
+        return;
+
+    // the pictures of a batch share the quantization tables
+    Buffers buffers = createBatch(3, 100, true);
+
+    beginPicture(context, surfaces.front());
+    renderPicture(context, buffers.data(), buffers.size());
+    EXPECT_STATUS_EQ(VA_STATUS_ERROR_INVALID_PARAMETER,
+        i965_EndPicture(*this, context));
+
+    destroyBatch(buffers);
+}
+
+} // namespace Encode
+} // namespace JPEG
@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_jpeg_test_data.h"
+#include "i965_test_fixture.h"
+
+#include <algorithm>
+#include <cstring>
+
+extern "C" {
+    #include "gen6_mfc.h"
+}
+
+/*
+ * The quantization and Huffman tables of the JPEG encoder are kept in the
+ * context and only computed again when the quality or the tables change.
+ */
+namespace JPEG {
+namespace Encode {
+
+static const uint32_t zigzagDirect[64] = {
+    0,   1,  8, 16,  9,  2,  3, 10,
+    17, 24, 32, 25, 18, 11,  4,  5,
+    12, 19, 26, 33, 40, 48, 41, 34,
+    27, 20, 13,  6,  7, 14, 21, 28,
+    35, 42, 49, 56, 57, 50, 43, 36,
+    29, 22, 15, 23, 30, 37, 44, 51,
+    58, 59, 52, 45, 38, 31, 39, 46,
+    53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/* MFX_FQM_STATE payload of a zigzag matrix, as the driver computed it */
+static void referenceFQM(
+    const unsigned char zigzag[64], unsigned quality, uint32_t fqm[32])
+{
+    unsigned char raster[64], column[64];
+
+    quality = std::min(std::max(quality, 1u), 100u);
+    quality = quality < 50 ? 5000 / quality : 200 - quality * 2;
+
+    for (unsigned i(0); i < 64; ++i)
+        raster[zigzagDirect[i]] = std::min(
+            std::max(zigzag[i] * quality / 100, 1u), 255u);
+
+    for (unsigned i(0); i < 64; ++i)
+        column[(i % 8) * 8 + i / 8] = raster[i];
+
+    // two 16 bit reciprocals per dword, the low one sign extended
+    for (unsigned i(0); i < 32; ++i) {
+        const short low(65535 / column[2 * i]);
+        const short high(65535 / column[2 * i + 1]);
+        fqm[i] = uint32_t(int(high) * 65536) | uint32_t(int(low));
+    }
+}
+
+class JPEGEncodeTablesTest
+    : public I965TestFixture
+{
+protected:
+    static const unsigned width = 64;
+    static const unsigned height = 64;
+
+    void SetUp()
+    {
+        I965TestFixture::SetUp();
+
+        struct i965_driver_data *i965(*this);
+        ASSERT_PTR(i965);
+
+        if (not HAS_JPEG_ENCODING(i965)) {
+            skipped = true;
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " is unsupported on this hardware" << std::endl;
+            return;
+        }
+
+        input = TestInput::create(VA_FOURCC_NV12, width, height);
+        ASSERT_PTR(input.get());
+
+        SurfaceAttribs attributes(1);
+        attributes.front().flags = VA_SURFACE_ATTRIB_SETTABLE;
+        attributes.front().type = VASurfaceAttribPixelFormat;
+        attributes.front().value.type = VAGenericValueTypeInteger;
+        attributes.front().value.value.i = input->image->fourcc;
+
+        ConfigAttribs attribs(
+            1, {type:VAConfigAttribRTFormat, value:input->image->format});
+
+        surfaces = createSurfaces(width, height, input->image->format, 1,
+            attributes);
+        ASSERT_EQ(1u, surfaces.size());
+        ASSERT_NO_FAILURE(input->image->toSurface(surfaces.front()));
+
+        config = createConfig(::JPEG::profile, entrypoint, attribs);
+        for (auto& context : contexts)
+            context = createContext(config, width, height, 0, surfaces);
+
+        coded = createBuffer(contexts[0], VAEncCodedBufferType,
+            (input->image->sizes.sum() + 8192u) * 2);
+    }
+
+    void TearDown()
+    {
+        if (coded != VA_INVALID_ID)
+            destroyBuffer(coded);
+        for (auto context : contexts) {
+            if (context != VA_INVALID_ID)
+                destroyContext(context);
+        }
+        if (config != VA_INVALID_ID)
+            destroyConfig(config);
+        if (not surfaces.empty())
+            destroySurfaces(surfaces);
+
+        I965TestFixture::TearDown();
+    }
+
+    const struct gen6_mfc_context *mfcContext(unsigned i = 0)
+    {
+        struct i965_driver_data *i965(*this);
+        struct object_context const *obj_context = CONTEXT(contexts[i]);
+        if (not obj_context) return NULL;
+
+        return reinterpret_cast<const struct gen6_mfc_context *>(
+            reinterpret_cast<const struct intel_encoder_context *>(
+                obj_context->hw_context)->mfc_context);
+    }
+
+    void encode(unsigned quality, const HuffmanTable& huffman,
+        unsigned i = 0)
+    {
+        PictureParameter picture(input->picture);
+        VAEncPackedHeaderParameterBuffer packed;
+        const uint8_t header(0xff);
+        Buffers buffers;
+
+        picture.coded_buf = coded;
+        picture.quality = quality;
+
+        std::memset(&packed, 0, sizeof(packed));
+        packed.type = VAEncPackedHeaderRawData;
+        packed.bit_length = 8;
+
+        buffers.push_back(createBuffer(contexts[i],
+            VAEncPictureParameterBufferType, sizeof(picture), 1, &picture));
+        buffers.push_back(createBuffer(contexts[i], VAQMatrixBufferType,
+            sizeof(IQMatrix), 1, &input->matrix));
+        buffers.push_back(createBuffer(contexts[i], VAHuffmanTableBufferType,
+            sizeof(HuffmanTable), 1, &huffman));
+        buffers.push_back(createBuffer(contexts[i],
+            VAEncSliceParameterBufferType, sizeof(SliceParameter), 1,
+            &input->slice));
+        buffers.push_back(createBuffer(contexts[i],
+            VAEncPackedHeaderParameterBufferType, sizeof(packed), 1,
+            &packed));
+        buffers.push_back(createBuffer(contexts[i],
+            VAEncPackedHeaderDataBufferType, 1, 1, &header));
+
+        beginPicture(contexts[i], surfaces.front());
+        renderPicture(contexts[i], buffers.data(), buffers.size());
+        endPicture(contexts[i]);
+
+        for (auto id : buffers)
+            destroyBuffer(id);
+    }
+
+    void encode(unsigned quality, unsigned i = 0)
+    {
+        encode(quality, input->huffman, i);
+    }
+
+    bool skipped = false;
+    TestInput::Shared input;
+    Surfaces surfaces;
+    VAConfigID config = VA_INVALID_ID;
+    VAContextID contexts[2] = {VA_INVALID_ID, VA_INVALID_ID};
+    VABufferID coded = VA_INVALID_ID;
+};
+
+TEST_F(JPEGEncodeTablesTest, ReusedAtFixedQuality)
+{
+    if (skipped)
+        return;
+
+    ASSERT_NO_FAILURE(encode(75));
+
+    const struct gen6_mfc_context *mfc_context(mfcContext());
+    ASSERT_PTR(mfc_context);
+    EXPECT_EQ(1u, mfc_context->jpeg_tables.num_updates);
+    EXPECT_EQ(0u, mfc_context->jpeg_tables.num_reuses);
+
+    for (unsigned i(1); i <= 4; ++i) {
+        ASSERT_NO_FAILURE(encode(75));
+        EXPECT_EQ(1u, mfc_context->jpeg_tables.num_updates);
+        EXPECT_EQ(i, mfc_context->jpeg_tables.num_reuses);
+    }
+}
+
+TEST_F(JPEGEncodeTablesTest, ComputedOnChange)
+{
+    if (skipped)
+        return;
+
+    HuffmanTable huffman(input->huffman);
+
+    ASSERT_NO_FAILURE(encode(75));
+    ASSERT_NO_FAILURE(encode(80));
+    ASSERT_NO_FAILURE(encode(80));
+
+    const struct gen6_mfc_context *mfc_context(mfcContext());
+    ASSERT_PTR(mfc_context);
+    EXPECT_EQ(2u, mfc_context->jpeg_tables.num_updates);
+    EXPECT_EQ(1u, mfc_context->jpeg_tables.num_reuses);
+
+    // a different AC code of the chroma table
+    huffman.huffman_table[1].ac_values[0] ^= 1;
+    ASSERT_NO_FAILURE(encode(80, huffman));
+    EXPECT_EQ(3u, mfc_context->jpeg_tables.num_updates);
+
+    // the padding is not part of the tables
+    huffman.huffman_table[1].pad[0] ^= 1;
+    ASSERT_NO_FAILURE(encode(80, huffman));
+    EXPECT_EQ(3u, mfc_context->jpeg_tables.num_updates);
+    EXPECT_EQ(2u, mfc_context->jpeg_tables.num_reuses);
+}
+
+TEST_F(JPEGEncodeTablesTest, BitExact)
+{
+    if (skipped)
+        return;
+
+    for (unsigned quality : {1u, 10u, 49u, 50u, 75u, 99u, 100u, 75u, 1u}) {
+        uint32_t fqm[32];
+
+        // contexts[0] reuses its tables whenever it can, contexts[1]
+        // computes them every time
+        ASSERT_NO_FAILURE(encode(quality, 0));
+        ASSERT_NO_FAILURE(encode(quality, 0));
+        ASSERT_NO_FAILURE(encode(quality % 100 + 1, 1));
+        ASSERT_NO_FAILURE(encode(quality, 1));
+
+        const struct gen6_mfc_context *cached(mfcContext(0));
+        const struct gen6_mfc_context *computed(mfcContext(1));
+        ASSERT_PTR(cached);
+        ASSERT_PTR(computed);
+
+        referenceFQM(input->matrix.lum_quantiser_matrix, quality, fqm);
+        EXPECT_EQ(0, std::memcmp(fqm, cached->jpeg_tables.qm[0],
+            sizeof(fqm))) << quality;
+
+        referenceFQM(input->matrix.chroma_quantiser_matrix, quality, fqm);
+        EXPECT_EQ(0, std::memcmp(fqm, cached->jpeg_tables.qm[1],
+            sizeof(fqm))) << quality;
+
+        EXPECT_EQ(0, std::memcmp(cached->jpeg_tables.qm,
+            computed->jpeg_tables.qm, sizeof(cached->jpeg_tables.qm)))
+            << quality;
+        EXPECT_EQ(0, std::memcmp(cached->jpeg_tables.dc_table,
+            computed->jpeg_tables.dc_table,
+            sizeof(cached->jpeg_tables.dc_table))) << quality;
+        EXPECT_EQ(0, std::memcmp(cached->jpeg_tables.ac_table,
+            computed->jpeg_tables.ac_table,
+            sizeof(cached->jpeg_tables.ac_table))) << quality;
+    }
+}
+
+} // namespace Encode
+} // namespace JPEG
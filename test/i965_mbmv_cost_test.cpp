@@ -0,0 +1,98 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+#include "test_utils.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_defines.h"
+    #include "gen6_vme.h"
+}
+
+#include <vector>
+
+namespace MbMvCost {
+
+static const int QpMax = 52;
+static const size_t MessageSize = 32;
+
+static std::vector<uint8_t> randomMessage()
+{
+    static const RandomValueGenerator<int> rand(0, 0xff);
+    std::vector<uint8_t> message(MessageSize);
+
+    for (size_t i(0); i < MessageSize; ++i)
+        message[i] = rand();
+
+    return message;
+}
+
+TEST(MbMvCostTest, H264MatchesFormula)
+{
+    static const int sliceTypes[] = {
+        SLICE_TYPE_P, SLICE_TYPE_B, SLICE_TYPE_I,
+    };
+
+    for (int sliceType : sliceTypes) {
+        for (int qp(0); qp <= QpMax; ++qp) {
+            /* the costs that aren't set must be left alone */
+            std::vector<uint8_t> expected(randomMessage());
+            std::vector<uint8_t> actual(expected);
+
+            intel_h264_calc_mbmvcost_qp(qp, sliceType, expected.data());
+            intel_h264_get_mbmvcost_qp(qp, sliceType, actual.data());
+
+            EXPECT_EQ(expected, actual)
+                << "slice type " << sliceType << ", qp " << qp;
+        }
+    }
+}
+
+TEST(MbMvCostTest, HEVCMatchesFormula)
+{
+    static const std::pair<int, int> sliceTypes[] = {
+        {HEVC_SLICE_P, SLICE_TYPE_P},
+        {HEVC_SLICE_B, SLICE_TYPE_B},
+        {HEVC_SLICE_I, SLICE_TYPE_I},
+    };
+
+    for (const auto& sliceType : sliceTypes) {
+        for (int qp(0); qp <= QpMax; ++qp) {
+            std::vector<uint8_t> expected(randomMessage());
+            std::vector<uint8_t> actual(expected);
+
+            intel_h264_calc_mbmvcost_qp(qp, sliceType.second, expected.data());
+            expected[MODE_REFID_COST] = actual[MODE_REFID_COST];
+            expected[MODE_CHROMA_INTRA] = actual[MODE_CHROMA_INTRA];
+
+            intel_hevc_get_mbmvcost_qp(qp, sliceType.first, actual.data());
+
+            EXPECT_EQ(expected, actual)
+                << "slice type " << sliceType.first << ", qp " << qp;
+        }
+    }
+}
+
+} // namespace MbMvCost
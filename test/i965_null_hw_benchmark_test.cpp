@@ -0,0 +1,954 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "i965_jpeg_test_data.h"
+#include "i965_test_fixture.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+    #include "i965_gpe_utils.h"
+    #include "intel_null_hw.h"
+}
+
+/*
+ * CPU cost of the driver per frame, measured on the null hardware backend
+ * so that the numbers hold the driver alone: run the tests with
+ * VA_INTEL_NULL_HW=<PCI id>, e.g. VA_INTEL_NULL_HW=0x1912 for a SKL GT2.
+ * The parameters are synthetic, only the work on the CPU is meaningful.
+ */
+namespace NullHW {
+
+class NullHWBenchmarkTest
+    : public I965TestFixture
+{
+protected:
+    static const unsigned numFrames = 60;
+
+    bool isSkipped(bool supported)
+    {
+        if (not I965TestEnvironment::instance()->isNullHW()) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " needs VA_INTEL_NULL_HW" << std::endl;
+            return true;
+        }
+
+        if (not supported) {
+            RecordProperty("skipped", true);
+            std::cout << "[  SKIPPED ] " << getFullTestName()
+                << " is unsupported on this hardware" << std::endl;
+            return true;
+        }
+
+        return false;
+    }
+
+    /* the CPU time of this thread only, the driver runs on the caller */
+    static double threadTime()
+    {
+        struct timespec ts;
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+        return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+    }
+
+    void measure(const std::string& name, std::function<void(unsigned)> frame,
+        double *cpuTime = NULL)
+    {
+        struct intel_null_hw_stats begin, end;
+
+        // the first frame allocates the per context resources
+        ASSERT_NO_FAILURE(frame(0));
+
+        intel_null_hw_get_stats(&begin);
+        const double start(threadTime());
+
+        for (unsigned i(1); i <= numFrames; ++i)
+            ASSERT_NO_FAILURE(frame(i));
+
+        const double usPerFrame((threadTime() - start) / numFrames);
+        intel_null_hw_get_stats(&end);
+
+        const double allocsPerFrame(
+            double(end.num_allocs - begin.num_allocs) / numFrames);
+        const double execsPerFrame(
+            double(end.num_execs - begin.num_execs) / numFrames);
+
+        if (cpuTime)
+            *cpuTime = usPerFrame;
+
+        RecordProperty("us_per_frame", int(usPerFrame + 0.5));
+        RecordProperty("bo_allocs_per_frame", int(allocsPerFrame + 0.5));
+        RecordProperty("execs_per_frame", int(execsPerFrame + 0.5));
+
+        std::cout << std::fixed << std::setprecision(1) << name << ": "
+            << usPerFrame << " us CPU, " << allocsPerFrame << " BO allocs, "
+            << execsPerFrame << " execs per frame" << std::endl;
+    }
+
+    void submit(VAContextID context, VASurfaceID surface, Buffers& buffers)
+    {
+        beginPicture(context, surface);
+        renderPicture(context, buffers.data(), buffers.size());
+        endPicture(context);
+
+        for (auto id : buffers)
+            destroyBuffer(id);
+        buffers.clear();
+    }
+
+    /* an I frame of synthetic H.264 parameters, listing refs as the
+     * reference frames of the DPB */
+    void submitH264(VAContextID context, VASurfaceID surface, unsigned i,
+        unsigned wmbs, unsigned hmbs, const Surfaces& refs = Surfaces())
+    {
+        std::vector<uint8_t> sliceData(4096, 0x5a);
+        sliceData[0] = 0x00, sliceData[1] = 0x00, sliceData[2] = 0x01;
+        sliceData[3] = 0x65;
+
+        VAPictureParameterBufferH264 pic;
+        VAIQMatrixBufferH264 iq;
+        VASliceParameterBufferH264 slice;
+        Buffers buffers;
+
+        std::memset(&pic, 0, sizeof(pic));
+        pic.CurrPic.picture_id = surface;
+        pic.CurrPic.frame_idx = i % 16;
+        pic.CurrPic.flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+        for (unsigned j(0); j < 16; ++j) {
+            pic.ReferenceFrames[j].picture_id = VA_INVALID_SURFACE;
+            pic.ReferenceFrames[j].flags = VA_PICTURE_H264_INVALID;
+        }
+        for (unsigned j(0); j < refs.size() and j < 16; ++j) {
+            pic.ReferenceFrames[j].picture_id = refs[j];
+            pic.ReferenceFrames[j].frame_idx = i - 1 - j;
+            pic.ReferenceFrames[j].flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+        }
+        pic.picture_width_in_mbs_minus1 = wmbs - 1;
+        pic.picture_height_in_mbs_minus1 = hmbs - 1;
+        pic.num_ref_frames = refs.empty() ? 1 : refs.size();
+        pic.seq_fields.bits.chroma_format_idc = 1;
+        pic.seq_fields.bits.frame_mbs_only_flag = 1;
+        pic.seq_fields.bits.direct_8x8_inference_flag = 1;
+        pic.seq_fields.bits.log2_max_pic_order_cnt_lsb_minus4 = 4;
+        pic.pic_fields.bits.entropy_coding_mode_flag = 1;
+        pic.pic_fields.bits.transform_8x8_mode_flag = 1;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        pic.frame_num = i % 16;
+
+        std::memset(&iq, 16, sizeof(iq));
+
+        std::memset(&slice, 0, sizeof(slice));
+        slice.slice_data_size = sliceData.size();
+        slice.slice_data_flag = VA_SLICE_DATA_FLAG_ALL;
+        slice.slice_data_bit_offset = 40;
+        slice.slice_type = 2;
+        for (unsigned j(0); j < 32; ++j) {
+            slice.RefPicList0[j].picture_id = VA_INVALID_SURFACE;
+            slice.RefPicList0[j].flags = VA_PICTURE_H264_INVALID;
+            slice.RefPicList1[j] = slice.RefPicList0[j];
+        }
+
+        buffers.push_back(createBuffer(context,
+            VAPictureParameterBufferType, sizeof(pic), 1, &pic));
+        buffers.push_back(createBuffer(context,
+            VAIQMatrixBufferType, sizeof(iq), 1, &iq));
+        buffers.push_back(createBuffer(context,
+            VASliceParameterBufferType, sizeof(slice), 1, &slice));
+        buffers.push_back(createBuffer(context,
+            VASliceDataBufferType, sliceData.size(), 1, sliceData.data()));
+
+        submit(context, surface, buffers);
+    }
+
+    /* a frame of synthetic H.264 CQP parameters, IPPP with an IDR every 30 */
+    void submitH264Encode(VAContextID context, VASurfaceID input,
+        const Surfaces& recons, VABufferID coded, unsigned i,
+        unsigned wmbs, unsigned hmbs, bool seqEveryFrame = false)
+    {
+        VAEncSequenceParameterBufferH264 seq;
+        VAEncPictureParameterBufferH264 pic;
+        VAEncSliceParameterBufferH264 slice;
+        const bool idr(i % 30 == 0);
+        VAPictureH264 last;
+        Buffers buffers;
+
+        // the previous frame, the only reference of a P frame
+        std::memset(&last, 0, sizeof(last));
+        if (not idr) {
+            last.picture_id = recons[(i + 1) % recons.size()];
+            last.frame_idx = (i - 1) % 16;
+            last.flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+            last.TopFieldOrderCnt = last.BottomFieldOrderCnt = (i % 30 - 1) * 2;
+        }
+
+        std::memset(&seq, 0, sizeof(seq));
+        seq.level_idc = 41;
+        seq.intra_period = 30;
+        seq.intra_idr_period = 30;
+        seq.ip_period = 1;
+        seq.max_num_ref_frames = 1;
+        seq.picture_width_in_mbs = wmbs;
+        seq.picture_height_in_mbs = hmbs;
+        seq.seq_fields.bits.chroma_format_idc = 1;
+        seq.seq_fields.bits.frame_mbs_only_flag = 1;
+        seq.seq_fields.bits.direct_8x8_inference_flag = 1;
+        seq.seq_fields.bits.log2_max_frame_num_minus4 = 4;
+        seq.seq_fields.bits.log2_max_pic_order_cnt_lsb_minus4 = 4;
+        seq.time_scale = 60;
+        seq.num_units_in_tick = 1;
+
+        std::memset(&pic, 0, sizeof(pic));
+        pic.CurrPic.picture_id = recons[i % recons.size()];
+        pic.CurrPic.frame_idx = i % 16;
+        pic.CurrPic.flags = VA_PICTURE_H264_SHORT_TERM_REFERENCE;
+        pic.CurrPic.TopFieldOrderCnt = pic.CurrPic.BottomFieldOrderCnt = (i % 30) * 2;
+        for (unsigned j(0); j < 16; ++j) {
+            pic.ReferenceFrames[j].picture_id = VA_INVALID_SURFACE;
+            pic.ReferenceFrames[j].flags = VA_PICTURE_H264_INVALID;
+        }
+        if (not idr)
+            pic.ReferenceFrames[0] = last;
+        pic.coded_buf = coded;
+        pic.frame_num = i % 30;
+        pic.pic_init_qp = 26;
+        pic.pic_fields.bits.idr_pic_flag = idr;
+        pic.pic_fields.bits.reference_pic_flag = 1;
+        pic.pic_fields.bits.entropy_coding_mode_flag = 1;
+        pic.pic_fields.bits.deblocking_filter_control_present_flag = 1;
+
+        std::memset(&slice, 0, sizeof(slice));
+        slice.num_macroblocks = wmbs * hmbs;
+        slice.slice_type = idr ? 2 : 0;
+        slice.idr_pic_id = i / 30;
+        slice.pic_order_cnt_lsb = (i % 30) * 2;
+        for (unsigned j(0); j < 32; ++j) {
+            slice.RefPicList0[j].picture_id = VA_INVALID_SURFACE;
+            slice.RefPicList0[j].flags = VA_PICTURE_H264_INVALID;
+            slice.RefPicList1[j] = slice.RefPicList0[j];
+        }
+        if (not idr)
+            slice.RefPicList0[0] = last;
+
+        if (idr or seqEveryFrame) {
+            buffers.push_back(createBuffer(context,
+                VAEncSequenceParameterBufferType, sizeof(seq), 1, &seq));
+        }
+        buffers.push_back(createBuffer(context,
+            VAEncPictureParameterBufferType, sizeof(pic), 1, &pic));
+        buffers.push_back(createBuffer(context,
+            VAEncSliceParameterBufferType, sizeof(slice), 1, &slice));
+
+        submit(context, input, buffers);
+    }
+};
+
+TEST_F(NullHWBenchmarkTest, H264Decode)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_H264_DECODING(i965)))
+        return;
+
+    const unsigned width(1920), height(1088);
+    const unsigned wmbs(width / 16), hmbs(height / 16);
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 4));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileH264High, VAEntrypointVLD));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, width, height, 0, surfaces));
+
+    measure("H.264 decode 1080p, I frames", [&](unsigned i) {
+        submitH264(context, surfaces[i % surfaces.size()], i, wmbs, hmbs);
+    });
+
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+/* a low resolution stream with a full DPB, as when many streams are decoded
+ * by a single process: the checks of the 16 references dominate the frame */
+TEST_F(NullHWBenchmarkTest, H264DecodeReferences)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_H264_DECODING(i965)))
+        return;
+
+    const unsigned width(352), height(288);
+    const unsigned numRefs(16);
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(width, height, VA_RT_FORMAT_YUV420,
+            numRefs + 1));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileH264High, VAEntrypointVLD));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, width, height, 0, surfaces));
+
+    struct object_context const *obj_context = CONTEXT(context);
+    ASSERT_PTR(obj_context);
+    const struct decode_check_cache& cache(
+        obj_context->codec_state.decode.check_cache);
+
+    // the previous 16 pictures, most recent first
+    auto frame = [&](unsigned i) {
+        const unsigned n(numRefs + 1);
+        Surfaces refs;
+
+        for (unsigned j(1); j <= numRefs; ++j)
+            refs.push_back(surfaces[(i + n - j) % n]);
+        submitH264(context, surfaces[i % n], i, width / 16, height / 16, refs);
+    };
+
+    // decode into every surface once, so that all the references exist
+    for (unsigned i(0); i < surfaces.size(); ++i)
+        ASSERT_NO_FAILURE(submitH264(context, surfaces[i], i, width / 16,
+            height / 16));
+
+    const unsigned hits(cache.num_hits), misses(cache.num_misses);
+
+    measure("H.264 decode CIF, 16 references", [&](unsigned i) {
+        frame(surfaces.size() + i);
+    });
+
+    // only the picture being decoded is checked again
+    const unsigned frames(numFrames + 1);
+    EXPECT_EQ(numRefs * frames, cache.num_hits - hits);
+    EXPECT_EQ(frames, cache.num_misses - misses);
+    RecordProperty("check_cache_hits", cache.num_hits - hits);
+    RecordProperty("check_cache_misses", cache.num_misses - misses);
+
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+/* short sessions, created and torn down, e.g. thumbnails */
+TEST_F(NullHWBenchmarkTest, H264DecodeSessions)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_H264_DECODING(i965)))
+        return;
+
+    const unsigned width(1280), height(720);
+    const unsigned numSurfaces(4);
+    struct i965_dmv_pool_stats begin, end;
+
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileH264High, VAEntrypointVLD));
+
+    i965_dmv_pool_get_stats(&i965->dmv_pools[I965_DMV_POOL_AVC], &begin);
+
+    measure("H.264 decode 720p, a session of 4 I frames", [&](unsigned) {
+        Surfaces surfaces = createSurfaces(width, height,
+            VA_RT_FORMAT_YUV420, numSurfaces);
+        VAContextID context = createContext(config, width, height, 0,
+            surfaces);
+
+        for (unsigned i(0); i < numSurfaces; ++i)
+            submitH264(context, surfaces[i], i, width / 16, height / 16);
+
+        destroyContext(context);
+        destroySurfaces(surfaces);
+    });
+
+    i965_dmv_pool_get_stats(&i965->dmv_pools[I965_DMV_POOL_AVC], &end);
+
+    // the first session allocates the DMVs, the others reuse them
+    EXPECT_GT(end.num_reuses, begin.num_reuses);
+    RecordProperty("dmv_allocs", end.num_allocs - begin.num_allocs);
+    RecordProperty("dmv_reuses", end.num_reuses - begin.num_reuses);
+
+    destroyConfig(config);
+}
+
+TEST_F(NullHWBenchmarkTest, MPEG2Decode)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_MPEG2_DECODING(i965)))
+        return;
+
+    const unsigned width(1920), height(1088);
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 4));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileMPEG2Main, VAEntrypointVLD));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, width, height, 0, surfaces));
+
+    // one slice per MB row
+    const unsigned sliceSize(256), numSlices(height / 16);
+    std::vector<uint8_t> sliceData(sliceSize * numSlices, 0x5a);
+
+    measure("MPEG-2 decode 1080p, I frames", [&](unsigned i) {
+        VAPictureParameterBufferMPEG2 pic;
+        VAIQMatrixBufferMPEG2 iq;
+        std::vector<VASliceParameterBufferMPEG2> slices(numSlices);
+        Buffers buffers;
+
+        std::memset(&pic, 0, sizeof(pic));
+        pic.horizontal_size = width;
+        pic.vertical_size = height;
+        pic.forward_reference_picture = VA_INVALID_SURFACE;
+        pic.backward_reference_picture = VA_INVALID_SURFACE;
+        pic.picture_coding_type = 1;
+        pic.f_code = 0xffff;
+        pic.picture_coding_extension.bits.picture_structure = 3;
+        pic.picture_coding_extension.bits.frame_pred_frame_dct = 1;
+        pic.picture_coding_extension.bits.progressive_frame = 1;
+        pic.picture_coding_extension.bits.is_first_field = 1;
+
+        std::memset(&iq, 0, sizeof(iq));
+
+        std::memset(slices.data(), 0, slices.size() * sizeof(slices[0]));
+        for (unsigned j(0); j < numSlices; ++j) {
+            slices[j].slice_data_size = sliceSize;
+            slices[j].slice_data_offset = j * sliceSize;
+            slices[j].slice_data_flag = VA_SLICE_DATA_FLAG_ALL;
+            slices[j].macroblock_offset = 38;
+            slices[j].slice_vertical_position = j;
+            slices[j].quantiser_scale_code = 8;
+        }
+
+        buffers.push_back(createBuffer(context,
+            VAPictureParameterBufferType, sizeof(pic), 1, &pic));
+        buffers.push_back(createBuffer(context,
+            VAIQMatrixBufferType, sizeof(iq), 1, &iq));
+        buffers.push_back(createBuffer(context, VASliceParameterBufferType,
+            sizeof(slices[0]), slices.size(), slices.data()));
+        buffers.push_back(createBuffer(context,
+            VASliceDataBufferType, sliceData.size(), 1, sliceData.data()));
+
+        submit(context, surfaces[i % surfaces.size()], buffers);
+    });
+
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+TEST_F(NullHWBenchmarkTest, JPEGDecode)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_JPEG_DECODING(i965)))
+        return;
+
+    using namespace ::JPEG::Decode;
+
+    const TestPattern::SharedConst pattern(new TestPatternData<1>);
+    const PictureData::SharedConst pd(pattern->encoded(VA_FOURCC_IMC3));
+    ASSERT_PTR(pd.get());
+
+    VAConfigAttrib a = { type:VAConfigAttribRTFormat, value:pd->format };
+    ConfigAttribs attribs(1, a);
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(
+            pd->pparam.picture_width, pd->pparam.picture_height, pd->format));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(::JPEG::profile, entrypoint, attribs));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(
+            config, pd->pparam.picture_width, pd->pparam.picture_height, 0,
+            surfaces));
+
+    measure("JPEG decode", [&](unsigned) {
+        Buffers buffers;
+
+        buffers.push_back(createBuffer(context, VAPictureParameterBufferType,
+            sizeof(pd->pparam), 1, &pd->pparam));
+        buffers.push_back(createBuffer(context, VAIQMatrixBufferType,
+            sizeof(IQMatrix), 1, &pd->iqmatrix));
+        buffers.push_back(createBuffer(context, VAHuffmanTableBufferType,
+            sizeof(HuffmanTable), 1, &pd->huffman));
+        buffers.push_back(createBuffer(context, VASliceParameterBufferType,
+            sizeof(pd->sparam), 1, &pd->sparam));
+        buffers.push_back(createBuffer(context, VASliceDataBufferType,
+            pd->sparam.slice_data_size, 1, pd->slice.data()));
+
+        submit(context, surfaces.front(), buffers);
+    });
+
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+TEST_F(NullHWBenchmarkTest, H264Encode)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_H264_ENCODING(i965)))
+        return;
+
+    const unsigned width(1920), height(1088);
+    const unsigned wmbs(width / 16), hmbs(height / 16);
+
+    VAConfigAttrib a = { type:VAConfigAttribRateControl, value:VA_RC_CQP };
+    ConfigAttribs attribs(1, a);
+
+    ASSERT_NO_FAILURE(
+        Surfaces inputs = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+    ASSERT_NO_FAILURE(
+        Surfaces recons = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(
+            VAProfileH264Main, VAEntrypointEncSlice, attribs));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, width, height, 0, recons));
+    ASSERT_NO_FAILURE(
+        VABufferID coded = createBuffer(
+            context, VAEncCodedBufferType, width * height * 3 / 2));
+
+    measure("H.264 encode 1080p CQP, IPPP", [&](unsigned i) {
+        submitH264Encode(context, inputs[i % inputs.size()], recons, coded, i,
+            wmbs, hmbs);
+    });
+
+    destroyBuffer(coded);
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(recons);
+    destroySurfaces(inputs);
+}
+
+/*
+ * The applications sending the sequence parameters with every frame, the
+ * encoder only derives the sequence state again when they changed. The
+ * same stream is timed without and with the tracking of the parameters.
+ */
+TEST_F(NullHWBenchmarkTest, H264EncodeParams)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_H264_ENCODING(i965)))
+        return;
+
+    const unsigned width(1920), height(1088);
+    const unsigned wmbs(width / 16), hmbs(height / 16);
+
+    VAConfigAttrib a = { type:VAConfigAttribRateControl, value:VA_RC_CQP };
+    ConfigAttribs attribs(1, a);
+
+    ASSERT_NO_FAILURE(
+        Surfaces inputs = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+    ASSERT_NO_FAILURE(
+        Surfaces recons = createSurfaces(width, height, VA_RT_FORMAT_YUV420, 2));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(
+            VAProfileH264Main, VAEntrypointEncSlice, attribs));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, width, height, 0, recons));
+    ASSERT_NO_FAILURE(
+        VABufferID coded = createBuffer(
+            context, VAEncCodedBufferType, width * height * 3 / 2));
+
+    struct object_context const *obj_context = CONTEXT(context);
+    ASSERT_PTR(obj_context);
+    struct intel_encoder_context const *encoder_context =
+        reinterpret_cast<struct intel_encoder_context const *>(
+            obj_context->hw_context);
+    ASSERT_PTR(encoder_context);
+    struct i965_encoder_params& params(
+        const_cast<struct intel_encoder_context *>(encoder_context)->params);
+    double untracked(0), tracked(0);
+
+    params.disabled = 1;
+    measure("H.264 encode 1080p CQP, IPPP, sequence every frame, untracked",
+        [&](unsigned i) {
+            submitH264Encode(context, inputs[i % inputs.size()], recons,
+                coded, i, wmbs, hmbs, true);
+        }, &untracked);
+
+    // every frame derives the sequence state
+    EXPECT_EQ(numFrames + 1, params.num_frames);
+    EXPECT_EQ(numFrames + 1, params.num_changed[I965_ENCODER_PARAMS_SEQ]);
+    EXPECT_EQ(0u, params.num_skipped[I965_ENCODER_PARAMS_SEQ]);
+
+    params.disabled = 0;
+    measure("H.264 encode 1080p CQP, IPPP, sequence every frame, tracked",
+        [&](unsigned i) {
+            submitH264Encode(context, inputs[i % inputs.size()], recons,
+                coded, i, wmbs, hmbs, true);
+        }, &tracked);
+
+    // one sequence for all the frames
+    EXPECT_EQ(2 * (numFrames + 1), params.num_frames);
+    EXPECT_EQ(numFrames + 2, params.num_changed[I965_ENCODER_PARAMS_SEQ]);
+    if (IS_GEN9(i965->intel.device_info) or IS_GEN10(i965->intel.device_info))
+        EXPECT_GE(params.num_skipped[I965_ENCODER_PARAMS_SEQ], unsigned(numFrames));
+
+    RecordProperty("us_per_frame_untracked", int(untracked + 0.5));
+    RecordProperty("us_per_frame_tracked", int(tracked + 0.5));
+    RecordProperty("seq_skipped", params.num_skipped[I965_ENCODER_PARAMS_SEQ]);
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "H.264 encode parameter tracking: " << untracked - tracked
+        << " us CPU saved per frame" << std::endl;
+
+    destroyBuffer(coded);
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(recons);
+    destroySurfaces(inputs);
+}
+
+TEST_F(NullHWBenchmarkTest, JPEGEncode)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_JPEG_ENCODING(i965)))
+        return;
+
+    using namespace ::JPEG::Encode;
+
+    const TestInput::Shared input(TestInput::create(VA_FOURCC_NV12, 1920, 1080));
+    ASSERT_PTR(input.get());
+
+    SurfaceAttribs attributes(1);
+    attributes.front().flags = VA_SURFACE_ATTRIB_SETTABLE;
+    attributes.front().type = VASurfaceAttribPixelFormat;
+    attributes.front().value.type = VAGenericValueTypeInteger;
+    attributes.front().value.value.i = input->image->fourcc;
+
+    ConfigAttribs attribs(
+        1, {type:VAConfigAttribRTFormat, value:input->image->format});
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(input->image->width,
+            input->image->height, input->image->format, 1, attributes));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(::JPEG::profile, entrypoint, attribs));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, input->image->width,
+            input->image->height, 0, surfaces));
+    ASSERT_NO_FAILURE(
+        VABufferID coded = createBuffer(context, VAEncCodedBufferType,
+            (input->image->sizes.sum() + 8192u) * 2));
+
+    input->picture.coded_buf = coded;
+
+    measure("JPEG encode 1080p", [&](unsigned) {
+        VAEncPackedHeaderParameterBuffer packed;
+        const uint8_t header(0xff);
+        Buffers buffers;
+
+        std::memset(&packed, 0, sizeof(packed));
+        packed.type = VAEncPackedHeaderRawData;
+        packed.bit_length = 8;
+
+        buffers.push_back(createBuffer(context, VAEncPictureParameterBufferType,
+            sizeof(PictureParameter), 1, &input->picture));
+        buffers.push_back(createBuffer(context, VAQMatrixBufferType,
+            sizeof(IQMatrix), 1, &input->matrix));
+        buffers.push_back(createBuffer(context, VAHuffmanTableBufferType,
+            sizeof(HuffmanTable), 1, &input->huffman));
+        buffers.push_back(createBuffer(context, VAEncSliceParameterBufferType,
+            sizeof(SliceParameter), 1, &input->slice));
+        buffers.push_back(createBuffer(context,
+            VAEncPackedHeaderParameterBufferType, sizeof(packed), 1, &packed));
+        buffers.push_back(createBuffer(context,
+            VAEncPackedHeaderDataBufferType, 1, 1, &header));
+
+        submit(context, surfaces.front(), buffers);
+    });
+
+    destroyBuffer(coded);
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+/* small pictures, the quantization and Huffman tables take a good part */
+TEST_F(NullHWBenchmarkTest, JPEGEncodeTables)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_JPEG_ENCODING(i965)))
+        return;
+
+    using namespace ::JPEG::Encode;
+
+    const TestInput::Shared input(TestInput::create(VA_FOURCC_NV12, 64, 64));
+    ASSERT_PTR(input.get());
+
+    SurfaceAttribs attributes(1);
+    attributes.front().flags = VA_SURFACE_ATTRIB_SETTABLE;
+    attributes.front().type = VASurfaceAttribPixelFormat;
+    attributes.front().value.type = VAGenericValueTypeInteger;
+    attributes.front().value.value.i = input->image->fourcc;
+
+    ConfigAttribs attribs(
+        1, {type:VAConfigAttribRTFormat, value:input->image->format});
+
+    ASSERT_NO_FAILURE(
+        Surfaces surfaces = createSurfaces(input->image->width,
+            input->image->height, input->image->format, 1, attributes));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(::JPEG::profile, entrypoint, attribs));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, input->image->width,
+            input->image->height, 0, surfaces));
+    ASSERT_NO_FAILURE(
+        VABufferID coded = createBuffer(context, VAEncCodedBufferType,
+            (input->image->sizes.sum() + 8192u) * 2));
+
+    auto frame = [&](unsigned quality) {
+        PictureParameter picture(input->picture);
+        VAEncPackedHeaderParameterBuffer packed;
+        const uint8_t header(0xff);
+        Buffers buffers;
+
+        picture.coded_buf = coded;
+        picture.quality = quality;
+
+        std::memset(&packed, 0, sizeof(packed));
+        packed.type = VAEncPackedHeaderRawData;
+        packed.bit_length = 8;
+
+        buffers.push_back(createBuffer(context, VAEncPictureParameterBufferType,
+            sizeof(PictureParameter), 1, &picture));
+        buffers.push_back(createBuffer(context, VAQMatrixBufferType,
+            sizeof(IQMatrix), 1, &input->matrix));
+        buffers.push_back(createBuffer(context, VAHuffmanTableBufferType,
+            sizeof(HuffmanTable), 1, &input->huffman));
+        buffers.push_back(createBuffer(context, VAEncSliceParameterBufferType,
+            sizeof(SliceParameter), 1, &input->slice));
+        buffers.push_back(createBuffer(context,
+            VAEncPackedHeaderParameterBufferType, sizeof(packed), 1, &packed));
+        buffers.push_back(createBuffer(context,
+            VAEncPackedHeaderDataBufferType, 1, 1, &header));
+
+        submit(context, surfaces.front(), buffers);
+    };
+
+    measure("JPEG encode 64x64 fixed quality", [&](unsigned) {
+        frame(75);
+    });
+    measure("JPEG encode 64x64 new quality every frame", [&](unsigned i) {
+        frame(50 + i % 50);
+    });
+
+    destroyBuffer(coded);
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(surfaces);
+}
+
+TEST_F(NullHWBenchmarkTest, VPP)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(HAS_VPP(i965)))
+        return;
+
+    ASSERT_NO_FAILURE(
+        Surfaces inputs = createSurfaces(1920, 1080, VA_RT_FORMAT_YUV420));
+    ASSERT_NO_FAILURE(
+        Surfaces outputs = createSurfaces(1280, 720, VA_RT_FORMAT_YUV420));
+    ASSERT_NO_FAILURE(
+        VAConfigID config = createConfig(VAProfileNone, VAEntrypointVideoProc));
+    ASSERT_NO_FAILURE(
+        VAContextID context = createContext(config, 1280, 720, 0, outputs));
+
+    measure("VPP 1080p to 720p NV12", [&](unsigned) {
+        VAProcPipelineParameterBuffer pipeline;
+        Buffers buffers;
+
+        std::memset(&pipeline, 0, sizeof(pipeline));
+        pipeline.surface = inputs.front();
+        pipeline.output_background_color = 0xff000000;
+
+        buffers.push_back(createBuffer(context,
+            VAProcPipelineParameterBufferType, sizeof(pipeline), 1, &pipeline));
+
+        submit(context, outputs.front(), buffers);
+    });
+
+    destroyContext(context);
+    destroyConfig(config);
+    destroySurfaces(outputs);
+    destroySurfaces(inputs);
+}
+
+/*
+ * The surface state setup of a GPE kernel binding as many surfaces as
+ * the AVC MBEnc kernel, with the surface state BO mapped for every
+ * surface and mapped once for the whole kernel
+ */
+TEST_F(NullHWBenchmarkTest, GPESurfaceState)
+{
+    struct i965_driver_data *i965(*this);
+    ASSERT_PTR(i965);
+    if (isSkipped(i965->intel.device_info->gen >= 8))
+        return;
+
+    struct i965_gpe_table *gpe(&i965->gpe_table);
+    static const unsigned numSurfaces = 32;
+    const unsigned surfaceStateSize(std::max(SURFACE_STATE_PADDED_SIZE_GEN8,
+        SURFACE_STATE_PADDED_SIZE_GEN9));
+    std::vector<struct i965_gpe_resource> buffers(numSurfaces / 2);
+    std::vector<struct i965_gpe_resource> surfaces(numSurfaces / 2);
+    struct i965_gpe_context gpe_context;
+
+    std::memset(&gpe_context, 0, sizeof(gpe_context));
+    gpe_context.surface_state_binding_table.max_entries = numSurfaces;
+    gpe_context.surface_state_binding_table.binding_table_offset = 0;
+    gpe_context.surface_state_binding_table.surface_state_offset =
+        ALIGN(numSurfaces * 4, 64);
+    gpe_context.surface_state_binding_table.length =
+        ALIGN(numSurfaces * 4, 64) + ALIGN(numSurfaces * surfaceStateSize, 64);
+    gpe_context.idrt.max_entries = 1;
+    gpe_context.idrt.entry_size = 32;
+    gpe_context.curbe.length = 128;
+
+    for (auto& buffer : buffers) {
+        std::memset(&buffer, 0, sizeof(buffer));
+        ASSERT_TRUE(i965_allocate_gpe_resource(i965->intel.bufmgr, &buffer,
+            0x10000, "buffer"));
+    }
+
+    for (auto& surface : surfaces) {
+        std::memset(&surface, 0, sizeof(surface));
+        ASSERT_TRUE(i965_gpe_allocate_2d_resource(i965->intel.bufmgr,
+            &surface, 480, 272, 512, "surface"));
+    }
+
+    auto kernel = [&](bool mapOnce) {
+        unsigned index(0);
+
+        gpe->context_init(*this, &gpe_context);
+        if (mapOnce)
+            i965_gpe_context_map_surface_state(&gpe_context);
+        gpe->reset_binding_table(*this, &gpe_context);
+
+        for (auto& buffer : buffers)
+            i965_add_buffer_gpe_surface(*this, &gpe_context, &buffer, 0,
+                buffer.size / 4, 0, index++);
+
+        for (auto& surface : surfaces)
+            i965_add_buffer_2d_gpe_surface(*this, &gpe_context, &surface, 1,
+                I965_SURFACEFORMAT_R8_UNORM, index++);
+
+        if (mapOnce)
+            i965_gpe_context_unmap_surface_state(&gpe_context);
+    };
+
+    measure("GPE surface state, 32 surfaces, mapped per surface",
+        [&](unsigned) { kernel(false); });
+    measure("GPE surface state, 32 surfaces, mapped once",
+        [&](unsigned) { kernel(true); });
+
+    gen8_gpe_context_destroy(&gpe_context);
+    for (auto& buffer : buffers)
+        i965_free_gpe_resource(&buffer);
+    for (auto& surface : surfaces)
+        i965_free_gpe_resource(&surface);
+}
+
+/*
+ * The latency of vaInitialize() and vaTerminate() for the short lived
+ * processes, with and without VA_INTEL_CAPS_CACHE. The null backend
+ * answers the device queries for free, on a device the cache also saves
+ * their ioctls.
+ */
+TEST_F(NullHWBenchmarkTest, Initialize)
+{
+    if (isSkipped(true))
+        return;
+
+    static const unsigned numInits = 20;
+
+    std::ostringstream os;
+    os << "/tmp/i965_null_hw_caps." << getpid();
+    const std::string path(os.str());
+    std::remove(path.c_str());
+
+    auto initialize = [&](const std::string& name, bool cached) {
+        struct timespec start, end;
+        double us(0);
+
+        for (unsigned i(0); i < numInits; ++i) {
+            VADisplayContext dctx;
+            VADriverContext ctx;
+            VADriverVTable vtable;
+            VADriverVTableVPP vtable_vpp;
+
+            std::memset(&dctx, 0, sizeof(dctx));
+            std::memset(&ctx, 0, sizeof(ctx));
+            std::memset(&vtable, 0, sizeof(vtable));
+            std::memset(&vtable_vpp, 0, sizeof(vtable_vpp));
+            dctx.pDriverContext = &ctx;
+            ctx.pDisplayContext = &dctx;
+            ctx.display_type = VA_DISPLAY_DRM;
+            ctx.vtable = &vtable;
+            ctx.vtable_vpp = &vtable_vpp;
+
+            clock_gettime(CLOCK_MONOTONIC, &start);
+            ASSERT_STATUS(VA_DRIVER_INIT_FUNC(&ctx));
+            const int fromCache(i965_driver_data(&ctx)->intel.caps_from_cache);
+            EXPECT_STATUS(i965_Terminate(&ctx));
+            clock_gettime(CLOCK_MONOTONIC, &end);
+
+            // the first init of the cached run writes the cache
+            EXPECT_EQ(cached and i > 0, bool(fromCache)) << i;
+
+            us += (end.tv_sec - start.tv_sec) * 1e6
+                + (end.tv_nsec - start.tv_nsec) / 1e3;
+        }
+
+        RecordProperty(name, int(us / numInits + 0.5));
+
+        std::cout << std::fixed << std::setprecision(1) << "initialize "
+            << name << ": " << us / numInits << " us per init" << std::endl;
+    };
+
+    ASSERT_NO_FAILURE(initialize("probed_us", false));
+
+    setenv("VA_INTEL_CAPS_CACHE", path.c_str(), 1);
+    ASSERT_NO_FAILURE(initialize("cached_us", true));
+    unsetenv("VA_INTEL_CAPS_CACHE");
+
+    std::remove(path.c_str());
+}
+
+} // namespace NullHW
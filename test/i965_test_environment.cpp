@@ -40,6 +40,7 @@ I965TestEnvironment::I965TestEnvironment()
     : ::testing::Environment()
     , m_handle(-1)
     , m_vaDisplay(NULL)
+    , m_nullHW(false)
 {
     return;
 }
@@ -54,6 +55,11 @@ void I965TestEnvironment::SetUp()
     ASSERT_EQ(-1, m_handle);
     ASSERT_PTR_NULL(m_vaDisplay);
 
+    if (std::getenv("VA_INTEL_NULL_HW")) {
+        SetUpNullHW();
+        return;
+    }
+
     m_handle = open("/dev/dri/renderD128", O_RDWR);
     if (m_handle < 0)
         m_handle = open("/dev/dri/card0", O_RDWR);
@@ -80,8 +86,63 @@ void I965TestEnvironment::SetUp()
     ::testing::Test::RecordProperty("vaapi_version", VA_VERSION_S);
 }
 
+void I965TestEnvironment::SetUpNullHW()
+{
+    VADisplayContextP dctx =
+        (VADisplayContextP)std::calloc(1, sizeof(VADisplayContext));
+    ASSERT_PTR(dctx);
+
+    VADriverContextP ctx =
+        (VADriverContextP)std::calloc(1, sizeof(VADriverContext));
+    ASSERT_PTR(ctx);
+
+    dctx->pDriverContext = ctx;
+    ctx->pDisplayContext = dctx;
+    ctx->display_type = VA_DISPLAY_DRM;
+    ctx->vtable = (VADriverVTable *)std::calloc(1, sizeof(VADriverVTable));
+    ctx->vtable_vpp =
+        (VADriverVTableVPP *)std::calloc(1, sizeof(VADriverVTableVPP));
+
+    m_nullHW = true;
+    m_vaDisplay = (VADisplay)dctx;
+
+    ASSERT_PTR(ctx->vtable);
+    ASSERT_PTR(ctx->vtable_vpp);
+    ASSERT_STATUS(VA_DRIVER_INIT_FUNC(ctx));
+
+    const std::string vendor(ctx->str_vendor);
+
+    ::testing::Test::RecordProperty("driver_vendor", vendor);
+    ::testing::Test::RecordProperty("null_hw", std::getenv("VA_INTEL_NULL_HW"));
+}
+
+void I965TestEnvironment::TearDownNullHW()
+{
+    VADisplayContextP dctx(*this);
+    VADriverContextP ctx(*this);
+
+    if (ctx) {
+        if (ctx->pDriverData)
+            EXPECT_STATUS(i965_Terminate(ctx));
+
+        std::free(ctx->vtable);
+        std::free(ctx->vtable_vpp);
+        std::free(ctx);
+    }
+
+    std::free(dctx);
+
+    m_nullHW = false;
+    m_vaDisplay = NULL;
+}
+
 void I965TestEnvironment::TearDown()
 {
+    if (m_nullHW) {
+        TearDownNullHW();
+        return;
+    }
+
     if (m_vaDisplay) {
         EXPECT_STATUS(vaTerminate(m_vaDisplay));
     }
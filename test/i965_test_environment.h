@@ -61,10 +61,21 @@ private:
 
     int m_handle; /* current native display handle */
     VADisplay m_vaDisplay; /* current VADisplay handle */
+    bool m_nullHW; /* VA_INTEL_NULL_HW: the display is ours, not libva's */
+
+    /**
+     * With VA_INTEL_NULL_HW set there is no device to open, so the driver
+     * linked into the test is initialized directly on a display context
+     * allocated here instead of through vaInitialize().
+     */
+    void SetUpNullHW();
+    void TearDownNullHW();
 
 public:
     static I965TestEnvironment* instance();
 
+    bool isNullHW() const { return m_nullHW; }
+
     /**
      * VADisplay implicit and explicit conversion operator.
      */
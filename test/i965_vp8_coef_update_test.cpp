@@ -0,0 +1,240 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "vp8_probs.h"
+    #include "vp8_coef_update.h"
+}
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+
+namespace VP8CoefUpdate {
+
+typedef unsigned int TokenCounts[4][8][3][12];
+typedef unsigned int BranchCounts[4][8][3][11][2];
+typedef unsigned char Probs[4][8][3][11];
+
+// The nodes and the decisions that code every token (RFC 6386, 13.2)
+const struct {
+    unsigned length;
+    unsigned char node[6];
+    unsigned char bit[6];
+} tokenPath[12] = {
+    {2, {0, 1}, {1, 0}},                                // DCT_0
+    {3, {0, 1, 2}, {1, 1, 0}},                          // DCT_1
+    {5, {0, 1, 2, 3, 4}, {1, 1, 1, 0, 0}},              // DCT_2
+    {6, {0, 1, 2, 3, 4, 5}, {1, 1, 1, 0, 1, 0}},        // DCT_3
+    {6, {0, 1, 2, 3, 4, 5}, {1, 1, 1, 0, 1, 1}},        // DCT_4
+    {6, {0, 1, 2, 3, 6, 7}, {1, 1, 1, 1, 0, 0}},        // DCT_CAT1
+    {6, {0, 1, 2, 3, 6, 7}, {1, 1, 1, 1, 0, 1}},        // DCT_CAT2
+    {6, {0, 1, 2, 3, 6, 8}, {1, 1, 1, 1, 1, 0}},        // DCT_CAT3, then node 9
+    {6, {0, 1, 2, 3, 6, 8}, {1, 1, 1, 1, 1, 0}},        // DCT_CAT4, then node 9
+    {6, {0, 1, 2, 3, 6, 8}, {1, 1, 1, 1, 1, 1}},        // DCT_CAT5, then node 10
+    {6, {0, 1, 2, 3, 6, 8}, {1, 1, 1, 1, 1, 1}},        // DCT_CAT6, then node 10
+    {1, {0}, {0}},                                      // DCT_EOB
+};
+
+void referenceBranchCounts(const TokenCounts& tokens, BranchCounts& branches)
+{
+    memset(branches, 0, sizeof(branches));
+
+    for (unsigned i(0); i < 4; ++i) {
+        for (unsigned j(0); j < 8; ++j) {
+            for (unsigned k(0); k < 3; ++k) {
+                for (unsigned t(0); t < 12; ++t) {
+                    const unsigned count(tokens[i][j][k][t]);
+
+                    for (unsigned n(0); n < tokenPath[t].length; ++n)
+                        branches[i][j][k][tokenPath[t].node[n]][tokenPath[t].bit[n]] += count;
+
+                    if (t == 7 || t == 8)
+                        branches[i][j][k][9][t - 7] += count;
+                    else if (t == 9 || t == 10)
+                        branches[i][j][k][10][t - 9] += count;
+                }
+            }
+        }
+    }
+}
+
+int64_t cost(unsigned count0, unsigned count1, unsigned prob)
+{
+    return int64_t(count0) * vp8_prob_cost[prob] +
+        int64_t(count1) * vp8_prob_cost[255 - prob];
+}
+
+// One probability at a time, as the encoder of libvpx does it
+unsigned referenceSearch(const Probs& probs, const BranchCounts& branches,
+    Probs& newProbs, Probs& flags)
+{
+    int64_t total(0);
+
+    for (unsigned i(0); i < 4; ++i) {
+        for (unsigned j(0); j < 8; ++j) {
+            for (unsigned k(0); k < 3; ++k) {
+                for (unsigned n(0); n < 11; ++n) {
+                    const unsigned c0(branches[i][j][k][n][0]);
+                    const unsigned c1(branches[i][j][k][n][1]);
+                    const unsigned oldProb(probs[i][j][k][n]);
+                    const unsigned upd(vp8_coef_update_probs[i][j][k][n]);
+
+                    newProbs[i][j][k][n] = oldProb;
+                    flags[i][j][k][n] = 0;
+
+                    if (!(c0 + c1))
+                        continue;
+
+                    unsigned prob((uint64_t(c0) * 256 + (c0 + c1) / 2) / (c0 + c1));
+                    prob = std::min(std::max(prob, 1u), 255u);
+
+                    const int64_t savings(cost(c0, c1, oldProb) - cost(c0, c1, prob)
+                        - (8 * 256 + vp8_prob_cost[255 - upd] - vp8_prob_cost[upd]));
+
+                    if (savings > 0) {
+                        newProbs[i][j][k][n] = prob;
+                        flags[i][j][k][n] = 1;
+                        total += savings;
+                    }
+                }
+            }
+        }
+    }
+
+    return total >> 8;
+}
+
+void check(const Probs& probs, const TokenCounts& tokens)
+{
+    BranchCounts branches, expectBranches;
+    Probs newProbs, flags, expectProbs, expectFlags;
+
+    vp8_coef_branch_counts(tokens, branches);
+    referenceBranchCounts(tokens, expectBranches);
+    ASSERT_EQ(0, memcmp(branches, expectBranches, sizeof(branches)));
+
+    const unsigned saved(vp8_coef_update_search(probs, branches, newProbs, flags));
+    EXPECT_EQ(referenceSearch(probs, branches, expectProbs, expectFlags), saved);
+    EXPECT_EQ(0, memcmp(newProbs, expectProbs, sizeof(newProbs)));
+    EXPECT_EQ(0, memcmp(flags, expectFlags, sizeof(flags)));
+}
+
+TEST(VP8CoefUpdateTest, BranchCounts)
+{
+    TokenCounts tokens;
+    BranchCounts branches;
+
+    for (unsigned t(0); t < 12; ++t) {
+        memset(tokens, 0, sizeof(tokens));
+        tokens[1][2][0][t] = 5;
+
+        vp8_coef_branch_counts(tokens, branches);
+
+        // every token goes through the root
+        EXPECT_EQ(5u, branches[1][2][0][0][0] + branches[1][2][0][0][1]);
+        EXPECT_EQ(t == 11 ? 5u : 0u, branches[1][2][0][0][0]);
+        EXPECT_EQ(0u, branches[0][0][0][0][0] + branches[0][0][0][0][1]);
+    }
+}
+
+TEST(VP8CoefUpdateTest, NoTokens)
+{
+    TokenCounts tokens;
+    memset(tokens, 0, sizeof(tokens));
+    check(vp8_default_coef_probs, tokens);
+
+    BranchCounts branches;
+    Probs newProbs, flags;
+    vp8_coef_branch_counts(tokens, branches);
+    EXPECT_EQ(0u, vp8_coef_update_search(vp8_default_coef_probs, branches,
+        newProbs, flags));
+    EXPECT_EQ(0, memcmp(newProbs, vp8_default_coef_probs, sizeof(newProbs)));
+}
+
+TEST(VP8CoefUpdateTest, Random)
+{
+    std::mt19937 gen(0x5eed);
+    TokenCounts tokens;
+    Probs probs;
+
+    for (unsigned round(0); round < 50; ++round) {
+        // from a few tokens to a 4K frame, skewed toward the small tokens
+        const unsigned scale(1u << (round % 20));
+        std::uniform_int_distribution<unsigned> count(0, scale);
+
+        for (unsigned i(0); i < 4; ++i)
+            for (unsigned j(0); j < 8; ++j)
+                for (unsigned k(0); k < 3; ++k)
+                    for (unsigned t(0); t < 12; ++t)
+                        tokens[i][j][k][t] = count(gen) >> (t < 5 || t == 11 ? 0 : t - 4);
+
+        check(vp8_default_coef_probs, tokens);
+
+        std::uniform_int_distribution<unsigned> prob(1, 255);
+        for (unsigned n(0); n < VP8_NUM_COEF_PROBS; ++n)
+            (&probs[0][0][0][0])[n] = prob(gen);
+
+        check(probs, tokens);
+    }
+}
+
+TEST(VP8CoefUpdateTest, Matching)
+{
+    TokenCounts tokens;
+    BranchCounts branches;
+    Probs probs, newProbs, flags;
+    std::mt19937 gen(0xc0ef);
+    std::uniform_int_distribution<unsigned> count(0, 4096);
+
+    for (unsigned n(0); n < 4 * 8 * 3 * 12; ++n)
+        (&tokens[0][0][0][0])[n] = count(gen);
+
+    // probabilities that match the tokens leave nothing to update
+    vp8_coef_branch_counts(tokens, branches);
+    for (unsigned n(0); n < VP8_NUM_COEF_PROBS; ++n) {
+        const unsigned c0((&branches[0][0][0][0][0])[2 * n]);
+        const unsigned c1((&branches[0][0][0][0][0])[2 * n + 1]);
+        const unsigned prob(c0 + c1 ? (c0 * 256 + (c0 + c1) / 2) / (c0 + c1) : 128);
+        (&probs[0][0][0][0])[n] = std::min(std::max(prob, 1u), 255u);
+    }
+
+    EXPECT_EQ(0u, vp8_coef_update_search(probs, branches, newProbs, flags));
+    EXPECT_EQ(0, memcmp(newProbs, probs, sizeof(newProbs)));
+
+    // and a skewed root is worth an update
+    for (unsigned k(0); k < 3; ++k)
+        tokens[0][0][k][11] = 100000;
+
+    vp8_coef_branch_counts(tokens, branches);
+    EXPECT_GT(vp8_coef_update_search(probs, branches, newProbs, flags), 0u);
+    EXPECT_EQ(1, flags[0][0][0][0]);
+    EXPECT_GT(newProbs[0][0][0][0], probs[0][0][0][0]);
+    check(probs, tokens);
+}
+
+} // namespace VP8CoefUpdate
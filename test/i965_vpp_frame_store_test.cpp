@@ -0,0 +1,117 @@
+/*
+ * Copyright (C) 2026 Intel Corporation. All Rights Reserved.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sub license, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice (including the
+ * next paragraph) shall be included in all copies or substantial portions
+ * of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT.
+ * IN NO EVENT SHALL PRECISION INSIGHT AND/OR ITS SUPPLIERS BE LIABLE FOR
+ * ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT,
+ * TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE
+ * SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "test.h"
+
+extern "C" {
+    #include "sysdeps.h"
+    #include "i965_drv_video.h"
+    #include "i965_post_processing.h"
+}
+
+namespace VPPFrameStore {
+
+class VPPFrameStoreGeometryTest
+    : public ::testing::Test
+{
+protected:
+    virtual void SetUp()
+    {
+        geometry = vpp_frame_store_geometry();
+    }
+
+    bool update(int width, int height)
+    {
+        return vpp_frame_store_geometry_update(&geometry, width, height);
+    }
+
+    vpp_frame_store_geometry geometry;
+};
+
+TEST_F(VPPFrameStoreGeometryTest, FirstFrameAllocates)
+{
+    EXPECT_TRUE(update(1280, 720));
+    EXPECT_EQ(1280, geometry.width);
+    EXPECT_EQ(720, geometry.height);
+
+    // the first allocation is not a reallocation
+    EXPECT_EQ(0u, geometry.num_reallocs);
+
+    EXPECT_FALSE(update(1280, 720));
+    EXPECT_EQ(0u, geometry.num_reallocs);
+}
+
+// an ABR ladder switching down and back up keeps the first allocation
+TEST_F(VPPFrameStoreGeometryTest, DownSwitchReuses)
+{
+    EXPECT_TRUE(update(1920, 1080));
+
+    EXPECT_FALSE(update(1280, 720));
+    EXPECT_FALSE(update(640, 360));
+    EXPECT_FALSE(update(1920, 1080));
+    EXPECT_FALSE(update(1920, 360));
+    EXPECT_FALSE(update(640, 1080));
+
+    EXPECT_EQ(1920, geometry.width);
+    EXPECT_EQ(1080, geometry.height);
+    EXPECT_EQ(0u, geometry.num_reallocs);
+}
+
+// growing in one dimension keeps the other at its largest
+TEST_F(VPPFrameStoreGeometryTest, UpSwitchGrows)
+{
+    EXPECT_TRUE(update(1280, 720));
+
+    EXPECT_TRUE(update(1920, 544));
+    EXPECT_EQ(1920, geometry.width);
+    EXPECT_EQ(720, geometry.height);
+    EXPECT_EQ(1u, geometry.num_reallocs);
+
+    EXPECT_TRUE(update(1024, 1088));
+    EXPECT_EQ(1920, geometry.width);
+    EXPECT_EQ(1088, geometry.height);
+    EXPECT_EQ(2u, geometry.num_reallocs);
+
+    EXPECT_FALSE(update(1920, 1080));
+    EXPECT_EQ(2u, geometry.num_reallocs);
+}
+
+// beyond the bound the frame store follows the input down again
+TEST_F(VPPFrameStoreGeometryTest, LargestIsBounded)
+{
+    EXPECT_TRUE(update(1920, 1080));
+
+    EXPECT_TRUE(update(8192, 4320));
+    EXPECT_EQ(8192, geometry.width);
+    EXPECT_EQ(4320, geometry.height);
+
+    EXPECT_TRUE(update(1920, 1080));
+    EXPECT_EQ(VPP_FRAME_STORE_MAX_WIDTH, geometry.width);
+    EXPECT_EQ(VPP_FRAME_STORE_MAX_HEIGHT, geometry.height);
+
+    EXPECT_FALSE(update(3840, 2160));
+    EXPECT_EQ(2u, geometry.num_reallocs);
+}
+
+} // namespace VPPFrameStore